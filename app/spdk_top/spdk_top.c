@@ -9,6 +9,7 @@
 #include "spdk/event.h"
 #include "spdk/util.h"
 #include "spdk/env.h"
+#include "spdk/thread.h"
 
 #if defined __has_include
 #if __has_include(<ncurses/panel.h>)
@@ -71,7 +72,7 @@
 #define CORE_WIN_FIRST_COL 16
 #define CORE_WIN_WIDTH 48
 #define CORE_WIN_HEIGHT 11
-#define POLLER_WIN_HEIGHT 8
+#define POLLER_WIN_HEIGHT 9
 #define POLLER_WIN_WIDTH 64
 #define POLLER_WIN_FIRST_COL 14
 #define FIRST_DATA_ROW 7
@@ -108,6 +109,7 @@ enum column_pollers_type {
 	COL_POLLERS_RUN_COUNTER,
 	COL_POLLERS_PERIOD,
 	COL_POLLERS_BUSY_COUNT,
+	COL_POLLERS_SLOW_COUNT,
 	COL_POLLERS_NONE = 255,
 };
 
@@ -183,6 +185,7 @@ static struct col_desc g_col_desc[NUMBER_OF_TABS][TABS_COL_COUNT] = {
 		{.name = "Run count", .max_data_string = MAX_POLLER_RUN_COUNT},
 		{.name = "Period [us]", .max_data_string = MAX_PERIOD_STR_LEN},
 		{.name = "Status (busy count)", .max_data_string = MAX_POLLER_IND_STR_LEN},
+		{.name = "Slow count", .max_data_string = MAX_POLLER_RUN_COUNT},
 		{.name = (char *)NULL}
 	},
 	{	{.name = "Core", .max_data_string = MAX_CORE_STR_LEN},
@@ -219,6 +222,7 @@ struct rpc_poller_info {
 	uint64_t id;
 	uint64_t run_count;
 	uint64_t busy_count;
+	uint64_t slow_count;
 	uint64_t period_ticks;
 	enum spdk_poller_type type;
 	char thread_name[MAX_THREAD_NAME];
@@ -256,6 +260,14 @@ struct rpc_scheduler {
 };
 
 struct rpc_thread_info g_threads_info[RPC_MAX_THREADS];
+/* Thread statistics region of the application, if it runs on the same host. */
+static const struct spdk_thread_stats_shm *g_thread_stats_shm;
+static size_t g_thread_stats_shm_size;
+static bool g_thread_stats_shm_checked;
+/* Identity of the mapped region, to notice when the application is restarted. */
+static char *g_thread_stats_shm_name;
+static dev_t g_thread_stats_shm_dev;
+static ino_t g_thread_stats_shm_ino;
 struct rpc_poller_info g_pollers_info[RPC_MAX_POLLERS];
 struct rpc_core_info g_cores_info[RPC_MAX_CORES];
 struct rpc_scheduler g_scheduler_info;
@@ -357,6 +369,7 @@ static const struct spdk_json_object_decoder rpc_pollers_decoders[] = {
 	{"id", offsetof(struct rpc_poller_info, id), spdk_json_decode_uint64},
 	{"run_count", offsetof(struct rpc_poller_info, run_count), spdk_json_decode_uint64},
 	{"busy_count", offsetof(struct rpc_poller_info, busy_count), spdk_json_decode_uint64},
+	{"slow_count", offsetof(struct rpc_poller_info, slow_count), spdk_json_decode_uint64, true},
 	{"period_ticks", offsetof(struct rpc_poller_info, period_ticks), spdk_json_decode_uint64, true},
 };
 
@@ -709,6 +722,143 @@ store_last_counters(uint64_t poller_id, uint64_t thread_id, uint64_t last_run_co
 	TAILQ_INSERT_TAIL(&g_run_counter_history, history, link);
 }
 
+static void
+thread_stats_shm_open(struct spdk_json_val *result)
+{
+	const struct spdk_thread_stats_shm *shm;
+	struct spdk_json_val *val;
+	struct stat st;
+	char *shm_name;
+	size_t size;
+	int fd;
+
+	g_thread_stats_shm_checked = true;
+
+	if (spdk_json_find_string(result, "shm_name", NULL, &val) != 0) {
+		return;
+	}
+
+	shm_name = spdk_json_strdup(val);
+	if (shm_name == NULL) {
+		return;
+	}
+
+	/* The region is only reachable if the application runs on this host. */
+	fd = shm_open(shm_name, O_RDONLY, 0);
+	if (fd < 0) {
+		free(shm_name);
+		return;
+	}
+
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(*shm)) {
+		close(fd);
+		free(shm_name);
+		return;
+	}
+
+	shm = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (shm == MAP_FAILED) {
+		free(shm_name);
+		return;
+	}
+
+	size = sizeof(*shm) + (size_t)shm->max_threads * sizeof(shm->threads[0]);
+	if (shm->version != SPDK_THREAD_STATS_SHM_VERSION || size > (size_t)st.st_size) {
+		munmap((void *)shm, st.st_size);
+		free(shm_name);
+		return;
+	}
+
+	g_thread_stats_shm = shm;
+	g_thread_stats_shm_size = st.st_size;
+	g_thread_stats_shm_name = shm_name;
+	g_thread_stats_shm_dev = st.st_dev;
+	g_thread_stats_shm_ino = st.st_ino;
+}
+
+/* A restarted application creates a new region under the same name, the mapped one is dead. */
+static bool
+thread_stats_shm_is_stale(void)
+{
+	struct stat st;
+	int fd, rc;
+
+	fd = shm_open(g_thread_stats_shm_name, O_RDONLY, 0);
+	if (fd < 0) {
+		return true;
+	}
+
+	rc = fstat(fd, &st);
+	close(fd);
+
+	return rc != 0 || st.st_dev != g_thread_stats_shm_dev ||
+	       st.st_ino != g_thread_stats_shm_ino;
+}
+
+static int
+thread_stats_shm_decode(struct rpc_thread_info *out, uint64_t *current_threads_count)
+{
+	struct spdk_thread_stats_shm_entry entry;
+	struct spdk_cpuset core_mask = {}, tmp_mask;
+	uint64_t count = 0;
+	uint32_t i;
+
+	/* Show the cpumask limited to the cores of the application, as the RPC does. */
+	for (i = 0; i < g_last_cores_count; i++) {
+		spdk_cpuset_set_cpu(&core_mask, g_cores_info[i].lcore, true);
+	}
+
+	for (i = 0; i < g_thread_stats_shm->max_threads && count < RPC_MAX_THREADS; i++) {
+		if (!spdk_thread_stats_shm_read(g_thread_stats_shm, i, &entry)) {
+			continue;
+		}
+
+		/* The busy and idle ticks of a thread sleeping in interrupt mode are behind. */
+		if (entry.in_interrupt) {
+			*current_threads_count = count;
+			return -EAGAIN;
+		}
+
+		if (g_last_cores_count > 0 && spdk_cpuset_parse(&tmp_mask, entry.cpumask) == 0) {
+			spdk_cpuset_and(&tmp_mask, &core_mask);
+			snprintf(entry.cpumask, sizeof(entry.cpumask), "%s",
+				 spdk_cpuset_fmt(&tmp_mask));
+		}
+
+		out[count].name = strdup(entry.name);
+		out[count].cpumask = strdup(entry.cpumask);
+		out[count].id = entry.id;
+		out[count].busy = entry.busy_tsc;
+		out[count].idle = entry.idle_tsc;
+		out[count].active_pollers_count = entry.active_pollers_count;
+		out[count].timed_pollers_count = entry.timed_pollers_count;
+		out[count].paused_pollers_count = entry.paused_pollers_count;
+		count++;
+
+		if (out[count - 1].name == NULL || out[count - 1].cpumask == NULL) {
+			*current_threads_count = count;
+			return -ENOMEM;
+		}
+	}
+
+	*current_threads_count = count;
+	return 0;
+}
+
+static void
+thread_stats_shm_close(void)
+{
+	if (g_thread_stats_shm != NULL) {
+		munmap((void *)g_thread_stats_shm, g_thread_stats_shm_size);
+		g_thread_stats_shm = NULL;
+	}
+
+	free(g_thread_stats_shm_name);
+	g_thread_stats_shm_name = NULL;
+	g_thread_stats_shm_checked = false;
+}
+
 static int
 get_thread_data(void)
 {
@@ -716,21 +866,53 @@ get_thread_data(void)
 	struct rpc_thread_info thread_info[RPC_MAX_THREADS], *thread;
 	struct rpc_core_info *core_info;
 	uint64_t i, j, k, current_threads_count = 0;
+	bool shm_read = false;
 	int rc = 0;
 
-	rc = rpc_send_req("thread_get_stats", &json_resp);
-	if (rc) {
-		return rc;
+	memset(thread_info, 0, sizeof(struct rpc_thread_info) * RPC_MAX_THREADS);
+
+	if (g_thread_stats_shm != NULL && thread_stats_shm_is_stale()) {
+		/* Map the region of the new application once the RPC reports it. */
+		thread_stats_shm_close();
 	}
 
-	/* Decode json */
-	memset(thread_info, 0, sizeof(struct rpc_thread_info) * RPC_MAX_THREADS);
-	if (rpc_decode_threads_array(json_resp->result, thread_info, &current_threads_count)) {
-		rc = -EINVAL;
-		for (i = 0; i < current_threads_count; i++) {
-			free_rpc_threads_stats(&thread_info[i]);
+	if (g_thread_stats_shm != NULL) {
+		/* Read the statistics directly, without interrupting the application threads. */
+		rc = thread_stats_shm_decode(thread_info, &current_threads_count);
+		if (rc != 0) {
+			for (i = 0; i < current_threads_count; i++) {
+				free_rpc_threads_stats(&thread_info[i]);
+			}
+			if (rc != -EAGAIN) {
+				goto end;
+			}
+			memset(thread_info, 0, sizeof(struct rpc_thread_info) * RPC_MAX_THREADS);
+			current_threads_count = 0;
+			rc = 0;
+		} else {
+			shm_read = true;
+		}
+	}
+
+	if (!shm_read) {
+		rc = rpc_send_req("thread_get_stats", &json_resp);
+		if (rc) {
+			return rc;
+		}
+
+		/* Decode json */
+		if (rpc_decode_threads_array(json_resp->result, thread_info,
+					     &current_threads_count)) {
+			rc = -EINVAL;
+			for (i = 0; i < current_threads_count; i++) {
+				free_rpc_threads_stats(&thread_info[i]);
+			}
+			goto end;
+		}
+
+		if (!g_thread_stats_shm_checked) {
+			thread_stats_shm_open(json_resp->result);
 		}
-		goto end;
 	}
 
 	pthread_mutex_lock(&g_thread_lock);
@@ -854,6 +1036,10 @@ subsort_pollers(enum column_pollers_type sort_column, const void *p1, const void
 			}
 		}
 		break;
+	case COL_POLLERS_SLOW_COUNT:
+		count1 = poller1->slow_count;
+		count2 = poller2->slow_count;
+		break;
 	case COL_POLLERS_NONE:
 	default:
 		return 0;
@@ -1469,7 +1655,7 @@ draw_poller_tab_row(uint64_t current_row, uint8_t item_index)
 	uint64_t last_run_counter, last_busy_counter;
 	uint16_t col = TABS_DATA_START_COL;
 	char run_count[MAX_POLLER_RUN_COUNT], period_ticks[MAX_PERIOD_STR_LEN],
-	     status[MAX_POLLER_IND_STR_LEN];
+	     status[MAX_POLLER_IND_STR_LEN], slow_count[MAX_POLLER_RUN_COUNT];
 
 	last_busy_counter = get_last_busy_counter(g_pollers_info[current_row].id,
 			    g_pollers_info[current_row].thread_id);
@@ -1558,6 +1744,14 @@ draw_poller_tab_row(uint64_t current_row, uint8_t item_index)
 				wattroff(g_tabs[POLLERS_TAB], COLOR_PAIR(9));
 			}
 		}
+		col += col_desc[COL_POLLERS_BUSY_COUNT].max_data_string + 2;
+	}
+
+	if (!col_desc[COL_POLLERS_SLOW_COUNT].disabled) {
+		snprintf(slow_count, MAX_POLLER_RUN_COUNT, "%" PRIu64,
+			 g_pollers_info[current_row].slow_count);
+		print_max_len(g_tabs[POLLERS_TAB], TABS_DATA_START_ROW + item_index, col,
+			      col_desc[COL_POLLERS_SLOW_COUNT].max_data_string, ALIGN_RIGHT, slow_count);
 	}
 }
 
@@ -2767,6 +2961,9 @@ draw_poller_win_content(WINDOW *poller_win, struct rpc_poller_info *poller_info)
 		print_in_middle(poller_win, 6, 1, POLLER_WIN_WIDTH + 6, "Idle", COLOR_PAIR(7));
 	}
 
+	print_left(poller_win, 7, 2, POLLER_WIN_WIDTH, "Slow count:", COLOR_PAIR(5));
+	mvwprintw(poller_win, 7, POLLER_WIN_FIRST_COL, "%" PRIu64, poller_info->slow_count);
+
 	wnoutrefresh(poller_win);
 }
 
@@ -3323,6 +3520,7 @@ finish(int sig)
 	/* End ncurses mode */
 	endwin();
 	spdk_jsonrpc_client_close(g_rpc_client);
+	thread_stats_shm_close();
 	exit(0);
 }
 
@@ -212,6 +212,7 @@ static uint32_t g_num_namespaces;
 static TAILQ_HEAD(, worker_thread) g_workers = TAILQ_HEAD_INITIALIZER(g_workers);
 static uint32_t g_num_workers = 0;
 static bool g_use_every_core = false;
+static bool g_balance_qpairs = false;
 static uint32_t g_main_core;
 static pthread_barrier_t g_worker_sync_barrier;
 
@@ -835,6 +836,25 @@ nvme_setup_payload(struct perf_task *task, uint8_t pattern)
 	}
 }
 
+static int
+nvme_get_next_qpair(struct ns_worker_ctx *ns_ctx)
+{
+	int qp_num;
+
+	qp_num = ns_ctx->u.nvme.last_qpair;
+	ns_ctx->u.nvme.last_qpair++;
+	if (ns_ctx->u.nvme.last_qpair == ns_ctx->u.nvme.num_active_qpairs) {
+		ns_ctx->u.nvme.last_qpair = 0;
+	}
+
+	if (!g_balance_qpairs || ns_ctx->u.nvme.num_active_qpairs == 1) {
+		return qp_num;
+	}
+
+	return spdk_nvme_qpair_select_least_outstanding(ns_ctx->u.nvme.qpair,
+			ns_ctx->u.nvme.num_active_qpairs, qp_num);
+}
+
 static int
 nvme_submit_io(struct perf_task *task, struct ns_worker_ctx *ns_ctx,
 	       struct ns_entry *entry, uint64_t offset_in_ios)
@@ -859,11 +879,7 @@ nvme_submit_io(struct perf_task *task, struct ns_worker_ctx *ns_ctx,
 		}
 	}
 
-	qp_num = ns_ctx->u.nvme.last_qpair;
-	ns_ctx->u.nvme.last_qpair++;
-	if (ns_ctx->u.nvme.last_qpair == ns_ctx->u.nvme.num_active_qpairs) {
-		ns_ctx->u.nvme.last_qpair = 0;
-	}
+	qp_num = nvme_get_next_qpair(ns_ctx);
 
 	if (mode != DIF_MODE_NONE) {
 		rc = spdk_dif_ctx_init(&task->dif_ctx, entry->block_size, entry->md_size,
@@ -1895,6 +1911,7 @@ usage(char *program_name)
 	printf("\t[--transport-tos <val> specify the type of service for RDMA transport. Default: 0 (disabled)]\n");
 	printf("\t[--rdma-srq-size <val> The size of a shared rdma receive queue. Default: 0 (disabled)]\n");
 	printf("\t[--use-every-core for each namespace, I/Os are submitted from all cores]\n");
+	printf("\t[--balance-qpairs submit each I/O to the io queue with the fewest outstanding requests instead of round-robin]\n");
 }
 
 static void
@@ -2409,6 +2426,8 @@ static const struct option g_perf_cmdline_opts[] = {
 	{"rdma-srq-size", required_argument, NULL, PERF_RDMA_SRQ_SIZE},
 #define PERF_USE_EVERY_CORE	269
 	{"use-every-core", no_argument, NULL, PERF_USE_EVERY_CORE},
+#define PERF_BALANCE_QPAIRS	270
+	{"balance-qpairs", no_argument, NULL, PERF_BALANCE_QPAIRS},
 	/* Should be the last element */
 	{0, 0, 0, 0}
 };
@@ -2643,6 +2662,9 @@ parse_args(int argc, char **argv, struct spdk_env_opts *env_opts)
 		case PERF_USE_EVERY_CORE:
 			g_use_every_core = true;
 			break;
+		case PERF_BALANCE_QPAIRS:
+			g_balance_qpairs = true;
+			break;
 		case PERF_DEFAULT_SOCK_IMPL:
 			sock_impl = optarg;
 			rc = spdk_sock_set_default_impl(optarg);
@@ -283,8 +283,38 @@ struct spdk_nvme_ctrlr_opts {
 	 * Set the IP protocol type of service value for RDMA transport. Default is 0, which means that the TOS will not be set.
 	 */
 	uint8_t transport_tos;
+
+	/**
+	 * Reuse the Identify Namespace data and Namespace Identification Descriptor lists
+	 * gathered during the previous initialization when the controller is reset or
+	 * reconnected.
+	 *
+	 * The cache is only used if the Identify Controller data returned after the reset
+	 * describes the same controller (CNTLID for PCIe controllers, serial number,
+	 * subsystem NQN and number of namespaces) and no Namespace Attribute Changed event
+	 * is pending. The active namespace list is always re-read, so namespaces attached
+	 * while the controller was disconnected are still identified, and so are the
+	 * namespaces reported by the Changed Namespace List log page. The cache is not used
+	 * if that log page cannot be read or is disabled by disable_read_changed_ns_list_log_page.
+	 *
+	 * Default is `false` (all namespaces are identified on every reset).
+	 */
+	bool enable_identify_cache;
+
+	/**
+	 * It is used for fabrics transports.
+	 *
+	 * Ask the target to resume the previous controller when the controller is reset or
+	 * reconnected, by sending its CNTLID in the admin queue Connect command instead of
+	 * 0xFFFF. If the target resumes it, still enabled and with its features intact, the
+	 * controller disable/enable sequence and Identify Controller are skipped. Otherwise,
+	 * the admin queue is connected again to a new controller and fully initialized.
+	 *
+	 * Default is `false`.
+	 */
+	bool enable_warm_reconnect;
 } __attribute__((packed));
-SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_ctrlr_opts) == 818, "Incorrect size");
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_ctrlr_opts) == 820, "Incorrect size");
 
 /**
  * NVMe acceleration operation callback.
@@ -3883,6 +3913,26 @@ uint16_t spdk_nvme_qpair_get_id(struct spdk_nvme_qpair *qpair);
  */
 uint32_t spdk_nvme_qpair_get_num_outstanding_reqs(struct spdk_nvme_qpair *qpair);
 
+/**
+ * Select the queue pair with the fewest outstanding requests.
+ *
+ * Used to spread I/O over several queue pairs of the same namespace, so that a queue
+ * pair that is slow to complete, e.g. a TCP connection recovering from packet loss,
+ * stops receiving new I/O. The outstanding requests are counted as in
+ * spdk_nvme_qpair_get_num_outstanding_reqs(), so a split I/O counts as its parent
+ * and each of its children. Only connected queue pairs are considered.
+ *
+ * \param qpairs Array of queue pairs to select from.
+ * \param num_qpairs Number of queue pairs in the array.
+ * \param start Index of the queue pair to start the search from. Ties go to the first
+ * queue pair found, so advancing start on each call keeps round-robin order among
+ * equally loaded queue pairs.
+ *
+ * \return index of the selected queue pair, or start if none of them is connected.
+ */
+uint32_t spdk_nvme_qpair_select_least_outstanding(struct spdk_nvme_qpair **qpairs,
+		uint32_t num_qpairs, uint32_t start);
+
 /**
  * \brief Prints (SPDK_NOTICELOG) the contents of an NVMe submission queue entry (command).
  *
@@ -882,7 +882,9 @@ union spdk_nvme_feat_async_event_configuration {
 		uint8_t fw_activation_notice	: 1;
 		uint8_t telemetry_log_notice	: 1;
 		uint8_t ana_change_notice	: 1;
-		uint8_t reserved1		: 4;
+		/** Predictable latency event aggregate log change notice */
+		uint8_t pleal_change_notice	: 1;
+		uint8_t reserved1		: 3;
 		uint16_t reserved2		: 15;
 		/** Discovery log change (refer to the NVMe over Fabrics specification) */
 		uint16_t discovery_log_change_notice	: 1;
@@ -3539,8 +3541,10 @@ enum spdk_nvme_async_event_info_notice {
 	SPDK_NVME_ASYNC_EVENT_TELEMETRY_LOG_CHANGED	= 0x2,
 	/* Asymmetric Namespace Access Change */
 	SPDK_NVME_ASYNC_EVENT_ANA_CHANGE		= 0x3,
+	/* Predictable Latency Event Aggregate Log Change */
+	SPDK_NVME_ASYNC_EVENT_PLEAL_CHANGE		= 0x4,
 
-	/* 0x4 - 0xEF Reserved */
+	/* 0x5 - 0xEF Reserved */
 
 	/** Discovery log change event(refer to the NVMe over Fabrics specification) */
 	SPDK_NVME_ASYNC_EVENT_DISCOVERY_LOG_CHANGE	= 0xF0,
@@ -3626,6 +3630,100 @@ struct spdk_nvme_ana_group_descriptor {
 };
 SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_ana_group_descriptor) == 32, "Incorrect size");
 
+/* Predictable latency mode window */
+enum spdk_nvme_plm_window {
+	/* 0x0 Not used (Predictable Latency Mode not enabled) */
+
+	/* Deterministic Window */
+	SPDK_NVME_PLM_WINDOW_DTWIN	= 0x1,
+	/* Non-Deterministic Window */
+	SPDK_NVME_PLM_WINDOW_NDWIN	= 0x2,
+
+	/* 0x3 - 0x7 Reserved */
+};
+
+/**
+ * Predictable latency per NVM set page (\ref SPDK_NVME_LOG_PREDICATBLE_LATENCY)
+ *
+ * The NVM Set Identifier is passed as the log specific identifier.
+ */
+struct spdk_nvme_plm_page {
+	struct {
+		/** Current window, see \ref spdk_nvme_plm_window */
+		uint8_t window		: 3;
+		uint8_t reserved	: 5;
+	} status;
+
+	uint8_t reserved1;
+
+	union {
+		uint16_t raw;
+		struct {
+			/** DTWIN reads warning */
+			uint16_t dtwin_reads_warn	: 1;
+			/** DTWIN writes warning */
+			uint16_t dtwin_writes_warn	: 1;
+			/** DTWIN time warning */
+			uint16_t dtwin_time_warn	: 1;
+			uint16_t reserved		: 11;
+			/** Autonomous transition from DTWIN to NDWIN due to typical or maximum value exceeded */
+			uint16_t dtwin_exceeded		: 1;
+			/** Autonomous transition from DTWIN to NDWIN due to deterministic excursion */
+			uint16_t dtwin_excursion	: 1;
+		} bits;
+	} event_type;
+
+	uint8_t reserved4[28];
+
+	/** DTWIN reads typical */
+	uint64_t dtwin_rt;
+	/** DTWIN writes typical */
+	uint64_t dtwin_wt;
+	/** DTWIN time maximum in ms */
+	uint64_t dtwin_tmax;
+	/** NDWIN time minimum high in ms */
+	uint64_t ndwin_tmin_hi;
+	/** NDWIN time minimum low in ms */
+	uint64_t ndwin_tmin_lo;
+
+	uint8_t reserved72[56];
+
+	/** DTWIN reads estimate */
+	uint64_t dtwin_re;
+	/** DTWIN writes estimate */
+	uint64_t dtwin_we;
+	/** DTWIN time estimate in ms */
+	uint64_t dtwin_te;
+
+	uint8_t reserved152[360];
+};
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_plm_page) == 512, "Incorrect size");
+
+/**
+ * Predictable latency event aggregate page (\ref SPDK_NVME_LOG_PREDICTABLE_LATENCY_EVENT)
+ */
+struct spdk_nvme_plm_event_aggregate_page {
+	/** Number of NVM Set Identifier entries */
+	uint64_t num_entries;
+	/** NVM Sets with pending predictable latency events */
+	uint16_t nvmsetid[];
+};
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_plm_event_aggregate_page) == 8, "Incorrect size");
+
+/**
+ * Data used by Set Features/Get Features \ref SPDK_NVME_FEAT_PREDICTABLE_LATENCY_MODE_WINDOW
+ * (command dword 12; the NVM Set Identifier is passed in command dword 11)
+ */
+union spdk_nvme_feat_plm_window {
+	uint32_t raw;
+	struct {
+		/** Window to enter, see \ref spdk_nvme_plm_window */
+		uint32_t wsel		: 3;
+		uint32_t reserved	: 29;
+	} bits;
+};
+SPDK_STATIC_ASSERT(sizeof(union spdk_nvme_feat_plm_window) == 4, "Incorrect size");
+
 /* Reclaim unit handle type */
 enum spdk_nvme_fdp_ruh_type {
 	/* 0x0 Reserved */
@@ -553,6 +553,51 @@ int spdk_nvmf_subsystem_disconnect_host(struct spdk_nvmf_subsystem *subsystem,
 					spdk_nvmf_tgt_subsystem_listen_done_fn cb_fn,
 					void *cb_arg);
 
+/**
+ * Limit the READ and WRITE commands a host may submit to a subsystem.
+ *
+ * The limits apply to each controller the host creates on the subsystem and are
+ * shared by all of the controller's I/O queues, regardless of the poll groups
+ * they are on. Commands exceeding them are queued until the next timeslice, so a
+ * single host can no longer starve the other hosts sharing the namespaces.
+ * Controllers that are already connected pick up the new limits asynchronously.
+ *
+ * \param subsystem Subsystem to operate on.
+ * \param hostnqn The NQN for the host. The host must be on the allowed list.
+ * \param rw_ios_per_sec Maximum number of READ and WRITE commands per second,
+ * 0 for no limit.
+ * \param rw_mbytes_per_sec Maximum number of megabytes read and written per second,
+ * 0 for no limit.
+ * \param weight Share of the namespace limits, set with
+ * spdk_nvmf_subsystem_set_ns_qos_limits(), the host gets relative to the other
+ * hosts queued on the same poll group. Must be between 1 and 100.
+ *
+ * \return 0 on success, or negated errno value on failure.
+ */
+int spdk_nvmf_subsystem_set_host_qos_limits(struct spdk_nvmf_subsystem *subsystem,
+		const char *hostnqn, uint64_t rw_ios_per_sec,
+		uint64_t rw_mbytes_per_sec, uint32_t weight);
+
+/**
+ * Limit the READ and WRITE commands all hosts together may submit to a namespace.
+ *
+ * The limits are shared by every controller and poll group. Commands exceeding
+ * them are queued and dispatched in proportion to the weights of the hosts
+ * that submitted them.
+ *
+ * \param subsystem Subsystem to operate on.
+ * \param nsid Namespace ID to limit.
+ * \param rw_ios_per_sec Maximum number of READ and WRITE commands per second,
+ * 0 for no limit.
+ * \param rw_mbytes_per_sec Maximum number of megabytes read and written per second,
+ * 0 for no limit.
+ *
+ * \return 0 on success, or negated errno value on failure.
+ */
+int spdk_nvmf_subsystem_set_ns_qos_limits(struct spdk_nvmf_subsystem *subsystem,
+		uint32_t nsid, uint64_t rw_ios_per_sec,
+		uint64_t rw_mbytes_per_sec);
+
 /**
  * Set whether a subsystem should allow any host or only hosts in the allowed list.
  *
@@ -732,6 +777,25 @@ bool spdk_nvmf_subsytem_any_listener_allowed(
 int spdk_nvmf_subsystem_set_ana_reporting(struct spdk_nvmf_subsystem *subsystem,
 		bool ana_reporting);
 
+/**
+ * Set how long a controller is kept after its host lost all of its connections
+ * without shutting the controller down.
+ *
+ * Until the timeout expires, the host can resume the controller, with all of its
+ * features, by sending an admin queue Connect command with the controller's CNTLID
+ * instead of 0xFFFF.
+ *
+ * May only be performed on subsystems in the INACTIVE state.
+ *
+ * \param subsystem Subsystem to modify.
+ * \param resume_timeout_ms Timeout in milliseconds, 0 (the default) destroys such
+ * controllers immediately.
+ *
+ * \return 0 on success, or negated errno value on failure.
+ */
+int spdk_nvmf_subsystem_set_resume_timeout(struct spdk_nvmf_subsystem *subsystem,
+		uint32_t resume_timeout_ms);
+
 /** NVMe-oF target namespace creation options */
 struct spdk_nvmf_ns_opts {
 	/**
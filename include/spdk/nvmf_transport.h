@@ -99,6 +99,10 @@ struct spdk_nvmf_request {
 	enum spdk_nvmf_zcopy_phase	zcopy_phase;
 
 	TAILQ_ENTRY(spdk_nvmf_request)	link;
+	/* Used while the request is held back by QoS limits */
+	TAILQ_ENTRY(spdk_nvmf_request)	qos_link;
+	/* Virtual finish time, requests held back are resubmitted in increasing order */
+	uint64_t			qos_tag;
 };
 
 enum spdk_nvmf_qpair_state {
@@ -132,6 +136,12 @@ struct spdk_nvmf_qpair {
 
 	TAILQ_HEAD(, spdk_nvmf_request)		outstanding;
 	TAILQ_ENTRY(spdk_nvmf_qpair)		link;
+
+	/* Requests held back by QoS limits, in submission order */
+	TAILQ_HEAD(, spdk_nvmf_request)		qos_queued;
+	TAILQ_ENTRY(spdk_nvmf_qpair)		qos_link;
+	uint64_t				qos_last_tag;
+	bool					qos_blocked;
 };
 
 struct spdk_nvmf_transport_poll_group {
@@ -162,6 +172,12 @@ struct spdk_nvmf_poll_group {
 	/* All of the queue pairs that belong to this poll group */
 	TAILQ_HEAD(, spdk_nvmf_qpair)			qpairs;
 
+	/* Queue pairs with requests held back by QoS limits, resubmitted by the QoS poller */
+	TAILQ_HEAD(, spdk_nvmf_qpair)			qos_qpairs;
+	struct spdk_poller				*qos_poller;
+	/* Tag of the last resubmitted request */
+	uint64_t					qos_vtime;
+
 	/* Statistics */
 	struct spdk_nvmf_poll_group_stat		stat;
 
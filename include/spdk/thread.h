@@ -18,6 +18,7 @@
 #include "spdk/fd_group.h"
 #include "spdk/stdinc.h"
 #include "spdk/assert.h"
+#include "spdk/barrier.h"
 #include "spdk/cpuset.h"
 #include "spdk/env.h"
 #include "spdk/util.h"
@@ -352,6 +353,26 @@ struct spdk_cpuset *spdk_thread_get_cpumask(struct spdk_thread *thread);
  */
 int spdk_thread_set_cpumask(struct spdk_cpuset *cpumask);
 
+/**
+ * Set the NUMA socket of the devices polled by the thread. Schedulers prefer
+ * to run the thread on cores of this socket. Unlike the cpumask, this is only
+ * a preference and the thread is not rescheduled immediately.
+ *
+ * \param thread The thread to set the socket ID for.
+ * \param socket_id Socket ID, or SPDK_ENV_SOCKET_ID_ANY if the thread has no
+ * device affinity.
+ */
+void spdk_thread_set_socket_id(struct spdk_thread *thread, int socket_id);
+
+/**
+ * Get the NUMA socket of the devices polled by the thread.
+ *
+ * \param thread The thread to get the socket ID for.
+ *
+ * \return Socket ID, or SPDK_ENV_SOCKET_ID_ANY if none was set.
+ */
+int spdk_thread_get_socket_id(const struct spdk_thread *thread);
+
 /**
  * Return the thread object associated with the context handle previously
  * obtained by calling spdk_thread_get_ctx().
@@ -477,6 +498,129 @@ struct spdk_thread_stats {
  */
 int spdk_thread_get_stats(struct spdk_thread_stats *stats);
 
+/** Version of the layout of the thread statistics shared memory region */
+#define SPDK_THREAD_STATS_SHM_VERSION	2
+
+/** Maximum length of a thread name in the shared memory region, including the terminator */
+#define SPDK_THREAD_STATS_SHM_NAME_LEN	257
+
+/**
+ * Statistics a thread publishes in the shared memory region.  The thread updates it
+ * periodically while it is polled, so it is slightly behind the thread's own counters.
+ */
+struct spdk_thread_stats_shm_entry {
+	/** Odd while the thread updates the entry */
+	uint64_t seq;
+	/** ID of the thread, 0 if the entry is unused */
+	uint64_t id;
+	char name[SPDK_THREAD_STATS_SHM_NAME_LEN];
+	char cpumask[SPDK_CPUSET_SIZE / 4 + 1];
+	/** Time of the update, in ticks */
+	uint64_t tsc;
+	uint64_t busy_tsc;
+	uint64_t idle_tsc;
+	uint64_t active_pollers_count;
+	uint64_t timed_pollers_count;
+	uint64_t paused_pollers_count;
+	/** Sums of the statistics of all pollers of the thread */
+	uint64_t poller_run_count;
+	uint64_t poller_busy_count;
+	uint64_t poller_slow_count;
+	uint64_t io_channel_count;
+	/** Messages waiting to be executed by the thread */
+	uint64_t msg_queue_depth;
+	/**
+	 * Whether the thread is in interrupt mode.  Such a thread only refreshes the entry when it
+	 * wakes up, so the busy and idle ticks are not current while it waits for events.
+	 */
+	uint64_t in_interrupt;
+};
+
+/** Thread statistics shared memory region */
+struct spdk_thread_stats_shm {
+	uint32_t version;
+	/** Number of entries */
+	uint32_t max_threads;
+	uint64_t tsc_rate;
+	struct spdk_thread_stats_shm_entry threads[];
+};
+
+/**
+ * Create the shared memory region the threads publish their statistics in.
+ *
+ * Threads beyond the capacity of the region are not published.
+ *
+ * \param shm_name Name of the POSIX shared memory object.
+ * \param max_threads Number of threads the region can hold.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_thread_stats_shm_init(const char *shm_name, uint32_t max_threads);
+
+/**
+ * Get the statistics of the current thread, as it would publish them in the shared memory
+ * region.  Unlike the published ones, they are current.
+ *
+ * \param entry Filled with the statistics of the current thread.
+ *
+ * \return 0 on success, -EINVAL if not called from an SPDK thread.
+ */
+int spdk_thread_get_stats_entry(struct spdk_thread_stats_shm_entry *entry);
+
+/**
+ * Remove the shared memory region created by spdk_thread_stats_shm_init().
+ *
+ * Must not be called while threads are being polled.
+ */
+void spdk_thread_stats_shm_cleanup(void);
+
+/**
+ * Get the thread statistics shared memory region.
+ *
+ * \param shm_name If not NULL, filled with the name of the shared memory object.
+ *
+ * \return the region, or NULL if it was not created.
+ */
+const struct spdk_thread_stats_shm *spdk_thread_stats_shm_get(const char **shm_name);
+
+/**
+ * Copy an entry of the thread statistics shared memory region.
+ *
+ * The entries are updated without locks, so the copy is retried while the thread
+ * updates the entry.  It does not call any other SPDK function, so it can be used by
+ * tools mapping the region from another process.
+ *
+ * \param shm Thread statistics shared memory region.
+ * \param index Index of the entry.
+ * \param entry Filled with a consistent copy of the entry.
+ *
+ * \return true if the entry is used by a thread, false if it is unused or was being
+ * updated for too long.
+ */
+static inline bool
+spdk_thread_stats_shm_read(const struct spdk_thread_stats_shm *shm, uint32_t index,
+			   struct spdk_thread_stats_shm_entry *entry)
+{
+	const volatile struct spdk_thread_stats_shm_entry *src = &shm->threads[index];
+	uint64_t seq;
+	int retries;
+
+	for (retries = 0; retries < 1000; retries++) {
+		seq = src->seq;
+		if (seq & 1) {
+			continue;
+		}
+		spdk_smp_rmb();
+		memcpy(entry, (const void *)src, sizeof(*entry));
+		spdk_smp_rmb();
+		if (src->seq == seq) {
+			return entry->id != 0;
+		}
+	}
+
+	return false;
+}
+
 /**
  * Return the TSC value from the end of the last time this thread was polled.
  *
@@ -502,6 +646,23 @@ uint64_t spdk_thread_get_last_tsc(struct spdk_thread *thread);
  */
 int spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx);
 
+/**
+ * Send a batch of messages to the given thread.
+ *
+ * This is equivalent to calling spdk_thread_send_msg() once per context, in order,
+ * but queues all messages at once and notifies the target thread only once.
+ *
+ * \param thread The target thread.
+ * \param fn This function will be called on the given thread once per context.
+ * \param ctx Array of contexts, each passed to one call of fn.
+ * \param count Number of contexts in the array.
+ *
+ * \return the number of messages sent. It's less than count only if the remaining
+ * messages could not be allocated or the destination thread has exited.
+ */
+uint32_t spdk_thread_send_msg_batch(const struct spdk_thread *thread, spdk_msg_fn fn, void **ctx,
+				    uint32_t count);
+
 /**
  * Send a message to the given thread. Only one critical message can be outstanding at the same
  * time. It's intended to use this function in any cases that might interrupt the execution of the
@@ -751,6 +912,26 @@ struct spdk_thread *spdk_io_channel_get_thread(struct spdk_io_channel *ch);
 void spdk_for_each_channel(void *io_device, spdk_channel_msg fn, void *ctx,
 			   spdk_channel_for_each_cpl cpl);
 
+/**
+ * Call 'fn' on each channel associated with io_device, on all threads at once.
+ *
+ * Unlike spdk_for_each_channel(), the messages to all threads owning a channel
+ * are sent up front, so calls to 'fn' on different threads may overlap in time
+ * and 'ctx' must be safe to access concurrently. Each 'fn' must still call
+ * spdk_for_each_channel_continue() once it is done with its channel. A non-zero
+ * status doesn't stop the calls on other channels; the first non-zero status is
+ * passed to 'cpl'.
+ *
+ * \param io_device 'fn' will be called on each channel associated with this io_device.
+ * \param fn Called on the appropriate thread for each channel associated with io_device.
+ * \param ctx Context buffer registered to spdk_io_channel_iter that can be obtained
+ * form the function spdk_io_channel_iter_get_ctx().
+ * \param cpl Called on the thread that spdk_for_each_channel_parallel was called from
+ * once 'fn' has completed on each channel.
+ */
+void spdk_for_each_channel_parallel(void *io_device, spdk_channel_msg fn, void *ctx,
+				    spdk_channel_for_each_cpl cpl);
+
 /**
  * Get io_device from the I/O channel iterator.
  *
@@ -968,6 +1149,134 @@ void spdk_spin_unlock(struct spdk_spinlock *sspin);
  */
 bool spdk_spin_held(struct spdk_spinlock *sspin);
 
+/**
+ * A task of a background work job, covering a range of the job's indices.
+ */
+struct spdk_work_task;
+
+/**
+ * Function processing one index of a background work job.
+ *
+ * It may be called on any SPDK thread and must call spdk_work_task_done() on that
+ * same thread once the index is processed, either before returning or later, when
+ * an asynchronous operation completes.
+ *
+ * \param ctx Context passed to spdk_work_submit().
+ * \param index Index to process.
+ * \param task Task the index belongs to.
+ */
+typedef void (*spdk_work_fn)(void *ctx, uint64_t index, struct spdk_work_task *task);
+
+/**
+ * Completion callback of a background work job.
+ *
+ * \param ctx Context passed to spdk_work_submit().
+ * \param status 0 if all indices were processed, or the first error reported by
+ * spdk_work_task_done().
+ */
+typedef void (*spdk_work_cpl)(void *ctx, int status);
+
+struct spdk_work_job_opts {
+	/** Number of indices of the job, the work function is called once for each of them */
+	uint64_t count;
+	/** Number of consecutive indices a thread takes at once, 0 means 1 */
+	uint32_t chunk;
+	/** Maximum number of tasks of the job processed at the same time, 0 means no limit */
+	uint32_t max_tasks;
+	/**
+	 * I/O device the work function needs a channel of, or NULL.  The channel is
+	 * retrieved with spdk_work_task_get_io_channel().
+	 */
+	void *io_device;
+};
+
+/**
+ * Submit a background work job.
+ *
+ * The job's indices are split into tasks, which are processed by the calling
+ * thread and stolen by idle SPDK threads, so that long-running background jobs are
+ * spread across reactors.  Busy threads only process tasks of the jobs they
+ * submitted, within the per-iteration budget set by spdk_work_set_opts().  Threads
+ * in interrupt mode never steal tasks.
+ *
+ * Indices are processed in no particular order, possibly at the same time.  Once the
+ * job fails, its remaining indices are skipped.
+ *
+ * Must be called from an SPDK thread.
+ *
+ * \param opts Options of the job.
+ * \param fn Function processing each index.
+ * \param ctx Context passed to fn.
+ * \param cpl_fn Called on the calling thread once all indices are processed.
+ * \param cpl_ctx Context passed to cpl_fn.
+ *
+ * \return 0 on success, -EINVAL if the parameters are invalid, -ENOMEM if the job
+ * cannot be allocated.
+ */
+int spdk_work_submit(const struct spdk_work_job_opts *opts, spdk_work_fn fn, void *ctx,
+		     spdk_work_cpl cpl_fn, void *cpl_ctx);
+
+/**
+ * Report that an index of a background work job was processed.
+ *
+ * Must be called on the thread the work function was called on.
+ *
+ * \param task Task passed to the work function.
+ * \param status 0 on success, negative errno to fail the job.
+ */
+void spdk_work_task_done(struct spdk_work_task *task, int status);
+
+/**
+ * Get the channel of the job's I/O device on the thread processing a task.
+ *
+ * \param task Task passed to the work function.
+ *
+ * \return the I/O channel, or NULL if the job has no I/O device.
+ */
+struct spdk_io_channel *spdk_work_task_get_io_channel(struct spdk_work_task *task);
+
+struct spdk_work_opts {
+	/** Maximum number of tasks processed at the same time by all threads */
+	uint32_t max_tasks;
+	/**
+	 * Time in microseconds a thread may spend processing tasks in one iteration.  A task
+	 * which takes longer continues in a message, from the next index on.
+	 */
+	uint32_t budget_us;
+};
+
+/**
+ * Set the options of background work.
+ *
+ * \param opts Options to set.
+ *
+ * \return 0 on success, -EINVAL if the options are invalid.
+ */
+int spdk_work_set_opts(const struct spdk_work_opts *opts);
+
+/**
+ * Get the options of background work.
+ *
+ * \param opts Options to fill in.
+ */
+void spdk_work_get_opts(struct spdk_work_opts *opts);
+
+/** Maximum number of buffer size classes between the small and the large one */
+#define SPDK_IOBUF_MAX_MEDIUM_CLASSES	4
+
+/** Maximum number of buffer size classes, including the small and the large one */
+#define SPDK_IOBUF_MAX_CLASSES		(SPDK_IOBUF_MAX_MEDIUM_CLASSES + 2)
+
+/** Maximum number of NUMA nodes the iobuf pools are split across */
+#define SPDK_IOBUF_MAX_NODES		8
+
+struct spdk_iobuf_class_opts {
+	/** Maximum number of buffers */
+	uint64_t pool_count;
+	/** Size of a single buffer */
+	uint32_t bufsize;
+};
+
 struct spdk_iobuf_opts {
 	/** Maximum number of small buffers */
 	uint64_t small_pool_count;
@@ -977,6 +1286,13 @@ struct spdk_iobuf_opts {
 	uint32_t small_bufsize;
 	/** Size of a single large buffer */
 	uint32_t large_bufsize;
+	/** Number of medium size classes */
+	uint32_t medium_class_count;
+	/**
+	 * Medium size classes, in increasing order of buffer size.  Their sizes must fall between
+	 * small_bufsize and large_bufsize.
+	 */
+	struct spdk_iobuf_class_opts medium_classes[SPDK_IOBUF_MAX_MEDIUM_CLASSES];
 };
 
 struct spdk_iobuf_entry;
@@ -988,6 +1304,12 @@ struct spdk_iobuf_entry {
 	spdk_iobuf_get_cb		cb_fn;
 	const void			*module;
 	STAILQ_ENTRY(spdk_iobuf_entry)	stailq;
+	/** Virtual finish time, used to share the released buffers between waiting modules */
+	uint64_t			tag;
+	/** Tick count at which the entry started waiting */
+	uint64_t			wait_tsc;
+	/** Queueing order, breaks the ties between equal tags */
+	uint32_t			seq;
 };
 
 
@@ -1019,6 +1341,10 @@ struct spdk_iobuf_channel {
 	struct spdk_iobuf_pool		small;
 	/** Large buffer memory pool */
 	struct spdk_iobuf_pool		large;
+	/** Medium buffer memory pools, in increasing order of buffer size */
+	struct spdk_iobuf_pool		medium[SPDK_IOBUF_MAX_MEDIUM_CLASSES];
+	/** Number of medium buffer memory pools */
+	uint32_t			medium_count;
 	/** Module pointer */
 	const void			*module;
 	/** Parent IO channel */
@@ -1058,6 +1384,42 @@ int spdk_iobuf_set_opts(const struct spdk_iobuf_opts *opts);
  */
 void spdk_iobuf_get_opts(struct spdk_iobuf_opts *opts);
 
+struct spdk_iobuf_module_opts {
+	/**
+	 * Percentage of each buffer pool reserved for the module.  Other modules can't take the
+	 * buffers the module needs to reach its reservation.
+	 */
+	uint32_t reserved_percent;
+	/** Maximum percentage of each buffer pool the module can hold, 0 means no limit */
+	uint32_t max_percent;
+	/**
+	 * Weight of the module when buffers are released while several modules are waiting for
+	 * them.  A module with twice the weight of another one gets twice as many buffers.
+	 * Default is 1.
+	 */
+	uint32_t weight;
+};
+
+/**
+ * Set the options of an iobuf pool user.  The options must be set before
+ * `spdk_iobuf_initialize()` and are kept until `spdk_iobuf_finish()`.  The buffers held by a
+ * module include the ones cached by its channels, so the limit should leave room for those caches.
+ *
+ * \param name Name of the module.
+ * \param opts Options to set.
+ *
+ * \return 0 on success, -EBUSY if the pools are already allocated, negative errno otherwise.
+ */
+int spdk_iobuf_set_module_opts(const char *name, const struct spdk_iobuf_module_opts *opts);
+
+/**
+ * Get the options of an iobuf pool user.
+ *
+ * \param name Name of the module.
+ * \param opts Options to fill in.  Modules without explicit options get the defaults.
+ */
+void spdk_iobuf_get_module_opts(const char *name, struct spdk_iobuf_module_opts *opts);
+
 /**
  * Register a module as an iobuf pool user.  Only registered users can request buffers from the
  * iobuf pool.
@@ -1080,10 +1442,14 @@ int spdk_iobuf_unregister_module(const char *name);
 /**
  * Initialize an iobuf channel.
  *
+ * The channel takes its buffers from the pools allocated on the NUMA node of the calling thread
+ * and only falls back to the other nodes once those are exhausted.
+ *
  * \param ch iobuf channel to initialize.
  * \param name Name of the module registered via `spdk_iobuf_register_module()`.
  * \param small_cache_size Number of small buffers to be cached by this channel.
- * \param large_cache_size Number of large buffers to be cached by this channel.
+ * \param large_cache_size Number of large buffers to be cached by this channel.  The same number
+ *                         of buffers is cached for each medium size class.
  *
  * \return 0 on success, negative errno otherwise.
  */
@@ -1105,7 +1471,7 @@ typedef int (*spdk_iobuf_for_each_entry_fn)(struct spdk_iobuf_channel *ch,
  * using `ch`.  The iteration is stopped if the callback returns non-zero status.
  *
  * \param ch iobuf channel to iterate over.
- * \param pool Pool to iterate over (`small` or `large`).
+ * \param pool Pool to iterate over (`small`, `large` or one of `medium`).
  * \param cb_fn Callback to execute on each entry on the queue that was requested using `ch`.
  * \param cb_ctx Argument passed to `cb_fn`.
  *
@@ -1151,6 +1517,62 @@ void *spdk_iobuf_get(struct spdk_iobuf_channel *ch, uint64_t len, struct spdk_io
  */
 void spdk_iobuf_put(struct spdk_iobuf_channel *ch, void *buf, uint64_t len);
 
+struct spdk_iobuf_node_stats {
+	/** NUMA socket the buffers are allocated on, SPDK_ENV_SOCKET_ID_ANY if not bound */
+	int32_t socket_id;
+	/** Number of buffers allocated on this node */
+	uint64_t count;
+	/** Number of buffers left in the pool, i.e. neither in use nor cached by any channel */
+	uint64_t available;
+};
+
+struct spdk_iobuf_class_stats {
+	/** Size of a single buffer */
+	uint32_t bufsize;
+	/** Number of NUMA nodes the buffers are split across */
+	uint32_t num_nodes;
+	/** Per-node occupancy */
+	struct spdk_iobuf_node_stats nodes[SPDK_IOBUF_MAX_NODES];
+};
+
+struct spdk_iobuf_module_stats {
+	/** Name of the module */
+	const char *name;
+	/**
+	 * Number of buffers held by the module, including the cached ones, per size class.  Only
+	 * counted if any module has a reservation or a limit, zero otherwise.
+	 */
+	uint64_t in_use[SPDK_IOBUF_MAX_CLASSES];
+	/** Number of requests that had to wait for a buffer */
+	uint64_t wait_count;
+	/** Total time spent waiting for buffers, in ticks */
+	uint64_t wait_ticks;
+	/** Longest time a single request waited for a buffer, in ticks */
+	uint64_t max_wait_ticks;
+};
+
+/**
+ * Get the statistics of an iobuf pool user.  The `in_use` counters are indexed the same way as
+ * the size classes in `spdk_iobuf_get_class_stats()`.
+ *
+ * \param index Index of the module.
+ * \param stats Statistics to fill in.
+ *
+ * \return 0 on success, -ENOENT if there's no module with that index.
+ */
+int spdk_iobuf_get_module_stats(uint32_t index, struct spdk_iobuf_module_stats *stats);
+
+/**
+ * Get the occupancy of a buffer size class.  The classes are indexed in increasing order of
+ * buffer size, starting with the small one and ending with the large one.
+ *
+ * \param index Index of the size class.
+ * \param stats Statistics to fill in.
+ *
+ * \return 0 on success, -ENOENT if there's no class with that index.
+ */
+int spdk_iobuf_get_class_stats(uint32_t index, struct spdk_iobuf_class_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
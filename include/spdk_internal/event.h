@@ -86,6 +86,13 @@ struct spdk_reactor {
 
 	struct spdk_fd_group				*fgrp;
 	int						resched_fd;
+
+	/* End of the last iteration which did some work, used by the idle policy */
+	uint64_t					last_busy_tsc;
+	/* Length of the next sleep, doubled after each sleep until work is done */
+	uint64_t					sleep_backoff_tsc;
+	/* Time spent sleeping, which is also accounted as idle */
+	uint64_t					sleep_tsc;
 } __attribute__((aligned(SPDK_CACHE_LINE_SIZE)));
 
 int spdk_reactors_init(size_t msg_mempool_size);
@@ -128,6 +135,41 @@ void spdk_for_each_reactor(spdk_event_fn fn, void *arg1, void *arg2, spdk_event_
 int spdk_reactor_set_interrupt_mode(uint32_t lcore, bool new_in_interrupt,
 				    spdk_reactor_set_interrupt_mode_cb cb_fn, void *cb_arg);
 
+/**
+ * Idle policy of the reactors in poll mode.
+ *
+ * A reactor whose threads have not done any work for spin_us keeps polling, but pauses
+ * the CPU between iterations for the next pause_us, and then sleeps between iterations.
+ * Each sleep is twice as long as the previous one, up to max_sleep_us, and ends no later
+ * than the next timed poller expiration.  Messages and events sent to a sleeping reactor
+ * wait for the end of the sleep.
+ */
+struct spdk_reactor_idle_opts {
+	/** Time in microseconds a reactor keeps busy polling once idle */
+	uint32_t spin_us;
+	/** Time in microseconds a reactor pauses the CPU between iterations after spinning */
+	uint32_t pause_us;
+	/** Maximum time in microseconds a reactor sleeps between iterations, 0 never sleeps */
+	uint32_t max_sleep_us;
+};
+
+/**
+ * Set the idle policy of all reactors.  Setting both pause_us and max_sleep_us to 0
+ * disables the policy, which is the default.
+ *
+ * \param opts Idle policy to set.
+ *
+ * \return 0 on success, -EINVAL if the policy is invalid.
+ */
+int spdk_reactor_set_idle_opts(const struct spdk_reactor_idle_opts *opts);
+
+/**
+ * Get the idle policy of the reactors.
+ *
+ * \param opts Filled with the idle policy.
+ */
+void spdk_reactor_get_idle_opts(struct spdk_reactor_idle_opts *opts);
+
 #ifdef __cplusplus
 }
 #endif
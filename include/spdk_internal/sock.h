@@ -321,6 +321,34 @@ end:
 	return iovcnt;
 }
 
+/*
+ * Build in diov the part of siov that follows the first offset bytes.  Returns the
+ * number of entries filled in, or -1 if they don't fit in IOV_BATCH_SIZE entries.
+ */
+static inline int
+sock_iov_advance(struct iovec *diov, struct iovec *siov, int siovcnt, size_t offset)
+{
+	int i, iovcnt = 0;
+
+	for (i = 0; i < siovcnt; i++) {
+		if (offset >= siov[i].iov_len) {
+			offset -= siov[i].iov_len;
+			continue;
+		}
+
+		if (iovcnt >= IOV_BATCH_SIZE) {
+			return -1;
+		}
+
+		diov[iovcnt].iov_base = (uint8_t *)siov[i].iov_base + offset;
+		diov[iovcnt].iov_len = siov[i].iov_len - offset;
+		iovcnt++;
+		offset = 0;
+	}
+
+	return iovcnt;
+}
+
 static inline void
 spdk_sock_get_placement_id(int fd, enum spdk_placement_mode mode, int *placement_id)
 {
@@ -10,10 +10,13 @@
 #include "spdk/thread.h"
 
 struct spdk_poller;
+struct spdk_histogram_data;
 
 struct spdk_poller_stats {
 	uint64_t	run_count;
 	uint64_t	busy_count;
+	/* Number of executions that took longer than the slow poller threshold. */
+	uint64_t	slow_count;
 };
 
 struct io_device;
@@ -25,6 +28,47 @@ const char *spdk_poller_get_state_str(struct spdk_poller *poller);
 uint64_t spdk_poller_get_period_ticks(struct spdk_poller *poller);
 void spdk_poller_get_stats(struct spdk_poller *poller, struct spdk_poller_stats *stats);
 
+/**
+ * Get the histogram of execution times of a poller, in ticks.  Must be called
+ * from the thread that owns the poller.
+ *
+ * \param poller Poller to query.
+ *
+ * \return the histogram, or NULL if the poller has not run since histograms
+ * were enabled.
+ */
+const struct spdk_histogram_data *spdk_poller_get_histogram(struct spdk_poller *poller);
+
+/**
+ * Enable or disable collecting execution time histograms of all pollers.
+ * Disabling stops the collection, but keeps the data already collected.
+ *
+ * \param enable true to enable, false to disable.
+ */
+void spdk_poller_enable_histograms(bool enable);
+
+/**
+ * Check whether execution time histograms of pollers are collected.
+ *
+ * \return true if enabled, false otherwise.
+ */
+bool spdk_poller_histograms_enabled(void);
+
+/**
+ * Set the execution time above which a poller run is counted as slow and
+ * recorded with the THREAD_SLOW_POLLER trace point.
+ *
+ * \param threshold_us Threshold in microseconds, 0 disables the detection.
+ */
+void spdk_poller_set_slow_threshold(uint64_t threshold_us);
+
+/**
+ * Get the slow poller threshold.
+ *
+ * \return the threshold in microseconds, 0 if the detection is disabled.
+ */
+uint64_t spdk_poller_get_slow_threshold(void);
+
 const char *spdk_io_channel_get_io_device_name(struct spdk_io_channel *ch);
 int spdk_io_channel_get_ref_count(struct spdk_io_channel *ch);
 
@@ -361,6 +361,8 @@ struct spdk_bdev_channel_iter {
 	spdk_bdev_for_each_channel_done cpl;
 	struct spdk_io_channel_iter *i;
 	void *ctx;
+	/* Set for the per-channel copies used by bdev_for_each_channel_parallel() */
+	bool parallel;
 };
 
 struct spdk_bdev_io_error_stat {
@@ -392,6 +394,9 @@ static int bdev_write_zero_buffer(struct spdk_bdev_io *bdev_io);
 static void bdev_enable_qos_msg(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
 				struct spdk_io_channel *ch, void *_ctx);
 static void bdev_enable_qos_done(struct spdk_bdev *bdev, void *_ctx, int status);
+static void bdev_for_each_channel_parallel(struct spdk_bdev *bdev,
+		spdk_bdev_for_each_channel_msg fn, void *ctx,
+		spdk_bdev_for_each_channel_done cpl);
 
 static int bdev_readv_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 				     struct iovec *iov, int iovcnt, void *md_buf, uint64_t offset_blocks,
@@ -4027,8 +4032,14 @@ bdev_abort_all_buf_io_cb(struct spdk_iobuf_channel *ch, struct spdk_iobuf_entry
 static void
 bdev_abort_all_buf_io(struct spdk_bdev_mgmt_channel *mgmt_ch, struct spdk_bdev_channel *ch)
 {
+	uint32_t i;
+
 	spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.small,
 				  bdev_abort_all_buf_io_cb, ch);
+	for (i = 0; i < mgmt_ch->iobuf.medium_count; i++) {
+		spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.medium[i],
+					  bdev_abort_all_buf_io_cb, ch);
+	}
 	spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.large,
 				  bdev_abort_all_buf_io_cb, ch);
 }
@@ -4096,6 +4107,7 @@ bdev_abort_buf_io_cb(struct spdk_iobuf_channel *ch, struct spdk_iobuf_entry *ent
 static bool
 bdev_abort_buf_io(struct spdk_bdev_mgmt_channel *mgmt_ch, struct spdk_bdev_io *bio_to_abort)
 {
+	uint32_t i;
 	int rc;
 
 	rc = spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.small,
@@ -4104,6 +4116,14 @@ bdev_abort_buf_io(struct spdk_bdev_mgmt_channel *mgmt_ch, struct spdk_bdev_io *b
 		return true;
 	}
 
+	for (i = 0; i < mgmt_ch->iobuf.medium_count; i++) {
+		rc = spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.medium[i],
+					       bdev_abort_buf_io_cb, bio_to_abort);
+		if (rc == 1) {
+			return true;
+		}
+	}
+
 	rc = spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.large,
 				       bdev_abort_buf_io_cb, bio_to_abort);
 	return rc == 1;
@@ -6351,7 +6371,10 @@ bdev_get_each_channel_stat(struct spdk_bdev_channel_iter *i, struct spdk_bdev *b
 	struct spdk_bdev_iostat_ctx *bdev_iostat_ctx = _ctx;
 	struct spdk_bdev_channel *channel = __io_ch_to_bdev_ch(ch);
 
+	/* Other channels add their statistics at the same time */
+	spdk_spin_lock(&bdev->internal.spinlock);
 	spdk_bdev_add_io_stat(bdev_iostat_ctx->stat, channel->stat);
+	spdk_spin_unlock(&bdev->internal.spinlock);
 	spdk_bdev_for_each_channel_continue(i, 0);
 }
 
@@ -6382,8 +6405,8 @@ spdk_bdev_get_device_stat(struct spdk_bdev *bdev, struct spdk_bdev_io_stat *stat
 	spdk_spin_unlock(&bdev->internal.spinlock);
 
 	/* Then iterate and add the statistics from each existing channel. */
-	spdk_bdev_for_each_channel(bdev, bdev_get_each_channel_stat, bdev_iostat_ctx,
-				   bdev_get_device_stat_done);
+	bdev_for_each_channel_parallel(bdev, bdev_get_each_channel_stat, bdev_iostat_ctx,
+				       bdev_get_device_stat_done);
 }
 
 struct bdev_iostat_reset_ctx {
@@ -6438,10 +6461,10 @@ bdev_reset_device_stat(struct spdk_bdev *bdev, enum spdk_bdev_reset_stat_mode mo
 	spdk_bdev_reset_io_stat(bdev->internal.stat, mode);
 	spdk_spin_unlock(&bdev->internal.spinlock);
 
-	spdk_bdev_for_each_channel(bdev,
-				   bdev_reset_each_channel_stat,
-				   ctx,
-				   bdev_reset_device_stat_done);
+	bdev_for_each_channel_parallel(bdev,
+				       bdev_reset_each_channel_stat,
+				       ctx,
+				       bdev_reset_device_stat_done);
 }
 
 int
@@ -7679,7 +7702,7 @@ bdev_start_qos(struct spdk_bdev *bdev)
 			return -ENOMEM;
 		}
 		ctx->bdev = bdev;
-		spdk_bdev_for_each_channel(bdev, bdev_enable_qos_msg, ctx, bdev_enable_qos_done);
+		bdev_for_each_channel_parallel(bdev, bdev_enable_qos_msg, ctx, bdev_enable_qos_done);
 	}
 
 	return 0;
@@ -8837,8 +8860,8 @@ spdk_bdev_set_qos_rate_limits(struct spdk_bdev *bdev, uint64_t *limits,
 			/* Enabling */
 			bdev_set_qos_rate_limits(bdev, limits);
 
-			spdk_bdev_for_each_channel(bdev, bdev_enable_qos_msg, ctx,
-						   bdev_enable_qos_done);
+			bdev_for_each_channel_parallel(bdev, bdev_enable_qos_msg, ctx,
+						       bdev_enable_qos_done);
 		} else {
 			/* Updating */
 			bdev_set_qos_rate_limits(bdev, limits);
@@ -8851,8 +8874,8 @@ spdk_bdev_set_qos_rate_limits(struct spdk_bdev *bdev, uint64_t *limits,
 			bdev_set_qos_rate_limits(bdev, limits);
 
 			/* Disabling */
-			spdk_bdev_for_each_channel(bdev, bdev_disable_qos_msg, ctx,
-						   bdev_disable_qos_msg_done);
+			bdev_for_each_channel_parallel(bdev, bdev_disable_qos_msg, ctx,
+						       bdev_disable_qos_msg_done);
 		} else {
 			spdk_spin_unlock(&bdev->internal.spinlock);
 			bdev_set_qos_limit_done(ctx, 0);
@@ -9686,7 +9709,13 @@ spdk_bdev_for_each_bdev_io(struct spdk_bdev *bdev, void *_ctx, spdk_bdev_io_fn f
 void
 spdk_bdev_for_each_channel_continue(struct spdk_bdev_channel_iter *iter, int status)
 {
-	spdk_for_each_channel_continue(iter->i, status);
+	struct spdk_io_channel_iter *i = iter->i;
+
+	if (iter->parallel) {
+		free(iter);
+	}
+
+	spdk_for_each_channel_continue(i, status);
 }
 
 static struct spdk_bdev *
@@ -9743,6 +9772,55 @@ spdk_bdev_for_each_channel(struct spdk_bdev *bdev, spdk_bdev_for_each_channel_ms
 			      iter, bdev_each_channel_cpl);
 }
 
+static void
+bdev_each_channel_parallel_msg(struct spdk_io_channel_iter *i)
+{
+	struct spdk_bdev_channel_iter *iter = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_bdev *bdev = io_channel_iter_get_bdev(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct spdk_bdev_channel_iter *ch_iter;
+
+	/* The channels are visited concurrently, so each one needs its own iterator */
+	ch_iter = calloc(1, sizeof(*ch_iter));
+	if (ch_iter == NULL) {
+		spdk_for_each_channel_continue(i, -ENOMEM);
+		return;
+	}
+
+	*ch_iter = *iter;
+	ch_iter->i = i;
+	ch_iter->parallel = true;
+	iter->fn(ch_iter, bdev, ch, iter->ctx);
+}
+
+/*
+ * Same as spdk_bdev_for_each_channel(), except that 'fn' is called on all channels at
+ * once. Only for operations that don't depend on the order the channels are visited in
+ * and whose 'fn' is safe to run concurrently.
+ */
+static void
+bdev_for_each_channel_parallel(struct spdk_bdev *bdev, spdk_bdev_for_each_channel_msg fn,
+			       void *ctx, spdk_bdev_for_each_channel_done cpl)
+{
+	struct spdk_bdev_channel_iter *iter;
+
+	assert(bdev != NULL && fn != NULL && ctx != NULL);
+
+	iter = calloc(1, sizeof(struct spdk_bdev_channel_iter));
+	if (iter == NULL) {
+		SPDK_ERRLOG("Unable to allocate iterator\n");
+		assert(false);
+		return;
+	}
+
+	iter->fn = fn;
+	iter->cpl = cpl;
+	iter->ctx = ctx;
+
+	spdk_for_each_channel_parallel(__bdev_to_io_dev(bdev), bdev_each_channel_parallel_msg,
+				       iter, bdev_each_channel_cpl);
+}
+
 static void
 bdev_copy_do_write_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 {
@@ -24,6 +24,11 @@
 
 #define BLOB_CRC32C_INITIAL    0xffffffffUL
 
+/* Clusters copied by a background work task of inflate and decouple, one at a time */
+#define BLOB_INFLATE_CHUNK		8
+/* Maximum number of threads copying the clusters of a single blob at once */
+#define BLOB_INFLATE_MAX_TASKS		4
+
 static int bs_register_md_thread(struct spdk_blob_store *bs);
 static int bs_unregister_md_thread(struct spdk_blob_store *bs);
 static void blob_close_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno);
@@ -6098,8 +6103,6 @@ struct spdk_clone_snapshot_ctx {
 
 	struct spdk_io_channel *channel;
 
-	/* Current cluster for inflate operation */
-	uint64_t cluster;
 
 	/* For inflation force allocation of all unallocated clusters and remove
 	 * thin-provisioning. Otherwise only decouple parent and keep clone thin. */
@@ -6767,56 +6770,108 @@ bs_cluster_needs_allocation(struct spdk_blob *blob, uint64_t cluster, bool alloc
 	return (allocate_all || b->blob->active.clusters[cluster] != 0);
 }
 
+struct bs_inflate_cluster_ctx {
+	struct spdk_clone_snapshot_ctx	*ctx;
+	struct spdk_work_task		*task;
+	uint64_t			cluster;
+};
+
+static void bs_inflate_blob_touch_cluster(struct bs_inflate_cluster_ctx *cluster_ctx);
+
 static void
-bs_inflate_blob_touch_next(void *cb_arg, int bserrno)
+bs_inflate_blob_cluster_cpl(void *cb_arg, int bserrno)
 {
-	struct spdk_clone_snapshot_ctx *ctx = (struct spdk_clone_snapshot_ctx *)cb_arg;
+	struct bs_inflate_cluster_ctx *cluster_ctx = cb_arg;
+
+	if (bserrno != 0) {
+		spdk_work_task_done(cluster_ctx->task, bserrno);
+		free(cluster_ctx);
+		return;
+	}
+
+	/* The dummy read is only queued, not copying, if another cluster is being
+	 * allocated on this channel.  Try again until the cluster is allocated.
+	 */
+	bs_inflate_blob_touch_cluster(cluster_ctx);
+}
+
+static void
+bs_inflate_blob_touch_cluster(struct bs_inflate_cluster_ctx *cluster_ctx)
+{
+	struct spdk_clone_snapshot_ctx *ctx = cluster_ctx->ctx;
 	struct spdk_blob *_blob = ctx->original.blob;
+	struct spdk_io_channel *channel = spdk_work_task_get_io_channel(cluster_ctx->task);
 	struct spdk_bs_cpl cpl;
 	spdk_bs_user_op_t *op;
 	uint64_t offset;
 
-	if (bserrno != 0) {
-		bs_clone_snapshot_origblob_cleanup(ctx, bserrno);
+	if (!bs_cluster_needs_allocation(_blob, cluster_ctx->cluster, ctx->allocate_all)) {
+		spdk_work_task_done(cluster_ctx->task, 0);
+		free(cluster_ctx);
 		return;
 	}
 
-	for (; ctx->cluster < _blob->active.num_clusters; ctx->cluster++) {
-		if (bs_cluster_needs_allocation(_blob, ctx->cluster, ctx->allocate_all)) {
-			break;
-		}
+	offset = bs_cluster_to_lba(_blob->bs, cluster_ctx->cluster);
+
+	/* Use a dummy 0B read as a context for cluster copy */
+	cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
+	cpl.u.blob_basic.cb_fn = bs_inflate_blob_cluster_cpl;
+	cpl.u.blob_basic.cb_arg = cluster_ctx;
+
+	op = bs_user_op_alloc(channel, &cpl, SPDK_BLOB_READ, _blob, NULL, 0, offset, 0);
+	if (!op) {
+		spdk_work_task_done(cluster_ctx->task, -ENOMEM);
+		free(cluster_ctx);
+		return;
 	}
 
-	if (ctx->cluster < _blob->active.num_clusters) {
-		offset = bs_cluster_to_lba(_blob->bs, ctx->cluster);
+	bs_allocate_and_copy_cluster(_blob, channel, offset, op);
+}
 
-		/* We may safely increment a cluster before copying */
-		ctx->cluster++;
+static void
+bs_inflate_blob_cluster(void *cb_arg, uint64_t cluster, struct spdk_work_task *task)
+{
+	struct spdk_clone_snapshot_ctx *ctx = (struct spdk_clone_snapshot_ctx *)cb_arg;
+	struct bs_inflate_cluster_ctx *cluster_ctx;
 
-		/* Use a dummy 0B read as a context for cluster copy */
-		cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
-		cpl.u.blob_basic.cb_fn = bs_inflate_blob_touch_next;
-		cpl.u.blob_basic.cb_arg = ctx;
+	if (!bs_cluster_needs_allocation(ctx->original.blob, cluster, ctx->allocate_all)) {
+		spdk_work_task_done(task, 0);
+		return;
+	}
 
-		op = bs_user_op_alloc(ctx->channel, &cpl, SPDK_BLOB_READ, _blob,
-				      NULL, 0, offset, 0);
-		if (!op) {
-			bs_clone_snapshot_origblob_cleanup(ctx, -ENOMEM);
-			return;
-		}
+	cluster_ctx = calloc(1, sizeof(*cluster_ctx));
+	if (!cluster_ctx) {
+		spdk_work_task_done(task, -ENOMEM);
+		return;
+	}
 
-		bs_allocate_and_copy_cluster(_blob, ctx->channel, offset, op);
-	} else {
-		bs_inflate_blob_done(ctx);
+	cluster_ctx->ctx = ctx;
+	cluster_ctx->task = task;
+	cluster_ctx->cluster = cluster;
+	bs_inflate_blob_touch_cluster(cluster_ctx);
+}
+
+static void
+bs_inflate_blob_clusters_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_clone_snapshot_ctx *ctx = (struct spdk_clone_snapshot_ctx *)cb_arg;
+
+	if (bserrno != 0) {
+		bs_clone_snapshot_origblob_cleanup(ctx, bserrno);
+		return;
 	}
+
+	bs_inflate_blob_done(ctx);
 }
 
 static void
 bs_inflate_blob_open_cpl(void *cb_arg, struct spdk_blob *_blob, int bserrno)
 {
 	struct spdk_clone_snapshot_ctx *ctx = (struct spdk_clone_snapshot_ctx *)cb_arg;
+	struct spdk_work_job_opts opts = {};
 	uint64_t clusters_needed;
 	uint64_t i;
+	int rc;
 
 	if (bserrno != 0) {
 		bs_clone_snapshot_cleanup_finish(ctx, bserrno);
@@ -6879,8 +6934,15 @@ bs_inflate_blob_open_cpl(void *cb_arg, struct spdk_blob *_blob, int bserrno)
 		return;
 	}
 
-	ctx->cluster = 0;
-	bs_inflate_blob_touch_next(ctx, 0);
+	/* The clusters are copied in the background by the idle threads too. */
+	opts.count = _blob->active.num_clusters;
+	opts.chunk = BLOB_INFLATE_CHUNK;
+	opts.max_tasks = BLOB_INFLATE_MAX_TASKS;
+	opts.io_device = _blob->bs;
+	rc = spdk_work_submit(&opts, bs_inflate_blob_cluster, ctx, bs_inflate_blob_clusters_cpl, ctx);
+	if (rc != 0) {
+		bs_clone_snapshot_origblob_cleanup(ctx, rc);
+	}
 }
 
 static void
@@ -30,6 +30,7 @@
 #define SPDK_APP_DPDK_DEFAULT_CORE_MASK		"0x1"
 #define SPDK_APP_DPDK_DEFAULT_BASE_VIRTADDR	0x200000000000
 #define SPDK_APP_DEFAULT_CORE_LIMIT		0x140000000 /* 5 GiB */
+#define SPDK_APP_THREAD_STATS_MAX_THREADS	1024
 
 /* For core counts <= 63, the message memory pool size is set to
  * SPDK_DEFAULT_MSG_MEMPOOL_SIZE.
@@ -380,6 +381,25 @@ app_setup_env(struct spdk_app_opts *opts)
 	return rc;
 }
 
+static void
+app_setup_thread_stats(struct spdk_app_opts *opts)
+{
+	char shm_name[64];
+
+	if (opts->shm_id >= 0) {
+		snprintf(shm_name, sizeof(shm_name), "/%s_thread_stats.%d", opts->name,
+			 opts->shm_id);
+	} else {
+		snprintf(shm_name, sizeof(shm_name), "/%s_thread_stats.pid%d", opts->name,
+			 (int)getpid());
+	}
+
+	/* Tools fall back to RPCs without the region, so the app can run without it. */
+	if (spdk_thread_stats_shm_init(shm_name, SPDK_APP_THREAD_STATS_MAX_THREADS) != 0) {
+		SPDK_WARNLOG("Unable to create thread statistics region %s\n", shm_name);
+	}
+}
+
 static int
 app_setup_trace(struct spdk_app_opts *opts)
 {
@@ -794,6 +814,8 @@ spdk_app_start(struct spdk_app_opts *opts_user, spdk_msg_fn start_fn,
 		return 1;
 	}
 
+	app_setup_thread_stats(opts);
+
 	if (!opts->disable_signal_handlers && app_setup_signal_handlers(opts) != 0) {
 		return 1;
 	}
@@ -817,6 +839,7 @@ spdk_app_fini(void)
 {
 	spdk_trace_cleanup();
 	spdk_reactors_fini();
+	spdk_thread_stats_shm_cleanup();
 	spdk_env_fini();
 	spdk_log_close();
 	unclaim_cpu_cores(NULL);
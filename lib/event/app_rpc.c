@@ -13,6 +13,8 @@
 #include "spdk/scheduler.h"
 #include "spdk/thread.h"
 #include "spdk/json.h"
+#include "spdk/base64.h"
+#include "spdk/histogram_data.h"
 
 #include "spdk/log.h"
 #include "spdk_internal/event.h"
@@ -124,6 +126,53 @@ rpc_framework_monitor_context_switch(struct spdk_jsonrpc_request *request,
 SPDK_RPC_REGISTER("framework_monitor_context_switch", rpc_framework_monitor_context_switch,
 		  SPDK_RPC_RUNTIME)
 
+struct rpc_thread_monitor_pollers {
+	bool histograms;
+	uint64_t slow_threshold_us;
+};
+
+static const struct spdk_json_object_decoder rpc_thread_monitor_pollers_decoders[] = {
+	{"histograms", offsetof(struct rpc_thread_monitor_pollers, histograms),
+	 spdk_json_decode_bool, true},
+	{"slow_threshold_us", offsetof(struct rpc_thread_monitor_pollers, slow_threshold_us),
+	 spdk_json_decode_uint64, true},
+};
+
+static void
+rpc_thread_monitor_pollers(struct spdk_jsonrpc_request *request,
+			   const struct spdk_json_val *params)
+{
+	struct rpc_thread_monitor_pollers req = {};
+	struct spdk_json_write_ctx *w;
+
+	req.histograms = spdk_poller_histograms_enabled();
+	req.slow_threshold_us = spdk_poller_get_slow_threshold();
+
+	if (params != NULL) {
+		if (spdk_json_decode_object(params, rpc_thread_monitor_pollers_decoders,
+					    SPDK_COUNTOF(rpc_thread_monitor_pollers_decoders),
+					    &req)) {
+			SPDK_DEBUGLOG(app_rpc, "spdk_json_decode_object failed\n");
+			spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+			return;
+		}
+
+		spdk_poller_enable_histograms(req.histograms);
+		spdk_poller_set_slow_threshold(req.slow_threshold_us);
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_object_begin(w);
+
+	spdk_json_write_named_bool(w, "histograms", spdk_poller_histograms_enabled());
+	spdk_json_write_named_uint64(w, "slow_threshold_us", spdk_poller_get_slow_threshold());
+
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(request, w);
+}
+
+SPDK_RPC_REGISTER("thread_monitor_pollers", rpc_thread_monitor_pollers, SPDK_RPC_RUNTIME)
+
 struct rpc_get_stats_ctx {
 	struct spdk_jsonrpc_request *request;
 	struct spdk_json_write_ctx *w;
@@ -143,7 +192,8 @@ rpc_thread_get_stats_done(void *arg)
 }
 
 static void
-rpc_thread_get_stats_for_each(struct spdk_jsonrpc_request *request, spdk_msg_fn fn)
+rpc_thread_get_stats_for_each(struct spdk_jsonrpc_request *request, spdk_msg_fn fn,
+			      const char *shm_name)
 {
 	struct rpc_get_stats_ctx *ctx;
 
@@ -158,77 +208,161 @@ rpc_thread_get_stats_for_each(struct spdk_jsonrpc_request *request, spdk_msg_fn
 	ctx->w = spdk_jsonrpc_begin_result(ctx->request);
 	spdk_json_write_object_begin(ctx->w);
 	spdk_json_write_named_uint64(ctx->w, "tick_rate", spdk_get_ticks_hz());
+	if (shm_name != NULL) {
+		spdk_json_write_named_string(ctx->w, "shm_name", shm_name);
+	}
 	spdk_json_write_named_array_begin(ctx->w, "threads");
 
 	spdk_for_each_thread(fn, ctx, rpc_thread_get_stats_done);
 }
 
 static void
-_rpc_thread_get_stats(void *arg)
+rpc_thread_write_stats(struct spdk_json_write_ctx *w, struct spdk_thread_stats_shm_entry *entry)
 {
-	struct rpc_get_stats_ctx *ctx = arg;
-	struct spdk_thread *thread = spdk_get_thread();
 	struct spdk_cpuset tmp_mask = {};
-	struct spdk_poller *poller;
-	struct spdk_thread_stats stats;
-	uint64_t active_pollers_count = 0;
-	uint64_t timed_pollers_count = 0;
-	uint64_t paused_pollers_count = 0;
 
-	for (poller = spdk_thread_get_first_active_poller(thread); poller != NULL;
-	     poller = spdk_thread_get_next_active_poller(poller)) {
-		active_pollers_count++;
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "name", entry->name);
+	spdk_json_write_named_uint64(w, "id", entry->id);
+	if (spdk_cpuset_parse(&tmp_mask, entry->cpumask) == 0) {
+		spdk_cpuset_and(&tmp_mask, spdk_app_get_core_mask());
+	} else {
+		spdk_cpuset_copy(&tmp_mask, spdk_app_get_core_mask());
 	}
+	spdk_json_write_named_string(w, "cpumask", spdk_cpuset_fmt(&tmp_mask));
+	spdk_json_write_named_uint64(w, "busy", entry->busy_tsc);
+	spdk_json_write_named_uint64(w, "idle", entry->idle_tsc);
+	spdk_json_write_named_uint64(w, "active_pollers_count", entry->active_pollers_count);
+	spdk_json_write_named_uint64(w, "timed_pollers_count", entry->timed_pollers_count);
+	spdk_json_write_named_uint64(w, "paused_pollers_count", entry->paused_pollers_count);
+	spdk_json_write_named_uint64(w, "poller_run_count", entry->poller_run_count);
+	spdk_json_write_named_uint64(w, "poller_busy_count", entry->poller_busy_count);
+	spdk_json_write_named_uint64(w, "poller_slow_count", entry->poller_slow_count);
+	spdk_json_write_named_uint64(w, "io_channel_count", entry->io_channel_count);
+	spdk_json_write_named_uint64(w, "msg_queue_depth", entry->msg_queue_depth);
+	spdk_json_write_object_end(w);
+}
 
-	for (poller = spdk_thread_get_first_timed_poller(thread); poller != NULL;
-	     poller = spdk_thread_get_next_timed_poller(poller)) {
-		timed_pollers_count++;
+static void
+_rpc_thread_get_stats(void *arg)
+{
+	struct rpc_get_stats_ctx *ctx = arg;
+	struct spdk_thread_stats_shm_entry entry;
+
+	if (0 == spdk_thread_get_stats_entry(&entry)) {
+		rpc_thread_write_stats(ctx->w, &entry);
 	}
+}
 
-	for (poller = spdk_thread_get_first_paused_poller(thread); poller != NULL;
-	     poller = spdk_thread_get_next_paused_poller(poller)) {
-		paused_pollers_count++;
+/*
+ * The region can only be used if it lists every thread and none of them waits for events in
+ * interrupt mode, as such a thread doesn't refresh its busy and idle ticks while it sleeps.
+ */
+static bool
+rpc_thread_stats_shm_is_current(const struct spdk_thread_stats_shm *shm)
+{
+	struct spdk_thread_stats_shm_entry entry;
+	uint32_t i, count = 0;
+
+	for (i = 0; i < shm->max_threads; i++) {
+		if (!spdk_thread_stats_shm_read(shm, i, &entry)) {
+			continue;
+		}
+		if (entry.in_interrupt) {
+			return false;
+		}
+		count++;
 	}
 
-	if (0 == spdk_thread_get_stats(&stats)) {
-		spdk_json_write_object_begin(ctx->w);
-		spdk_json_write_named_string(ctx->w, "name", spdk_thread_get_name(thread));
-		spdk_json_write_named_uint64(ctx->w, "id", spdk_thread_get_id(thread));
-		spdk_cpuset_copy(&tmp_mask, spdk_app_get_core_mask());
-		spdk_cpuset_and(&tmp_mask, spdk_thread_get_cpumask(thread));
-		spdk_json_write_named_string(ctx->w, "cpumask", spdk_cpuset_fmt(&tmp_mask));
-		spdk_json_write_named_uint64(ctx->w, "busy", stats.busy_tsc);
-		spdk_json_write_named_uint64(ctx->w, "idle", stats.idle_tsc);
-		spdk_json_write_named_uint64(ctx->w, "active_pollers_count", active_pollers_count);
-		spdk_json_write_named_uint64(ctx->w, "timed_pollers_count", timed_pollers_count);
-		spdk_json_write_named_uint64(ctx->w, "paused_pollers_count", paused_pollers_count);
-		spdk_json_write_object_end(ctx->w);
+	return count >= spdk_thread_get_count();
+}
+
+static void
+rpc_thread_get_stats_shm(struct spdk_jsonrpc_request *request,
+			 const struct spdk_thread_stats_shm *shm, const char *shm_name)
+{
+	struct spdk_json_write_ctx *w;
+	struct spdk_thread_stats_shm_entry entry;
+	uint32_t i;
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_uint64(w, "tick_rate", shm->tsc_rate);
+	spdk_json_write_named_string(w, "shm_name", shm_name);
+	spdk_json_write_named_array_begin(w, "threads");
+
+	for (i = 0; i < shm->max_threads; i++) {
+		if (spdk_thread_stats_shm_read(shm, i, &entry)) {
+			rpc_thread_write_stats(w, &entry);
+		}
 	}
+
+	spdk_json_write_array_end(w);
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(request, w);
 }
 
 static void
 rpc_thread_get_stats(struct spdk_jsonrpc_request *request,
 		     const struct spdk_json_val *params)
 {
+	const struct spdk_thread_stats_shm *shm;
+	const char *shm_name;
+
 	if (params) {
 		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
 						 "'thread_get_stats' requires no arguments");
 		return;
 	}
 
-	rpc_thread_get_stats_for_each(request, _rpc_thread_get_stats);
+	/* Threads publish their statistics themselves, no need to interrupt them. */
+	shm = spdk_thread_stats_shm_get(&shm_name);
+	if (shm != NULL && rpc_thread_stats_shm_is_current(shm)) {
+		rpc_thread_get_stats_shm(request, shm, shm_name);
+		return;
+	}
+
+	rpc_thread_get_stats_for_each(request, _rpc_thread_get_stats, shm_name);
 }
 
 SPDK_RPC_REGISTER("thread_get_stats", rpc_thread_get_stats, SPDK_RPC_RUNTIME)
 
+static void
+rpc_get_poller_histogram(const struct spdk_histogram_data *histogram,
+			 struct spdk_json_write_ctx *w)
+{
+	char *encoded_histogram;
+	size_t src_len, dst_len;
+
+	src_len = SPDK_HISTOGRAM_NUM_BUCKETS(histogram) * sizeof(uint64_t);
+	dst_len = spdk_base64_get_encoded_strlen(src_len) + 1;
+
+	encoded_histogram = malloc(dst_len);
+	if (encoded_histogram == NULL) {
+		return;
+	}
+
+	if (spdk_base64_encode(encoded_histogram, histogram->bucket, src_len) == 0) {
+		spdk_json_write_named_object_begin(w, "histogram");
+		spdk_json_write_named_string(w, "histogram", encoded_histogram);
+		spdk_json_write_named_int64(w, "bucket_shift", histogram->bucket_shift);
+		spdk_json_write_named_int64(w, "tsc_rate", spdk_get_ticks_hz());
+		spdk_json_write_object_end(w);
+	}
+
+	free(encoded_histogram);
+}
+
 static void
 rpc_get_poller(struct spdk_poller *poller, struct spdk_json_write_ctx *w)
 {
+	const struct spdk_histogram_data *histogram;
 	struct spdk_poller_stats stats;
 	uint64_t period_ticks;
 
 	period_ticks = spdk_poller_get_period_ticks(poller);
 	spdk_poller_get_stats(poller, &stats);
+	histogram = spdk_poller_get_histogram(poller);
 
 	spdk_json_write_object_begin(w);
 	spdk_json_write_named_string(w, "name", spdk_poller_get_name(poller));
@@ -236,9 +370,13 @@ rpc_get_poller(struct spdk_poller *poller, struct spdk_json_write_ctx *w)
 	spdk_json_write_named_string(w, "state", spdk_poller_get_state_str(poller));
 	spdk_json_write_named_uint64(w, "run_count", stats.run_count);
 	spdk_json_write_named_uint64(w, "busy_count", stats.busy_count);
+	spdk_json_write_named_uint64(w, "slow_count", stats.slow_count);
 	if (period_ticks) {
 		spdk_json_write_named_uint64(w, "period_ticks", period_ticks);
 	}
+	if (histogram != NULL) {
+		rpc_get_poller_histogram(histogram, w);
+	}
 	spdk_json_write_object_end(w);
 }
 
@@ -287,7 +425,7 @@ rpc_thread_get_pollers(struct spdk_jsonrpc_request *request,
 		return;
 	}
 
-	rpc_thread_get_stats_for_each(request, _rpc_thread_get_pollers);
+	rpc_thread_get_stats_for_each(request, _rpc_thread_get_pollers, NULL);
 }
 
 SPDK_RPC_REGISTER("thread_get_pollers", rpc_thread_get_pollers, SPDK_RPC_RUNTIME)
@@ -331,7 +469,7 @@ rpc_thread_get_io_channels(struct spdk_jsonrpc_request *request,
 		return;
 	}
 
-	rpc_thread_get_stats_for_each(request, _rpc_thread_get_io_channels);
+	rpc_thread_get_stats_for_each(request, _rpc_thread_get_io_channels, NULL);
 }
 
 SPDK_RPC_REGISTER("thread_get_io_channels", rpc_thread_get_io_channels, SPDK_RPC_RUNTIME);
@@ -371,6 +509,7 @@ _rpc_framework_get_reactors(void *arg1, void *arg2)
 	spdk_json_write_named_uint32(ctx->w, "lcore", current_core);
 	spdk_json_write_named_uint64(ctx->w, "busy", reactor->busy_tsc);
 	spdk_json_write_named_uint64(ctx->w, "idle", reactor->idle_tsc);
+	spdk_json_write_named_uint64(ctx->w, "sleep", reactor->sleep_tsc);
 	spdk_json_write_named_bool(ctx->w, "in_interrupt", reactor->in_interrupt);
 
 	governor = spdk_governor_get();
@@ -432,6 +571,53 @@ rpc_framework_get_reactors(struct spdk_jsonrpc_request *request,
 
 SPDK_RPC_REGISTER("framework_get_reactors", rpc_framework_get_reactors, SPDK_RPC_RUNTIME)
 
+static const struct spdk_json_object_decoder rpc_framework_reactor_idle_policy_decoders[] = {
+	{"spin_us", offsetof(struct spdk_reactor_idle_opts, spin_us), spdk_json_decode_uint32, true},
+	{"pause_us", offsetof(struct spdk_reactor_idle_opts, pause_us), spdk_json_decode_uint32, true},
+	{"max_sleep_us", offsetof(struct spdk_reactor_idle_opts, max_sleep_us), spdk_json_decode_uint32, true},
+};
+
+static void
+rpc_framework_reactor_idle_policy(struct spdk_jsonrpc_request *request,
+				  const struct spdk_json_val *params)
+{
+	struct spdk_reactor_idle_opts opts;
+	struct spdk_json_write_ctx *w;
+	int rc;
+
+	spdk_reactor_get_idle_opts(&opts);
+
+	if (params != NULL) {
+		if (spdk_json_decode_object(params, rpc_framework_reactor_idle_policy_decoders,
+					    SPDK_COUNTOF(rpc_framework_reactor_idle_policy_decoders),
+					    &opts)) {
+			SPDK_DEBUGLOG(app_rpc, "spdk_json_decode_object failed\n");
+			spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+			return;
+		}
+
+		rc = spdk_reactor_set_idle_opts(&opts);
+		if (rc != 0) {
+			spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+							 spdk_strerror(-rc));
+			return;
+		}
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_object_begin(w);
+
+	spdk_json_write_named_uint32(w, "spin_us", opts.spin_us);
+	spdk_json_write_named_uint32(w, "pause_us", opts.pause_us);
+	spdk_json_write_named_uint32(w, "max_sleep_us", opts.max_sleep_us);
+
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(request, w);
+}
+
+SPDK_RPC_REGISTER("framework_reactor_idle_policy", rpc_framework_reactor_idle_policy,
+		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
+
 struct rpc_set_scheduler_ctx {
 	char *name;
 	uint64_t period;
@@ -28,6 +28,10 @@
 
 #define SPDK_EVENT_BATCH_SIZE		8
 
+#define SPDK_REACTOR_IDLE_DEFAULT_SPIN_US	1000
+/* Longest sleep the idle policy accepts, bounding the wake-up latency */
+#define SPDK_REACTOR_IDLE_MAX_SLEEP_US		100000
+
 static struct spdk_reactor *g_reactors;
 static uint32_t g_reactor_count;
 static struct spdk_cpuset g_reactor_core_mask;
@@ -52,6 +56,15 @@ TAILQ_HEAD(, spdk_governor) g_governor_list
 
 static struct spdk_governor *g_governor = NULL;
 
+static struct spdk_reactor_idle_opts g_reactor_idle_opts = {
+	.spin_us = SPDK_REACTOR_IDLE_DEFAULT_SPIN_US,
+};
+/* The idle policy in ticks, only set while it is enabled. */
+static bool g_reactor_idle_enabled = false;
+static uint64_t g_reactor_idle_spin_tsc;
+static uint64_t g_reactor_idle_pause_tsc;
+static uint64_t g_reactor_idle_max_sleep_tsc;
+
 static int reactor_interrupt_init(struct spdk_reactor *reactor);
 static void reactor_interrupt_fini(struct spdk_reactor *reactor);
 
@@ -889,15 +902,17 @@ reactor_interrupt_run(struct spdk_reactor *reactor)
 	spdk_fd_group_wait(reactor->fgrp, block_timeout);
 }
 
-static void
+/* Returns true if any event was executed or any thread did some work. */
+static bool
 _reactor_run(struct spdk_reactor *reactor)
 {
 	struct spdk_thread	*thread;
 	struct spdk_lw_thread	*lw_thread, *tmp;
 	uint64_t		now;
 	int			rc;
+	bool			busy;
 
-	event_queue_run_batch(reactor);
+	busy = event_queue_run_batch(reactor) > 0;
 
 	/* If no threads are present on the reactor,
 	 * tsc_last gets outdated. Update it to track
@@ -906,7 +921,7 @@ _reactor_run(struct spdk_reactor *reactor)
 		now = spdk_get_ticks();
 		reactor->idle_tsc += now - reactor->tsc_last;
 		reactor->tsc_last = now;
-		return;
+		return busy;
 	}
 
 	TAILQ_FOREACH_SAFE(lw_thread, &reactor->threads, link, tmp) {
@@ -918,11 +933,106 @@ _reactor_run(struct spdk_reactor *reactor)
 			reactor->idle_tsc += now - reactor->tsc_last;
 		} else if (rc > 0) {
 			reactor->busy_tsc += now - reactor->tsc_last;
+			busy = true;
 		}
 		reactor->tsc_last = now;
 
 		reactor_post_process_lw_thread(reactor, lw_thread);
 	}
+
+	return busy;
+}
+
+int
+spdk_reactor_set_idle_opts(const struct spdk_reactor_idle_opts *opts)
+{
+	uint64_t ticks_hz = spdk_get_ticks_hz();
+
+	if (opts->max_sleep_us > SPDK_REACTOR_IDLE_MAX_SLEEP_US) {
+		SPDK_ERRLOG("max_sleep_us must not exceed %u\n", SPDK_REACTOR_IDLE_MAX_SLEEP_US);
+		return -EINVAL;
+	}
+
+	g_reactor_idle_opts = *opts;
+	g_reactor_idle_spin_tsc = opts->spin_us * ticks_hz / SPDK_SEC_TO_USEC;
+	g_reactor_idle_pause_tsc = opts->pause_us * ticks_hz / SPDK_SEC_TO_USEC;
+	g_reactor_idle_max_sleep_tsc = opts->max_sleep_us * ticks_hz / SPDK_SEC_TO_USEC;
+	g_reactor_idle_enabled = opts->pause_us != 0 || opts->max_sleep_us != 0;
+
+	return 0;
+}
+
+void
+spdk_reactor_get_idle_opts(struct spdk_reactor_idle_opts *opts)
+{
+	*opts = g_reactor_idle_opts;
+}
+
+static uint64_t
+reactor_next_poller_expiration(struct spdk_reactor *reactor)
+{
+	struct spdk_lw_thread *lw_thread;
+	uint64_t next, expiration = UINT64_MAX;
+
+	TAILQ_FOREACH(lw_thread, &reactor->threads, link) {
+		next = spdk_thread_next_poller_expiration(spdk_thread_get_from_ctx(lw_thread));
+		if (next != 0 && next < expiration) {
+			expiration = next;
+		}
+	}
+
+	return expiration;
+}
+
+/*
+ * Back off from busy polling once the reactor has been idle for a while: first pause
+ * the CPU between iterations, which gives way to the SMT sibling, then sleep.
+ */
+static void
+reactor_idle(struct spdk_reactor *reactor, bool busy)
+{
+	struct timespec ts;
+	uint64_t idle_tsc, sleep_tsc, expiration, now, ns;
+
+	if (busy) {
+		reactor->last_busy_tsc = reactor->tsc_last;
+		reactor->sleep_backoff_tsc = 0;
+		return;
+	}
+
+	idle_tsc = reactor->tsc_last - reactor->last_busy_tsc;
+	if (idle_tsc < g_reactor_idle_spin_tsc) {
+		return;
+	}
+
+	if (idle_tsc < g_reactor_idle_spin_tsc + g_reactor_idle_pause_tsc ||
+	    g_reactor_idle_max_sleep_tsc == 0) {
+		spdk_pause();
+		return;
+	}
+
+	sleep_tsc = reactor->sleep_backoff_tsc;
+	if (sleep_tsc == 0) {
+		sleep_tsc = spdk_max(spdk_get_ticks_hz() / SPDK_SEC_TO_USEC, 1);
+	}
+	sleep_tsc = spdk_min(sleep_tsc, g_reactor_idle_max_sleep_tsc);
+	reactor->sleep_backoff_tsc = sleep_tsc * 2;
+
+	expiration = reactor_next_poller_expiration(reactor);
+	if (expiration <= reactor->tsc_last) {
+		return;
+	}
+	sleep_tsc = spdk_min(sleep_tsc, expiration - reactor->tsc_last);
+
+	ns = sleep_tsc * SPDK_SEC_TO_NSEC / spdk_get_ticks_hz();
+	ts.tv_sec = ns / SPDK_SEC_TO_NSEC;
+	ts.tv_nsec = ns % SPDK_SEC_TO_NSEC;
+	nanosleep(&ts, NULL);
+
+	now = spdk_get_ticks();
+	reactor->sleep_tsc += now - reactor->tsc_last;
+	reactor->idle_tsc += now - reactor->tsc_last;
+	reactor->tsc_last = now;
 }
 
 static int
@@ -933,6 +1043,7 @@ reactor_run(void *arg)
 	struct spdk_lw_thread	*lw_thread, *tmp;
 	char			thread_name[32];
 	uint64_t		last_sched = 0;
+	bool			busy;
 
 	SPDK_NOTICELOG("Reactor started on core %u\n", reactor->lcore);
 
@@ -943,13 +1054,17 @@ reactor_run(void *arg)
 	_set_thread_name(thread_name);
 
 	reactor->tsc_last = spdk_get_ticks();
+	reactor->last_busy_tsc = reactor->tsc_last;
 
 	while (1) {
 		/* Execute interrupt process fn if this reactor currently runs in interrupt state */
 		if (spdk_unlikely(reactor->in_interrupt)) {
 			reactor_interrupt_run(reactor);
 		} else {
-			_reactor_run(reactor);
+			busy = _reactor_run(reactor);
+			if (spdk_unlikely(g_reactor_idle_enabled)) {
+				reactor_idle(reactor, busy);
+			}
 		}
 
 		if (g_framework_context_switch_monitor_enabled) {
@@ -15,6 +15,13 @@
 #include "ftl_mngt_steps.h"
 #include "utils/ftl_addr_utils.h"
 
+/*
+ * Number of LBAs of the L2P snippet initialized by one index of the background work
+ * job, small enough to fit in the work budget.  A task takes a few indices at once.
+ */
+#define FTL_RECOVERY_SEQ_ID_LBAS	4096
+#define FTL_RECOVERY_SEQ_ID_CHUNK	16
+
 struct ftl_mngt_recovery_ctx {
 	/* Main recovery FTL management process */
 	struct ftl_mngt_process *main;
@@ -318,22 +325,21 @@ ftl_mngt_recovery_walk_band_tail_md(struct spdk_ftl_dev *dev, struct ftl_mngt_pr
 }
 
 static void
-ftl_mngt_recovery_iteration_init_seq_ids(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt)
+recovery_iteration_init_seq_ids(void *cb_arg, uint64_t index, struct spdk_work_task *task)
 {
+	struct ftl_mngt_process *mngt = cb_arg;
+	struct spdk_ftl_dev *dev = ftl_mngt_get_dev(mngt);
 	struct ftl_mngt_recovery_ctx *ctx = ftl_mngt_get_caller_ctx(mngt);
 	struct ftl_md *md = dev->layout.md[FTL_LAYOUT_REGION_TYPE_TRIM_MD];
 	uint64_t *trim_map = ftl_md_get_buffer(md);
 	uint64_t page_id, trim_seq_id;
 	uint32_t lbas_in_page = FTL_BLOCK_SIZE / dev->layout.l2p.addr_size;
-	uint64_t lba, lba_off;
+	uint64_t lba, lba_off, lba_first, lba_last;
 
-	if (dev->sb->ckpt_seq_id) {
-		FTL_ERRLOG(dev, "Checkpoint recovery not supported!\n");
-		ftl_mngt_fail_step(mngt);
-		return;
-	}
+	lba_first = ctx->iter.lba_first + index * FTL_RECOVERY_SEQ_ID_LBAS;
+	lba_last = spdk_min(lba_first + FTL_RECOVERY_SEQ_ID_LBAS, ctx->iter.lba_last);
 
-	for (lba = ctx->iter.lba_first; lba < ctx->iter.lba_last; lba++) {
+	for (lba = lba_first; lba < lba_last; lba++) {
 		lba_off = lba - ctx->iter.lba_first;
 		page_id = lba / lbas_in_page;
 
@@ -347,7 +353,41 @@ ftl_mngt_recovery_iteration_init_seq_ids(struct spdk_ftl_dev *dev, struct ftl_mn
 		ftl_addr_store(dev, ctx->l2p_snippet.l2p, lba_off, FTL_ADDR_INVALID);
 	}
 
-	ftl_mngt_next_step(mngt);
+	spdk_work_task_done(task, 0);
+}
+
+static void
+recovery_iteration_init_seq_ids_cpl(void *cb_arg, int status)
+{
+	struct ftl_mngt_process *mngt = cb_arg;
+
+	if (status) {
+		ftl_mngt_fail_step(mngt);
+	} else {
+		ftl_mngt_next_step(mngt);
+	}
+}
+
+static void
+ftl_mngt_recovery_iteration_init_seq_ids(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt)
+{
+	struct ftl_mngt_recovery_ctx *ctx = ftl_mngt_get_caller_ctx(mngt);
+	struct spdk_work_job_opts opts = {};
+
+	if (dev->sb->ckpt_seq_id) {
+		FTL_ERRLOG(dev, "Checkpoint recovery not supported!\n");
+		ftl_mngt_fail_step(mngt);
+		return;
+	}
+
+	/* The snippet is split into ranges initialized by the idle threads too */
+	opts.count = spdk_divide_round_up(ctx->iter.lba_last - ctx->iter.lba_first,
+					  FTL_RECOVERY_SEQ_ID_LBAS);
+	opts.chunk = FTL_RECOVERY_SEQ_ID_CHUNK;
+	if (spdk_work_submit(&opts, recovery_iteration_init_seq_ids, mngt,
+			     recovery_iteration_init_seq_ids_cpl, mngt)) {
+		ftl_mngt_fail_step(mngt);
+	}
 }
 
 static void
@@ -963,6 +963,8 @@ nvme_ctrlr_opts_init(struct spdk_nvme_ctrlr_opts *opts,
 	SET_FIELD(disable_read_ana_log_page);
 	SET_FIELD(disable_read_changed_ns_list_log_page);
 	SET_FIELD_ARRAY(psk);
+	SET_FIELD(enable_identify_cache);
+	SET_FIELD(enable_warm_reconnect);
 
 #undef FIELD_OK
 #undef SET_FIELD
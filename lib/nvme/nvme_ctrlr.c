@@ -238,6 +238,9 @@ spdk_nvme_ctrlr_get_default_ctrlr_opts(struct spdk_nvme_ctrlr_opts *opts, size_t
 		memset(opts->psk, 0, sizeof(opts->psk));
 	}
 
+	SET_FIELD(enable_identify_cache, false);
+	SET_FIELD(enable_warm_reconnect, false);
+
 #undef FIELD_OK
 #undef SET_FIELD
 }
@@ -1616,6 +1619,15 @@ nvme_ctrlr_disconnect(struct spdk_nvme_ctrlr *ctrlr)
 		return ctrlr->is_resetting ? -EBUSY : -ENXIO;
 	}
 
+	/* Only a controller that completed its initialization is worth resuming */
+	if (ctrlr->opts.enable_warm_reconnect && spdk_nvme_ctrlr_is_fabrics(ctrlr) &&
+	    ctrlr->state == NVME_CTRLR_STATE_READY) {
+		ctrlr->resume.cntlid = ctrlr->cntlid;
+	} else {
+		ctrlr->resume.cntlid = 0xFFFF;
+	}
+	ctrlr->resume.resumed = false;
+
 	ctrlr->is_resetting = true;
 	ctrlr->is_failed = false;
 	ctrlr->is_disconnecting = true;
@@ -1907,6 +1919,121 @@ spdk_nvme_ctrlr_set_remove_cb(struct spdk_nvme_ctrlr *ctrlr,
 	nvme_robust_mutex_unlock(&ctrlr->ctrlr_lock);
 }
 
+static void
+nvme_ctrlr_identify_cache_drop(struct spdk_nvme_ctrlr *ctrlr)
+{
+	struct spdk_nvme_ns *ns;
+
+	ctrlr->identify_cache.hit = false;
+
+	RB_FOREACH(ns, nvme_ns_tree, &ctrlr->ns) {
+		ns->identify_cached = false;
+	}
+}
+
+static void
+nvme_ctrlr_identify_cache_save(struct spdk_nvme_ctrlr *ctrlr)
+{
+	ctrlr->identify_cache.hit = false;
+
+	if (!ctrlr->identify_cache.valid) {
+		return;
+	}
+
+	/* Remember who the controller was before the Identify data gets overwritten. */
+	ctrlr->identify_cache.cntlid = ctrlr->cdata.cntlid;
+	ctrlr->identify_cache.nn = ctrlr->cdata.nn;
+	memcpy(ctrlr->identify_cache.sn, ctrlr->cdata.sn, sizeof(ctrlr->identify_cache.sn));
+	memcpy(ctrlr->identify_cache.subnqn, ctrlr->cdata.subnqn, sizeof(ctrlr->identify_cache.subnqn));
+}
+
+static void
+nvme_ctrlr_identify_cache_check(struct spdk_nvme_ctrlr *ctrlr)
+{
+	bool hit = false;
+
+	if (ctrlr->identify_cache.valid) {
+		hit = ctrlr->identify_cache.nn == ctrlr->cdata.nn &&
+		      memcmp(ctrlr->identify_cache.sn, ctrlr->cdata.sn,
+			     sizeof(ctrlr->identify_cache.sn)) == 0 &&
+		      memcmp(ctrlr->identify_cache.subnqn, ctrlr->cdata.subnqn,
+			     sizeof(ctrlr->identify_cache.subnqn)) == 0;
+		/*
+		 * Fabrics controllers using the dynamic controller model get a new CNTLID
+		 * for every association, so only PCIe controllers are expected to keep it.
+		 */
+		if (ctrlr->trid.trtype == SPDK_NVME_TRANSPORT_PCIE &&
+		    ctrlr->identify_cache.cntlid != ctrlr->cdata.cntlid) {
+			hit = false;
+		}
+	}
+
+	/* The cache is marked valid again once the initialization completes. */
+	ctrlr->identify_cache.valid = false;
+
+	if (hit) {
+		NVME_CTRLR_DEBUGLOG(ctrlr, "Reusing cached namespace identify data\n");
+		ctrlr->identify_cache.hit = true;
+		return;
+	}
+
+	nvme_ctrlr_identify_cache_drop(ctrlr);
+}
+
+static void
+nvme_ctrlr_identify_cache_update(struct spdk_nvme_ctrlr *ctrlr)
+{
+	struct spdk_nvme_ns *ns;
+
+	/* Only the initialization that checked the cache may take data from it */
+	ctrlr->identify_cache.hit = false;
+
+	/* The event is processed after the initialization, which validates the cache then */
+	if (!ctrlr->opts.enable_identify_cache || ctrlr->identify_cache.ns_changed) {
+		return;
+	}
+
+	RB_FOREACH(ns, nvme_ns_tree, &ctrlr->ns) {
+		ns->identify_cached = ns->active;
+	}
+
+	ctrlr->identify_cache.valid = true;
+}
+
+static inline bool
+nvme_ctrlr_ns_identify_cached(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_ns *ns)
+{
+	return ctrlr->identify_cache.hit && ns->identify_cached;
+}
+
+/*
+ * Return the first active namespace after prev_nsid (or the first active namespace
+ * if prev_nsid is 0) whose data cannot be taken from the identify cache.
+ */
+static uint32_t
+nvme_ctrlr_get_next_ns_to_identify(struct spdk_nvme_ctrlr *ctrlr, uint32_t prev_nsid)
+{
+	struct spdk_nvme_ns *ns;
+	uint32_t nsid;
+
+	if (prev_nsid == 0) {
+		nsid = spdk_nvme_ctrlr_get_first_active_ns(ctrlr);
+	} else {
+		nsid = spdk_nvme_ctrlr_get_next_active_ns(ctrlr, prev_nsid);
+	}
+
+	while (nsid != 0) {
+		ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
+		if (ns == NULL || !nvme_ctrlr_ns_identify_cached(ctrlr, ns)) {
+			break;
+		}
+
+		nsid = spdk_nvme_ctrlr_get_next_active_ns(ctrlr, nsid);
+	}
+
+	return nsid;
+}
+
 static void
 nvme_ctrlr_identify_done(void *arg, const struct spdk_nvme_cpl *cpl)
 {
@@ -1918,6 +2045,8 @@ nvme_ctrlr_identify_done(void *arg, const struct spdk_nvme_cpl *cpl)
 		return;
 	}
 
+	nvme_ctrlr_identify_cache_check(ctrlr);
+
 	/*
 	 * Use MDTS to ensure our default max_xfer_size doesn't exceed what the
 	 *  controller supports.
@@ -1984,6 +2113,8 @@ nvme_ctrlr_identify(struct spdk_nvme_ctrlr *ctrlr)
 {
 	int	rc;
 
+	nvme_ctrlr_identify_cache_save(ctrlr);
+
 	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY,
 			     ctrlr->opts.admin_timeout_ms);
 
@@ -2397,7 +2528,9 @@ _nvme_active_ns_ctx_deleter(struct nvme_active_ns_ctx *ctx)
 	assert(ctx->state == NVME_ACTIVE_NS_STATE_DONE);
 
 	RB_FOREACH(ns, nvme_ns_tree, &ctrlr->ns) {
-		nvme_ns_free_iocs_specific_data(ns);
+		if (!nvme_ctrlr_ns_identify_cached(ctrlr, ns)) {
+			nvme_ns_free_iocs_specific_data(ns);
+		}
 	}
 
 	nvme_ctrlr_identify_active_ns_swap(ctrlr, ctx->new_ns_list, ctx->page_count * 1024);
@@ -2421,6 +2554,79 @@ _nvme_ctrlr_identify_active_ns(struct spdk_nvme_ctrlr *ctrlr)
 	nvme_ctrlr_identify_active_ns_async(ctx);
 }
 
+static void
+nvme_ctrlr_get_changed_ns_list_done(void *arg, const struct spdk_nvme_cpl *cpl)
+{
+	struct spdk_nvme_ctrlr *ctrlr = arg;
+	uint32_t *changed_ns_list = ctrlr->tmp_ptr;
+	struct spdk_nvme_ns tmp, *ns;
+	uint32_t i;
+
+	if (spdk_nvme_cpl_is_error(cpl) || changed_ns_list[0] == 0xFFFFFFFFu) {
+		/* Without the list (or if it overflowed), any namespace may have changed */
+		NVME_CTRLR_DEBUGLOG(ctrlr, "Changed namespace list unavailable, dropping cache\n");
+		nvme_ctrlr_identify_cache_drop(ctrlr);
+	} else {
+		for (i = 0; i < SPDK_NVME_MAX_CHANGED_NAMESPACES && changed_ns_list[i] != 0; i++) {
+			tmp.id = changed_ns_list[i];
+			ns = RB_FIND(nvme_ns_tree, &ctrlr->ns, &tmp);
+			if (ns != NULL) {
+				NVME_CTRLR_DEBUGLOG(ctrlr, "Namespace %u changed\n", ns->id);
+				ns->identify_cached = false;
+			}
+		}
+	}
+
+	spdk_free(ctrlr->tmp_ptr);
+	ctrlr->tmp_ptr = NULL;
+
+	_nvme_ctrlr_identify_active_ns(ctrlr);
+}
+
+/*
+ * Namespaces may have changed while the controller was disconnected, without any
+ * event being received.  Those reported by the Changed Namespace List log page are
+ * identified again, reading it also clears the log for the next events.
+ */
+static int
+nvme_ctrlr_get_changed_ns_list(struct spdk_nvme_ctrlr *ctrlr)
+{
+	size_t size = SPDK_NVME_MAX_CHANGED_NAMESPACES * sizeof(uint32_t);
+	int rc;
+
+	if (ctrlr->opts.disable_read_changed_ns_list_log_page) {
+		nvme_ctrlr_identify_cache_drop(ctrlr);
+		_nvme_ctrlr_identify_active_ns(ctrlr);
+		return 0;
+	}
+
+	assert(!ctrlr->tmp_ptr);
+	ctrlr->tmp_ptr = spdk_zmalloc(size, 64, NULL, SPDK_ENV_SOCKET_ID_ANY,
+				      SPDK_MALLOC_SHARE | SPDK_MALLOC_DMA);
+	if (!ctrlr->tmp_ptr) {
+		rc = -ENOMEM;
+		goto error;
+	}
+
+	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_ACTIVE_NS,
+			     ctrlr->opts.admin_timeout_ms);
+
+	rc = spdk_nvme_ctrlr_cmd_get_log_page(ctrlr, SPDK_NVME_LOG_CHANGED_NS_LIST,
+					      SPDK_NVME_GLOBAL_NS_TAG, ctrlr->tmp_ptr, size, 0,
+					      nvme_ctrlr_get_changed_ns_list_done, ctrlr);
+	if (rc != 0) {
+		goto error;
+	}
+
+	return 0;
+
+error:
+	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
+	spdk_free(ctrlr->tmp_ptr);
+	ctrlr->tmp_ptr = NULL;
+	return rc;
+}
+
 int
 nvme_ctrlr_identify_active_ns(struct spdk_nvme_ctrlr *ctrlr)
 {
@@ -2469,7 +2675,7 @@ nvme_ctrlr_identify_ns_async_done(void *arg, const struct spdk_nvme_cpl *cpl)
 	nvme_ns_set_identify_data(ns);
 
 	/* move on to the next active NS */
-	nsid = spdk_nvme_ctrlr_get_next_active_ns(ctrlr, ns->id);
+	nsid = nvme_ctrlr_get_next_ns_to_identify(ctrlr, ns->id);
 	ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
 	if (ns == NULL) {
 		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_ID_DESCS,
@@ -2507,7 +2713,7 @@ nvme_ctrlr_identify_namespaces(struct spdk_nvme_ctrlr *ctrlr)
 	struct spdk_nvme_ns *ns;
 	int rc;
 
-	nsid = spdk_nvme_ctrlr_get_first_active_ns(ctrlr);
+	nsid = nvme_ctrlr_get_next_ns_to_identify(ctrlr, 0);
 	ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
 	if (ns == NULL) {
 		/* No active NS, move on to the next state */
@@ -2534,13 +2740,8 @@ nvme_ctrlr_identify_namespaces_iocs_specific_next(struct spdk_nvme_ctrlr *ctrlr,
 	struct spdk_nvme_ns *ns;
 	int rc;
 
-	if (!prev_nsid) {
-		nsid = spdk_nvme_ctrlr_get_first_active_ns(ctrlr);
-	} else {
-		/* move on to the next active NS */
-		nsid = spdk_nvme_ctrlr_get_next_active_ns(ctrlr, prev_nsid);
-	}
-
+	/* move on to the first/next active NS */
+	nsid = nvme_ctrlr_get_next_ns_to_identify(ctrlr, prev_nsid);
 	ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
 	if (ns == NULL) {
 		/* No first/next active NS, move on to the next state */
@@ -2551,7 +2752,7 @@ nvme_ctrlr_identify_namespaces_iocs_specific_next(struct spdk_nvme_ctrlr *ctrlr,
 
 	/* loop until we find a ns which has (supported) iocs specific data */
 	while (!nvme_ns_has_supported_iocs_specific_data(ns)) {
-		nsid = spdk_nvme_ctrlr_get_next_active_ns(ctrlr, ns->id);
+		nsid = nvme_ctrlr_get_next_ns_to_identify(ctrlr, ns->id);
 		ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
 		if (ns == NULL) {
 			/* no namespace with (supported) iocs specific data found */
@@ -2663,7 +2864,7 @@ nvme_ctrlr_identify_id_desc_async_done(void *arg, const struct spdk_nvme_cpl *cp
 	nvme_ns_set_id_desc_list_data(ns);
 
 	/* move on to the next active NS */
-	nsid = spdk_nvme_ctrlr_get_next_active_ns(ctrlr, ns->id);
+	nsid = nvme_ctrlr_get_next_ns_to_identify(ctrlr, ns->id);
 	ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
 	if (ns == NULL) {
 		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_NS_IOCS_SPECIFIC,
@@ -2708,7 +2909,7 @@ nvme_ctrlr_identify_id_desc_namespaces(struct spdk_nvme_ctrlr *ctrlr)
 		return 0;
 	}
 
-	nsid = spdk_nvme_ctrlr_get_first_active_ns(ctrlr);
+	nsid = nvme_ctrlr_get_next_ns_to_identify(ctrlr, 0);
 	ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
 	if (ns == NULL) {
 		/* No active NS, move on to the next state */
@@ -3051,6 +3252,7 @@ nvme_ctrlr_process_async_event(struct spdk_nvme_ctrlr *ctrlr,
 
 	if ((event.bits.async_event_type == SPDK_NVME_ASYNC_EVENT_TYPE_NOTICE) &&
 	    (event.bits.async_event_info == SPDK_NVME_ASYNC_EVENT_NS_ATTR_CHANGED)) {
+		ctrlr->identify_cache.ns_changed = false;
 		nvme_ctrlr_clear_changed_ns_log(ctrlr);
 
 		rc = nvme_ctrlr_identify_active_ns(ctrlr);
@@ -3058,6 +3260,7 @@ nvme_ctrlr_process_async_event(struct spdk_nvme_ctrlr *ctrlr,
 			return;
 		}
 		nvme_ctrlr_update_namespaces(ctrlr);
+		nvme_ctrlr_identify_cache_update(ctrlr);
 		nvme_io_msg_ctrlr_update(ctrlr);
 	}
 
@@ -3122,6 +3325,7 @@ nvme_ctrlr_async_event_cb(void *arg, const struct spdk_nvme_cpl *cpl)
 {
 	struct nvme_async_event_request	*aer = arg;
 	struct spdk_nvme_ctrlr		*ctrlr = aer->ctrlr;
+	union spdk_nvme_async_event_completion event;
 
 	if (cpl->status.sct == SPDK_NVME_SCT_GENERIC &&
 	    cpl->status.sc == SPDK_NVME_SC_ABORTED_SQ_DELETION) {
@@ -3146,6 +3350,18 @@ nvme_ctrlr_async_event_cb(void *arg, const struct spdk_nvme_cpl *cpl)
 		return;
 	}
 
+	event.raw = cpl->cdw0;
+	if ((event.bits.async_event_type == SPDK_NVME_ASYNC_EVENT_TYPE_NOTICE) &&
+	    (event.bits.async_event_info == SPDK_NVME_ASYNC_EVENT_NS_ATTR_CHANGED)) {
+		/*
+		 * Cached namespace data is stale until the event has been processed.  An
+		 * initialization in progress keeps the cached data it already decided to use,
+		 * the event refreshes the namespaces once it completes.
+		 */
+		ctrlr->identify_cache.valid = false;
+		ctrlr->identify_cache.ns_changed = true;
+	}
+
 	/* Add the events to the list */
 	nvme_ctrlr_queue_async_event(ctrlr, cpl);
 
@@ -3240,6 +3456,9 @@ nvme_ctrlr_configure_aer(struct spdk_nvme_ctrlr *ctrlr)
 				config.bits.ana_change_notice = 1;
 			}
 		}
+		if (ctrlr->vs.raw >= SPDK_NVME_VERSION(1, 4, 0) && ctrlr->cdata.oaes.pleal_change_notices) {
+			config.bits.pleal_change_notice = 1;
+		}
 		if (ctrlr->vs.raw >= SPDK_NVME_VERSION(1, 3, 0) && ctrlr->cdata.lpa.telemetry) {
 			config.bits.telemetry_log_notice = 1;
 		}
@@ -3569,6 +3788,22 @@ nvme_ctrlr_process_init_check_en(void *ctx, uint64_t value, const struct spdk_nv
 	assert(value <= UINT32_MAX);
 	ctrlr->process_init_cc.raw = (uint32_t)value;
 
+	if (ctrlr->resume.resumed) {
+		ctrlr->resume.resumed = false;
+
+		/* A resumed controller is still enabled and identified, so skip ahead. */
+		if (ctrlr->process_init_cc.bits.en) {
+			NVME_CTRLR_NOTICELOG(ctrlr, "resumed controller 0x%04" PRIx16 "\n", ctrlr->cntlid);
+			nvme_ctrlr_identify_cache_save(ctrlr);
+			nvme_ctrlr_identify_cache_check(ctrlr);
+			nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_CONFIGURE_AER,
+					     ctrlr->opts.admin_timeout_ms);
+			return;
+		}
+
+		NVME_CTRLR_DEBUGLOG(ctrlr, "controller was not resumed, initializing it\n");
+	}
+
 	if (ctrlr->process_init_cc.bits.en) {
 		NVME_CTRLR_DEBUGLOG(ctrlr, "CC.EN = 1\n");
 		state = NVME_CTRLR_STATE_DISABLE_WAIT_FOR_READY_1;
@@ -3803,8 +4038,14 @@ nvme_ctrlr_process_init(struct spdk_nvme_ctrlr *ctrlr)
 			nvme_qpair_set_state(ctrlr->adminq, NVME_QPAIR_ENABLED);
 		/* Fall through */
 		case NVME_QPAIR_ENABLED:
-			nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_READ_VS,
-					     NVME_TIMEOUT_INFINITE);
+			if (ctrlr->resume.resumed) {
+				/* VS and CAP cannot change, go check that it is still enabled. */
+				nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_CHECK_EN,
+						     nvme_ctrlr_get_ready_timeout(ctrlr));
+			} else {
+				nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_READ_VS,
+						     NVME_TIMEOUT_INFINITE);
+			}
 			/* Abort any queued requests that were sent while the adminq was connecting
 			 * to avoid stalling the init process during a reset, as requests don't get
 			 * resubmitted while the controller is resetting and subsequent commands
@@ -3816,6 +4057,14 @@ nvme_ctrlr_process_init(struct spdk_nvme_ctrlr *ctrlr)
 			assert(ctrlr->adminq->async == true);
 			break;
 		case NVME_QPAIR_DISCONNECTED:
+			if (ctrlr->resume.cntlid != 0xFFFF) {
+				/* The target may not support resuming it, ask for a new controller. */
+				NVME_CTRLR_NOTICELOG(ctrlr, "failed to resume controller 0x%04" PRIx16 "\n",
+						     ctrlr->resume.cntlid);
+				ctrlr->resume.cntlid = 0xFFFF;
+				nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_CONNECT_ADMINQ, NVME_TIMEOUT_INFINITE);
+				break;
+			}
 		/* fallthrough */
 		default:
 			nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
@@ -3925,7 +4174,11 @@ nvme_ctrlr_process_init(struct spdk_nvme_ctrlr *ctrlr)
 		break;
 
 	case NVME_CTRLR_STATE_IDENTIFY_ACTIVE_NS:
-		_nvme_ctrlr_identify_active_ns(ctrlr);
+		if (ctrlr->identify_cache.hit) {
+			rc = nvme_ctrlr_get_changed_ns_list(ctrlr);
+		} else {
+			_nvme_ctrlr_identify_active_ns(ctrlr);
+		}
 		break;
 
 	case NVME_CTRLR_STATE_IDENTIFY_NS:
@@ -3968,6 +4221,7 @@ nvme_ctrlr_process_init(struct spdk_nvme_ctrlr *ctrlr)
 			NVME_CTRLR_ERRLOG(ctrlr, "Transport controller ready step failed: rc %d\n", rc);
 			nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
 		} else {
+			nvme_ctrlr_identify_cache_update(ctrlr);
 			nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_READY, NVME_TIMEOUT_INFINITE);
 		}
 		break;
@@ -4092,6 +4346,7 @@ nvme_ctrlr_construct(struct spdk_nvme_ctrlr *ctrlr)
 
 	ctrlr->flags = 0;
 	ctrlr->free_io_qids = NULL;
+	ctrlr->resume.cntlid = 0xFFFF;
 	ctrlr->is_resetting = false;
 	ctrlr->is_failed = false;
 	ctrlr->is_destructed = false;
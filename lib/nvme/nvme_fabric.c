@@ -545,7 +545,8 @@ nvme_fabric_qpair_connect_async(struct spdk_nvme_qpair *qpair, uint32_t num_entr
 	memcpy(&req->cmd, &cmd, sizeof(cmd));
 
 	if (nvme_qpair_is_admin_queue(qpair)) {
-		nvmf_data->cntlid = 0xFFFF;
+		/* 0xFFFF unless the previous controller should be resumed */
+		nvmf_data->cntlid = ctrlr->resume.cntlid;
 	} else {
 		nvmf_data->cntlid = ctrlr->cntlid;
 	}
@@ -616,6 +617,8 @@ nvme_fabric_qpair_connect_poll(struct spdk_nvme_qpair *qpair)
 		rsp = (struct spdk_nvmf_fabric_connect_rsp *)&status->cpl;
 		ctrlr->cntlid = rsp->status_code_specific.success.cntlid;
 		SPDK_DEBUGLOG(nvme, "CNTLID 0x%04" PRIx16 "\n", ctrlr->cntlid);
+		ctrlr->resume.resumed = ctrlr->resume.cntlid != 0xFFFF && ctrlr->resume.cntlid == ctrlr->cntlid;
+		ctrlr->resume.cntlid = 0xFFFF;
 	}
 finish:
 	qpair->poll_status = NULL;
@@ -516,6 +516,9 @@ struct spdk_nvme_ns {
 	uint16_t			flags;
 	bool				active;
 
+	/* Identify data is current and may be reused on controller re-initialization */
+	bool				identify_cached;
+
 	/* Command Set Identifier */
 	enum spdk_nvme_csi		csi;
 
@@ -1011,6 +1014,28 @@ struct spdk_nvme_ctrlr {
 	STAILQ_HEAD(, nvme_register_completion)	register_operations;
 
 	union spdk_nvme_cc_register		process_init_cc;
+
+	/* Identity of the controller whose namespace data is cached, see enable_identify_cache */
+	struct {
+		/* Namespace data gathered by the last initialization is current */
+		bool				valid;
+		/* The re-initialized controller matched the cached identity */
+		bool				hit;
+		/* A Namespace Attribute Changed event wasn't processed yet */
+		bool				ns_changed;
+		uint16_t			cntlid;
+		uint32_t			nn;
+		int8_t				sn[SPDK_NVME_CTRLR_SN_LEN];
+		uint8_t				subnqn[SPDK_NVME_NQN_FIELD_SIZE];
+	} identify_cache;
+
+	/* Warm reconnect state, see enable_warm_reconnect */
+	struct {
+		/* CNTLID sent in the next admin queue Connect, 0xFFFF for a new controller */
+		uint16_t			cntlid;
+		/* The target accepted the Connect for the previous controller */
+		bool				resumed;
+	} resume;
 };
 
 struct spdk_nvme_probe_ctx {
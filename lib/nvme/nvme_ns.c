@@ -570,4 +570,5 @@ nvme_ns_destruct(struct spdk_nvme_ns *ns)
 	ns->sectors_per_stripe = 0;
 	ns->flags = 0;
 	ns->csi = SPDK_NVME_CSI_NVM;
+	ns->identify_cached = false;
 }
@@ -1209,3 +1209,33 @@ spdk_nvme_qpair_get_num_outstanding_reqs(struct spdk_nvme_qpair *qpair)
 {
 	return qpair->num_outstanding_reqs;
 }
+
+uint32_t
+spdk_nvme_qpair_select_least_outstanding(struct spdk_nvme_qpair **qpairs, uint32_t num_qpairs,
+		uint32_t start)
+{
+	uint32_t i, idx, num_reqs, min_reqs = UINT32_MAX, min_idx = start;
+
+	assert(start < num_qpairs);
+
+	idx = start;
+	for (i = 0; i < num_qpairs; i++) {
+		/* I/O submitted to a qpair that isn't connected would just fail or be queued */
+		if (nvme_qpair_get_state(qpairs[idx]) == NVME_QPAIR_ENABLED) {
+			num_reqs = qpairs[idx]->num_outstanding_reqs;
+			if (num_reqs < min_reqs) {
+				min_reqs = num_reqs;
+				min_idx = idx;
+				if (num_reqs == 0) {
+					break;
+				}
+			}
+		}
+
+		if (++idx == num_qpairs) {
+			idx = 0;
+		}
+	}
+
+	return min_idx;
+}
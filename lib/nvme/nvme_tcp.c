@@ -37,6 +37,12 @@
 #define NVME_TCP_MAX_R2T_DEFAULT		1
 #define NVME_TCP_PDU_H2C_MIN_DATA_SIZE		4096
 
+/*
+ * Smallest header (CH + PSH) of any PDU a host can receive: CapsuleResp, C2HData,
+ * R2T and C2HTermReq all use 24 byte headers and ICResp is larger.
+ */
+#define NVME_TCP_HOST_MIN_PDU_HLEN		sizeof(struct spdk_nvme_tcp_rsp)
+
 /*
  * Maximum value of transport_ack_timeout used by TCP controller
  */
@@ -1618,7 +1624,7 @@ nvme_tcp_read_pdu(struct nvme_tcp_qpair *tqpair, uint32_t *reaped, uint32_t max_
 {
 	int rc = 0;
 	struct nvme_tcp_pdu *pdu;
-	uint32_t data_len;
+	uint32_t data_len, psh_bytes;
 	enum nvme_tcp_pdu_recv_state prev_state;
 
 	*reaped = tqpair->async_complete;
@@ -1641,8 +1647,11 @@ nvme_tcp_read_pdu(struct nvme_tcp_qpair *tqpair, uint32_t *reaped, uint32_t max_
 		/* Wait for the pdu common header */
 		case NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_CH:
 			assert(pdu->ch_valid_bytes < sizeof(struct spdk_nvme_tcp_common_pdu_hdr));
+			/* Every PDU received by the host has at least NVME_TCP_HOST_MIN_PDU_HLEN bytes
+			 * of header, so read the start of the PDU specific header together with the
+			 * common header.  This saves a socket read for each PDU. */
 			rc = nvme_tcp_read_data(tqpair->sock,
-						sizeof(struct spdk_nvme_tcp_common_pdu_hdr) - pdu->ch_valid_bytes,
+						NVME_TCP_HOST_MIN_PDU_HLEN - pdu->ch_valid_bytes,
 						(uint8_t *)&pdu->hdr.common + pdu->ch_valid_bytes);
 			if (rc < 0) {
 				nvme_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_QUIESCING);
@@ -1653,8 +1662,20 @@ nvme_tcp_read_pdu(struct nvme_tcp_qpair *tqpair, uint32_t *reaped, uint32_t max_
 				return NVME_TCP_PDU_IN_PROGRESS;
 			}
 
+			psh_bytes = pdu->ch_valid_bytes - sizeof(struct spdk_nvme_tcp_common_pdu_hdr);
+			pdu->ch_valid_bytes = sizeof(struct spdk_nvme_tcp_common_pdu_hdr);
+
 			/* The command header of this PDU has now been read from the socket. */
 			nvme_tcp_pdu_ch_handle(tqpair);
+			if (tqpair->recv_state != NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PSH) {
+				break;
+			}
+
+			pdu->psh_valid_bytes += psh_bytes;
+			assert(pdu->psh_valid_bytes <= pdu->psh_len);
+			if (pdu->psh_valid_bytes == pdu->psh_len) {
+				nvme_tcp_pdu_psh_handle(tqpair, reaped);
+			}
 			break;
 		/* Wait for the pdu specific header  */
 		case NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PSH:
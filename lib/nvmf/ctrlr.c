@@ -43,6 +43,14 @@
 
 #define NVMF_ABORT_COMMAND_LIMIT 3
 
+#define NVMF_QOS_TIMESLICE_IN_USEC 1000
+/*
+ * Virtual time charged for a request of a weight 1 host.  Heavier hosts are charged
+ * NVMF_QOS_WEIGHT_SCALE / weight, rounded down by less than 0.01% of their share for any
+ * weight up to NVMF_QOS_MAX_WEIGHT.
+ */
+#define NVMF_QOS_WEIGHT_SCALE (NVMF_QOS_MAX_WEIGHT * 10000)
+
 /*
  * Support for custom admin command handlers
  */
@@ -215,6 +223,21 @@ nvmf_ctrlr_start_keep_alive_timer(struct spdk_nvmf_ctrlr *ctrlr)
 	}
 }
 
+static void
+nvmf_ctrlr_set_connect_kato(struct spdk_nvmf_ctrlr *ctrlr,
+			    const struct spdk_nvmf_fabric_connect_cmd *connect_cmd)
+{
+	/*
+	 * KAS: This field indicates the granularity of the Keep Alive Timer in 100ms units.
+	 * If this field is cleared to 0h, then Keep Alive is not supported.
+	 */
+	if (ctrlr->cdata.kas) {
+		ctrlr->feat.keep_alive_timer.bits.kato = spdk_divide_round_up(connect_cmd->kato,
+				KAS_DEFAULT_VALUE * KAS_TIME_UNIT_IN_MS) *
+				KAS_DEFAULT_VALUE * KAS_TIME_UNIT_IN_MS;
+	}
+}
+
 static int _retry_qid_check(void *ctx);
 
 static void
@@ -390,16 +413,7 @@ nvmf_ctrlr_create(struct spdk_nvmf_subsystem *subsystem,
 	}
 
 	nvmf_ctrlr_cdata_init(transport, subsystem, &ctrlr->cdata);
-
-	/*
-	 * KAS: This field indicates the granularity of the Keep Alive Timer in 100ms units.
-	 * If this field is cleared to 0h, then Keep Alive is not supported.
-	 */
-	if (ctrlr->cdata.kas) {
-		ctrlr->feat.keep_alive_timer.bits.kato = spdk_divide_round_up(connect_cmd->kato,
-				KAS_DEFAULT_VALUE * KAS_TIME_UNIT_IN_MS) *
-				KAS_DEFAULT_VALUE * KAS_TIME_UNIT_IN_MS;
-	}
+	nvmf_ctrlr_set_connect_kato(ctrlr, connect_cmd);
 
 	ctrlr->feat.async_event_configuration.bits.ns_attr_notice = 1;
 	if (ctrlr->subsys->flags.ana_reporting) {
@@ -547,17 +561,180 @@ _nvmf_ctrlr_destruct(void *ctx)
 		STAILQ_REMOVE(&ctrlr->async_events, event, spdk_nvmf_async_event_completion, link);
 		free(event);
 	}
+	free(ctrlr->discovery_log);
 	free(ctrlr);
 }
 
-void
-nvmf_ctrlr_destruct(struct spdk_nvmf_ctrlr *ctrlr)
+static void
+_nvmf_ctrlr_free(struct spdk_nvmf_ctrlr *ctrlr)
 {
 	nvmf_subsystem_remove_ctrlr(ctrlr->subsys, ctrlr);
 
 	spdk_thread_send_msg(ctrlr->thread, _nvmf_ctrlr_destruct, ctrlr);
 }
 
+/*
+ * A controller whose host lost its connections without shutting it down is kept
+ * for the subsystem's resume timeout, so that the host can reattach to it with an
+ * admin Connect carrying its CNTLID instead of initializing a new controller.
+ */
+static bool
+nvmf_ctrlr_can_resume(struct spdk_nvmf_ctrlr *ctrlr)
+{
+	struct spdk_nvmf_subsystem *subsystem = ctrlr->subsys;
+
+	if (subsystem->resume_timeout_ms == 0 || subsystem->destroying ||
+	    subsystem->subtype != SPDK_NVMF_SUBTYPE_NVME || !ctrlr->dynamic_ctrlr) {
+		return false;
+	}
+
+	if (subsystem->state != SPDK_NVMF_SUBSYSTEM_ACTIVE &&
+	    subsystem->state != SPDK_NVMF_SUBSYSTEM_PAUSING &&
+	    subsystem->state != SPDK_NVMF_SUBSYSTEM_PAUSED &&
+	    subsystem->state != SPDK_NVMF_SUBSYSTEM_RESUMING) {
+		return false;
+	}
+
+	/* Only a live controller is worth keeping, not one that was reset or shut down */
+	return ctrlr->vcprop.cc.bits.en && !ctrlr->vcprop.cc.bits.shn &&
+	       ctrlr->vcprop.csts.bits.rdy && !ctrlr->vcprop.csts.bits.cfs &&
+	       ctrlr->vcprop.csts.bits.shst == SPDK_NVME_SHST_NORMAL &&
+	       !ctrlr->disconnect_in_progress;
+}
+
+static int
+nvmf_ctrlr_resume_timeout(void *ctx)
+{
+	struct spdk_nvmf_ctrlr *ctrlr = ctx;
+
+	SPDK_NOTICELOG("Controller 0x%hx of host %s was not resumed, destroying it\n",
+		       ctrlr->cntlid, ctrlr->hostnqn);
+	nvmf_ctrlr_abort_resume(ctrlr);
+
+	return SPDK_POLLER_BUSY;
+}
+
+void
+nvmf_ctrlr_abort_resume(struct spdk_nvmf_ctrlr *ctrlr)
+{
+	assert(spdk_get_thread() == ctrlr->subsys->thread);
+	assert(ctrlr->resume_timer != NULL);
+
+	spdk_poller_unregister(&ctrlr->resume_timer);
+	_nvmf_ctrlr_free(ctrlr);
+}
+
+static void
+_nvmf_ctrlr_park_done(void *ctx)
+{
+	struct spdk_nvmf_ctrlr *ctrlr = ctx;
+	struct spdk_nvmf_subsystem *subsystem = ctrlr->subsys;
+
+	if (subsystem->destroying) {
+		_nvmf_ctrlr_free(ctrlr);
+		return;
+	}
+
+	SPDK_NOTICELOG("Keeping controller 0x%hx of host %s for %u ms\n", ctrlr->cntlid,
+		       ctrlr->hostnqn, subsystem->resume_timeout_ms);
+	ctrlr->resume_timer = SPDK_POLLER_REGISTER(nvmf_ctrlr_resume_timeout, ctrlr,
+			      subsystem->resume_timeout_ms * 1000ULL);
+}
+
+static void
+_nvmf_ctrlr_park(void *ctx)
+{
+	struct spdk_nvmf_ctrlr *ctrlr = ctx;
+
+	assert(spdk_get_thread() == ctrlr->thread);
+	assert(ctrlr->in_destruct);
+
+	nvmf_ctrlr_stop_keep_alive_timer(ctrlr);
+	nvmf_ctrlr_stop_association_timer(ctrlr);
+
+	spdk_thread_send_msg(ctrlr->subsys->thread, _nvmf_ctrlr_park_done, ctrlr);
+}
+
+void
+nvmf_ctrlr_destruct(struct spdk_nvmf_ctrlr *ctrlr)
+{
+	if (nvmf_ctrlr_can_resume(ctrlr)) {
+		spdk_thread_send_msg(ctrlr->thread, _nvmf_ctrlr_park, ctrlr);
+		return;
+	}
+
+	_nvmf_ctrlr_free(ctrlr);
+}
+
+static void
+_nvmf_ctrlr_resume_admin_qpair(void *ctx)
+{
+	struct spdk_nvmf_request *req = ctx;
+	struct spdk_nvmf_ctrlr *ctrlr = req->qpair->ctrlr;
+
+	_nvmf_ctrlr_add_admin_qpair(req);
+
+	/* Namespaces changed while the host was away, it has to pick that up again */
+	if (ctrlr->changed_ns_list_count != 0) {
+		nvmf_ctrlr_async_event_ns_notice(ctrlr);
+	}
+}
+
+static void
+_nvmf_ctrlr_resume(void *ctx)
+{
+	struct spdk_nvmf_request *req = ctx;
+	struct spdk_nvmf_fabric_connect_data *data = req->iov[0].iov_base;
+	struct spdk_nvmf_fabric_connect_rsp *rsp = &req->rsp->connect_rsp;
+	struct spdk_nvmf_qpair *qpair = req->qpair;
+	struct spdk_nvme_transport_id listen_trid = {};
+	const struct spdk_nvmf_subsystem_listener *listener;
+	struct spdk_nvmf_subsystem *subsystem;
+	struct spdk_nvmf_ctrlr *ctrlr;
+
+	subsystem = spdk_nvmf_tgt_find_subsystem(qpair->transport->tgt, data->subnqn);
+	/* We already checked this in spdk_nvmf_ctrlr_connect */
+	assert(subsystem != NULL);
+
+	ctrlr = nvmf_subsystem_get_ctrlr(subsystem, data->cntlid);
+	if (ctrlr == NULL || ctrlr->resume_timer == NULL ||
+	    spdk_uuid_compare(&ctrlr->hostid, (struct spdk_uuid *)data->hostid) != 0 ||
+	    strncmp(ctrlr->hostnqn, data->hostnqn, sizeof(ctrlr->hostnqn)) != 0) {
+		SPDK_ERRLOG("No controller 0x%x of host %s to resume\n", data->cntlid, data->hostnqn);
+		SPDK_NVMF_INVALID_CONNECT_DATA(rsp, cntlid);
+		spdk_nvmf_request_complete(req);
+		return;
+	}
+
+	/* The host may come back through another path, e.g. after a failover */
+	if (spdk_nvmf_qpair_get_listen_trid(qpair, &listen_trid) != 0) {
+		SPDK_ERRLOG("Could not get listener transport ID\n");
+		rsp->status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+		spdk_nvmf_request_complete(req);
+		return;
+	}
+
+	listener = nvmf_subsystem_find_listener(subsystem, &listen_trid);
+	if (listener == NULL) {
+		SPDK_ERRLOG("Listener was not found\n");
+		rsp->status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+		spdk_nvmf_request_complete(req);
+		return;
+	}
+
+	SPDK_NOTICELOG("Resuming controller 0x%hx of host %s\n", ctrlr->cntlid, ctrlr->hostnqn);
+
+	spdk_poller_unregister(&ctrlr->resume_timer);
+	ctrlr->listener = listener;
+	ctrlr->thread = qpair->group->thread;
+	ctrlr->in_destruct = false;
+	qpair->ctrlr = ctrlr;
+	/* The keep alive poller is re-armed with the timeout of the new Connect */
+	nvmf_ctrlr_set_connect_kato(ctrlr, &req->cmd->connect_cmd);
+
+	spdk_thread_send_msg(ctrlr->thread, _nvmf_ctrlr_resume_admin_qpair, req);
+}
+
 static void
 nvmf_ctrlr_add_io_qpair(void *ctx)
 {
@@ -813,6 +990,13 @@ _nvmf_ctrlr_connect(struct spdk_nvmf_request *req)
 	if (cmd->qid == 0) {
 		SPDK_DEBUGLOG(nvmf, "Connect Admin Queue for controller ID 0x%x\n", data->cntlid);
 
+		if (spdk_nvme_trtype_is_fabrics(transport->ops->type) && data->cntlid != 0xFFFF &&
+		    subsystem->resume_timeout_ms != 0) {
+			/* Reattach to a controller kept since the host lost its connection */
+			spdk_thread_send_msg(subsystem->thread, _nvmf_ctrlr_resume, req);
+			return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
+		}
+
 		if (spdk_nvme_trtype_is_fabrics(transport->ops->type) && data->cntlid != 0xFFFF) {
 			/* This NVMf target only supports dynamic mode. */
 			SPDK_ERRLOG("The NVMf target only supports dynamic mode (CNTLID = 0x%x).\n", data->cntlid);
@@ -1986,7 +2170,7 @@ nvmf_ctrlr_set_features_number_of_queues(struct spdk_nvmf_request *req)
 	return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
 }
 
-SPDK_STATIC_ASSERT(sizeof(struct spdk_nvmf_ctrlr) == 4920,
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvmf_ctrlr) == 4984,
 		   "Please check migration fields that need to be added or not");
 
 static void
@@ -2565,7 +2749,7 @@ nvmf_ctrlr_get_log_page(struct spdk_nvmf_request *req)
 				return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
 			}
 			nvmf_get_discovery_log_page(subsystem->tgt, ctrlr->hostnqn, req->iov, req->iovcnt,
-						    offset, len, &cmd_source_trid);
+						    offset, len, &cmd_source_trid, &ctrlr->discovery_log);
 			if (!rae) {
 				nvmf_ctrlr_unmask_aen(ctrlr, SPDK_NVME_ASYNC_EVENT_DISCOVERY_LOG_CHANGE_MASK_BIT);
 			}
@@ -4166,6 +4350,227 @@ spdk_nvmf_request_zcopy_end(struct spdk_nvmf_request *req, bool commit)
 	nvmf_bdev_ctrlr_zcopy_end(req, commit);
 }
 
+void
+nvmf_qos_bucket_set_limits(struct nvmf_qos_bucket *qos, uint64_t rw_ios_per_sec,
+			   uint64_t rw_mbytes_per_sec)
+{
+	uint64_t max_ios, max_bytes;
+
+	max_ios = SPDK_CEIL_DIV(rw_ios_per_sec * NVMF_QOS_TIMESLICE_IN_USEC, SPDK_SEC_TO_USEC);
+	max_bytes = SPDK_CEIL_DIV(rw_mbytes_per_sec * 1024 * 1024 * NVMF_QOS_TIMESLICE_IN_USEC,
+				  SPDK_SEC_TO_USEC);
+
+	__atomic_store_n(&qos->remaining_ios, (int64_t)max_ios, __ATOMIC_RELAXED);
+	__atomic_store_n(&qos->remaining_bytes, (int64_t)max_bytes, __ATOMIC_RELAXED);
+	__atomic_store_n(&qos->max_ios_per_timeslice, max_ios, __ATOMIC_RELAXED);
+	__atomic_store_n(&qos->max_bytes_per_timeslice, max_bytes, __ATOMIC_RELAXED);
+}
+
+void
+nvmf_ctrlr_set_qos_limits(struct spdk_nvmf_ctrlr *ctrlr, uint64_t rw_ios_per_sec,
+			  uint64_t rw_mbytes_per_sec, uint32_t weight)
+{
+	nvmf_qos_bucket_set_limits(&ctrlr->qos, rw_ios_per_sec, rw_mbytes_per_sec);
+	__atomic_store_n(&ctrlr->qos_weight, weight, __ATOMIC_RELAXED);
+}
+
+static inline bool
+nvmf_qos_bucket_is_limited(struct nvmf_qos_bucket *qos)
+{
+	return __atomic_load_n(&qos->max_ios_per_timeslice, __ATOMIC_RELAXED) != 0 ||
+	       __atomic_load_n(&qos->max_bytes_per_timeslice, __ATOMIC_RELAXED) != 0;
+}
+
+/* Add the budget of a new timeslice, keeping the overshoot of the previous one */
+static void
+nvmf_qos_bucket_refill(int64_t *remaining, uint64_t max)
+{
+	int64_t cur = __atomic_load_n(remaining, __ATOMIC_RELAXED);
+
+	while (!__atomic_compare_exchange_n(remaining, &cur, spdk_min(cur, 0) + (int64_t)max,
+					    false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+	}
+}
+
+/* Take amount from the budget unless it's used up.  Like bdev QoS, the command that exhausts
+ * the budget is still let through and the overshoot is carried over to the next timeslice. */
+static bool
+nvmf_qos_bucket_take(int64_t *remaining, int64_t amount)
+{
+	int64_t cur = __atomic_load_n(remaining, __ATOMIC_RELAXED);
+
+	do {
+		if (cur <= 0) {
+			return false;
+		}
+	} while (!__atomic_compare_exchange_n(remaining, &cur, cur - amount, false,
+					      __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+	return true;
+}
+
+static bool
+nvmf_qos_bucket_consume(struct nvmf_qos_bucket *qos, uint64_t length)
+{
+	uint64_t max_ios, max_bytes, timeslice, last;
+
+	max_ios = __atomic_load_n(&qos->max_ios_per_timeslice, __ATOMIC_RELAXED);
+	max_bytes = __atomic_load_n(&qos->max_bytes_per_timeslice, __ATOMIC_RELAXED);
+	if (spdk_likely(max_ios == 0 && max_bytes == 0)) {
+		return true;
+	}
+
+	timeslice = spdk_get_ticks() / (spdk_get_ticks_hz() * NVMF_QOS_TIMESLICE_IN_USEC /
+					 SPDK_SEC_TO_USEC);
+	last = __atomic_load_n(&qos->timeslice, __ATOMIC_RELAXED);
+	if (timeslice != last &&
+	    __atomic_compare_exchange_n(&qos->timeslice, &last, timeslice, false,
+					__ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+		nvmf_qos_bucket_refill(&qos->remaining_ios, max_ios);
+		nvmf_qos_bucket_refill(&qos->remaining_bytes, max_bytes);
+	}
+
+	if (max_ios != 0 && !nvmf_qos_bucket_take(&qos->remaining_ios, 1)) {
+		return false;
+	}
+
+	if (max_bytes != 0 && !nvmf_qos_bucket_take(&qos->remaining_bytes, (int64_t)length)) {
+		if (max_ios != 0) {
+			__atomic_fetch_add(&qos->remaining_ios, 1, __ATOMIC_RELAXED);
+		}
+		return false;
+	}
+
+	return true;
+}
+
+static void
+nvmf_qos_bucket_release(struct nvmf_qos_bucket *qos, uint64_t length)
+{
+	if (__atomic_load_n(&qos->max_ios_per_timeslice, __ATOMIC_RELAXED) != 0) {
+		__atomic_fetch_add(&qos->remaining_ios, 1, __ATOMIC_RELAXED);
+	}
+	if (__atomic_load_n(&qos->max_bytes_per_timeslice, __ATOMIC_RELAXED) != 0) {
+		__atomic_fetch_add(&qos->remaining_bytes, (int64_t)length, __ATOMIC_RELAXED);
+	}
+}
+
+static inline bool
+nvmf_qos_is_limited(struct spdk_nvmf_ctrlr *ctrlr, struct spdk_nvmf_ns *ns,
+		    struct spdk_nvmf_request *req)
+{
+	if (req->cmd->nvme_cmd.opc != SPDK_NVME_OPC_READ &&
+	    req->cmd->nvme_cmd.opc != SPDK_NVME_OPC_WRITE) {
+		return false;
+	}
+
+	return nvmf_qos_bucket_is_limited(&ctrlr->qos) || nvmf_qos_bucket_is_limited(&ns->qos);
+}
+
+/* Take one command worth of both the host's and the namespace's budgets, or none of them */
+static bool
+nvmf_qos_consume(struct spdk_nvmf_ctrlr *ctrlr, struct spdk_nvmf_ns *ns,
+		 struct spdk_nvmf_request *req)
+{
+	if (!nvmf_qos_bucket_consume(&ctrlr->qos, req->length)) {
+		return false;
+	}
+
+	if (!nvmf_qos_bucket_consume(&ns->qos, req->length)) {
+		nvmf_qos_bucket_release(&ctrlr->qos, req->length);
+		return false;
+	}
+
+	return true;
+}
+
+static int nvmf_poll_group_qos_poll(void *ctx);
+static int nvmf_poll_group_process_qos_queued(struct spdk_nvmf_poll_group *group);
+
+/*
+ * A poll group resubmitting millions of requests per second wraps its virtual time around
+ * within weeks, so tags are compared by their distance, which stays far below 2^63.
+ */
+static inline bool
+nvmf_qos_tag_before(uint64_t tag, uint64_t other)
+{
+	return (int64_t)(tag - other) < 0;
+}
+
+static void
+nvmf_poll_group_qos_queue(struct spdk_nvmf_poll_group *group, struct spdk_nvmf_request *req)
+{
+	struct spdk_nvmf_qpair *qpair = req->qpair;
+	uint32_t weight;
+
+	/*
+	 * The requests held back by the namespace limits are resubmitted in tag order, so the
+	 * hosts sharing a namespace get its budget in proportion to their weights.  A queue pair
+	 * that had nothing queued starts from the group's virtual time, whatever its last tag
+	 * was, so that idle periods don't turn into credit over the busy hosts.
+	 */
+	weight = __atomic_load_n(&qpair->ctrlr->qos_weight, __ATOMIC_RELAXED);
+	if (weight == 0) {
+		weight = NVMF_QOS_DEFAULT_WEIGHT;
+	}
+	if (TAILQ_EMPTY(&qpair->qos_queued)) {
+		req->qos_tag = group->qos_vtime;
+		TAILQ_INSERT_TAIL(&group->qos_qpairs, qpair, qos_link);
+	} else {
+		req->qos_tag = qpair->qos_last_tag;
+		if (nvmf_qos_tag_before(req->qos_tag, group->qos_vtime)) {
+			req->qos_tag = group->qos_vtime;
+		}
+	}
+	req->qos_tag += NVMF_QOS_WEIGHT_SCALE / weight;
+	qpair->qos_last_tag = req->qos_tag;
+
+	TAILQ_INSERT_TAIL(&qpair->qos_queued, req, qos_link);
+
+	/* A timed poller drains the queue in interrupt mode too, the budget is only refilled
+	 * once per timeslice anyway. */
+	if (group->qos_poller == NULL) {
+		group->qos_poller = SPDK_POLLER_REGISTER(nvmf_poll_group_qos_poll, group,
+				    NVMF_QOS_TIMESLICE_IN_USEC);
+	}
+}
+
+static void
+nvmf_poll_group_qos_dequeue(struct spdk_nvmf_poll_group *group, struct spdk_nvmf_request *req)
+{
+	struct spdk_nvmf_qpair *qpair = req->qpair;
+
+	TAILQ_REMOVE(&qpair->qos_queued, req, qos_link);
+	if (TAILQ_EMPTY(&qpair->qos_queued)) {
+		TAILQ_REMOVE(&group->qos_qpairs, qpair, qos_link);
+	}
+}
+
+void
+nvmf_qpair_abort_qos_queued(struct spdk_nvmf_qpair *qpair)
+{
+	TAILQ_HEAD(, spdk_nvmf_request) reqs = TAILQ_HEAD_INITIALIZER(reqs);
+	struct spdk_nvmf_request *req;
+
+	if (TAILQ_EMPTY(&qpair->qos_queued)) {
+		return;
+	}
+
+	/* Completing the last request may destroy the qpair */
+	TAILQ_REMOVE(&qpair->group->qos_qpairs, qpair, qos_link);
+	TAILQ_CONCAT(&reqs, &qpair->qos_queued, qos_link);
+
+	while ((req = TAILQ_FIRST(&reqs)) != NULL) {
+		TAILQ_REMOVE(&reqs, req, qos_link);
+		req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+		req->rsp->nvme_cpl.status.sc = SPDK_NVME_SC_ABORTED_SQ_DELETION;
+		_nvmf_request_complete(req);
+	}
+}
+
+static int nvmf_ctrlr_submit_io_cmd(struct spdk_nvmf_request *req, struct spdk_bdev *bdev,
+				    struct spdk_bdev_desc *desc, struct spdk_io_channel *ch);
+
 int
 nvmf_ctrlr_process_io_cmd(struct spdk_nvmf_request *req)
 {
@@ -4250,6 +4655,31 @@ nvmf_ctrlr_process_io_cmd(struct spdk_nvmf_request *req)
 		req->qpair->first_fused_req = NULL;
 	}
 
+	if (spdk_unlikely(nvmf_qos_is_limited(ctrlr, ns, req))) {
+		if (!TAILQ_EMPTY(&group->qos_qpairs)) {
+			/* Let the requests held back compete with this one for the budget */
+			nvmf_poll_group_qos_queue(group, req);
+			nvmf_poll_group_process_qos_queued(group);
+			return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
+		}
+
+		if (!nvmf_qos_consume(ctrlr, ns, req)) {
+			/* Over the limits for this timeslice.  The poll group resubmits it. */
+			nvmf_poll_group_qos_queue(group, req);
+			return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
+		}
+	}
+
+	return nvmf_ctrlr_submit_io_cmd(req, bdev, desc, ch);
+}
+
+static int
+nvmf_ctrlr_submit_io_cmd(struct spdk_nvmf_request *req, struct spdk_bdev *bdev,
+			 struct spdk_bdev_desc *desc, struct spdk_io_channel *ch)
+{
+	struct spdk_nvmf_ctrlr *ctrlr = req->qpair->ctrlr;
+	struct spdk_nvme_cmd *cmd = &req->cmd->nvme_cmd;
+
 	if (spdk_nvmf_request_using_zcopy(req)) {
 		assert(req->zcopy_phase == NVMF_ZCOPY_PHASE_INIT);
 		return nvmf_bdev_ctrlr_zcopy_start(bdev, desc, ch, req);
@@ -4281,6 +4711,94 @@ nvmf_ctrlr_process_io_cmd(struct spdk_nvmf_request *req)
 	}
 }
 
+/* Resubmit the requests held back by QoS limits.  Returns the number resubmitted. */
+static int
+nvmf_poll_group_process_qos_queued(struct spdk_nvmf_poll_group *group)
+{
+	struct spdk_nvmf_request *req, *best;
+	struct spdk_nvmf_qpair *qpair;
+	struct spdk_nvmf_ctrlr *ctrlr;
+	struct spdk_nvmf_subsystem_poll_group *sgroup;
+	struct spdk_nvmf_ns *ns;
+	struct spdk_io_channel *ch;
+	uint32_t nsid;
+	int count = 0;
+
+	TAILQ_FOREACH(qpair, &group->qos_qpairs, qos_link) {
+		qpair->qos_blocked = false;
+	}
+
+	/* Serve the requests in increasing tag order.  The ones over their limits keep their
+	 * queue pair waiting for the next timeslice, while the others go on. */
+	while (true) {
+		best = NULL;
+		TAILQ_FOREACH(qpair, &group->qos_qpairs, qos_link) {
+			req = TAILQ_FIRST(&qpair->qos_queued);
+			if (!qpair->qos_blocked &&
+			    (best == NULL || nvmf_qos_tag_before(req->qos_tag, best->qos_tag))) {
+				best = req;
+			}
+		}
+
+		if (best == NULL) {
+			break;
+		}
+
+		req = best;
+		ctrlr = req->qpair->ctrlr;
+		nsid = req->cmd->nvme_cmd.nsid;
+		ns = _nvmf_subsystem_get_ns(ctrlr->subsys, nsid);
+		sgroup = &group->sgroups[ctrlr->subsys->id];
+		ch = NULL;
+		if (ns != NULL && nsid <= sgroup->num_ns) {
+			ch = sgroup->ns_info[nsid - 1].channel;
+		}
+
+		if (spdk_unlikely(ns == NULL || ns->bdev == NULL || ch == NULL)) {
+			/* The namespace went away while the request waited */
+			nvmf_poll_group_qos_dequeue(group, req);
+			count++;
+			req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+			req->rsp->nvme_cpl.status.sc = SPDK_NVME_SC_INVALID_NAMESPACE_OR_FORMAT;
+			req->rsp->nvme_cpl.status.dnr = 1;
+			_nvmf_request_complete(req);
+			continue;
+		}
+
+		if (!nvmf_qos_consume(ctrlr, ns, req)) {
+			req->qpair->qos_blocked = true;
+			continue;
+		}
+
+		nvmf_poll_group_qos_dequeue(group, req);
+		count++;
+		if (nvmf_qos_tag_before(group->qos_vtime, req->qos_tag)) {
+			group->qos_vtime = req->qos_tag;
+		}
+
+		if (nvmf_ctrlr_submit_io_cmd(req, ns->bdev, ns->desc, ch) ==
+		    SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE) {
+			_nvmf_request_complete(req);
+		}
+	}
+
+	return count;
+}
+
+static int
+nvmf_poll_group_qos_poll(void *ctx)
+{
+	struct spdk_nvmf_poll_group *group = ctx;
+	int count;
+
+	count = nvmf_poll_group_process_qos_queued(group);
+	if (TAILQ_EMPTY(&group->qos_qpairs)) {
+		spdk_poller_unregister(&group->qos_poller);
+	}
+
+	return count > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
 static void
 nvmf_qpair_request_cleanup(struct spdk_nvmf_qpair *qpair)
 {
@@ -64,22 +64,30 @@ nvmf_discovery_compare_tr_svcid(const struct spdk_nvme_transport_id *trid1,
 	return strcasecmp(trid1->trsvcid, trid2->trsvcid) == 0;
 }
 
+/* Number of entries the discovery log page is initially allocated for */
+#define NVMF_DISCOVERY_LOG_INITIAL_ENTRIES	16
+
+static size_t
+nvmf_discovery_log_size(const struct spdk_nvmf_discovery_log_page *disc_log)
+{
+	return offsetof(struct spdk_nvmf_discovery_log_page, entries[disc_log->numrec]);
+}
+
 static struct spdk_nvmf_discovery_log_page *
-nvmf_generate_discovery_log(struct spdk_nvmf_tgt *tgt, const char *hostnqn, size_t *log_page_size,
+nvmf_generate_discovery_log(struct spdk_nvmf_tgt *tgt, const char *hostnqn,
 			    struct spdk_nvme_transport_id *cmd_source_trid)
 {
-	uint64_t numrec = 0;
+	uint64_t numrec = 0, max_numrec;
 	struct spdk_nvmf_subsystem *subsystem;
 	struct spdk_nvmf_subsystem_listener *listener;
 	struct spdk_nvmf_discovery_log_page_entry *entry;
 	struct spdk_nvmf_discovery_log_page *disc_log;
-	size_t cur_size;
 
 	SPDK_DEBUGLOG(nvmf, "Generating log page for genctr %" PRIu64 "\n",
 		      tgt->discovery_genctr);
 
-	cur_size = sizeof(struct spdk_nvmf_discovery_log_page);
-	disc_log = calloc(1, cur_size);
+	max_numrec = NVMF_DISCOVERY_LOG_INITIAL_ENTRIES;
+	disc_log = calloc(1, offsetof(struct spdk_nvmf_discovery_log_page, entries[max_numrec]));
 	if (disc_log == NULL) {
 		SPDK_ERRLOG("Discovery log page memory allocation error\n");
 		return NULL;
@@ -138,16 +146,19 @@ nvmf_generate_discovery_log(struct spdk_nvmf_tgt *tgt, const char *hostnqn, size
 			SPDK_DEBUGLOG(nvmf, "listener %s:%s trtype %s\n", listener->trid->traddr, listener->trid->trsvcid,
 				      listener->trid->trstring);
 
-			size_t new_size = cur_size + sizeof(*entry);
-			void *new_log_page = realloc(disc_log, new_size);
+			if (numrec == max_numrec) {
+				/* Grow geometrically, so large targets don't reallocate per entry */
+				void *new_log_page = realloc(disc_log, offsetof(struct spdk_nvmf_discovery_log_page,
+							     entries[max_numrec * 2]));
 
-			if (new_log_page == NULL) {
-				SPDK_ERRLOG("Discovery log page memory allocation error\n");
-				break;
-			}
+				if (new_log_page == NULL) {
+					SPDK_ERRLOG("Discovery log page memory allocation error\n");
+					break;
+				}
 
-			disc_log = new_log_page;
-			cur_size = new_size;
+				disc_log = new_log_page;
+				max_numrec *= 2;
+			}
 
 			entry = &disc_log->entries[numrec];
 			memset(entry, 0, sizeof(*entry));
@@ -165,7 +176,6 @@ nvmf_generate_discovery_log(struct spdk_nvmf_tgt *tgt, const char *hostnqn, size
 
 	disc_log->numrec = numrec;
 	disc_log->genctr = tgt->discovery_genctr;
-	*log_page_size = cur_size;
 
 	return disc_log;
 }
@@ -173,18 +183,39 @@ nvmf_generate_discovery_log(struct spdk_nvmf_tgt *tgt, const char *hostnqn, size
 void
 nvmf_get_discovery_log_page(struct spdk_nvmf_tgt *tgt, const char *hostnqn, struct iovec *iov,
 			    uint32_t iovcnt, uint64_t offset, uint32_t length,
-			    struct spdk_nvme_transport_id *cmd_source_trid)
+			    struct spdk_nvme_transport_id *cmd_source_trid,
+			    struct spdk_nvmf_discovery_log_page **cached_log)
 {
 	size_t copy_len = 0;
 	size_t zero_len = 0;
 	struct iovec *tmp;
 	size_t log_page_size = 0;
-	struct spdk_nvmf_discovery_log_page *discovery_log_page;
+	struct spdk_nvmf_discovery_log_page *discovery_log_page = NULL;
+
+	/*
+	 * Hosts read the log in several commands (header first, then the entries), so keep
+	 * the log generated for the controller and only rebuild it once genctr changes.
+	 * Every change to the log's content bumps genctr.
+	 */
+	if (cached_log != NULL && *cached_log != NULL) {
+		if ((*cached_log)->genctr == tgt->discovery_genctr) {
+			discovery_log_page = *cached_log;
+		} else {
+			free(*cached_log);
+			*cached_log = NULL;
+		}
+	}
 
-	discovery_log_page = nvmf_generate_discovery_log(tgt, hostnqn, &log_page_size, cmd_source_trid);
+	if (discovery_log_page == NULL) {
+		discovery_log_page = nvmf_generate_discovery_log(tgt, hostnqn, cmd_source_trid);
+		if (cached_log != NULL) {
+			*cached_log = discovery_log_page;
+		}
+	}
 
 	/* Copy the valid part of the discovery log page, if any */
 	if (discovery_log_page) {
+		log_page_size = nvmf_discovery_log_size(discovery_log_page);
 		for (tmp = iov; tmp < iov + iovcnt; tmp++) {
 			copy_len = spdk_min(tmp->iov_len, length);
 			copy_len = spdk_min(log_page_size - offset, copy_len);
@@ -207,6 +238,8 @@ nvmf_get_discovery_log_page(struct spdk_nvmf_tgt *tgt, const char *hostnqn, stru
 			memset((char *)tmp->iov_base, 0, tmp->iov_len);
 		}
 
-		free(discovery_log_page);
+		if (cached_log == NULL) {
+			free(discovery_log_page);
+		}
 	}
 }
@@ -111,6 +111,7 @@ nvmf_tgt_cleanup_poll_group(struct spdk_nvmf_poll_group *group)
 	free(group->sgroups);
 
 	spdk_poller_unregister(&group->poller);
+	spdk_poller_unregister(&group->qos_poller);
 
 	if (group->destroy_cb_fn) {
 		group->destroy_cb_fn(group->destroy_cb_arg, 0);
@@ -177,6 +178,7 @@ nvmf_tgt_create_poll_group(void *io_device, void *ctx_buf)
 	group->tgt = tgt;
 	TAILQ_INIT(&group->tgroups);
 	TAILQ_INIT(&group->qpairs);
+	TAILQ_INIT(&group->qos_qpairs);
 	group->thread = thread;
 	pthread_mutex_init(&group->mutex, NULL);
 
@@ -352,6 +354,10 @@ _nvmf_tgt_destroy_next_transport(void *ctx)
 		pthread_mutex_destroy(&tgt->mutex);
 		free(tgt);
 
+		if (TAILQ_EMPTY(&g_nvmf_tgts)) {
+			nvmf_ptpl_writer_fini();
+		}
+
 		if (destroy_cb_fn) {
 			destroy_cb_fn(destroy_cb_arg, 0);
 		}
@@ -486,6 +492,9 @@ nvmf_write_subsystem_config_json(struct spdk_json_write_ctx *w,
 	spdk_json_write_named_uint32(w, "min_cntlid", spdk_nvmf_subsystem_get_min_cntlid(subsystem));
 	spdk_json_write_named_uint32(w, "max_cntlid", spdk_nvmf_subsystem_get_max_cntlid(subsystem));
 	spdk_json_write_named_bool(w, "ana_reporting", nvmf_subsystem_get_ana_reporting(subsystem));
+	if (nvmf_subsystem_get_resume_timeout(subsystem) != 0) {
+		spdk_json_write_named_uint32(w, "resume_timeout_ms", nvmf_subsystem_get_resume_timeout(subsystem));
+	}
 
 	/*     } "params" */
 	spdk_json_write_object_end(w);
@@ -510,6 +519,29 @@ nvmf_write_subsystem_config_json(struct spdk_json_write_ctx *w,
 
 		/* } */
 		spdk_json_write_object_end(w);
+
+		if (host->rw_ios_per_sec == 0 && host->rw_mbytes_per_sec == 0 &&
+		    host->qos_weight == NVMF_QOS_DEFAULT_WEIGHT) {
+			continue;
+		}
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "method", "nvmf_subsystem_set_host_qos_limits");
+
+		/*     "params" : { */
+		spdk_json_write_named_object_begin(w, "params");
+
+		spdk_json_write_named_string(w, "nqn", spdk_nvmf_subsystem_get_nqn(subsystem));
+		spdk_json_write_named_string(w, "host", spdk_nvmf_host_get_nqn(host));
+		spdk_json_write_named_uint64(w, "rw_ios_per_sec", host->rw_ios_per_sec);
+		spdk_json_write_named_uint64(w, "rw_mbytes_per_sec", host->rw_mbytes_per_sec);
+		spdk_json_write_named_uint32(w, "weight", host->qos_weight);
+
+		/*     } "params" */
+		spdk_json_write_object_end(w);
+
+		/* } */
+		spdk_json_write_object_end(w);
 	}
 
 	for (ns = spdk_nvmf_subsystem_get_first_ns(subsystem); ns != NULL;
@@ -558,6 +590,27 @@ nvmf_write_subsystem_config_json(struct spdk_json_write_ctx *w,
 
 		/* } */
 		spdk_json_write_object_end(w);
+
+		if (ns->rw_ios_per_sec == 0 && ns->rw_mbytes_per_sec == 0) {
+			continue;
+		}
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "method", "nvmf_subsystem_set_ns_qos_limits");
+
+		/*     "params" : { */
+		spdk_json_write_named_object_begin(w, "params");
+
+		spdk_json_write_named_string(w, "nqn", spdk_nvmf_subsystem_get_nqn(subsystem));
+		spdk_json_write_named_uint32(w, "nsid", spdk_nvmf_ns_get_id(ns));
+		spdk_json_write_named_uint64(w, "rw_ios_per_sec", ns->rw_ios_per_sec);
+		spdk_json_write_named_uint64(w, "rw_mbytes_per_sec", ns->rw_mbytes_per_sec);
+
+		/*     } "params" */
+		spdk_json_write_object_end(w);
+
+		/* } */
+		spdk_json_write_object_end(w);
 	}
 
 	for (listener = spdk_nvmf_subsystem_get_first_listener(subsystem); listener != NULL;
@@ -1057,6 +1110,7 @@ spdk_nvmf_poll_group_add(struct spdk_nvmf_poll_group *group,
 	struct spdk_nvmf_transport_poll_group *tgroup;
 
 	TAILQ_INIT(&qpair->outstanding);
+	TAILQ_INIT(&qpair->qos_queued);
 	qpair->group = group;
 	qpair->ctrlr = NULL;
 	qpair->disconnect_started = false;
@@ -1297,6 +1351,7 @@ spdk_nvmf_qpair_disconnect(struct spdk_nvmf_qpair *qpair, nvmf_qpair_disconnect_
 		qpair->state_cb_arg = qpair_ctx;
 		nvmf_qpair_abort_pending_zcopy_reqs(qpair);
 		nvmf_qpair_free_aer(qpair);
+		nvmf_qpair_abort_qos_queued(qpair);
 		return 0;
 	}
 
@@ -25,6 +25,10 @@
 #define NVMF_MIN_CNTLID 1
 #define NVMF_MAX_CNTLID 0xFFEF
 
+/* Range of the QoS weights of the hosts */
+#define NVMF_QOS_DEFAULT_WEIGHT 1
+#define NVMF_QOS_MAX_WEIGHT 100
+
 enum spdk_nvmf_tgt_state {
 	NVMF_TGT_IDLE = 0,
 	NVMF_TGT_RUNNING,
@@ -78,11 +82,30 @@ struct spdk_nvmf_tgt {
 	TAILQ_ENTRY(spdk_nvmf_tgt)		link;
 };
 
+/*
+ * QoS budget of a timeslice.  The limits are written on the subsystem thread, while the
+ * remaining budget is consumed from every poll group, so all of these are accessed atomically.
+ */
+struct nvmf_qos_bucket {
+	uint64_t			max_ios_per_timeslice;
+	uint64_t			max_bytes_per_timeslice;
+	int64_t				remaining_ios;
+	int64_t				remaining_bytes;
+	uint64_t			timeslice;
+};
+
 struct spdk_nvmf_host {
 	char				nqn[SPDK_NVMF_NQN_MAX_LEN + 1];
+	/* QoS limits applied to the host's controllers, 0 means unlimited */
+	uint64_t			rw_ios_per_sec;
+	uint64_t			rw_mbytes_per_sec;
+	uint32_t			qos_weight;
 	TAILQ_ENTRY(spdk_nvmf_host)	link;
+	RB_ENTRY(spdk_nvmf_host)	node;
 };
 
+RB_HEAD(host_tree, spdk_nvmf_host);
+
 struct spdk_nvmf_subsystem_listener {
 	struct spdk_nvmf_subsystem			*subsystem;
 	spdk_nvmf_tgt_subsystem_listen_done_fn		cb_fn;
@@ -154,6 +177,10 @@ struct spdk_nvmf_registrant {
 	uint64_t rkey;
 };
 
+typedef void (*nvmf_ns_reservation_persist_cb)(void *cb_arg, int status);
+
+struct nvmf_ns_ptpl_waiter;
+
 struct spdk_nvmf_ns {
 	uint32_t nsid;
 	uint32_t anagrpid;
@@ -177,10 +204,20 @@ struct spdk_nvmf_ns {
 	char *ptpl_file;
 	/* Persist Through Power Loss feature is enabled */
 	bool ptpl_activated;
+	/* Outstanding writes of the Persist Through Power Loss file */
+	struct {
+		uint64_t seq;
+		bool in_progress;
+		TAILQ_HEAD(, nvmf_ns_ptpl_waiter) waiters;
+	} ptpl_write;
 	/* ZCOPY supported on bdev device */
 	bool zcopy;
 	/* Command Set Identifier */
 	enum spdk_nvme_csi csi;
+	/* QoS limits shared by all hosts, 0 means unlimited */
+	uint64_t rw_ios_per_sec;
+	uint64_t rw_mbytes_per_sec;
+	struct nvmf_qos_bucket qos;
 };
 
 /*
@@ -234,12 +271,18 @@ struct spdk_nvmf_ctrlr {
 	uint8_t num_avail_log_pages;
 	TAILQ_HEAD(log_page_head, spdk_nvmf_reservation_log) log_head;
 
+	/* Discovery log generated for this controller, valid while its genctr is current */
+	struct spdk_nvmf_discovery_log_page *discovery_log;
+
 	/* Time to trigger keep-alive--poller_time = now_tick + period */
 	uint64_t			last_keep_alive_tick;
 	struct spdk_poller		*keep_alive_poller;
 
 	struct spdk_poller		*association_timer;
 
+	/* Set while the controller is kept for its host to resume it */
+	struct spdk_poller		*resume_timer;
+
 	struct spdk_poller		*cc_timer;
 	uint64_t			cc_timeout_tsc;
 	struct spdk_poller		*cc_timeout_timer;
@@ -252,6 +295,11 @@ struct spdk_nvmf_ctrlr {
 	bool				acre_enabled;
 	bool				dynamic_ctrlr;
 
+	/* Host QoS budget, shared by the controller's I/O qpairs on all poll groups */
+	struct nvmf_qos_bucket		qos;
+	/* Share of the namespaces' QoS budgets while hosts compete for them */
+	uint32_t			qos_weight;
+
 	TAILQ_ENTRY(spdk_nvmf_ctrlr)	link;
 };
 
@@ -293,6 +341,9 @@ struct spdk_nvmf_subsystem {
 	uint16_t					min_cntlid;
 	uint16_t					max_cntlid;
 
+	/* How long a controller is kept after its host lost all connections */
+	uint32_t					resume_timeout_ms;
+
 	TAILQ_HEAD(, spdk_nvmf_ctrlr)			ctrlrs;
 
 	/* A mutex used to protect the hosts list and allow_any_host flag. Unlike the namespace
@@ -302,6 +353,8 @@ struct spdk_nvmf_subsystem {
 	 * are added or removed dynamically. */
 	pthread_mutex_t					mutex;
 	TAILQ_HEAD(, spdk_nvmf_host)			hosts;
+	/* Index of the hosts list by NQN, used by the CONNECT path */
+	struct host_tree				host_index;
 	TAILQ_HEAD(, spdk_nvmf_subsystem_listener)	listeners;
 	struct spdk_bit_array				*used_listener_ids;
 
@@ -345,9 +398,11 @@ void nvmf_poll_group_resume_subsystem(struct spdk_nvmf_poll_group *group,
 void nvmf_update_discovery_log(struct spdk_nvmf_tgt *tgt, const char *hostnqn);
 void nvmf_get_discovery_log_page(struct spdk_nvmf_tgt *tgt, const char *hostnqn, struct iovec *iov,
 				 uint32_t iovcnt, uint64_t offset, uint32_t length,
-				 struct spdk_nvme_transport_id *cmd_source_trid);
+				 struct spdk_nvme_transport_id *cmd_source_trid,
+				 struct spdk_nvmf_discovery_log_page **cached_log);
 
 void nvmf_ctrlr_destruct(struct spdk_nvmf_ctrlr *ctrlr);
+void nvmf_ctrlr_abort_resume(struct spdk_nvmf_ctrlr *ctrlr);
 int nvmf_ctrlr_process_admin_cmd(struct spdk_nvmf_request *req);
 int nvmf_ctrlr_process_io_cmd(struct spdk_nvmf_request *req);
 bool nvmf_ctrlr_dsm_supported(struct spdk_nvmf_ctrlr *ctrlr);
@@ -403,6 +458,7 @@ void nvmf_subsystem_set_ana_state(struct spdk_nvmf_subsystem *subsystem,
 				  enum spdk_nvme_ana_state ana_state, uint32_t anagrpid,
 				  spdk_nvmf_tgt_subsystem_listen_done_fn cb_fn, void *cb_arg);
 bool nvmf_subsystem_get_ana_reporting(struct spdk_nvmf_subsystem *subsystem);
+uint32_t nvmf_subsystem_get_resume_timeout(struct spdk_nvmf_subsystem *subsystem);
 
 /**
  * Sets the controller ID range for a subsystem.
@@ -425,10 +481,23 @@ void nvmf_ctrlr_async_event_discovery_log_change_notice(void *ctx);
 void nvmf_ctrlr_async_event_reservation_notification(struct spdk_nvmf_ctrlr *ctrlr);
 
 void nvmf_ns_reservation_request(void *ctx);
+int nvmf_ns_reservation_persist(struct spdk_nvmf_ns *ns, nvmf_ns_reservation_persist_cb cb_fn,
+				void *cb_arg);
 void nvmf_ctrlr_reservation_notice_log(struct spdk_nvmf_ctrlr *ctrlr,
 				       struct spdk_nvmf_ns *ns,
 				       enum spdk_nvme_reservation_notification_log_page_type type);
 
+typedef int (*nvmf_ptpl_write_fn)(void *ctx);
+typedef void (*nvmf_ptpl_write_done_fn)(void *ctx, int rc);
+
+/*
+ * Queue write_fn to the thread writing the Persist Through Power Loss files.  done_fn is
+ * called with its return value on the calling thread.
+ */
+int nvmf_ptpl_write_submit(nvmf_ptpl_write_fn write_fn, nvmf_ptpl_write_done_fn done_fn,
+			   void *ctx);
+void nvmf_ptpl_writer_fini(void);
+
 
 /*
  * Abort zero-copy requests that already got the buffer (received zcopy_start cb), but haven't
@@ -450,6 +519,15 @@ int nvmf_ctrlr_abort_request(struct spdk_nvmf_request *req);
 
 void nvmf_ctrlr_set_fatal_status(struct spdk_nvmf_ctrlr *ctrlr);
 
+void nvmf_qos_bucket_set_limits(struct nvmf_qos_bucket *qos, uint64_t rw_ios_per_sec,
+				uint64_t rw_mbytes_per_sec);
+
+void nvmf_ctrlr_set_qos_limits(struct spdk_nvmf_ctrlr *ctrlr, uint64_t rw_ios_per_sec,
+			       uint64_t rw_mbytes_per_sec, uint32_t weight);
+
+/* Complete the requests of a disconnecting qpair that are held back by QoS limits. */
+void nvmf_qpair_abort_qos_queued(struct spdk_nvmf_qpair *qpair);
+
 static inline struct spdk_nvmf_ns *
 _nvmf_subsystem_get_ns(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid)
 {
@@ -467,6 +545,61 @@ nvmf_qpair_is_admin_queue(struct spdk_nvmf_qpair *qpair)
 	return qpair->qid == 0;
 }
 
+/*
+ * Number of qpairs currently placed on a poll group.  Unassociated qpairs are
+ * counted as well, since they will eventually become io qpairs.  Transports
+ * use this as the load metric when choosing a poll group for a new connection.
+ */
+static inline uint32_t
+nvmf_poll_group_get_io_qpair_count(struct spdk_nvmf_poll_group *group)
+{
+	uint32_t count;
+
+	pthread_mutex_lock(&group->mutex);
+	count = group->stat.current_io_qpairs + group->current_unassociated_qpairs;
+	pthread_mutex_unlock(&group->mutex);
+
+	return count;
+}
+
+typedef struct spdk_nvmf_transport_poll_group *(*nvmf_transport_poll_group_next_fn)(
+	struct spdk_nvmf_transport_poll_group *group, void *ctx);
+
+/*
+ * Walk a transport's poll groups starting at start and return the one with the
+ * fewest qpairs.  next_fn returns the poll group following the given one,
+ * wrapping around at the end of the transport's list.  Starting at the next
+ * round-robin group keeps the round-robin order among equally loaded groups, so
+ * that back-to-back connections from one host (whose qpair counts are only
+ * updated once they reach their poll group) still get spread out.
+ */
+static inline struct spdk_nvmf_transport_poll_group *
+nvmf_transport_get_least_loaded_poll_group(struct spdk_nvmf_transport_poll_group *start,
+		nvmf_transport_poll_group_next_fn next_fn, void *ctx)
+{
+	struct spdk_nvmf_transport_poll_group *min, *current;
+	uint32_t min_value, count;
+
+	min = start;
+	current = start;
+	min_value = nvmf_poll_group_get_io_qpair_count(start->group);
+
+	while (min_value > 0) {
+		current = next_fn(current, ctx);
+		if (current == start) {
+			break;
+		}
+
+		count = nvmf_poll_group_get_io_qpair_count(current->group);
+		if (count < min_value) {
+			min_value = count;
+			min = current;
+		}
+	}
+
+	return min;
+}
+
 /**
  * Initiates a zcopy start operation
  *
@@ -347,6 +347,7 @@ struct rpc_subsystem_create {
 	bool ana_reporting;
 	uint16_t min_cntlid;
 	uint16_t max_cntlid;
+	uint32_t resume_timeout_ms;
 };
 
 static const struct spdk_json_object_decoder rpc_subsystem_create_decoders[] = {
@@ -359,6 +360,7 @@ static const struct spdk_json_object_decoder rpc_subsystem_create_decoders[] = {
 	{"ana_reporting", offsetof(struct rpc_subsystem_create, ana_reporting), spdk_json_decode_bool, true},
 	{"min_cntlid", offsetof(struct rpc_subsystem_create, min_cntlid), spdk_json_decode_uint16, true},
 	{"max_cntlid", offsetof(struct rpc_subsystem_create, max_cntlid), spdk_json_decode_uint16, true},
+	{"resume_timeout_ms", offsetof(struct rpc_subsystem_create, resume_timeout_ms), spdk_json_decode_uint32, true},
 };
 
 static void
@@ -443,6 +445,8 @@ rpc_nvmf_create_subsystem(struct spdk_jsonrpc_request *request,
 
 	spdk_nvmf_subsystem_set_ana_reporting(subsystem, req->ana_reporting);
 
+	spdk_nvmf_subsystem_set_resume_timeout(subsystem, req->resume_timeout_ms);
+
 	if (nvmf_subsystem_set_cntlid_range(subsystem, req->min_cntlid, req->max_cntlid)) {
 		SPDK_ERRLOG("Subsystem %s: invalid cntlid range [%u-%u]\n", req->nqn, req->min_cntlid,
 			    req->max_cntlid);
@@ -1443,6 +1447,9 @@ struct nvmf_rpc_host_ctx {
 	char *host;
 	char *tgt_name;
 	bool allow_any_host;
+	uint64_t rw_ios_per_sec;
+	uint64_t rw_mbytes_per_sec;
+	uint32_t weight;
 };
 
 static const struct spdk_json_object_decoder nvmf_rpc_subsystem_host_decoder[] = {
@@ -1584,6 +1591,148 @@ rpc_nvmf_subsystem_remove_host(struct spdk_jsonrpc_request *request,
 SPDK_RPC_REGISTER("nvmf_subsystem_remove_host", rpc_nvmf_subsystem_remove_host,
 		  SPDK_RPC_RUNTIME)
 
+static const struct spdk_json_object_decoder nvmf_rpc_subsystem_host_qos_decoder[] = {
+	{"nqn", offsetof(struct nvmf_rpc_host_ctx, nqn), spdk_json_decode_string},
+	{"host", offsetof(struct nvmf_rpc_host_ctx, host), spdk_json_decode_string},
+	{"rw_ios_per_sec", offsetof(struct nvmf_rpc_host_ctx, rw_ios_per_sec), spdk_json_decode_uint64, true},
+	{"rw_mbytes_per_sec", offsetof(struct nvmf_rpc_host_ctx, rw_mbytes_per_sec), spdk_json_decode_uint64, true},
+	{"weight", offsetof(struct nvmf_rpc_host_ctx, weight), spdk_json_decode_uint32, true},
+	{"tgt_name", offsetof(struct nvmf_rpc_host_ctx, tgt_name), spdk_json_decode_string, true},
+};
+
+static void
+rpc_nvmf_subsystem_set_host_qos_limits(struct spdk_jsonrpc_request *request,
+				       const struct spdk_json_val *params)
+{
+	struct nvmf_rpc_host_ctx ctx = {};
+	struct spdk_nvmf_subsystem *subsystem;
+	struct spdk_nvmf_tgt *tgt;
+	int rc;
+
+	ctx.weight = NVMF_QOS_DEFAULT_WEIGHT;
+
+	if (spdk_json_decode_object(params, nvmf_rpc_subsystem_host_qos_decoder,
+				    SPDK_COUNTOF(nvmf_rpc_subsystem_host_qos_decoder),
+				    &ctx)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_host_ctx_free(&ctx);
+		return;
+	}
+
+	tgt = spdk_nvmf_get_tgt(ctx.tgt_name);
+	if (!tgt) {
+		SPDK_ERRLOG("Unable to find a target object.\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Unable to find a target.");
+		nvmf_rpc_host_ctx_free(&ctx);
+		return;
+	}
+
+	subsystem = spdk_nvmf_tgt_find_subsystem(tgt, ctx.nqn);
+	if (!subsystem) {
+		SPDK_ERRLOG("Unable to find subsystem with NQN %s\n", ctx.nqn);
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_host_ctx_free(&ctx);
+		return;
+	}
+
+	rc = spdk_nvmf_subsystem_set_host_qos_limits(subsystem, ctx.host, ctx.rw_ios_per_sec,
+			ctx.rw_mbytes_per_sec, ctx.weight);
+	if (rc == -ENOENT) {
+		SPDK_ERRLOG("Host %s is not allowed on subsystem %s\n", ctx.host, ctx.nqn);
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_host_ctx_free(&ctx);
+		return;
+	} else if (rc == -EINVAL) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid weight");
+		nvmf_rpc_host_ctx_free(&ctx);
+		return;
+	} else if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Internal error");
+		nvmf_rpc_host_ctx_free(&ctx);
+		return;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+	nvmf_rpc_host_ctx_free(&ctx);
+}
+SPDK_RPC_REGISTER("nvmf_subsystem_set_host_qos_limits", rpc_nvmf_subsystem_set_host_qos_limits,
+		  SPDK_RPC_RUNTIME)
+
+struct nvmf_rpc_ns_qos_ctx {
+	char *nqn;
+	char *tgt_name;
+	uint32_t nsid;
+	uint64_t rw_ios_per_sec;
+	uint64_t rw_mbytes_per_sec;
+};
+
+static const struct spdk_json_object_decoder nvmf_rpc_subsystem_ns_qos_decoder[] = {
+	{"nqn", offsetof(struct nvmf_rpc_ns_qos_ctx, nqn), spdk_json_decode_string},
+	{"nsid", offsetof(struct nvmf_rpc_ns_qos_ctx, nsid), spdk_json_decode_uint32},
+	{"rw_ios_per_sec", offsetof(struct nvmf_rpc_ns_qos_ctx, rw_ios_per_sec), spdk_json_decode_uint64, true},
+	{"rw_mbytes_per_sec", offsetof(struct nvmf_rpc_ns_qos_ctx, rw_mbytes_per_sec), spdk_json_decode_uint64, true},
+	{"tgt_name", offsetof(struct nvmf_rpc_ns_qos_ctx, tgt_name), spdk_json_decode_string, true},
+};
+
+static void
+nvmf_rpc_ns_qos_ctx_free(struct nvmf_rpc_ns_qos_ctx *ctx)
+{
+	free(ctx->nqn);
+	free(ctx->tgt_name);
+}
+
+static void
+rpc_nvmf_subsystem_set_ns_qos_limits(struct spdk_jsonrpc_request *request,
+				     const struct spdk_json_val *params)
+{
+	struct nvmf_rpc_ns_qos_ctx ctx = {};
+	struct spdk_nvmf_subsystem *subsystem;
+	struct spdk_nvmf_tgt *tgt;
+	int rc;
+
+	if (spdk_json_decode_object(params, nvmf_rpc_subsystem_ns_qos_decoder,
+				    SPDK_COUNTOF(nvmf_rpc_subsystem_ns_qos_decoder),
+				    &ctx)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_ns_qos_ctx_free(&ctx);
+		return;
+	}
+
+	tgt = spdk_nvmf_get_tgt(ctx.tgt_name);
+	if (!tgt) {
+		SPDK_ERRLOG("Unable to find a target object.\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Unable to find a target.");
+		nvmf_rpc_ns_qos_ctx_free(&ctx);
+		return;
+	}
+
+	subsystem = spdk_nvmf_tgt_find_subsystem(tgt, ctx.nqn);
+	if (!subsystem) {
+		SPDK_ERRLOG("Unable to find subsystem with NQN %s\n", ctx.nqn);
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_ns_qos_ctx_free(&ctx);
+		return;
+	}
+
+	rc = spdk_nvmf_subsystem_set_ns_qos_limits(subsystem, ctx.nsid, ctx.rw_ios_per_sec,
+			ctx.rw_mbytes_per_sec);
+	if (rc != 0) {
+		SPDK_ERRLOG("Namespace %u not found on subsystem %s\n", ctx.nsid, ctx.nqn);
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_ns_qos_ctx_free(&ctx);
+		return;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+	nvmf_rpc_ns_qos_ctx_free(&ctx);
+}
+SPDK_RPC_REGISTER("nvmf_subsystem_set_ns_qos_limits", rpc_nvmf_subsystem_set_ns_qos_limits,
+		  SPDK_RPC_RUNTIME)
+
 
 static const struct spdk_json_object_decoder nvmf_rpc_subsystem_any_host_decoder[] = {
 	{"nqn", offsetof(struct nvmf_rpc_host_ctx, nqn), spdk_json_decode_string},
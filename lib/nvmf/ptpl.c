@@ -0,0 +1,138 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+/*
+ * Writer for the Persist Through Power Loss files.  The files are written and
+ * flushed with blocking file I/O, so the writes are queued to a single helper
+ * thread shared by all namespaces instead of being done on SPDK threads.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/env.h"
+#include "spdk/log.h"
+#include "spdk/queue.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+
+#include "nvmf_internal.h"
+
+struct nvmf_ptpl_write {
+	nvmf_ptpl_write_fn		write_fn;
+	nvmf_ptpl_write_done_fn		done_fn;
+	void				*ctx;
+	struct spdk_thread		*thread;
+	int				rc;
+	TAILQ_ENTRY(nvmf_ptpl_write)	link;
+};
+
+static struct {
+	pthread_mutex_t				mutex;
+	pthread_cond_t				cond;
+	pthread_t				tid;
+	bool					running;
+	bool					exit;
+	TAILQ_HEAD(, nvmf_ptpl_write)		writes;
+} g_ptpl_writer = {
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+	.writes = TAILQ_HEAD_INITIALIZER(g_ptpl_writer.writes),
+};
+
+static void
+nvmf_ptpl_write_done(void *ctx)
+{
+	struct nvmf_ptpl_write *write = ctx;
+
+	write->done_fn(write->ctx, write->rc);
+	free(write);
+}
+
+static void *
+nvmf_ptpl_writer(void *ctx)
+{
+	struct nvmf_ptpl_write *write;
+
+	spdk_unaffinitize_thread();
+
+	pthread_mutex_lock(&g_ptpl_writer.mutex);
+	while (true) {
+		write = TAILQ_FIRST(&g_ptpl_writer.writes);
+		if (write == NULL) {
+			/* Queued writes are always finished before exiting */
+			if (g_ptpl_writer.exit) {
+				break;
+			}
+			pthread_cond_wait(&g_ptpl_writer.cond, &g_ptpl_writer.mutex);
+			continue;
+		}
+
+		TAILQ_REMOVE(&g_ptpl_writer.writes, write, link);
+		pthread_mutex_unlock(&g_ptpl_writer.mutex);
+
+		write->rc = write->write_fn(write->ctx);
+		spdk_thread_send_msg(write->thread, nvmf_ptpl_write_done, write);
+
+		pthread_mutex_lock(&g_ptpl_writer.mutex);
+	}
+	pthread_mutex_unlock(&g_ptpl_writer.mutex);
+
+	return NULL;
+}
+
+int
+nvmf_ptpl_write_submit(nvmf_ptpl_write_fn write_fn, nvmf_ptpl_write_done_fn done_fn, void *ctx)
+{
+	struct nvmf_ptpl_write *write;
+	int rc;
+
+	write = calloc(1, sizeof(*write));
+	if (write == NULL) {
+		return -ENOMEM;
+	}
+
+	write->write_fn = write_fn;
+	write->done_fn = done_fn;
+	write->ctx = ctx;
+	write->thread = spdk_get_thread();
+
+	pthread_mutex_lock(&g_ptpl_writer.mutex);
+	if (!g_ptpl_writer.running) {
+		g_ptpl_writer.exit = false;
+		rc = pthread_create(&g_ptpl_writer.tid, NULL, nvmf_ptpl_writer, NULL);
+		if (rc != 0) {
+			pthread_mutex_unlock(&g_ptpl_writer.mutex);
+			SPDK_ERRLOG("Failed to start the PTPL writer thread: %s\n",
+				    spdk_strerror(rc));
+			free(write);
+			return -rc;
+		}
+		g_ptpl_writer.running = true;
+	}
+
+	TAILQ_INSERT_TAIL(&g_ptpl_writer.writes, write, link);
+	pthread_cond_signal(&g_ptpl_writer.cond);
+	pthread_mutex_unlock(&g_ptpl_writer.mutex);
+
+	return 0;
+}
+
+/* Called once the last target is destroyed, no new writes may be submitted meanwhile */
+void
+nvmf_ptpl_writer_fini(void)
+{
+	pthread_mutex_lock(&g_ptpl_writer.mutex);
+	if (!g_ptpl_writer.running) {
+		pthread_mutex_unlock(&g_ptpl_writer.mutex);
+		return;
+	}
+
+	g_ptpl_writer.exit = true;
+	pthread_cond_signal(&g_ptpl_writer.cond);
+	pthread_mutex_unlock(&g_ptpl_writer.mutex);
+
+	pthread_join(g_ptpl_writer.tid, NULL);
+	g_ptpl_writer.running = false;
+}
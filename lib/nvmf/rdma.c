@@ -38,6 +38,11 @@ const struct spdk_nvmf_transport_ops spdk_nvmf_transport_rdma;
 #define DEFAULT_NVMF_RDMA_CQ_SIZE	4096
 #define MAX_WR_PER_QP(queue_depth)	(queue_depth * 3 + 2)
 
+/* A shared receive queue grows once less than 1/8 of its receive WRs remain posted */
+#define NVMF_RDMA_SRQ_LOW_WATERMARK_DIV	8
+/* Growing a shared receive queue is deferred, and done at most once per this period */
+#define NVMF_RDMA_SRQ_GROW_DELAY_US	10000
+
 static int g_spdk_nvmf_ibv_query_mask =
 	IBV_QP_STATE |
 	IBV_QP_PKEY_INDEX |
@@ -249,6 +254,7 @@ struct spdk_nvmf_rdma_resource_opts {
 	struct spdk_rdma_mem_map	*map;
 	uint32_t			max_queue_depth;
 	uint32_t			in_capsule_data_size;
+	int				socket_id;
 	bool				shared;
 };
 
@@ -279,6 +285,12 @@ struct spdk_nvmf_rdma_resources {
 
 	/* Queue to track free requests */
 	STAILQ_HEAD(, spdk_nvmf_rdma_request)	free_queue;
+
+	/* Number of elements in each of the arrays above */
+	uint32_t				max_queue_depth;
+
+	/* Link to the resources added to a shared receive queue as it grows */
+	STAILQ_ENTRY(spdk_nvmf_rdma_resources)	link;
 };
 
 typedef void (*spdk_nvmf_rdma_qpair_ibv_event)(struct spdk_nvmf_rdma_qpair *rqpair);
@@ -384,6 +396,7 @@ struct spdk_nvmf_rdma_poller_stat {
 	uint64_t				pending_free_request;
 	uint64_t				pending_rdma_read;
 	uint64_t				pending_rdma_write;
+	uint64_t				srq_low_watermark;
 	struct spdk_rdma_qp_stats		qp_stats;
 };
 
@@ -397,11 +410,23 @@ struct spdk_nvmf_rdma_poller {
 
 	/* The maximum number of I/O outstanding on the shared receive queue at one time */
 	uint16_t				max_srq_depth;
+	/* The number of receive WRs currently allocated for the shared receive queue */
+	uint16_t				srq_depth;
 	bool					need_destroy;
+	bool					srq_below_watermark;
+
+	/* Grows the shared receive queue outside of the completion polling path */
+	struct spdk_poller			*srq_grow_poller;
 
 	/* Shared receive queue */
 	struct spdk_rdma_srq			*srq;
 
+	/* The number of receive WRs completed on the shared receive queue */
+	uint64_t				srq_recv_completions;
+
+	/* Resources of the shared receive queue, the first entry is the same as resources */
+	STAILQ_HEAD(, spdk_nvmf_rdma_resources)	srq_resources;
+
 	struct spdk_nvmf_rdma_resources		*resources;
 	struct spdk_nvmf_rdma_poller_stat	stat;
 
@@ -441,6 +466,9 @@ struct spdk_nvmf_rdma_device {
 	struct spdk_rdma_mem_map		*map;
 	struct ibv_pd				*pd;
 
+	/* NUMA node the device is attached to, or SPDK_ENV_SOCKET_ID_ANY */
+	int					socket_id;
+
 	int					num_srq;
 	bool					need_destroy;
 	bool					ready_to_destroy;
@@ -459,6 +487,7 @@ struct spdk_nvmf_rdma_port {
 struct rdma_transport_opts {
 	int		num_cqe;
 	uint32_t	max_srq_depth;
+	uint32_t	initial_srq_depth;
 	bool		no_srq;
 	bool		no_wr_batching;
 	int		acceptor_backlog;
@@ -507,6 +536,10 @@ static const struct spdk_json_object_decoder rdma_transport_opts_decoder[] = {
 		"max_srq_depth", offsetof(struct rdma_transport_opts, max_srq_depth),
 		spdk_json_decode_uint32, true
 	},
+	{
+		"initial_srq_depth", offsetof(struct rdma_transport_opts, initial_srq_depth),
+		spdk_json_decode_uint32, true
+	},
 	{
 		"no_srq", offsetof(struct rdma_transport_opts, no_srq),
 		spdk_json_decode_bool, true
@@ -679,6 +712,19 @@ nvmf_rdma_resources_destroy(struct spdk_nvmf_rdma_resources *resources)
 	free(resources);
 }
 
+/* Allocate the memory on the NUMA node of the NIC if possible, on any node otherwise. */
+static void *
+nvmf_rdma_resources_zmalloc(size_t size, int socket_id)
+{
+	void *buf;
+
+	buf = spdk_zmalloc(size, 0x1000, NULL, socket_id, SPDK_MALLOC_DMA);
+	if (buf == NULL && socket_id != SPDK_ENV_SOCKET_ID_ANY) {
+		buf = spdk_zmalloc(size, 0x1000, NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	}
+
+	return buf;
+}
 
 static struct spdk_nvmf_rdma_resources *
 nvmf_rdma_resources_create(struct spdk_nvmf_rdma_resource_opts *opts)
@@ -699,19 +745,18 @@ nvmf_rdma_resources_create(struct spdk_nvmf_rdma_resource_opts *opts)
 		return NULL;
 	}
 
-	resources->reqs = spdk_zmalloc(opts->max_queue_depth * sizeof(*resources->reqs),
-				       0x1000, NULL, SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
-	resources->recvs = spdk_zmalloc(opts->max_queue_depth * sizeof(*resources->recvs),
-					0x1000, NULL, SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
-	resources->cmds = spdk_zmalloc(opts->max_queue_depth * sizeof(*resources->cmds),
-				       0x1000, NULL, SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
-	resources->cpls = spdk_zmalloc(opts->max_queue_depth * sizeof(*resources->cpls),
-				       0x1000, NULL, SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+	resources->reqs = nvmf_rdma_resources_zmalloc(opts->max_queue_depth * sizeof(*resources->reqs),
+			  opts->socket_id);
+	resources->recvs = nvmf_rdma_resources_zmalloc(opts->max_queue_depth * sizeof(*resources->recvs),
+			   opts->socket_id);
+	resources->cmds = nvmf_rdma_resources_zmalloc(opts->max_queue_depth * sizeof(*resources->cmds),
+			  opts->socket_id);
+	resources->cpls = nvmf_rdma_resources_zmalloc(opts->max_queue_depth * sizeof(*resources->cpls),
+			  opts->socket_id);
 
 	if (opts->in_capsule_data_size > 0) {
-		resources->bufs = spdk_zmalloc(opts->max_queue_depth * opts->in_capsule_data_size,
-					       0x1000, NULL, SPDK_ENV_LCORE_ID_ANY,
-					       SPDK_MALLOC_DMA);
+		resources->bufs = nvmf_rdma_resources_zmalloc(opts->max_queue_depth * opts->in_capsule_data_size,
+				  opts->socket_id);
 	}
 
 	if (!resources->reqs || !resources->recvs || !resources->cmds ||
@@ -733,6 +778,7 @@ nvmf_rdma_resources_create(struct spdk_nvmf_rdma_resource_opts *opts)
 	/* Initialize queues */
 	STAILQ_INIT(&resources->incoming_queue);
 	STAILQ_INIT(&resources->free_queue);
+	resources->max_queue_depth = opts->max_queue_depth;
 
 	if (opts->shared) {
 		srq = (struct spdk_rdma_srq *)opts->qp;
@@ -870,25 +916,28 @@ nvmf_rdma_qpair_destroy(struct spdk_nvmf_rdma_qpair *rqpair)
 		struct spdk_nvmf_qpair *qpair = &rqpair->qpair;
 		struct spdk_nvmf_rdma_transport	*rtransport = SPDK_CONTAINEROF(qpair->transport,
 				struct spdk_nvmf_rdma_transport, transport);
+		struct spdk_nvmf_rdma_resources *resources = NULL;
 		struct spdk_nvmf_rdma_request *req;
-		uint32_t i, max_req_count = 0;
+		uint32_t i;
 
 		SPDK_WARNLOG("Destroying qpair when queue depth is %d\n", rqpair->qd);
 
 		if (rqpair->srq == NULL) {
 			nvmf_rdma_dump_qpair_contents(rqpair);
-			max_req_count = rqpair->max_queue_depth;
+			resources = rqpair->resources;
 		} else if (rqpair->poller && rqpair->resources) {
-			max_req_count = rqpair->poller->max_srq_depth;
+			resources = STAILQ_FIRST(&rqpair->poller->srq_resources);
 		}
 
 		SPDK_DEBUGLOG(rdma, "Release incomplete requests\n");
-		for (i = 0; i < max_req_count; i++) {
-			req = &rqpair->resources->reqs[i];
-			if (req->req.qpair == qpair && req->state != RDMA_REQUEST_STATE_FREE) {
-				/* nvmf_rdma_request_process checks qpair ibv and internal state
-				 * and completes a request */
-				nvmf_rdma_request_process(rtransport, req);
+		for (; resources != NULL; resources = STAILQ_NEXT(resources, link)) {
+			for (i = 0; i < resources->max_queue_depth; i++) {
+				req = &resources->reqs[i];
+				if (req->req.qpair == qpair && req->state != RDMA_REQUEST_STATE_FREE) {
+					/* nvmf_rdma_request_process checks qpair ibv and internal state
+					 * and completes a request */
+					nvmf_rdma_request_process(rtransport, req);
+				}
 			}
 		}
 		assert(rqpair->qd == 0);
@@ -1046,6 +1095,7 @@ nvmf_rdma_qpair_initialize(struct spdk_nvmf_qpair *qpair)
 		opts.shared = false;
 		opts.max_queue_depth = rqpair->max_queue_depth;
 		opts.in_capsule_data_size = transport->opts.in_capsule_data_size;
+		opts.socket_id = device->socket_id;
 
 		rqpair->resources = nvmf_rdma_resources_create(&opts);
 
@@ -2357,6 +2407,7 @@ nvmf_rdma_request_process(struct spdk_nvmf_rdma_transport *rtransport,
 #define SPDK_NVMF_RDMA_DEFAULT_MAX_QUEUE_DEPTH 128
 #define SPDK_NVMF_RDMA_DEFAULT_AQ_DEPTH 128
 #define SPDK_NVMF_RDMA_DEFAULT_SRQ_DEPTH 4096
+#define SPDK_NVMF_RDMA_DEFAULT_INITIAL_SRQ_DEPTH 0
 #define SPDK_NVMF_RDMA_DEFAULT_MAX_QPAIRS_PER_CTRLR 128
 #define SPDK_NVMF_RDMA_DEFAULT_IN_CAPSULE_DATA_SIZE 4096
 #define SPDK_NVMF_RDMA_DEFAULT_MAX_IO_SIZE 131072
@@ -2400,6 +2451,27 @@ static bool nvmf_rdma_retry_listen_port(struct spdk_nvmf_rdma_transport *rtransp
 static void destroy_ib_device(struct spdk_nvmf_rdma_transport *rtransport,
 			      struct spdk_nvmf_rdma_device *device);
 
+static int
+nvmf_rdma_get_device_socket_id(struct ibv_context *context)
+{
+	char path[PATH_MAX];
+	FILE *f;
+	int socket_id;
+
+	snprintf(path, sizeof(path), "%s/device/numa_node", context->device->ibdev_path);
+	f = fopen(path, "r");
+	if (f == NULL) {
+		return SPDK_ENV_SOCKET_ID_ANY;
+	}
+
+	if (fscanf(f, "%d", &socket_id) != 1 || socket_id < 0) {
+		socket_id = SPDK_ENV_SOCKET_ID_ANY;
+	}
+	fclose(f);
+
+	return socket_id;
+}
+
 static int
 create_ib_device(struct spdk_nvmf_rdma_transport *rtransport, struct ibv_context *context,
 		 struct spdk_nvmf_rdma_device **new_device)
@@ -2421,6 +2493,8 @@ create_ib_device(struct spdk_nvmf_rdma_transport *rtransport, struct ibv_context
 		return rc;
 	}
 
+	device->socket_id = nvmf_rdma_get_device_socket_id(context);
+
 #ifdef SPDK_CONFIG_RDMA_SEND_WITH_INVAL
 	if ((device->attr.device_cap_flags & IBV_DEVICE_MEM_MGT_EXTENSIONS) == 0) {
 		SPDK_WARNLOG("The libibverbs on this system supports SEND_WITH_INVALIDATE,");
@@ -2556,6 +2630,7 @@ nvmf_rdma_create(struct spdk_nvmf_transport_opts *opts)
 	rtransport->transport.ops = &spdk_nvmf_transport_rdma;
 	rtransport->rdma_opts.num_cqe = DEFAULT_NVMF_RDMA_CQ_SIZE;
 	rtransport->rdma_opts.max_srq_depth = SPDK_NVMF_RDMA_DEFAULT_SRQ_DEPTH;
+	rtransport->rdma_opts.initial_srq_depth = SPDK_NVMF_RDMA_DEFAULT_INITIAL_SRQ_DEPTH;
 	rtransport->rdma_opts.no_srq = SPDK_NVMF_RDMA_DEFAULT_NO_SRQ;
 	rtransport->rdma_opts.acceptor_backlog = SPDK_NVMF_RDMA_ACCEPTOR_BACKLOG;
 	rtransport->rdma_opts.no_wr_batching = SPDK_NVMF_RDMA_DEFAULT_NO_WR_BATCHING;
@@ -2572,8 +2647,8 @@ nvmf_rdma_create(struct spdk_nvmf_transport_opts *opts)
 		     "  Transport opts:  max_ioq_depth=%d, max_io_size=%d,\n"
 		     "  max_io_qpairs_per_ctrlr=%d, io_unit_size=%d,\n"
 		     "  in_capsule_data_size=%d, max_aq_depth=%d,\n"
-		     "  num_shared_buffers=%d, num_cqe=%d, max_srq_depth=%d, no_srq=%d,"
-		     "  acceptor_backlog=%d, no_wr_batching=%d abort_timeout_sec=%d\n",
+		     "  num_shared_buffers=%d, num_cqe=%d, max_srq_depth=%d, initial_srq_depth=%d,"
+		     "  no_srq=%d, acceptor_backlog=%d, no_wr_batching=%d abort_timeout_sec=%d\n",
 		     opts->max_queue_depth,
 		     opts->max_io_size,
 		     opts->max_qpairs_per_ctrlr - 1,
@@ -2583,6 +2658,7 @@ nvmf_rdma_create(struct spdk_nvmf_transport_opts *opts)
 		     opts->num_shared_buffers,
 		     rtransport->rdma_opts.num_cqe,
 		     rtransport->rdma_opts.max_srq_depth,
+		     rtransport->rdma_opts.initial_srq_depth,
 		     rtransport->rdma_opts.no_srq,
 		     rtransport->rdma_opts.acceptor_backlog,
 		     rtransport->rdma_opts.no_wr_batching,
@@ -2742,6 +2818,7 @@ nvmf_rdma_dump_opts(struct spdk_nvmf_transport *transport, struct spdk_json_writ
 
 	rtransport = SPDK_CONTAINEROF(transport, struct spdk_nvmf_rdma_transport, transport);
 	spdk_json_write_named_uint32(w, "max_srq_depth", rtransport->rdma_opts.max_srq_depth);
+	spdk_json_write_named_uint32(w, "initial_srq_depth", rtransport->rdma_opts.initial_srq_depth);
 	spdk_json_write_named_bool(w, "no_srq", rtransport->rdma_opts.no_srq);
 	if (rtransport->rdma_opts.no_srq == true) {
 		spdk_json_write_named_int32(w, "num_cqe", rtransport->rdma_opts.num_cqe);
@@ -3863,6 +3940,7 @@ nvmf_rdma_poller_create(struct spdk_nvmf_rdma_transport *rtransport,
 	RB_INIT(&poller->qpairs);
 	STAILQ_INIT(&poller->qpairs_pending_send);
 	STAILQ_INIT(&poller->qpairs_pending_recv);
+	STAILQ_INIT(&poller->srq_resources);
 
 	TAILQ_INSERT_TAIL(&rgroup->pollers, poller, link);
 	SPDK_DEBUGLOG(rdma, "Create poller %p on device %p in poll group %p.\n", poller, device, rgroup);
@@ -3872,6 +3950,11 @@ nvmf_rdma_poller_create(struct spdk_nvmf_rdma_transport *rtransport,
 				     rtransport->rdma_opts.max_srq_depth, device->context->device->name, device->attr.max_srq_wr);
 		}
 		poller->max_srq_depth = spdk_min((int)rtransport->rdma_opts.max_srq_depth, device->attr.max_srq_wr);
+		if (rtransport->rdma_opts.initial_srq_depth != 0) {
+			poller->srq_depth = spdk_min(rtransport->rdma_opts.initial_srq_depth, poller->max_srq_depth);
+		} else {
+			poller->srq_depth = poller->max_srq_depth;
+		}
 
 		device->num_srq++;
 		memset(&srq_init_attr, 0, sizeof(srq_init_attr));
@@ -3889,14 +3972,16 @@ nvmf_rdma_poller_create(struct spdk_nvmf_rdma_transport *rtransport,
 		opts.map = device->map;
 		opts.qpair = NULL;
 		opts.shared = true;
-		opts.max_queue_depth = poller->max_srq_depth;
+		opts.max_queue_depth = poller->srq_depth;
 		opts.in_capsule_data_size = rtransport->transport.opts.in_capsule_data_size;
+		opts.socket_id = device->socket_id;
 
 		poller->resources = nvmf_rdma_resources_create(&opts);
 		if (!poller->resources) {
 			SPDK_ERRLOG("Unable to allocate resources for shared receive queue.\n");
 			return -1;
 		}
+		STAILQ_INSERT_TAIL(&poller->srq_resources, poller->resources, link);
 	}
 
 	/*
@@ -3949,6 +4034,8 @@ nvmf_rdma_poll_group_create(struct spdk_nvmf_transport *transport,
 	struct spdk_nvmf_rdma_poll_group	*rgroup;
 	struct spdk_nvmf_rdma_poller		*poller;
 	struct spdk_nvmf_rdma_device		*device;
+	struct spdk_thread			*thread;
+	int					socket_id = SPDK_ENV_SOCKET_ID_ANY;
 	int					rc;
 
 	rtransport = SPDK_CONTAINEROF(transport, struct spdk_nvmf_rdma_transport, transport);
@@ -3966,6 +4053,20 @@ nvmf_rdma_poll_group_create(struct spdk_nvmf_transport *transport,
 			nvmf_rdma_poll_group_destroy(&rgroup->group);
 			return NULL;
 		}
+
+		if (device == TAILQ_FIRST(&rtransport->devices)) {
+			socket_id = device->socket_id;
+		} else if (device->socket_id != socket_id) {
+			socket_id = SPDK_ENV_SOCKET_ID_ANY;
+		}
+	}
+
+	/* If all devices are attached to the same socket, let the scheduler keep
+	 * the poll group on it.
+	 */
+	thread = spdk_get_thread();
+	if (thread != NULL && socket_id != SPDK_ENV_SOCKET_ID_ANY) {
+		spdk_thread_set_socket_id(thread, socket_id);
 	}
 
 	TAILQ_INSERT_TAIL(&rtransport->poll_groups, rgroup, link);
@@ -3977,20 +4078,18 @@ nvmf_rdma_poll_group_create(struct spdk_nvmf_transport *transport,
 	return &rgroup->group;
 }
 
-static uint32_t
-nvmf_poll_group_get_io_qpair_count(struct spdk_nvmf_poll_group *pg)
+static struct spdk_nvmf_transport_poll_group *
+nvmf_rdma_poll_group_next(struct spdk_nvmf_transport_poll_group *group, void *ctx)
 {
-	uint32_t count;
+	struct spdk_nvmf_rdma_transport *rtransport = ctx;
+	struct spdk_nvmf_rdma_poll_group *rgroup;
 
-	/* Just assume that unassociated qpairs will eventually be io
-	 * qpairs.  This is close enough for the use cases for this
-	 * function.
-	 */
-	pthread_mutex_lock(&pg->mutex);
-	count = pg->stat.current_io_qpairs + pg->current_unassociated_qpairs;
-	pthread_mutex_unlock(&pg->mutex);
+	rgroup = TAILQ_NEXT(SPDK_CONTAINEROF(group, struct spdk_nvmf_rdma_poll_group, group), link);
+	if (rgroup == NULL) {
+		rgroup = TAILQ_FIRST(&rtransport->poll_groups);
+	}
 
-	return count;
+	return &rgroup->group;
 }
 
 static struct spdk_nvmf_transport_poll_group *
@@ -3999,7 +4098,6 @@ nvmf_rdma_get_optimal_poll_group(struct spdk_nvmf_qpair *qpair)
 	struct spdk_nvmf_rdma_transport *rtransport;
 	struct spdk_nvmf_rdma_poll_group **pg;
 	struct spdk_nvmf_transport_poll_group *result;
-	uint32_t count;
 
 	rtransport = SPDK_CONTAINEROF(qpair->transport, struct spdk_nvmf_rdma_transport, transport);
 
@@ -4010,31 +4108,10 @@ nvmf_rdma_get_optimal_poll_group(struct spdk_nvmf_qpair *qpair)
 	if (qpair->qid == 0) {
 		pg = &rtransport->conn_sched.next_admin_pg;
 	} else {
-		struct spdk_nvmf_rdma_poll_group *pg_min, *pg_start, *pg_current;
-		uint32_t min_value;
-
 		pg = &rtransport->conn_sched.next_io_pg;
-		pg_min = *pg;
-		pg_start = *pg;
-		pg_current = *pg;
-		min_value = nvmf_poll_group_get_io_qpair_count(pg_current->group.group);
-
-		while ((count = nvmf_poll_group_get_io_qpair_count(pg_current->group.group)) > 0) {
-			pg_current = TAILQ_NEXT(pg_current, link);
-			if (pg_current == NULL) {
-				pg_current = TAILQ_FIRST(&rtransport->poll_groups);
-			}
-
-			if (count < min_value) {
-				min_value = count;
-				pg_min = pg_current;
-			}
-
-			if (pg_current == pg_start) {
-				break;
-			}
-		}
-		*pg = pg_min;
+		*pg = SPDK_CONTAINEROF(nvmf_transport_get_least_loaded_poll_group(&(*pg)->group,
+				       nvmf_rdma_poll_group_next, rtransport),
+				       struct spdk_nvmf_rdma_poll_group, group);
 	}
 
 	assert(*pg != NULL);
@@ -4053,16 +4130,18 @@ static void
 nvmf_rdma_poller_destroy(struct spdk_nvmf_rdma_poller *poller)
 {
 	struct spdk_nvmf_rdma_qpair	*qpair, *tmp_qpair;
+	struct spdk_nvmf_rdma_resources	*resources, *tmp_resources;
 	int				rc;
 
+	spdk_poller_unregister(&poller->srq_grow_poller);
 	TAILQ_REMOVE(&poller->group->pollers, poller, link);
 	RB_FOREACH_SAFE(qpair, qpairs_tree, &poller->qpairs, tmp_qpair) {
 		nvmf_rdma_qpair_destroy(qpair);
 	}
 
 	if (poller->srq) {
-		if (poller->resources) {
-			nvmf_rdma_resources_destroy(poller->resources);
+		STAILQ_FOREACH_SAFE(resources, &poller->srq_resources, link, tmp_resources) {
+			nvmf_rdma_resources_destroy(resources);
 		}
 		spdk_rdma_srq_destroy(poller->srq);
 		SPDK_DEBUGLOG(rdma, "Destroyed RDMA shared queue %p\n", poller->srq);
@@ -4483,6 +4562,82 @@ nvmf_rdma_log_wc_status(struct spdk_nvmf_rdma_qpair *rqpair, struct ibv_wc *wc)
 	}
 }
 
+/*
+ * The shared receive queue is created for max_srq_depth WRs, but only initial_srq_depth
+ * of them get resources up front.  Once the receive WRs still posted drop below
+ * 1/NVMF_RDMA_SRQ_LOW_WATERMARK_DIV of that, the depth is doubled, up to max_srq_depth.
+ * Allocating the resources is expensive, so it is done by a timed poller rather than
+ * from the completion path, which also limits growth to once per NVMF_RDMA_SRQ_GROW_DELAY_US.
+ */
+static int
+nvmf_rdma_poller_grow_srq(void *ctx)
+{
+	struct spdk_nvmf_rdma_poller		*rpoller = ctx;
+	struct spdk_nvmf_transport		*transport = rpoller->group->group.transport;
+	struct spdk_nvmf_rdma_resource_opts	opts;
+	struct spdk_nvmf_rdma_resources		*resources;
+	uint16_t				grow;
+
+	spdk_poller_unregister(&rpoller->srq_grow_poller);
+
+	/* The burst is already over, keep the current depth */
+	if (!rpoller->srq_below_watermark || rpoller->srq_depth >= rpoller->max_srq_depth) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	grow = spdk_min(rpoller->srq_depth, rpoller->max_srq_depth - rpoller->srq_depth);
+
+	opts.qp = rpoller->srq;
+	opts.map = rpoller->device->map;
+	opts.qpair = NULL;
+	opts.shared = true;
+	opts.max_queue_depth = grow;
+	opts.in_capsule_data_size = transport->opts.in_capsule_data_size;
+	opts.socket_id = rpoller->device->socket_id;
+
+	resources = nvmf_rdma_resources_create(&opts);
+	if (resources == NULL) {
+		SPDK_ERRLOG("Unable to grow shared receive queue of poller %p to %u\n", rpoller,
+			    rpoller->srq_depth + grow);
+		return SPDK_POLLER_BUSY;
+	}
+
+	/* All qpairs of the poller take requests from the first resources' free queue */
+	STAILQ_CONCAT(&rpoller->resources->free_queue, &resources->free_queue);
+	STAILQ_INSERT_TAIL(&rpoller->srq_resources, resources, link);
+	rpoller->srq_depth += grow;
+	SPDK_DEBUGLOG(rdma, "Shared receive queue of poller %p grown to %u\n", rpoller,
+		      rpoller->srq_depth);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+nvmf_rdma_poller_check_srq_watermark(struct spdk_nvmf_rdma_poller *rpoller)
+{
+	uint64_t posted;
+
+	posted = rpoller->stat.qp_stats.recv.num_submitted_wrs - rpoller->srq_recv_completions;
+	if (posted >= rpoller->srq_depth / NVMF_RDMA_SRQ_LOW_WATERMARK_DIV) {
+		rpoller->srq_below_watermark = false;
+		return;
+	}
+
+	if (rpoller->srq_below_watermark) {
+		return;
+	}
+
+	rpoller->srq_below_watermark = true;
+	rpoller->stat.srq_low_watermark++;
+
+	if (rpoller->srq_depth >= rpoller->max_srq_depth || rpoller->srq_grow_poller != NULL) {
+		return;
+	}
+
+	rpoller->srq_grow_poller = SPDK_POLLER_REGISTER(nvmf_rdma_poller_grow_srq, rpoller,
+				   NVMF_RDMA_SRQ_GROW_DELAY_US);
+}
+
 static int
 nvmf_rdma_poller_poll(struct spdk_nvmf_rdma_transport *rtransport,
 		      struct spdk_nvmf_rdma_poller *rpoller)
@@ -4547,6 +4702,7 @@ nvmf_rdma_poller_poll(struct spdk_nvmf_rdma_transport *rtransport,
 			/* rdma_recv->qpair will be invalid if using an SRQ.  In that case we have to get the qpair from the wc. */
 			rdma_recv = SPDK_CONTAINEROF(rdma_wr, struct spdk_nvmf_rdma_recv, rdma_wr);
 			if (rpoller->srq != NULL) {
+				rpoller->srq_recv_completions++;
 				rdma_recv->qpair = get_rdma_qpair_from_wc(rpoller, &wc[i]);
 				/* It is possible that there are still some completions for destroyed QP
 				 * associated with SRQ. We just ignore these late completions and re-post
@@ -4643,6 +4799,10 @@ nvmf_rdma_poller_poll(struct spdk_nvmf_rdma_transport *rtransport,
 		return -1;
 	}
 
+	if (rpoller->srq != NULL) {
+		nvmf_rdma_poller_check_srq_watermark(rpoller);
+	}
+
 	/* submit outstanding work requests. */
 	_poller_submit_recvs(rtransport, rpoller);
 	_poller_submit_sends(rtransport, rpoller);
@@ -4889,8 +5049,9 @@ nvmf_rdma_qpair_abort_request(struct spdk_nvmf_qpair *qpair,
 	struct spdk_nvmf_rdma_qpair *rqpair;
 	struct spdk_nvmf_rdma_transport *rtransport;
 	struct spdk_nvmf_transport *transport;
+	struct spdk_nvmf_rdma_resources *resources;
 	uint16_t cid;
-	uint32_t i, max_req_count;
+	uint32_t i;
 	struct spdk_nvmf_rdma_request *rdma_req_to_abort = NULL, *rdma_req;
 
 	rqpair = SPDK_CONTAINEROF(qpair, struct spdk_nvmf_rdma_qpair, qpair);
@@ -4898,17 +5059,19 @@ nvmf_rdma_qpair_abort_request(struct spdk_nvmf_qpair *qpair,
 	transport = &rtransport->transport;
 
 	cid = req->cmd->nvme_cmd.cdw10_bits.abort.cid;
-	max_req_count = rqpair->srq == NULL ? rqpair->max_queue_depth : rqpair->poller->max_srq_depth;
-
-	for (i = 0; i < max_req_count; i++) {
-		rdma_req = &rqpair->resources->reqs[i];
-		/* When SRQ == NULL, rqpair has its own requests and req.qpair pointer always points to the qpair
-		 * When SRQ != NULL all rqpairs share common requests and qpair pointer is assigned when we start to
-		 * process a request. So in both cases all requests which are not in FREE state have valid qpair ptr */
-		if (rdma_req->state != RDMA_REQUEST_STATE_FREE && rdma_req->req.cmd->nvme_cmd.cid == cid &&
-		    rdma_req->req.qpair == qpair) {
-			rdma_req_to_abort = rdma_req;
-			break;
+	resources = rqpair->srq == NULL ? rqpair->resources : STAILQ_FIRST(&rqpair->poller->srq_resources);
+
+	for (; resources != NULL && rdma_req_to_abort == NULL; resources = STAILQ_NEXT(resources, link)) {
+		for (i = 0; i < resources->max_queue_depth; i++) {
+			rdma_req = &resources->reqs[i];
+			/* When SRQ == NULL, rqpair has its own requests and req.qpair pointer always points to the qpair
+			 * When SRQ != NULL all rqpairs share common requests and qpair pointer is assigned when we start to
+			 * process a request. So in both cases all requests which are not in FREE state have valid qpair ptr */
+			if (rdma_req->state != RDMA_REQUEST_STATE_FREE && rdma_req->req.cmd->nvme_cmd.cid == cid &&
+			    rdma_req->req.qpair == qpair) {
+				rdma_req_to_abort = rdma_req;
+				break;
+			}
 		}
 	}
 
@@ -4968,6 +5131,11 @@ nvmf_rdma_poll_group_dump_stat(struct spdk_nvmf_transport_poll_group *group,
 					     rpoller->stat.qp_stats.recv.num_submitted_wrs);
 		spdk_json_write_named_uint64(w, "recv_doorbell_updates",
 					     rpoller->stat.qp_stats.recv.doorbell_updates);
+		if (rpoller->srq != NULL) {
+			spdk_json_write_named_uint32(w, "srq_depth", rpoller->srq_depth);
+			spdk_json_write_named_uint64(w, "srq_low_watermark",
+						     rpoller->stat.srq_low_watermark);
+		}
 		spdk_json_write_object_end(w);
 	}
 
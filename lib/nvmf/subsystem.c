@@ -45,6 +45,14 @@ enum spdk_nvmf_nqn_domain_states {
 
 static int _nvmf_subsystem_destroy(struct spdk_nvmf_subsystem *subsystem);
 
+static int
+host_cmp(struct spdk_nvmf_host *host1, struct spdk_nvmf_host *host2)
+{
+	return strncmp(host1->nqn, host2->nqn, sizeof(host1->nqn));
+}
+
+RB_GENERATE_STATIC(host_tree, spdk_nvmf_host, node, host_cmp);
+
 /* Returns true if is a valid ASCII string as defined by the NVMe spec */
 static bool
 nvmf_valid_ascii_string(const void *buf, size_t size)
@@ -265,6 +273,7 @@ spdk_nvmf_subsystem_create(struct spdk_nvmf_tgt *tgt,
 	pthread_mutex_init(&subsystem->mutex, NULL);
 	TAILQ_INIT(&subsystem->listeners);
 	TAILQ_INIT(&subsystem->hosts);
+	RB_INIT(&subsystem->host_index);
 	TAILQ_INIT(&subsystem->ctrlrs);
 	subsystem->used_listener_ids = spdk_bit_array_create(NVMF_MAX_LISTENERS_PER_SUBSYSTEM);
 	if (subsystem->used_listener_ids == NULL) {
@@ -312,6 +321,7 @@ static void
 nvmf_subsystem_remove_host(struct spdk_nvmf_subsystem *subsystem, struct spdk_nvmf_host *host)
 {
 	TAILQ_REMOVE(&subsystem->hosts, host, link);
+	RB_REMOVE(host_tree, &subsystem->host_index, host);
 	free(host);
 }
 
@@ -355,10 +365,18 @@ static int
 _nvmf_subsystem_destroy(struct spdk_nvmf_subsystem *subsystem)
 {
 	struct spdk_nvmf_ns		*ns;
+	struct spdk_nvmf_ctrlr		*ctrlr, *ctrlr_tmp;
 	nvmf_subsystem_destroy_cb	async_destroy_cb = NULL;
 	void				*async_destroy_cb_arg = NULL;
 	int				rc;
 
+	/* Controllers kept for their hosts to resume cannot be resumed anymore */
+	TAILQ_FOREACH_SAFE(ctrlr, &subsystem->ctrlrs, link, ctrlr_tmp) {
+		if (ctrlr->resume_timer != NULL) {
+			nvmf_ctrlr_abort_resume(ctrlr);
+		}
+	}
+
 	if (!TAILQ_EMPTY(&subsystem->ctrlrs)) {
 		SPDK_DEBUGLOG(nvmf, "subsystem %p %s has active controllers\n", subsystem, subsystem->subnqn);
 		subsystem->async_destroy = true;
@@ -555,6 +573,11 @@ nvmf_subsystem_set_state(struct spdk_nvmf_subsystem *subsystem,
 					    __ATOMIC_RELAXED, __ATOMIC_RELAXED);
 	}
 	assert(actual_old_state == expected_old_state);
+	if (actual_old_state == expected_old_state &&
+	    (state == SPDK_NVMF_SUBSYSTEM_ACTIVATING || state == SPDK_NVMF_SUBSYSTEM_DEACTIVATING)) {
+		/* The subsystem appears in or disappears from the discovery log */
+		subsystem->tgt->discovery_genctr++;
+	}
 	return actual_old_state - expected_old_state;
 }
 
@@ -612,10 +635,10 @@ subsystem_state_change_done(struct spdk_io_channel_iter *i, int status)
 			goto out;
 		}
 		ctx->requested_state = ctx->original_state;
-		spdk_for_each_channel(ctx->subsystem->tgt,
-				      subsystem_state_change_on_pg,
-				      ctx,
-				      subsystem_state_change_revert_done);
+		spdk_for_each_channel_parallel(ctx->subsystem->tgt,
+					       subsystem_state_change_on_pg,
+					       ctx,
+					       subsystem_state_change_revert_done);
 		return;
 	}
 
@@ -723,10 +746,11 @@ nvmf_subsystem_state_change(struct spdk_nvmf_subsystem *subsystem,
 	ctx->cb_fn = cb_fn;
 	ctx->cb_arg = cb_arg;
 
-	spdk_for_each_channel(subsystem->tgt,
-			      subsystem_state_change_on_pg,
-			      ctx,
-			      subsystem_state_change_done);
+	/* The poll groups are independent, so change their state all at once */
+	spdk_for_each_channel_parallel(subsystem->tgt,
+				       subsystem_state_change_on_pg,
+				       ctx,
+				       subsystem_state_change_done);
 
 	return 0;
 }
@@ -784,15 +808,11 @@ spdk_nvmf_subsystem_get_next(struct spdk_nvmf_subsystem *subsystem)
 static struct spdk_nvmf_host *
 nvmf_subsystem_find_host(struct spdk_nvmf_subsystem *subsystem, const char *hostnqn)
 {
-	struct spdk_nvmf_host *host = NULL;
+	struct spdk_nvmf_host host;
 
-	TAILQ_FOREACH(host, &subsystem->hosts, link) {
-		if (strcmp(hostnqn, host->nqn) == 0) {
-			return host;
-		}
-	}
+	snprintf(host.nqn, sizeof(host.nqn), "%s", hostnqn);
 
-	return NULL;
+	return RB_FIND(host_tree, &subsystem->host_index, &host);
 }
 
 int
@@ -822,10 +842,12 @@ spdk_nvmf_subsystem_add_host(struct spdk_nvmf_subsystem *subsystem, const char *
 	}
 
 	snprintf(host->nqn, sizeof(host->nqn), "%s", hostnqn);
+	host->qos_weight = NVMF_QOS_DEFAULT_WEIGHT;
 
 	SPDK_DTRACE_PROBE2(nvmf_subsystem_add_host, subsystem->subnqn, host->nqn);
 
 	TAILQ_INSERT_HEAD(&subsystem->hosts, host, link);
+	RB_INSERT(host_tree, &subsystem->host_index, host);
 
 	if (!TAILQ_EMPTY(&subsystem->listeners)) {
 		nvmf_update_discovery_log(subsystem->tgt, hostnqn);
@@ -884,6 +906,93 @@ spdk_nvmf_subsystem_remove_host(struct spdk_nvmf_subsystem *subsystem, const cha
 	return 0;
 }
 
+struct nvmf_subsystem_host_qos_ctx {
+	struct spdk_nvmf_subsystem	*subsystem;
+	char				hostnqn[SPDK_NVMF_NQN_MAX_LEN + 1];
+	uint64_t			rw_ios_per_sec;
+	uint64_t			rw_mbytes_per_sec;
+	uint32_t			weight;
+};
+
+static void
+nvmf_subsystem_update_ctrlrs_qos(void *_ctx)
+{
+	struct nvmf_subsystem_host_qos_ctx *ctx = _ctx;
+	struct spdk_nvmf_ctrlr *ctrlr;
+
+	TAILQ_FOREACH(ctrlr, &ctx->subsystem->ctrlrs, link) {
+		if (strcmp(ctrlr->hostnqn, ctx->hostnqn) == 0) {
+			nvmf_ctrlr_set_qos_limits(ctrlr, ctx->rw_ios_per_sec,
+						  ctx->rw_mbytes_per_sec, ctx->weight);
+		}
+	}
+
+	free(ctx);
+}
+
+int
+spdk_nvmf_subsystem_set_host_qos_limits(struct spdk_nvmf_subsystem *subsystem,
+					const char *hostnqn, uint64_t rw_ios_per_sec,
+					uint64_t rw_mbytes_per_sec, uint32_t weight)
+{
+	struct nvmf_subsystem_host_qos_ctx *ctx;
+	struct spdk_nvmf_host *host;
+
+	if (weight == 0 || weight > NVMF_QOS_MAX_WEIGHT) {
+		SPDK_ERRLOG("QoS weight must be between 1 and %d\n", NVMF_QOS_MAX_WEIGHT);
+		return -EINVAL;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	pthread_mutex_lock(&subsystem->mutex);
+
+	host = nvmf_subsystem_find_host(subsystem, hostnqn);
+	if (host == NULL) {
+		pthread_mutex_unlock(&subsystem->mutex);
+		free(ctx);
+		return -ENOENT;
+	}
+
+	host->rw_ios_per_sec = rw_ios_per_sec;
+	host->rw_mbytes_per_sec = rw_mbytes_per_sec;
+	host->qos_weight = weight;
+
+	pthread_mutex_unlock(&subsystem->mutex);
+
+	/* The subsystem thread owns the controller list */
+	ctx->subsystem = subsystem;
+	snprintf(ctx->hostnqn, sizeof(ctx->hostnqn), "%s", hostnqn);
+	ctx->rw_ios_per_sec = rw_ios_per_sec;
+	ctx->rw_mbytes_per_sec = rw_mbytes_per_sec;
+	ctx->weight = weight;
+	spdk_thread_send_msg(subsystem->thread, nvmf_subsystem_update_ctrlrs_qos, ctx);
+
+	return 0;
+}
+
+int
+spdk_nvmf_subsystem_set_ns_qos_limits(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+				      uint64_t rw_ios_per_sec, uint64_t rw_mbytes_per_sec)
+{
+	struct spdk_nvmf_ns *ns;
+
+	ns = _nvmf_subsystem_get_ns(subsystem, nsid);
+	if (ns == NULL) {
+		return -ENOENT;
+	}
+
+	ns->rw_ios_per_sec = rw_ios_per_sec;
+	ns->rw_mbytes_per_sec = rw_mbytes_per_sec;
+	/* The poll groups pick the new limits up on their next command */
+	nvmf_qos_bucket_set_limits(&ns->qos, rw_ios_per_sec, rw_mbytes_per_sec);
+
+	return 0;
+}
+
 struct nvmf_subsystem_disconnect_host_ctx {
 	struct spdk_nvmf_subsystem		*subsystem;
 	char					*hostnqn;
@@ -1336,6 +1445,9 @@ spdk_nvmf_subsystem_remove_ns(struct spdk_nvmf_subsystem *subsystem, uint32_t ns
 
 	subsystem->ana_group[ns->anagrpid - 1]--;
 
+	/* The subsystem is paused, so no reservation request can still be waiting on the file */
+	assert(!ns->ptpl_write.in_progress);
+	assert(TAILQ_EMPTY(&ns->ptpl_write.waiters));
 	free(ns->ptpl_file);
 	nvmf_ns_reservation_clear_all_registrants(ns);
 	spdk_bdev_module_release_bdev(ns->bdev);
@@ -1731,6 +1843,7 @@ spdk_nvmf_subsystem_add_ns_ext(struct spdk_nvmf_subsystem *subsystem, const char
 	ns->anagrpid = opts.anagrpid;
 	subsystem->ana_group[ns->anagrpid - 1]++;
 	TAILQ_INIT(&ns->registrants);
+	TAILQ_INIT(&ns->ptpl_write.waiters);
 	if (ptpl_file) {
 		rc = nvmf_ns_load_reservation(ptpl_file, &info);
 		if (!rc) {
@@ -1984,6 +2097,7 @@ nvmf_subsystem_gen_cntlid(struct spdk_nvmf_subsystem *subsystem)
 int
 nvmf_subsystem_add_ctrlr(struct spdk_nvmf_subsystem *subsystem, struct spdk_nvmf_ctrlr *ctrlr)
 {
+	struct spdk_nvmf_host *host;
 
 	if (ctrlr->dynamic_ctrlr) {
 		ctrlr->cntlid = nvmf_subsystem_gen_cntlid(subsystem);
@@ -1997,6 +2111,14 @@ nvmf_subsystem_add_ctrlr(struct spdk_nvmf_subsystem *subsystem, struct spdk_nvmf
 		return -EEXIST;
 	}
 
+	pthread_mutex_lock(&subsystem->mutex);
+	host = nvmf_subsystem_find_host(subsystem, ctrlr->hostnqn);
+	if (host != NULL) {
+		nvmf_ctrlr_set_qos_limits(ctrlr, host->rw_ios_per_sec, host->rw_mbytes_per_sec,
+					  host->qos_weight);
+	}
+	pthread_mutex_unlock(&subsystem->mutex);
+
 	TAILQ_INSERT_TAIL(&subsystem->ctrlrs, ctrlr, link);
 
 	SPDK_DTRACE_PROBE3(nvmf_subsystem_add_ctrlr, subsystem->subnqn, ctrlr, ctrlr->hostnqn);
@@ -2267,6 +2389,10 @@ nvmf_ns_json_write_cb(void *cb_ctx, const void *data, size_t size)
 		return -ENOENT;
 	}
 	rc = fwrite(data, 1, size, fd);
+	if (rc == size && (fflush(fd) != 0 || fsync(fileno(fd)) != 0)) {
+		SPDK_ERRLOG("Can't sync file %s\n", file);
+		rc = 0;
+	}
 	fclose(fd);
 
 	return rc == size ? 0 : -1;
@@ -2310,41 +2436,174 @@ exit:
 	return rc;
 }
 
-static int
-nvmf_ns_update_reservation_info(struct spdk_nvmf_ns *ns)
+static void
+nvmf_ns_get_reservation_info(struct spdk_nvmf_ns *ns, struct spdk_nvmf_reservation_info *info)
 {
-	struct spdk_nvmf_reservation_info info;
 	struct spdk_nvmf_registrant *reg, *tmp;
 	uint32_t i = 0;
 
 	assert(ns != NULL);
+	assert(ns->bdev != NULL);
 
-	if (!ns->bdev || !ns->ptpl_file) {
-		return 0;
-	}
-
-	memset(&info, 0, sizeof(info));
-	spdk_uuid_fmt_lower(info.bdev_uuid, sizeof(info.bdev_uuid), spdk_bdev_get_uuid(ns->bdev));
+	memset(info, 0, sizeof(*info));
+	spdk_uuid_fmt_lower(info->bdev_uuid, sizeof(info->bdev_uuid), spdk_bdev_get_uuid(ns->bdev));
 
 	if (ns->rtype) {
-		info.rtype = ns->rtype;
-		info.crkey = ns->crkey;
+		info->rtype = ns->rtype;
+		info->crkey = ns->crkey;
 		if (!nvmf_ns_reservation_all_registrants_type(ns)) {
 			assert(ns->holder != NULL);
-			spdk_uuid_fmt_lower(info.holder_uuid, sizeof(info.holder_uuid), &ns->holder->hostid);
+			spdk_uuid_fmt_lower(info->holder_uuid, sizeof(info->holder_uuid), &ns->holder->hostid);
 		}
 	}
 
 	TAILQ_FOREACH_SAFE(reg, &ns->registrants, link, tmp) {
-		spdk_uuid_fmt_lower(info.registrants[i].host_uuid, sizeof(info.registrants[i].host_uuid),
+		spdk_uuid_fmt_lower(info->registrants[i].host_uuid, sizeof(info->registrants[i].host_uuid),
 				    &reg->hostid);
-		info.registrants[i++].rkey = reg->rkey;
+		info->registrants[i++].rkey = reg->rkey;
+	}
+
+	info->num_regs = i;
+	info->ptpl_activated = ns->ptpl_activated;
+}
+
+struct nvmf_ns_ptpl_waiter {
+	nvmf_ns_reservation_persist_cb	cb_fn;
+	void				*cb_arg;
+	uint64_t			seq;
+	TAILQ_ENTRY(nvmf_ns_ptpl_waiter)	link;
+};
+
+struct nvmf_ns_ptpl_write {
+	struct spdk_nvmf_ns			*ns;
+	struct spdk_nvmf_reservation_info	info;
+	char					*file;
+	uint64_t				seq;
+};
+
+static void nvmf_ns_reservation_persist_submit(struct spdk_nvmf_ns *ns);
+
+static void
+nvmf_ns_reservation_persist_done(void *ctx, int rc)
+{
+	struct nvmf_ns_ptpl_write *write = ctx;
+	struct spdk_nvmf_ns *ns = write->ns;
+	struct nvmf_ns_ptpl_waiter *waiter, *tmp;
+	TAILQ_HEAD(, nvmf_ns_ptpl_waiter) done;
+
+	ns->ptpl_write.in_progress = false;
+
+	/* Every waiter queued before the snapshot was taken is covered by this write */
+	TAILQ_INIT(&done);
+	TAILQ_FOREACH_SAFE(waiter, &ns->ptpl_write.waiters, link, tmp) {
+		if (waiter->seq > write->seq) {
+			break;
+		}
+		TAILQ_REMOVE(&ns->ptpl_write.waiters, waiter, link);
+		TAILQ_INSERT_TAIL(&done, waiter, link);
+	}
+
+	/* Requests that arrived while the file was being written share the next write */
+	if (!TAILQ_EMPTY(&ns->ptpl_write.waiters)) {
+		nvmf_ns_reservation_persist_submit(ns);
+	}
+
+	TAILQ_FOREACH_SAFE(waiter, &done, link, tmp) {
+		TAILQ_REMOVE(&done, waiter, link);
+		waiter->cb_fn(waiter->cb_arg, rc);
+		free(waiter);
+	}
+
+	free(write->file);
+	free(write);
+}
+
+static int
+nvmf_ns_reservation_persist_write(void *ctx)
+{
+	struct nvmf_ns_ptpl_write *write = ctx;
+
+	return nvmf_ns_reservation_update(write->file, &write->info);
+}
+
+static void
+nvmf_ns_reservation_persist_submit(struct spdk_nvmf_ns *ns)
+{
+	struct nvmf_ns_ptpl_write *write;
+	struct nvmf_ns_ptpl_waiter *waiter;
+	int rc;
+
+	assert(!ns->ptpl_write.in_progress);
+
+	write = calloc(1, sizeof(*write));
+	if (write == NULL) {
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	write->file = strdup(ns->ptpl_file);
+	if (write->file == NULL) {
+		free(write);
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	write->ns = ns;
+	write->seq = ns->ptpl_write.seq;
+	nvmf_ns_get_reservation_info(ns, &write->info);
+
+	rc = nvmf_ptpl_write_submit(nvmf_ns_reservation_persist_write,
+				    nvmf_ns_reservation_persist_done, write);
+	if (rc != 0) {
+		free(write->file);
+		free(write);
+		goto err;
 	}
 
-	info.num_regs = i;
-	info.ptpl_activated = ns->ptpl_activated;
+	ns->ptpl_write.in_progress = true;
+	return;
 
-	return nvmf_ns_reservation_update(ns->ptpl_file, &info);
+err:
+	SPDK_ERRLOG("Failed to persist reservation of namespace %u: %s\n", ns->nsid,
+		    spdk_strerror(-rc));
+	while ((waiter = TAILQ_FIRST(&ns->ptpl_write.waiters))) {
+		TAILQ_REMOVE(&ns->ptpl_write.waiters, waiter, link);
+		waiter->cb_fn(waiter->cb_arg, rc);
+		free(waiter);
+	}
+}
+
+/*
+ * Write the current reservation state of the namespace to its PTPL file without
+ * blocking the calling thread.  The file is written by the PTPL writer thread
+ * and cb_fn is called on the calling thread once a write that includes the state
+ * as of this call has reached stable storage.  Calls made while a write is in
+ * flight are coalesced into a single follow-up write.
+ */
+int
+nvmf_ns_reservation_persist(struct spdk_nvmf_ns *ns, nvmf_ns_reservation_persist_cb cb_fn,
+			    void *cb_arg)
+{
+	struct nvmf_ns_ptpl_waiter *waiter;
+
+	assert(ns->ptpl_file != NULL);
+	assert(ns->bdev != NULL);
+
+	waiter = calloc(1, sizeof(*waiter));
+	if (waiter == NULL) {
+		return -ENOMEM;
+	}
+
+	waiter->cb_fn = cb_fn;
+	waiter->cb_arg = cb_arg;
+	waiter->seq = ++ns->ptpl_write.seq;
+	TAILQ_INSERT_TAIL(&ns->ptpl_write.waiters, waiter, link);
+
+	if (!ns->ptpl_write.in_progress) {
+		nvmf_ns_reservation_persist_submit(ns);
+	}
+
+	return 0;
 }
 
 static struct spdk_nvmf_registrant *
@@ -2727,12 +2986,6 @@ nvmf_ns_reservation_register(struct spdk_nvmf_ns *ns,
 	}
 
 exit:
-	if (update_sgroup) {
-		rc = nvmf_ns_update_reservation_info(ns);
-		if (rc != 0) {
-			status = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
-		}
-	}
 	req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
 	req->rsp->nvme_cpl.status.sc = status;
 	return update_sgroup;
@@ -2897,11 +3150,6 @@ exit:
 
 		}
 	}
-	if (update_sgroup && ns->ptpl_activated) {
-		if (nvmf_ns_update_reservation_info(ns)) {
-			status = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
-		}
-	}
 	req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
 	req->rsp->nvme_cpl.status.sc = status;
 	return update_sgroup;
@@ -3004,11 +3252,6 @@ nvmf_ns_reservation_release(struct spdk_nvmf_ns *ns,
 	}
 
 exit:
-	if (update_sgroup && ns->ptpl_activated) {
-		if (nvmf_ns_update_reservation_info(ns)) {
-			status = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
-		}
-	}
 	req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
 	req->rsp->nvme_cpl.status.sc = status;
 	return update_sgroup;
@@ -3106,16 +3349,49 @@ _nvmf_ns_reservation_update_done(struct spdk_nvmf_subsystem *subsystem,
 	spdk_thread_send_msg(group->thread, nvmf_ns_reservation_complete, req);
 }
 
+static void
+nvmf_ns_reservation_update_sgroups(struct spdk_nvmf_request *req)
+{
+	struct spdk_nvmf_ctrlr *ctrlr = req->qpair->ctrlr;
+	struct subsystem_update_ns_ctx *update_ctx;
+
+	/* update reservation information to subsystem's poll group */
+	update_ctx = calloc(1, sizeof(*update_ctx));
+	if (update_ctx == NULL) {
+		SPDK_ERRLOG("Can't alloc subsystem poll group update context\n");
+		_nvmf_ns_reservation_update_done(ctrlr->subsys, (void *)req, 0);
+		return;
+	}
+	update_ctx->subsystem = ctrlr->subsys;
+	update_ctx->cb_fn = _nvmf_ns_reservation_update_done;
+	update_ctx->cb_arg = req;
+
+	nvmf_subsystem_update_ns(ctrlr->subsys, subsystem_update_ns_done, update_ctx);
+}
+
+static void
+_nvmf_ns_reservation_persist_done(void *cb_arg, int status)
+{
+	struct spdk_nvmf_request *req = cb_arg;
+
+	if (status != 0) {
+		req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+		req->rsp->nvme_cpl.status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+	}
+
+	nvmf_ns_reservation_update_sgroups(req);
+}
+
 void
 nvmf_ns_reservation_request(void *ctx)
 {
 	struct spdk_nvmf_request *req = (struct spdk_nvmf_request *)ctx;
 	struct spdk_nvme_cmd *cmd = &req->cmd->nvme_cmd;
 	struct spdk_nvmf_ctrlr *ctrlr = req->qpair->ctrlr;
-	struct subsystem_update_ns_ctx *update_ctx;
 	uint32_t nsid;
 	struct spdk_nvmf_ns *ns;
 	bool update_sgroup = false;
+	int rc;
 
 	nsid = cmd->nsid;
 	ns = _nvmf_subsystem_get_ns(ctrlr->subsys, nsid);
@@ -3138,23 +3414,24 @@ nvmf_ns_reservation_request(void *ctx)
 		break;
 	}
 
-	/* update reservation information to subsystem's poll group */
-	if (update_sgroup) {
-		update_ctx = calloc(1, sizeof(*update_ctx));
-		if (update_ctx == NULL) {
-			SPDK_ERRLOG("Can't alloc subsystem poll group update context\n");
-			goto update_done;
-		}
-		update_ctx->subsystem = ctrlr->subsys;
-		update_ctx->cb_fn = _nvmf_ns_reservation_update_done;
-		update_ctx->cb_arg = req;
+	if (!update_sgroup) {
+		_nvmf_ns_reservation_update_done(ctrlr->subsys, (void *)req, 0);
+		return;
+	}
 
-		nvmf_subsystem_update_ns(ctrlr->subsys, subsystem_update_ns_done, update_ctx);
+	/* The completion is held back until the new state has reached the PTPL file, but the
+	 * subsystem thread keeps serving other reservation requests in the meantime.
+	 */
+	if (ns->ptpl_file && ns->bdev &&
+	    (cmd->opc == SPDK_NVME_OPC_RESERVATION_REGISTER || ns->ptpl_activated)) {
+		rc = nvmf_ns_reservation_persist(ns, _nvmf_ns_reservation_persist_done, req);
+		if (rc != 0) {
+			_nvmf_ns_reservation_persist_done(req, rc);
+		}
 		return;
 	}
 
-update_done:
-	_nvmf_ns_reservation_update_done(ctrlr->subsys, (void *)req, 0);
+	nvmf_ns_reservation_update_sgroups(req);
 }
 
 int
@@ -3176,6 +3453,25 @@ nvmf_subsystem_get_ana_reporting(struct spdk_nvmf_subsystem *subsystem)
 	return subsystem->flags.ana_reporting;
 }
 
+int
+spdk_nvmf_subsystem_set_resume_timeout(struct spdk_nvmf_subsystem *subsystem,
+				       uint32_t resume_timeout_ms)
+{
+	if (subsystem->state != SPDK_NVMF_SUBSYSTEM_INACTIVE) {
+		return -EAGAIN;
+	}
+
+	subsystem->resume_timeout_ms = resume_timeout_ms;
+
+	return 0;
+}
+
+uint32_t
+nvmf_subsystem_get_resume_timeout(struct spdk_nvmf_subsystem *subsystem)
+{
+	return subsystem->resume_timeout_ms;
+}
+
 struct subsystem_listener_update_ctx {
 	struct spdk_nvmf_subsystem_listener *listener;
 
@@ -234,6 +234,14 @@ struct spdk_nvmf_tcp_req  {
 	bool					has_in_capsule_data;
 	bool					fused_failed;
 
+	/* The capsule response is sent in the same socket request as the
+	 * last C2H data PDU, using the header stored in rsp_hdr. */
+	bool					rsp_coalesced;
+	union {
+		uint8_t				raw[sizeof(struct spdk_nvme_tcp_rsp) + SPDK_NVME_TCP_DIGEST_LEN];
+		struct spdk_nvme_tcp_rsp	capsule_resp;
+	} rsp_hdr;
+
 	/* transfer_tag */
 	uint16_t				ttag;
 
@@ -307,6 +315,11 @@ struct spdk_nvmf_tcp_qpair {
 	spdk_nvmf_transport_qpair_fini_cb	fini_cb_fn;
 	void					*fini_cb_arg;
 
+	/* Number of PDUs whose data digest is being computed by an accel sequence */
+	uint32_t				digests_in_flight;
+	/* Set if the qpair is destroyed once its digests in flight complete */
+	bool					destroy_deferred;
+
 	TAILQ_ENTRY(spdk_nvmf_tcp_qpair)	link;
 };
 
@@ -319,6 +332,20 @@ struct spdk_nvmf_tcp_control_msg_list {
 	STAILQ_HEAD(, spdk_nvmf_tcp_control_msg) free_msgs;
 };
 
+TAILQ_HEAD(nvmf_tcp_pdu_queue, nvme_tcp_pdu);
+
+/* Max number of data digests computed by a single accel sequence */
+#define NVMF_TCP_DIGEST_BATCH_SIZE	16
+/* Max number of accel sequences computing data digests per poll group */
+#define NVMF_TCP_DIGEST_BATCH_COUNT	32
+
+struct nvmf_tcp_digest_batch {
+	struct spdk_nvmf_tcp_poll_group		*tgroup;
+	struct nvmf_tcp_pdu_queue		pdus;
+	spdk_accel_completion_cb		cb_fn;
+	TAILQ_ENTRY(nvmf_tcp_digest_batch)	link;
+};
+
 struct spdk_nvmf_tcp_poll_group {
 	struct spdk_nvmf_transport_poll_group	group;
 	struct spdk_sock_group			*sock_group;
@@ -329,6 +356,14 @@ struct spdk_nvmf_tcp_poll_group {
 	struct spdk_io_channel			*accel_channel;
 	struct spdk_nvmf_tcp_control_msg_list	*control_msg_list;
 
+	/* PDUs whose data digest is computed at the end of the poll, in order */
+	struct nvmf_tcp_pdu_queue		send_digests;
+	struct nvmf_tcp_pdu_queue		recv_digests;
+	/* Set if CRC32C is executed by the software accel module */
+	bool					sw_digests;
+	struct nvmf_tcp_digest_batch		digest_batches[NVMF_TCP_DIGEST_BATCH_COUNT];
+	TAILQ_HEAD(, nvmf_tcp_digest_batch)	free_digest_batches;
+
 	TAILQ_ENTRY(spdk_nvmf_tcp_poll_group)	link;
 };
 
@@ -434,6 +469,7 @@ nvmf_tcp_req_get(struct spdk_nvmf_tcp_qpair *tqpair)
 	memset(&tcp_req->rsp, 0, sizeof(tcp_req->rsp));
 	tcp_req->h2c_offset = 0;
 	tcp_req->has_in_capsule_data = false;
+	tcp_req->rsp_coalesced = false;
 	tcp_req->req.dif_enabled = false;
 	tcp_req->req.zcopy_phase = NVMF_ZCOPY_PHASE_NONE;
 
@@ -532,6 +568,25 @@ nvmf_tcp_dump_qpair_req_contents(struct spdk_nvmf_tcp_qpair *tqpair)
 	}
 }
 
+static void
+nvmf_tcp_poll_group_purge_digests(struct spdk_nvmf_tcp_poll_group *tgroup,
+				  struct spdk_nvmf_tcp_qpair *tqpair)
+{
+	struct nvme_tcp_pdu *pdu, *tmp;
+
+	TAILQ_FOREACH_SAFE(pdu, &tgroup->send_digests, tailq, tmp) {
+		if (pdu->qpair == tqpair) {
+			TAILQ_REMOVE(&tgroup->send_digests, pdu, tailq);
+		}
+	}
+
+	TAILQ_FOREACH_SAFE(pdu, &tgroup->recv_digests, tailq, tmp) {
+		if (pdu->qpair == tqpair) {
+			TAILQ_REMOVE(&tgroup->recv_digests, pdu, tailq);
+		}
+	}
+}
+
 static void
 _nvmf_tcp_qpair_destroy(void *_tqpair)
 {
@@ -540,6 +595,16 @@ _nvmf_tcp_qpair_destroy(void *_tqpair)
 	void *cb_arg = tqpair->fini_cb_arg;
 	int err = 0;
 
+	if (tqpair->group != NULL) {
+		nvmf_tcp_poll_group_purge_digests(tqpair->group, tqpair);
+	}
+
+	if (spdk_unlikely(tqpair->digests_in_flight > 0)) {
+		/* The accel sequences still write the digests into its PDUs */
+		tqpair->destroy_deferred = true;
+		return;
+	}
+
 	spdk_trace_record(TRACE_TCP_QP_DESTROY, 0, 0, (uintptr_t)tqpair);
 
 	SPDK_DEBUGLOG(nvmf_tcp, "enter\n");
@@ -1041,6 +1106,26 @@ _pdu_write_done(struct nvme_tcp_pdu *pdu, int err)
 	pdu->sock_req.cb_fn(pdu->sock_req.cb_arg, err);
 }
 
+static void
+nvmf_tcp_c2h_append_capsule_resp(struct nvme_tcp_pdu *pdu)
+{
+	struct spdk_nvmf_tcp_req *tcp_req = pdu->sock_req.cb_arg;
+
+	if (!tcp_req->rsp_coalesced) {
+		return;
+	}
+
+	if (spdk_unlikely(pdu->sock_req.iovcnt >= (int)SPDK_COUNTOF(pdu->iov))) {
+		/* No room left, the response will be sent on its own once the data is out */
+		tcp_req->rsp_coalesced = false;
+		return;
+	}
+
+	pdu->iov[pdu->sock_req.iovcnt].iov_base = tcp_req->rsp_hdr.raw;
+	pdu->iov[pdu->sock_req.iovcnt].iov_len = tcp_req->rsp_hdr.capsule_resp.common.plen;
+	pdu->sock_req.iovcnt++;
+}
+
 static void
 _tcp_write_pdu(struct nvme_tcp_pdu *pdu)
 {
@@ -1050,6 +1135,9 @@ _tcp_write_pdu(struct nvme_tcp_pdu *pdu)
 
 	pdu->sock_req.iovcnt = nvme_tcp_build_iovs(pdu->iov, SPDK_COUNTOF(pdu->iov), pdu,
 			       tqpair->host_hdgst_enable, tqpair->host_ddgst_enable, &mapped_length);
+	if (pdu->hdr.common.pdu_type == SPDK_NVME_TCP_PDU_TYPE_C2H_DATA) {
+		nvmf_tcp_c2h_append_capsule_resp(pdu);
+	}
 	spdk_sock_writev_async(tqpair->sock, &pdu->sock_req);
 
 	if (pdu->hdr.common.pdu_type == SPDK_NVME_TCP_PDU_TYPE_IC_RESP ||
@@ -1088,22 +1176,17 @@ static void
 pdu_data_crc32_compute(struct nvme_tcp_pdu *pdu)
 {
 	struct spdk_nvmf_tcp_qpair *tqpair = pdu->qpair;
-	int rc = 0;
 
 	/* Data Digest */
 	if (pdu->data_len > 0 && g_nvme_tcp_ddgst[pdu->hdr.common.pdu_type] && tqpair->host_ddgst_enable) {
 		/* Only support this limitated case for the first step */
 		if (spdk_likely(!pdu->dif_ctx && (pdu->data_len % SPDK_NVME_TCP_DIGEST_ALIGNMENT == 0)
 				&& tqpair->group)) {
-			rc = spdk_accel_submit_crc32cv(tqpair->group->accel_channel, &pdu->data_digest_crc32, pdu->data_iov,
-						       pdu->data_iovcnt, 0, data_crc32_accel_done, pdu);
-			if (spdk_likely(rc == 0)) {
-				return;
-			}
-		} else {
-			pdu->data_digest_crc32 = nvme_tcp_pdu_calc_data_digest(pdu);
+			TAILQ_INSERT_TAIL(&tqpair->group->send_digests, pdu, tailq);
+			return;
 		}
-		data_crc32_accel_done(pdu, rc);
+		pdu->data_digest_crc32 = nvme_tcp_pdu_calc_data_digest(pdu);
+		data_crc32_accel_done(pdu, 0);
 	} else {
 		_tcp_write_pdu(pdu);
 	}
@@ -1440,6 +1523,8 @@ nvmf_tcp_poll_group_create(struct spdk_nvmf_transport *transport,
 {
 	struct spdk_nvmf_tcp_transport	*ttransport;
 	struct spdk_nvmf_tcp_poll_group *tgroup;
+	const char			*module_name = NULL;
+	int				i;
 
 	tgroup = calloc(1, sizeof(*tgroup));
 	if (!tgroup) {
@@ -1453,6 +1538,14 @@ nvmf_tcp_poll_group_create(struct spdk_nvmf_transport *transport,
 
 	TAILQ_INIT(&tgroup->qpairs);
 	TAILQ_INIT(&tgroup->await_req);
+	TAILQ_INIT(&tgroup->send_digests);
+	TAILQ_INIT(&tgroup->recv_digests);
+	TAILQ_INIT(&tgroup->free_digest_batches);
+	for (i = 0; i < NVMF_TCP_DIGEST_BATCH_COUNT; i++) {
+		tgroup->digest_batches[i].tgroup = tgroup;
+		TAILQ_INIT(&tgroup->digest_batches[i].pdus);
+		TAILQ_INSERT_TAIL(&tgroup->free_digest_batches, &tgroup->digest_batches[i], link);
+	}
 
 	ttransport = SPDK_CONTAINEROF(transport, struct spdk_nvmf_tcp_transport, transport);
 
@@ -1472,6 +1565,11 @@ nvmf_tcp_poll_group_create(struct spdk_nvmf_transport *transport,
 		goto cleanup;
 	}
 
+	if (spdk_accel_get_opc_module_name(ACCEL_OPC_CRC32C, &module_name) == 0 &&
+	    module_name != NULL && strcmp(module_name, "software") == 0) {
+		tgroup->sw_digests = true;
+	}
+
 	TAILQ_INSERT_TAIL(&ttransport->poll_groups, tgroup, link);
 	if (ttransport->next_pg == NULL) {
 		ttransport->next_pg = tgroup;
@@ -1484,6 +1582,20 @@ cleanup:
 	return NULL;
 }
 
+static struct spdk_nvmf_transport_poll_group *
+nvmf_tcp_poll_group_next(struct spdk_nvmf_transport_poll_group *group, void *ctx)
+{
+	struct spdk_nvmf_tcp_transport *ttransport = ctx;
+	struct spdk_nvmf_tcp_poll_group *tgroup;
+
+	tgroup = TAILQ_NEXT(SPDK_CONTAINEROF(group, struct spdk_nvmf_tcp_poll_group, group), link);
+	if (tgroup == NULL) {
+		tgroup = TAILQ_FIRST(&ttransport->poll_groups);
+	}
+
+	return &tgroup->group;
+}
+
 static struct spdk_nvmf_transport_poll_group *
 nvmf_tcp_get_optimal_poll_group(struct spdk_nvmf_qpair *qpair)
 {
@@ -1501,6 +1613,9 @@ nvmf_tcp_get_optimal_poll_group(struct spdk_nvmf_qpair *qpair)
 
 	pg = &ttransport->next_pg;
 	assert(*pg != NULL);
+	*pg = SPDK_CONTAINEROF(nvmf_transport_get_least_loaded_poll_group(&(*pg)->group,
+			       nvmf_tcp_poll_group_next, ttransport),
+			       struct spdk_nvmf_tcp_poll_group, group);
 	hint = (*pg)->sock_group;
 
 	tqpair = SPDK_CONTAINEROF(qpair, struct spdk_nvmf_tcp_qpair, qpair);
@@ -1528,6 +1643,8 @@ nvmf_tcp_poll_group_destroy(struct spdk_nvmf_transport_poll_group *group)
 	struct spdk_nvmf_tcp_transport *ttransport;
 
 	tgroup = SPDK_CONTAINEROF(group, struct spdk_nvmf_tcp_poll_group, group);
+	assert(TAILQ_EMPTY(&tgroup->send_digests));
+	assert(TAILQ_EMPTY(&tgroup->recv_digests));
 	spdk_sock_group_close(&tgroup->sock_group);
 	if (tgroup->control_msg_list) {
 		nvmf_tcp_control_msg_list_free(tgroup->control_msg_list);
@@ -1793,28 +1910,57 @@ err:
 	nvmf_tcp_send_c2h_term_req(tqpair, pdu, fes, error_offset);
 }
 
+static void
+nvmf_tcp_build_capsule_resp(struct spdk_nvmf_tcp_req *tcp_req,
+			    struct spdk_nvmf_tcp_qpair *tqpair,
+			    struct spdk_nvme_tcp_rsp *capsule_resp)
+{
+	capsule_resp->common.pdu_type = SPDK_NVME_TCP_PDU_TYPE_CAPSULE_RESP;
+	capsule_resp->common.plen = capsule_resp->common.hlen = sizeof(*capsule_resp);
+	capsule_resp->rccqe = tcp_req->req.rsp->nvme_cpl;
+	if (tqpair->host_hdgst_enable) {
+		capsule_resp->common.flags |= SPDK_NVME_TCP_CH_FLAGS_HDGSTF;
+		capsule_resp->common.plen += SPDK_NVME_TCP_DIGEST_LEN;
+	}
+}
+
 static void
 nvmf_tcp_send_capsule_resp_pdu(struct spdk_nvmf_tcp_req *tcp_req,
 			       struct spdk_nvmf_tcp_qpair *tqpair)
 {
 	struct nvme_tcp_pdu *rsp_pdu;
-	struct spdk_nvme_tcp_rsp *capsule_resp;
 
 	SPDK_DEBUGLOG(nvmf_tcp, "enter, tqpair=%p\n", tqpair);
 
 	rsp_pdu = nvmf_tcp_req_pdu_init(tcp_req);
 	assert(rsp_pdu != NULL);
 
-	capsule_resp = &rsp_pdu->hdr.capsule_resp;
-	capsule_resp->common.pdu_type = SPDK_NVME_TCP_PDU_TYPE_CAPSULE_RESP;
-	capsule_resp->common.plen = capsule_resp->common.hlen = sizeof(*capsule_resp);
-	capsule_resp->rccqe = tcp_req->req.rsp->nvme_cpl;
+	nvmf_tcp_build_capsule_resp(tcp_req, tqpair, &rsp_pdu->hdr.capsule_resp);
+
+	nvmf_tcp_qpair_write_req_pdu(tqpair, tcp_req, nvmf_tcp_request_free, tcp_req);
+}
+
+/*
+ * Prepare the capsule response of a read so that it can go out in the same socket
+ * request as its last C2H data PDU, instead of waiting for the data write to
+ * complete and then issuing a separate write.
+ */
+static void
+nvmf_tcp_prep_coalesced_capsule_resp(struct spdk_nvmf_tcp_req *tcp_req,
+				     struct spdk_nvmf_tcp_qpair *tqpair)
+{
+	struct spdk_nvme_tcp_rsp *capsule_resp = &tcp_req->rsp_hdr.capsule_resp;
+	uint32_t crc32c;
+
+	memset(&tcp_req->rsp_hdr, 0, sizeof(tcp_req->rsp_hdr));
+	nvmf_tcp_build_capsule_resp(tcp_req, tqpair, capsule_resp);
 	if (tqpair->host_hdgst_enable) {
-		capsule_resp->common.flags |= SPDK_NVME_TCP_CH_FLAGS_HDGSTF;
-		capsule_resp->common.plen += SPDK_NVME_TCP_DIGEST_LEN;
+		crc32c = spdk_crc32c_update(tcp_req->rsp_hdr.raw, capsule_resp->common.hlen, ~0);
+		crc32c ^= SPDK_CRC32C_XOR;
+		MAKE_DIGEST_WORD(tcp_req->rsp_hdr.raw + capsule_resp->common.hlen, crc32c);
 	}
 
-	nvmf_tcp_qpair_write_req_pdu(tqpair, tcp_req, nvmf_tcp_request_free, tcp_req);
+	tcp_req->rsp_coalesced = true;
 }
 
 static void
@@ -1833,7 +1979,8 @@ nvmf_tcp_pdu_c2h_data_complete(void *cb_arg)
 		return;
 	}
 
-	if (tcp_req->pdu->hdr.c2h_data.common.flags & SPDK_NVME_TCP_C2H_DATA_FLAGS_SUCCESS) {
+	if ((tcp_req->pdu->hdr.c2h_data.common.flags & SPDK_NVME_TCP_C2H_DATA_FLAGS_SUCCESS) ||
+	    tcp_req->rsp_coalesced) {
 		nvmf_tcp_request_free(tcp_req);
 	} else {
 		nvmf_tcp_send_capsule_resp_pdu(tcp_req, tqpair);
@@ -2021,7 +2168,6 @@ data_crc32_calc_done(void *cb_arg, int status)
 static void
 nvmf_tcp_pdu_payload_handle(struct spdk_nvmf_tcp_qpair *tqpair, struct nvme_tcp_pdu *pdu)
 {
-	int rc = 0;
 	assert(tqpair->recv_state == NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PAYLOAD);
 	tqpair->pdu_in_progress = NULL;
 	nvmf_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_READY);
@@ -2030,15 +2176,11 @@ nvmf_tcp_pdu_payload_handle(struct spdk_nvmf_tcp_qpair *tqpair, struct nvme_tcp_
 	if (pdu->ddgst_enable) {
 		if (tqpair->qpair.qid != 0 && !pdu->dif_ctx && tqpair->group &&
 		    (pdu->data_len % SPDK_NVME_TCP_DIGEST_ALIGNMENT == 0)) {
-			rc = spdk_accel_submit_crc32cv(tqpair->group->accel_channel, &pdu->data_digest_crc32, pdu->data_iov,
-						       pdu->data_iovcnt, 0, data_crc32_calc_done, pdu);
-			if (spdk_likely(rc == 0)) {
-				return;
-			}
-		} else {
-			pdu->data_digest_crc32 = nvme_tcp_pdu_calc_data_digest(pdu);
+			TAILQ_INSERT_TAIL(&tqpair->group->recv_digests, pdu, tailq);
+			return;
 		}
-		data_crc32_calc_done(pdu, rc);
+		pdu->data_digest_crc32 = nvme_tcp_pdu_calc_data_digest(pdu);
+		data_crc32_calc_done(pdu, 0);
 	} else {
 		_nvmf_tcp_pdu_payload_handle(tqpair, pdu);
 	}
@@ -2718,6 +2860,10 @@ _nvmf_tcp_send_c2h_data(struct spdk_nvmf_tcp_qpair *tqpair,
 	}
 
 	rsp_pdu->rw_offset += c2h_data->datal;
+	if ((c2h_data->common.flags & (SPDK_NVME_TCP_C2H_DATA_FLAGS_LAST_PDU |
+				       SPDK_NVME_TCP_C2H_DATA_FLAGS_SUCCESS)) == SPDK_NVME_TCP_C2H_DATA_FLAGS_LAST_PDU) {
+		nvmf_tcp_prep_coalesced_capsule_resp(tcp_req, tqpair);
+	}
 	nvmf_tcp_qpair_write_req_pdu(tqpair, tcp_req, nvmf_tcp_pdu_c2h_data_complete, tcp_req);
 }
 
@@ -3255,6 +3401,9 @@ nvmf_tcp_poll_group_remove(struct spdk_nvmf_transport_poll_group *group,
 		TAILQ_REMOVE(&tgroup->qpairs, tqpair, link);
 	}
 
+	/* The poll group mustn't touch the PDUs of the qpair anymore */
+	nvmf_tcp_poll_group_purge_digests(tgroup, tqpair);
+
 	rc = spdk_sock_group_remove_sock(tgroup->sock_group, tqpair->sock);
 	if (rc != 0) {
 		SPDK_ERRLOG("Could not remove sock from sock_group: %s (%d)\n",
@@ -3312,6 +3461,100 @@ nvmf_tcp_close_qpair(struct spdk_nvmf_qpair *qpair,
 	nvmf_tcp_qpair_destroy(tqpair);
 }
 
+static void
+nvmf_tcp_digest_batch_done(void *cb_arg, int status)
+{
+	struct nvmf_tcp_digest_batch *batch = cb_arg;
+	struct spdk_nvmf_tcp_qpair *tqpair;
+	struct nvme_tcp_pdu *pdu;
+
+	while ((pdu = TAILQ_FIRST(&batch->pdus)) != NULL) {
+		TAILQ_REMOVE(&batch->pdus, pdu, tailq);
+		tqpair = pdu->qpair;
+		assert(tqpair->digests_in_flight > 0);
+		tqpair->digests_in_flight--;
+		if (spdk_unlikely(tqpair->destroy_deferred)) {
+			if (tqpair->digests_in_flight == 0) {
+				_nvmf_tcp_qpair_destroy(tqpair);
+			}
+			continue;
+		}
+
+		batch->cb_fn(pdu, status);
+	}
+
+	TAILQ_INSERT_TAIL(&batch->tgroup->free_digest_batches, batch, link);
+}
+
+static void
+nvmf_tcp_poll_group_flush_digests(struct spdk_nvmf_tcp_poll_group *tgroup, struct nvmf_tcp_pdu_queue *queue,
+				  spdk_accel_completion_cb cb_fn)
+{
+	struct nvmf_tcp_digest_batch *batch;
+	struct spdk_accel_sequence *seq;
+	struct spdk_nvmf_tcp_qpair *tqpair;
+	struct nvme_tcp_pdu *pdu;
+	uint32_t count;
+	int rc = 0;
+
+	/*
+	 * The digests of all PDUs sent or received during the poll are computed back to back.
+	 * With the software module, that's done right here instead of going through an accel
+	 * task and its completion poller for each PDU.
+	 */
+	if (tgroup->sw_digests) {
+		while ((pdu = TAILQ_FIRST(queue)) != NULL) {
+			TAILQ_REMOVE(queue, pdu, tailq);
+			pdu->data_digest_crc32 = nvme_tcp_pdu_calc_data_digest(pdu);
+			cb_fn(pdu, 0);
+		}
+		return;
+	}
+
+	/*
+	 * Otherwise up to NVMF_TCP_DIGEST_BATCH_SIZE digests are appended to one accel sequence,
+	 * which is submitted and completed as a whole.  Whatever doesn't fit into the accel
+	 * channel or the free batches is retried on the next poll, keeping the PDUs in order.
+	 */
+	while (!TAILQ_EMPTY(queue) && rc != -ENOMEM) {
+		batch = TAILQ_FIRST(&tgroup->free_digest_batches);
+		if (batch == NULL) {
+			break;
+		}
+
+		seq = NULL;
+		count = 0;
+		while ((pdu = TAILQ_FIRST(queue)) != NULL && count < NVMF_TCP_DIGEST_BATCH_SIZE) {
+			rc = spdk_accel_append_crc32c(&seq, tgroup->accel_channel,
+						      &pdu->data_digest_crc32, pdu->data_iov,
+						      pdu->data_iovcnt, NULL, NULL, 0, NULL, NULL);
+			if (spdk_unlikely(rc == -ENOMEM)) {
+				break;
+			}
+
+			TAILQ_REMOVE(queue, pdu, tailq);
+			if (spdk_unlikely(rc != 0)) {
+				pdu->data_digest_crc32 = nvme_tcp_pdu_calc_data_digest(pdu);
+				cb_fn(pdu, 0);
+				continue;
+			}
+
+			TAILQ_INSERT_TAIL(&batch->pdus, pdu, tailq);
+			tqpair = pdu->qpair;
+			tqpair->digests_in_flight++;
+			count++;
+		}
+
+		if (seq == NULL) {
+			break;
+		}
+
+		TAILQ_REMOVE(&tgroup->free_digest_batches, batch, link);
+		batch->cb_fn = cb_fn;
+		spdk_accel_sequence_finish(seq, nvmf_tcp_digest_batch_done, batch);
+	}
+}
+
 static int
 nvmf_tcp_poll_group_poll(struct spdk_nvmf_transport_poll_group *group)
 {
@@ -3325,7 +3568,8 @@ nvmf_tcp_poll_group_poll(struct spdk_nvmf_transport_poll_group *group)
 
 	tgroup = SPDK_CONTAINEROF(group, struct spdk_nvmf_tcp_poll_group, group);
 
-	if (spdk_unlikely(TAILQ_EMPTY(&tgroup->qpairs) && TAILQ_EMPTY(&tgroup->await_req))) {
+	if (spdk_unlikely(TAILQ_EMPTY(&tgroup->qpairs) && TAILQ_EMPTY(&tgroup->await_req) &&
+			  TAILQ_EMPTY(&tgroup->send_digests) && TAILQ_EMPTY(&tgroup->recv_digests))) {
 		return 0;
 	}
 
@@ -3350,6 +3594,9 @@ nvmf_tcp_poll_group_poll(struct spdk_nvmf_transport_poll_group *group)
 		}
 	}
 
+	nvmf_tcp_poll_group_flush_digests(tgroup, &tgroup->recv_digests, data_crc32_calc_done);
+	nvmf_tcp_poll_group_flush_digests(tgroup, &tgroup->send_digests, data_crc32_accel_done);
+
 	return rc;
 }
 
@@ -45,6 +45,15 @@
 #define NVMF_VFIO_USER_SET_EVENTIDX_MAX_ATTEMPTS 3
 #define NVMF_VFIO_USER_EVENTIDX_POLL UINT32_MAX
 
+/*
+ * In interrupt mode, an I/O SQ using shadow doorbells that has at least this
+ * many new commands when it is woken up is switched to polling: its eventidx
+ * is left in polling mode so that the host stops writing to BAR0, and the SQ
+ * keeps waking itself up until it sees that many empty polls in a row.
+ */
+#define NVMF_VFIO_USER_SQ_POLLING_THRESHOLD 8
+#define NVMF_VFIO_USER_SQ_POLLING_IDLE_MAX 64
+
 #define NVMF_VFIO_USER_MAX_QPAIRS_PER_CTRLR 512
 #define NVMF_VFIO_USER_DEFAULT_MAX_QPAIRS_PER_CTRLR (NVMF_VFIO_USER_MAX_QPAIRS_PER_CTRLR / 4)
 
@@ -304,6 +313,30 @@ struct nvmf_vfio_user_sq {
 	/* Whether a shadow doorbell eventidx needs setting. */
 	bool					need_rearm;
 
+	/*
+	 * Interrupt mode only: I/O SQs are woken up through their own eventfd
+	 * when the host writes their tail doorbell, see sq_kick().
+	 */
+	int					intr_fd;
+	struct spdk_interrupt			*intr;
+
+	/*
+	 * Interrupt mode only: the SQ is busy, its eventidx is left in polling
+	 * mode and it kicks itself after each poll.
+	 */
+	bool					polling;
+	uint32_t				idle_polls;
+
+	struct {
+		/* Number of times the SQ's interrupt handler has run. */
+		uint64_t intr;
+		uint64_t polls_spurious;
+		uint64_t reqs;
+		/* Switches between interrupts and polling. */
+		uint64_t to_polling;
+		uint64_t to_intr;
+	} stats;
+
 	/* multiple SQs can be mapped to the same CQ */
 	uint16_t				cqid;
 
@@ -683,7 +716,7 @@ in_interrupt_mode(struct nvmf_vfio_user_transport *vu_transport)
 	       vu_transport->intr_mode_supported;
 }
 
-static int vfio_user_ctrlr_intr(void *ctx);
+static int _vfio_user_ctrlr_intr(struct nvmf_vfio_user_ctrlr *vu_ctrlr, bool poll_all_sqs);
 
 static void
 vfio_user_msg_ctrlr_intr(void *ctx)
@@ -693,12 +726,12 @@ vfio_user_msg_ctrlr_intr(void *ctx)
 
 	vu_ctrlr_group->stats.ctrlr_kicks++;
 
-	vfio_user_ctrlr_intr(ctx);
+	_vfio_user_ctrlr_intr(vu_ctrlr, true);
 }
 
 /*
  * Kick (force a wakeup) of all poll groups for this controller.
- * vfio_user_ctrlr_intr() itself arranges for kicking other poll groups if
+ * _vfio_user_ctrlr_intr() itself arranges for kicking other poll groups if
  * needed.
  */
 static void
@@ -714,6 +747,23 @@ ctrlr_kick(struct nvmf_vfio_user_ctrlr *vu_ctrlr)
 			     vfio_user_msg_ctrlr_intr, vu_ctrlr);
 }
 
+/*
+ * Kick (force a wakeup) of a single I/O SQ on its own poll group. Falls back
+ * to kicking the whole controller if the SQ has no interrupt registered.
+ */
+static void
+sq_kick(struct nvmf_vfio_user_sq *sq)
+{
+	assert(sq->qid != 0);
+
+	if (spdk_likely(sq->intr != NULL)) {
+		eventfd_write(sq->intr_fd, 1);
+		return;
+	}
+
+	ctrlr_kick(sq->ctrlr);
+}
+
 /*
  * Make the given DMA address and length available (locally mapped) via iov.
  */
@@ -1567,10 +1617,10 @@ vfio_user_sq_rearm(struct nvmf_vfio_user_ctrlr *ctrlr,
 
 	/*
 	 * We couldn't arrange an eventidx guaranteed to cause a BAR0 write, as
-	 * we raced with the producer too many times; force ourselves to wake up
-	 * instead. We'll process all queues at that point.
+	 * we raced with the producer too many times; force the SQ to wake up
+	 * instead.
 	 */
-	ctrlr_kick(ctrlr);
+	sq_kick(sq);
 
 	return count;
 }
@@ -1596,6 +1646,12 @@ vfio_user_poll_group_rearm(struct nvmf_vfio_user_poll_group *vu_group)
 			continue;
 		}
 
+		/* A polling SQ has nothing to arm, just make sure it keeps going. */
+		if (sq->polling) {
+			sq_kick(sq);
+			continue;
+		}
+
 		if (sq->need_rearm) {
 			count += vfio_user_sq_rearm(sq->ctrlr, sq, vu_group);
 		}
@@ -1881,6 +1937,11 @@ free_qp(struct nvmf_vfio_user_ctrlr *ctrlr, uint16_t qid)
 
 		free_sq_reqs(sq);
 
+		assert(sq->intr == NULL);
+		if (sq->intr_fd != -1) {
+			close(sq->intr_fd);
+		}
+
 		free(sq->mapping.sg);
 		free(sq);
 		ctrlr->sqs[qid] = NULL;
@@ -1916,6 +1977,16 @@ init_sq(struct nvmf_vfio_user_ctrlr *ctrlr, struct spdk_nvmf_transport *transpor
 		return -ENOMEM;
 	}
 
+	sq->intr_fd = -1;
+	if (id != 0 && in_interrupt_mode(ctrlr->transport)) {
+		sq->intr_fd = eventfd(0, EFD_NONBLOCK);
+		if (sq->intr_fd == -1) {
+			free(sq->mapping.sg);
+			free(sq);
+			return -errno;
+		}
+	}
+
 	sq->qid = id;
 	sq->qpair.qid = id;
 	sq->qpair.transport = transport;
@@ -2563,14 +2634,18 @@ handle_sq_tdbl_write(struct nvmf_vfio_user_ctrlr *ctrlr, const uint32_t new_tail
 			}
 
 			/*
-			 * If there are no free cq slots then kick interrupt FD to loop
+			 * If there are no free cq slots then kick the SQ to loop
 			 * again to process remaining sq cmds.
 			 * In case of polling mode we will process remaining sq cmds during
 			 * next polling interation.
 			 * sq head is advanced only for consumed commands.
 			 */
 			if (in_interrupt_mode(ctrlr->transport)) {
-				eventfd_write(ctrlr->intr_fd, 1);
+				if (sq->qid == 0) {
+					ctrlr_kick(ctrlr);
+				} else {
+					sq_kick(sq);
+				}
 			}
 			break;
 		}
@@ -2957,6 +3032,14 @@ handle_dbl_access(struct nvmf_vfio_user_ctrlr *ctrlr, uint32_t *buf,
 		      ctrlr_id(ctrlr), (pos & 1) ? "cqid" : "sqid",
 		      pos / 2, *buf);
 
+	/*
+	 * In interrupt mode, only wake up the I/O SQ that was written to; the
+	 * admin SQ is polled by vfio_user_ctrlr_intr() right after this.
+	 */
+	if (!(pos & 1) && pos != 0 && ctrlr->endpoint->interrupt_mode &&
+	    ctrlr->sqs[pos / 2] != NULL) {
+		sq_kick(ctrlr->sqs[pos / 2]);
+	}
 
 	return 0;
 }
@@ -4977,16 +5060,114 @@ vfio_user_poll_group_intr(void *ctx)
 }
 
 /*
- * Handle an interrupt for the given controller: we must poll the vfu_ctx, and
- * the SQs assigned to our own poll group. Other poll groups are handled via
- * vfio_user_poll_group_intr().
+ * Switch a busy SQ to polling, or an idle one back to interrupts, based on how
+ * many commands its last poll found. Only SQs using shadow doorbells can poll:
+ * otherwise every submission is a BAR0 write, i.e. a wakeup, anyway.
+ */
+static void
+vfio_user_sq_update_polling(struct nvmf_vfio_user_sq *sq, int count)
+{
+	if (sq->ctrlr->sdbl == NULL) {
+		return;
+	}
+
+	if (!sq->polling) {
+		if (count >= NVMF_VFIO_USER_SQ_POLLING_THRESHOLD) {
+			SPDK_DEBUGLOG(vfio_user_db, "%s: sqid:%u switching to polling\n",
+				      ctrlr_id(sq->ctrlr), sq->qid);
+			sq->polling = true;
+			sq->idle_polls = 0;
+			sq->stats.to_polling++;
+		}
+		return;
+	}
+
+	if (count != 0) {
+		sq->idle_polls = 0;
+	} else if (++sq->idle_polls >= NVMF_VFIO_USER_SQ_POLLING_IDLE_MAX) {
+		SPDK_DEBUGLOG(vfio_user_db, "%s: sqid:%u switching to interrupts\n",
+			      ctrlr_id(sq->ctrlr), sq->qid);
+		sq->polling = false;
+		sq->need_rearm = true;
+		sq->stats.to_intr++;
+	}
+}
+
+/*
+ * Handle an interrupt for a single I/O SQ, signalled by sq_kick() when its
+ * tail doorbell was written, or by the SQ itself while it is polling.
  */
 static int
-vfio_user_ctrlr_intr(void *ctx)
+vfio_user_sq_intr(void *ctx)
+{
+	struct nvmf_vfio_user_sq *sq = ctx;
+	struct nvmf_vfio_user_poll_group *vu_group;
+	eventfd_t val;
+	int ret;
+
+	eventfd_read(sq->intr_fd, &val);
+
+	sq->stats.intr++;
+
+	if (spdk_unlikely(sq->sq_state != VFIO_USER_SQ_ACTIVE || !sq->size)) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	/*
+	 * A quiesced controller does not process commands, it is kicked again
+	 * once it is resumed.
+	 */
+	if (spdk_unlikely(sq->ctrlr->state != VFIO_USER_CTRLR_RUNNING)) {
+		if (sq->polling) {
+			sq->polling = false;
+			sq->need_rearm = true;
+			sq->stats.to_intr++;
+		}
+		return SPDK_POLLER_IDLE;
+	}
+
+	vu_group = SPDK_CONTAINEROF(sq->group, struct nvmf_vfio_user_poll_group, group);
+
+	ret = nvmf_vfio_user_sq_poll(sq);
+	if (spdk_unlikely(ret < 0)) {
+		return SPDK_POLLER_BUSY;
+	}
+
+	sq->stats.reqs += ret;
+	if (ret == 0) {
+		sq->stats.polls_spurious++;
+	}
+
+	vfio_user_sq_update_polling(sq, ret);
+
+	if (sq->polling) {
+		/* Keep the host from writing to BAR0, we'll be back anyway. */
+		sq->ctrlr->sdbl->eventidxs[queue_index(sq->qid, false)] =
+			NVMF_VFIO_USER_EVENTIDX_POLL;
+		sq->need_rearm = false;
+		sq_kick(sq);
+	} else if (sq->need_rearm && sq->ctrlr->endpoint->interrupt_mode) {
+		ret += vfio_user_sq_rearm(sq->ctrlr, sq, vu_group);
+	}
+
+	return ret != 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
+/*
+ * Handle an interrupt for the given controller: we must poll the vfu_ctx,
+ * which is where BAR0 doorbell writes are handled, and the admin SQ. I/O SQs
+ * whose doorbell got written are woken up through their own interrupt, see
+ * handle_dbl_access().
+ *
+ * When kicked, all the SQs assigned to our own poll group are polled too.
+ * Other poll groups are handled via vfio_user_poll_group_intr().
+ */
+static int
+_vfio_user_ctrlr_intr(struct nvmf_vfio_user_ctrlr *vu_ctrlr, bool poll_all_sqs)
 {
 	struct nvmf_vfio_user_poll_group *vu_ctrlr_group;
-	struct nvmf_vfio_user_ctrlr *vu_ctrlr = ctx;
 	struct nvmf_vfio_user_poll_group *vu_group;
+	struct nvmf_vfio_user_sq *admin_sq;
 	int ret = SPDK_POLLER_IDLE;
 
 	vu_ctrlr_group = ctrlr_to_poll_group(vu_ctrlr);
@@ -5009,6 +5190,15 @@ vfio_user_ctrlr_intr(void *ctx)
 		return ret;
 	}
 
+	if (!poll_all_sqs) {
+		admin_sq = vu_ctrlr->sqs[0];
+		if (admin_sq->sq_state == VFIO_USER_SQ_ACTIVE && admin_sq->size &&
+		    nvmf_vfio_user_sq_poll(admin_sq) != 0) {
+			ret = SPDK_POLLER_BUSY;
+		}
+		return ret;
+	}
+
 	if (vu_ctrlr->transport->transport_opts.enable_intr_mode_sq_spreading) {
 		/*
 		 * We may have just written to a doorbell owned by another
@@ -5028,6 +5218,12 @@ vfio_user_ctrlr_intr(void *ctx)
 	return ret;
 }
 
+static int
+vfio_user_ctrlr_intr(void *ctx)
+{
+	return _vfio_user_ctrlr_intr(ctx, false);
+}
+
 static void
 vfio_user_ctrlr_set_intr_mode(struct spdk_poller *poller, void *ctx,
 			      bool interrupt_mode)
@@ -5112,6 +5308,16 @@ handle_queue_connect_rsp(struct nvmf_vfio_user_req *req, void *cb_arg)
 	vu_group = SPDK_CONTAINEROF(sq->group, struct nvmf_vfio_user_poll_group, group);
 	TAILQ_INSERT_TAIL(&vu_group->sqs, sq, link);
 
+	if (sq->intr_fd != -1) {
+		assert(sq->intr == NULL);
+		sq->intr = SPDK_INTERRUPT_REGISTER(sq->intr_fd, vfio_user_sq_intr, sq);
+		if (sq->intr == NULL) {
+			/* Doorbell writes kick the whole controller instead */
+			SPDK_ERRLOG("%s: failed to register interrupt for sqid:%u\n",
+				    ctrlr_id(vu_ctrlr), sq->qid);
+		}
+	}
+
 	admin_cq = vu_ctrlr->cqs[0];
 	assert(admin_cq != NULL);
 	assert(admin_cq->group != NULL);
@@ -5263,6 +5469,10 @@ nvmf_vfio_user_poll_group_remove(struct spdk_nvmf_transport_poll_group *group,
 	vu_group = SPDK_CONTAINEROF(group, struct nvmf_vfio_user_poll_group, group);
 	TAILQ_REMOVE(&vu_group->sqs, sq, link);
 
+	spdk_interrupt_unregister(&sq->intr);
+	sq->polling = false;
+	sq->idle_polls = 0;
+
 	return 0;
 }
 
@@ -5820,6 +6030,9 @@ nvmf_vfio_user_poll_group_dump_stat(struct spdk_nvmf_transport_poll_group *group
 {
 	struct nvmf_vfio_user_poll_group *vu_group = SPDK_CONTAINEROF(group,
 			struct nvmf_vfio_user_poll_group, group);
+	struct nvmf_vfio_user_transport *vu_transport = SPDK_CONTAINEROF(group->transport,
+			struct nvmf_vfio_user_transport, transport);
+	struct nvmf_vfio_user_sq *sq;
 	uint64_t polls_denom;
 
 	spdk_json_write_named_uint64(w, "ctrlr_intr", vu_group->stats.ctrlr_intr);
@@ -5842,6 +6055,29 @@ nvmf_vfio_user_poll_group_dump_stat(struct spdk_nvmf_transport_poll_group *group
 
 	spdk_json_write_named_uint64(w, "cqh_admin_writes", vu_group->stats.cqh_admin_writes);
 	spdk_json_write_named_uint64(w, "cqh_io_writes", vu_group->stats.cqh_io_writes);
+
+	if (!in_interrupt_mode(vu_transport)) {
+		return;
+	}
+
+	spdk_json_write_named_array_begin(w, "sqs");
+	TAILQ_FOREACH(sq, &vu_group->sqs, link) {
+		if (sq->qid == 0) {
+			continue;
+		}
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "ctrlr", ctrlr_id(sq->ctrlr));
+		spdk_json_write_named_uint32(w, "qid", sq->qid);
+		spdk_json_write_named_bool(w, "polling", sq->polling);
+		spdk_json_write_named_uint64(w, "intr", sq->stats.intr);
+		spdk_json_write_named_uint64(w, "polls_spurious", sq->stats.polls_spurious);
+		spdk_json_write_named_uint64(w, "reqs", sq->stats.reqs);
+		spdk_json_write_named_uint64(w, "to_polling", sq->stats.to_polling);
+		spdk_json_write_named_uint64(w, "to_intr", sq->stats.to_intr);
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
 }
 
 static void
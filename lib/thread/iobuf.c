@@ -26,33 +26,80 @@
 SPDK_STATIC_ASSERT(sizeof(struct spdk_iobuf_buffer) <= IOBUF_MIN_SMALL_BUFSIZE,
 		   "Invalid data offset");
 
+#define IOBUF_MAX_CLASSES		SPDK_IOBUF_MAX_CLASSES
+#define IOBUF_MAX_MODULES		32
+#define IOBUF_DEFAULT_WEIGHT		1
+#define IOBUF_MAX_WEIGHT		100
+/* Divisible by all the weights up to 16, so that the common ones don't lose precision */
+#define IOBUF_WEIGHT_SCALE		720720
+
+/* Requests of a single module waiting for buffers of a single class */
+struct iobuf_queue {
+	spdk_iobuf_entry_stailq_t	entries;
+	/* Tag of the last queued entry */
+	uint64_t			last_tag;
+};
+
 struct iobuf_channel {
-	spdk_iobuf_entry_stailq_t small_queue;
-	spdk_iobuf_entry_stailq_t large_queue;
+	struct iobuf_queue		queues[IOBUF_MAX_CLASSES][IOBUF_MAX_MODULES];
+	/* Mask of the modules with waiting entries, per class */
+	uint32_t			waiting[IOBUF_MAX_CLASSES];
+	/* Tag of the last served entry, per class */
+	uint64_t			vtime[IOBUF_MAX_CLASSES];
+	uint32_t			seq;
 };
 
 struct iobuf_module {
 	char				*name;
+	struct spdk_iobuf_module_opts	opts;
+	bool				registered;
+	/* Index of the module's queues in the iobuf channels */
+	uint32_t			slot;
+	/* Updated by all the threads */
+	uint64_t			in_use[IOBUF_MAX_CLASSES];
+	uint64_t			wait_count;
+	uint64_t			wait_ticks;
+	uint64_t			max_wait_ticks;
 	TAILQ_ENTRY(iobuf_module)	tailq;
 };
 
+/* Buffers of a single class allocated on a single NUMA node */
+struct iobuf_node {
+	struct spdk_ring		*pool;
+	void				*base;
+	uint64_t			count;
+	int				socket_id;
+};
+
+struct iobuf_class {
+	uint32_t			bufsize;
+	uint64_t			count;
+	uint32_t			num_nodes;
+	struct iobuf_node		nodes[SPDK_IOBUF_MAX_NODES];
+};
+
 struct iobuf {
-	struct spdk_ring		*small_pool;
-	struct spdk_ring		*large_pool;
-	void				*small_pool_base;
-	void				*large_pool_base;
+	struct iobuf_class		classes[IOBUF_MAX_CLASSES];
+	uint32_t			num_classes;
+	/* Sockets of the cores the application runs on */
+	int				sockets[SPDK_IOBUF_MAX_NODES];
+	uint32_t			num_sockets;
 	struct spdk_iobuf_opts		opts;
 	TAILQ_HEAD(, iobuf_module)	modules;
+	/* Mask of the slots taken by the registered modules */
+	uint32_t			module_slots;
+	/* Sum of the modules' reservations */
+	uint32_t			reserved_percent;
+	/* Whether the buffers held by each module are counted, only needed to enforce the
+	 * reservations and limits.  Fixed once the pools are allocated. */
+	bool				count_in_use;
 	spdk_iobuf_finish_cb		finish_cb;
 	void				*finish_arg;
 };
 
 static struct iobuf g_iobuf = {
 	.modules = TAILQ_HEAD_INITIALIZER(g_iobuf.modules),
-	.small_pool = NULL,
-	.large_pool = NULL,
-	.small_pool_base = NULL,
-	.large_pool_base = NULL,
+	.num_classes = 0,
 	.opts = {
 		.small_pool_count = IOBUF_DEFAULT_SMALL_POOL_SIZE,
 		.large_pool_count = IOBUF_DEFAULT_LARGE_POOL_SIZE,
@@ -61,13 +108,66 @@ static struct iobuf g_iobuf = {
 	},
 };
 
+static struct iobuf_module *
+iobuf_find_module(const char *name)
+{
+	struct iobuf_module *module;
+
+	TAILQ_FOREACH(module, &g_iobuf.modules, tailq) {
+		if (strcmp(name, module->name) == 0) {
+			return module;
+		}
+	}
+
+	return NULL;
+}
+
+static struct iobuf_module *
+iobuf_create_module(const char *name)
+{
+	struct iobuf_module *module;
+
+	module = calloc(1, sizeof(*module));
+	if (module == NULL) {
+		return NULL;
+	}
+
+	module->name = strdup(name);
+	if (module->name == NULL) {
+		free(module);
+		return NULL;
+	}
+
+	module->opts.weight = IOBUF_DEFAULT_WEIGHT;
+	TAILQ_INSERT_TAIL(&g_iobuf.modules, module, tailq);
+
+	return module;
+}
+
+static void
+iobuf_free_module(struct iobuf_module *module)
+{
+	TAILQ_REMOVE(&g_iobuf.modules, module, tailq);
+	g_iobuf.reserved_percent -= module->opts.reserved_percent;
+	free(module->name);
+	free(module);
+}
+
 static int
 iobuf_channel_create_cb(void *io_device, void *ctx)
 {
 	struct iobuf_channel *ch = ctx;
+	uint32_t i, j;
 
-	STAILQ_INIT(&ch->small_queue);
-	STAILQ_INIT(&ch->large_queue);
+	for (i = 0; i < IOBUF_MAX_CLASSES; i++) {
+		for (j = 0; j < IOBUF_MAX_MODULES; j++) {
+			STAILQ_INIT(&ch->queues[i][j].entries);
+			ch->queues[i][j].last_tag = 0;
+		}
+		ch->waiting[i] = 0;
+		ch->vtime[i] = 0;
+	}
+	ch->seq = 0;
 
 	return 0;
 }
@@ -76,63 +176,138 @@ static void
 iobuf_channel_destroy_cb(void *io_device, void *ctx)
 {
 	struct iobuf_channel *ch __attribute__((unused)) = ctx;
+	uint32_t i;
 
-	assert(STAILQ_EMPTY(&ch->small_queue));
-	assert(STAILQ_EMPTY(&ch->large_queue));
+	for (i = 0; i < IOBUF_MAX_CLASSES; i++) {
+		assert(ch->waiting[i] == 0);
+	}
 }
 
-int
-spdk_iobuf_initialize(void)
+static void
+iobuf_init_sockets(void)
 {
-	struct spdk_iobuf_opts *opts = &g_iobuf.opts;
-	int rc = 0;
-	uint64_t i;
-	struct spdk_iobuf_buffer *buf;
+	uint32_t core, i;
+	int socket_id;
 
-	g_iobuf.small_pool = spdk_ring_create(SPDK_RING_TYPE_MP_MC, opts->small_pool_count,
-					      SPDK_ENV_SOCKET_ID_ANY);
-	if (!g_iobuf.small_pool) {
-		SPDK_ERRLOG("Failed to create small iobuf pool\n");
-		rc = -ENOMEM;
-		goto error;
+	g_iobuf.num_sockets = 0;
+	SPDK_ENV_FOREACH_CORE(core) {
+		socket_id = (int)spdk_env_get_socket_id(core);
+		if (socket_id == SPDK_ENV_SOCKET_ID_ANY) {
+			continue;
+		}
+
+		for (i = 0; i < g_iobuf.num_sockets; i++) {
+			if (g_iobuf.sockets[i] == socket_id) {
+				break;
+			}
+		}
+
+		if (i == g_iobuf.num_sockets && g_iobuf.num_sockets < SPDK_IOBUF_MAX_NODES) {
+			g_iobuf.sockets[g_iobuf.num_sockets++] = socket_id;
+		}
 	}
 
-	/* Round up to the nearest alignment so that each element remains aligned */
-	opts->small_bufsize = SPDK_ALIGN_CEIL(opts->small_bufsize, IOBUF_ALIGNMENT);
-	g_iobuf.small_pool_base = spdk_malloc(opts->small_bufsize * opts->small_pool_count, IOBUF_ALIGNMENT,
-					      NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
-	if (g_iobuf.small_pool_base == NULL) {
-		SPDK_ERRLOG("Unable to allocate requested small iobuf pool size\n");
-		rc = -ENOMEM;
-		goto error;
+	/* There's nothing to gain from binding the pools to a single socket */
+	if (g_iobuf.num_sockets <= 1) {
+		g_iobuf.sockets[0] = SPDK_ENV_SOCKET_ID_ANY;
+		g_iobuf.num_sockets = 1;
 	}
+}
 
-	g_iobuf.large_pool = spdk_ring_create(SPDK_RING_TYPE_MP_MC, opts->large_pool_count,
-					      SPDK_ENV_SOCKET_ID_ANY);
-	if (!g_iobuf.large_pool) {
-		SPDK_ERRLOG("Failed to create large iobuf pool\n");
-		rc = -ENOMEM;
-		goto error;
+static int
+iobuf_class_init(struct iobuf_class *cls, uint32_t bufsize, uint64_t count)
+{
+	struct iobuf_node *node;
+	struct spdk_iobuf_buffer *buf;
+	uint64_t i;
+	uint32_t n;
+
+	cls->bufsize = bufsize;
+	cls->count = count;
+	cls->num_nodes = count >= g_iobuf.num_sockets ? g_iobuf.num_sockets : 1;
+
+	for (n = 0; n < cls->num_nodes; n++) {
+		node = &cls->nodes[n];
+		node->count = count / cls->num_nodes + (n < count % cls->num_nodes ? 1 : 0);
+		node->socket_id = cls->num_nodes > 1 ? g_iobuf.sockets[n] : SPDK_ENV_SOCKET_ID_ANY;
+
+		node->pool = spdk_ring_create(SPDK_RING_TYPE_MP_MC, node->count, node->socket_id);
+		if (node->pool == NULL) {
+			SPDK_ERRLOG("Failed to create iobuf pool of %"PRIu32"B buffers\n", bufsize);
+			return -ENOMEM;
+		}
+
+		node->base = spdk_malloc(bufsize * node->count, IOBUF_ALIGNMENT, NULL,
+					 node->socket_id, SPDK_MALLOC_DMA);
+		if (node->base == NULL && node->socket_id != SPDK_ENV_SOCKET_ID_ANY) {
+			SPDK_WARNLOG("Unable to allocate %"PRIu32"B iobuf buffers on socket %d, "
+				     "using any socket instead\n", bufsize, node->socket_id);
+			node->base = spdk_malloc(bufsize * node->count, IOBUF_ALIGNMENT, NULL,
+						 SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+		}
+		if (node->base == NULL) {
+			SPDK_ERRLOG("Unable to allocate requested iobuf pool of %"PRIu32"B buffers\n",
+				    bufsize);
+			return -ENOMEM;
+		}
+
+		for (i = 0; i < node->count; i++) {
+			buf = node->base + i * bufsize;
+			spdk_ring_enqueue(node->pool, (void **)&buf, 1, NULL);
+		}
+	}
+
+	return 0;
+}
+
+static void
+iobuf_class_free(struct iobuf_class *cls)
+{
+	struct iobuf_node *node;
+	uint32_t n;
+
+	for (n = 0; n < cls->num_nodes; n++) {
+		node = &cls->nodes[n];
+		spdk_free(node->base);
+		node->base = NULL;
+		spdk_ring_free(node->pool);
+		node->pool = NULL;
 	}
 
+	cls->num_nodes = 0;
+}
+
+static int
+_iobuf_initialize(void)
+{
+	struct spdk_iobuf_opts *opts = &g_iobuf.opts;
+	struct spdk_iobuf_class_opts *medium;
+	int rc = 0;
+	uint32_t i;
+
 	/* Round up to the nearest alignment so that each element remains aligned */
-	opts->large_bufsize = SPDK_ALIGN_CEIL(opts->large_bufsize, IOBUF_ALIGNMENT);
-	g_iobuf.large_pool_base = spdk_malloc(opts->large_bufsize * opts->large_pool_count, IOBUF_ALIGNMENT,
-					      NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
-	if (g_iobuf.large_pool_base == NULL) {
-		SPDK_ERRLOG("Unable to allocate requested large iobuf pool size\n");
-		rc = -ENOMEM;
+	opts->small_bufsize = SPDK_ALIGN_CEIL(opts->small_bufsize, IOBUF_ALIGNMENT);
+	rc = iobuf_class_init(&g_iobuf.classes[g_iobuf.num_classes++], opts->small_bufsize,
+			      opts->small_pool_count);
+	if (rc != 0) {
 		goto error;
 	}
 
-	for (i = 0; i < opts->small_pool_count; i++) {
-		buf = g_iobuf.small_pool_base + i * opts->small_bufsize;
-		spdk_ring_enqueue(g_iobuf.small_pool, (void **)&buf, 1, NULL);
+	for (i = 0; i < opts->medium_class_count; i++) {
+		medium = &opts->medium_classes[i];
+		medium->bufsize = SPDK_ALIGN_CEIL(medium->bufsize, IOBUF_ALIGNMENT);
+		rc = iobuf_class_init(&g_iobuf.classes[g_iobuf.num_classes++], medium->bufsize,
+				      medium->pool_count);
+		if (rc != 0) {
+			goto error;
+		}
 	}
 
-	for (i = 0; i < opts->large_pool_count; i++) {
-		buf = g_iobuf.large_pool_base + i * opts->large_bufsize;
-		spdk_ring_enqueue(g_iobuf.large_pool, (void **)&buf, 1, NULL);
+	opts->large_bufsize = SPDK_ALIGN_CEIL(opts->large_bufsize, IOBUF_ALIGNMENT);
+	rc = iobuf_class_init(&g_iobuf.classes[g_iobuf.num_classes++], opts->large_bufsize,
+			      opts->large_pool_count);
+	if (rc != 0) {
+		goto error;
 	}
 
 	spdk_io_device_register(&g_iobuf, iobuf_channel_create_cb, iobuf_channel_destroy_cb,
@@ -140,45 +315,58 @@ spdk_iobuf_initialize(void)
 
 	return 0;
 error:
-	spdk_free(g_iobuf.small_pool_base);
-	spdk_ring_free(g_iobuf.small_pool);
-	spdk_free(g_iobuf.large_pool_base);
-	spdk_ring_free(g_iobuf.large_pool);
+	for (i = 0; i < g_iobuf.num_classes; i++) {
+		iobuf_class_free(&g_iobuf.classes[i]);
+	}
+	g_iobuf.num_classes = 0;
 
 	return rc;
 }
 
+int
+spdk_iobuf_initialize(void)
+{
+	struct iobuf_module *module;
+
+	iobuf_init_sockets();
+
+	g_iobuf.count_in_use = g_iobuf.reserved_percent != 0;
+	TAILQ_FOREACH(module, &g_iobuf.modules, tailq) {
+		g_iobuf.count_in_use |= module->opts.max_percent != 0;
+	}
+
+	return _iobuf_initialize();
+}
+
 static void
 iobuf_unregister_cb(void *io_device)
 {
 	struct iobuf_module *module;
+	struct iobuf_class *cls;
+	struct iobuf_node *node;
+	uint32_t i, n;
 
 	while (!TAILQ_EMPTY(&g_iobuf.modules)) {
 		module = TAILQ_FIRST(&g_iobuf.modules);
-		TAILQ_REMOVE(&g_iobuf.modules, module, tailq);
-		free(module->name);
-		free(module);
-	}
-
-	if (spdk_ring_count(g_iobuf.small_pool) != g_iobuf.opts.small_pool_count) {
-		SPDK_ERRLOG("small iobuf pool count is %zu, expected %"PRIu64"\n",
-			    spdk_ring_count(g_iobuf.small_pool), g_iobuf.opts.small_pool_count);
+		iobuf_free_module(module);
 	}
+	g_iobuf.module_slots = 0;
+
+	for (i = 0; i < g_iobuf.num_classes; i++) {
+		cls = &g_iobuf.classes[i];
+		for (n = 0; n < cls->num_nodes; n++) {
+			node = &cls->nodes[n];
+			if (spdk_ring_count(node->pool) != node->count) {
+				SPDK_ERRLOG("%"PRIu32"B iobuf pool count on socket %d is %zu, "
+					    "expected %"PRIu64"\n", cls->bufsize, node->socket_id,
+					    spdk_ring_count(node->pool), node->count);
+			}
+		}
 
-	if (spdk_ring_count(g_iobuf.large_pool) != g_iobuf.opts.large_pool_count) {
-		SPDK_ERRLOG("large iobuf pool count is %zu, expected %"PRIu64"\n",
-			    spdk_ring_count(g_iobuf.large_pool), g_iobuf.opts.large_pool_count);
+		iobuf_class_free(cls);
 	}
-
-	spdk_free(g_iobuf.small_pool_base);
-	g_iobuf.small_pool_base = NULL;
-	spdk_ring_free(g_iobuf.small_pool);
-	g_iobuf.small_pool = NULL;
-
-	spdk_free(g_iobuf.large_pool_base);
-	g_iobuf.large_pool_base = NULL;
-	spdk_ring_free(g_iobuf.large_pool);
-	g_iobuf.large_pool = NULL;
+	g_iobuf.num_classes = 0;
+	g_iobuf.count_in_use = false;
 
 	if (g_iobuf.finish_cb != NULL) {
 		g_iobuf.finish_cb(g_iobuf.finish_arg);
@@ -197,6 +385,9 @@ spdk_iobuf_finish(spdk_iobuf_finish_cb cb_fn, void *cb_arg)
 int
 spdk_iobuf_set_opts(const struct spdk_iobuf_opts *opts)
 {
+	const struct spdk_iobuf_class_opts *medium;
+	uint32_t small_bufsize, large_bufsize, prev_bufsize, i;
+
 	if (opts->small_pool_count < IOBUF_MIN_SMALL_POOL_SIZE) {
 		SPDK_ERRLOG("small_pool_count must be at least %" PRIu32 "\n",
 			    IOBUF_MIN_SMALL_POOL_SIZE);
@@ -207,6 +398,37 @@ spdk_iobuf_set_opts(const struct spdk_iobuf_opts *opts)
 			    IOBUF_MIN_LARGE_POOL_SIZE);
 		return -EINVAL;
 	}
+	if (opts->medium_class_count > SPDK_IOBUF_MAX_MEDIUM_CLASSES) {
+		SPDK_ERRLOG("medium_class_count must be at most %" PRIu32 "\n",
+			    SPDK_IOBUF_MAX_MEDIUM_CLASSES);
+		return -EINVAL;
+	}
+
+	small_bufsize = spdk_max(opts->small_bufsize, IOBUF_MIN_SMALL_BUFSIZE);
+	large_bufsize = spdk_max(opts->large_bufsize, IOBUF_MIN_LARGE_BUFSIZE);
+
+	/* Sizes are compared after rounding up, as that's what the buffers are allocated with */
+	prev_bufsize = SPDK_ALIGN_CEIL(small_bufsize, IOBUF_ALIGNMENT);
+	for (i = 0; i < opts->medium_class_count; i++) {
+		medium = &opts->medium_classes[i];
+		if (medium->pool_count < IOBUF_MIN_LARGE_POOL_SIZE) {
+			SPDK_ERRLOG("medium class pool_count must be at least %" PRIu32 "\n",
+				    IOBUF_MIN_LARGE_POOL_SIZE);
+			return -EINVAL;
+		}
+		if (SPDK_ALIGN_CEIL(medium->bufsize, IOBUF_ALIGNMENT) <= prev_bufsize) {
+			SPDK_ERRLOG("medium class bufsize %" PRIu32 " must be larger than the size of "
+				    "the previous class (%" PRIu32 ")\n", medium->bufsize, prev_bufsize);
+			return -EINVAL;
+		}
+		prev_bufsize = SPDK_ALIGN_CEIL(medium->bufsize, IOBUF_ALIGNMENT);
+	}
+	if (SPDK_ALIGN_CEIL(large_bufsize, IOBUF_ALIGNMENT) <= prev_bufsize &&
+	    opts->medium_class_count > 0) {
+		SPDK_ERRLOG("large_bufsize must be larger than the size of the largest medium class "
+			    "(%" PRIu32 ")\n", prev_bufsize);
+		return -EINVAL;
+	}
 
 	g_iobuf.opts = *opts;
 
@@ -231,6 +453,258 @@ spdk_iobuf_get_opts(struct spdk_iobuf_opts *opts)
 	*opts = g_iobuf.opts;
 }
 
+static struct iobuf_node *
+iobuf_class_get_local_node(struct iobuf_class *cls, int socket_id)
+{
+	uint32_t n;
+
+	for (n = 0; n < cls->num_nodes; n++) {
+		if (cls->nodes[n].socket_id == socket_id) {
+			return &cls->nodes[n];
+		}
+	}
+
+	return &cls->nodes[0];
+}
+
+static struct iobuf_node *
+iobuf_class_find_node(struct iobuf_class *cls, void *buf)
+{
+	struct iobuf_node *node;
+	uint32_t n;
+
+	for (n = 0; n < cls->num_nodes; n++) {
+		node = &cls->nodes[n];
+		if ((uintptr_t)buf >= (uintptr_t)node->base &&
+		    (uintptr_t)buf < (uintptr_t)node->base + node->count * cls->bufsize) {
+			return node;
+		}
+	}
+
+	assert(0 && "Buffer doesn't belong to any iobuf pool");
+	return &cls->nodes[0];
+}
+
+/* Used once the pool of the local node is exhausted */
+static void *
+iobuf_class_get_remote(struct iobuf_class *cls, struct spdk_ring *local)
+{
+	struct spdk_iobuf_buffer *buf;
+	uint32_t n;
+
+	for (n = 0; n < cls->num_nodes; n++) {
+		if (cls->nodes[n].pool == local) {
+			continue;
+		}
+		if (spdk_ring_dequeue(cls->nodes[n].pool, (void **)&buf, 1) == 1) {
+			return buf;
+		}
+	}
+
+	return NULL;
+}
+
+static struct spdk_iobuf_pool *
+iobuf_channel_get_pool(struct spdk_iobuf_channel *ch, uint32_t index)
+{
+	if (index == 0) {
+		return &ch->small;
+	} else if (index <= ch->medium_count) {
+		return &ch->medium[index - 1];
+	}
+
+	return &ch->large;
+}
+
+/* Selects the smallest class able to hold len bytes */
+static inline struct spdk_iobuf_pool *
+iobuf_channel_find_pool(struct spdk_iobuf_channel *ch, uint64_t len, uint32_t *index)
+{
+	uint32_t i;
+
+	if (len <= ch->small.bufsize) {
+		*index = 0;
+		return &ch->small;
+	}
+
+	for (i = 0; i < ch->medium_count; i++) {
+		if (len <= ch->medium[i].bufsize) {
+			*index = i + 1;
+			return &ch->medium[i];
+		}
+	}
+
+	assert(len <= ch->large.bufsize);
+	*index = ch->medium_count + 1;
+
+	return &ch->large;
+}
+
+static inline void
+iobuf_module_update_in_use(struct iobuf_module *module, uint32_t index, int64_t delta)
+{
+	/* Avoid bouncing the module's cacheline between the threads unless it's needed */
+	if (spdk_likely(!g_iobuf.count_in_use)) {
+		return;
+	}
+
+	__atomic_fetch_add(&module->in_use[index], (uint64_t)delta, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t
+iobuf_module_get_limit(struct iobuf_module *module, uint32_t index)
+{
+	if (module->opts.max_percent == 0) {
+		return UINT64_MAX;
+	}
+
+	return g_iobuf.classes[index].count * module->opts.max_percent / 100;
+}
+
+static inline uint64_t
+iobuf_module_get_reserved(struct iobuf_module *module, uint32_t index)
+{
+	return g_iobuf.classes[index].count * module->opts.reserved_percent / 100;
+}
+
+/* Returns how many of count buffers a module can take from the pool of a class */
+static uint64_t
+iobuf_module_get_quota(struct iobuf_module *module, uint32_t index, uint64_t count)
+{
+	struct iobuf_class *cls = &g_iobuf.classes[index];
+	struct iobuf_module *other;
+	uint64_t in_use, limit, reserved, other_in_use, unmet = 0, available = 0, quota;
+	uint32_t n;
+
+	if (spdk_likely(module->opts.max_percent == 0 && g_iobuf.reserved_percent == 0)) {
+		return count;
+	}
+
+	in_use = __atomic_load_n(&module->in_use[index], __ATOMIC_RELAXED);
+	limit = iobuf_module_get_limit(module, index);
+	if (in_use >= limit) {
+		return 0;
+	}
+	count = spdk_min(count, limit - in_use);
+
+	reserved = iobuf_module_get_reserved(module, index);
+	if (g_iobuf.reserved_percent == module->opts.reserved_percent || in_use + count <= reserved) {
+		return count;
+	}
+
+	/* Leave enough buffers in the pool for the other modules to reach their reservations.
+	 * This is only best effort, as the other threads keep taking and releasing buffers. */
+	TAILQ_FOREACH(other, &g_iobuf.modules, tailq) {
+		if (other == module || !other->registered) {
+			continue;
+		}
+		other_in_use = __atomic_load_n(&other->in_use[index], __ATOMIC_RELAXED);
+		if (other_in_use < iobuf_module_get_reserved(other, index)) {
+			unmet += iobuf_module_get_reserved(other, index) - other_in_use;
+		}
+	}
+
+	for (n = 0; n < cls->num_nodes; n++) {
+		available += spdk_ring_count(cls->nodes[n].pool);
+	}
+
+	quota = available > unmet ? available - unmet : 0;
+	if (in_use < reserved) {
+		quota = spdk_max(quota, reserved - in_use);
+	}
+
+	return spdk_min(count, quota);
+}
+
+static void
+iobuf_channel_queue_entry(struct spdk_iobuf_channel *ch, uint32_t index,
+			  struct spdk_iobuf_entry *entry, spdk_iobuf_get_cb cb_fn)
+{
+	struct iobuf_channel *iobuf_ch = spdk_io_channel_get_ctx(ch->parent);
+	struct iobuf_module *module = (struct iobuf_module *)ch->module;
+	struct iobuf_queue *queue = &iobuf_ch->queues[index][module->slot];
+
+	/* Weighted fair queueing: each module advances its own virtual time by the inverse of its
+	 * weight, starting from the virtual time of the last entry served if it was idle. */
+	entry->tag = spdk_max(iobuf_ch->vtime[index], queue->last_tag) +
+		     IOBUF_WEIGHT_SCALE / module->opts.weight;
+	entry->seq = iobuf_ch->seq++;
+	entry->wait_tsc = spdk_get_ticks();
+	entry->module = module;
+	entry->cb_fn = cb_fn;
+	queue->last_tag = entry->tag;
+
+	STAILQ_INSERT_TAIL(&queue->entries, entry, stailq);
+	iobuf_ch->waiting[index] |= 1u << module->slot;
+}
+
+static inline bool
+iobuf_entry_before(struct spdk_iobuf_entry *entry, struct spdk_iobuf_entry *other)
+{
+	if (entry->tag != other->tag) {
+		return entry->tag < other->tag;
+	}
+
+	return (int32_t)(entry->seq - other->seq) < 0;
+}
+
+/* Selects the entry to hand a released buffer to.  Modules below their reservation go first,
+ * then the entry with the lowest tag wins.  Modules at their limit are skipped. */
+static struct spdk_iobuf_entry *
+iobuf_channel_dequeue_entry(struct iobuf_channel *iobuf_ch, uint32_t index)
+{
+	struct spdk_iobuf_entry *entry, *best = NULL;
+	struct iobuf_module *module;
+	uint64_t in_use;
+	uint32_t mask = iobuf_ch->waiting[index], slot, best_slot = 0;
+	bool below, best_below = false;
+
+	while (mask != 0) {
+		slot = __builtin_ctz(mask);
+		mask &= mask - 1;
+
+		entry = STAILQ_FIRST(&iobuf_ch->queues[index][slot].entries);
+		module = (struct iobuf_module *)entry->module;
+		in_use = __atomic_load_n(&module->in_use[index], __ATOMIC_RELAXED);
+		if (in_use >= iobuf_module_get_limit(module, index)) {
+			continue;
+		}
+
+		below = in_use < iobuf_module_get_reserved(module, index);
+		if (best == NULL || (below && !best_below) ||
+		    (below == best_below && iobuf_entry_before(entry, best))) {
+			best = entry;
+			best_slot = slot;
+			best_below = below;
+		}
+	}
+
+	if (best != NULL) {
+		STAILQ_REMOVE_HEAD(&iobuf_ch->queues[index][best_slot].entries, stailq);
+		if (STAILQ_EMPTY(&iobuf_ch->queues[index][best_slot].entries)) {
+			iobuf_ch->waiting[index] &= ~(1u << best_slot);
+		}
+		iobuf_ch->vtime[index] = spdk_max(iobuf_ch->vtime[index], best->tag);
+	}
+
+	return best;
+}
+
+static void
+iobuf_module_update_wait(struct iobuf_module *module, uint64_t ticks)
+{
+	uint64_t max_ticks;
+
+	__atomic_fetch_add(&module->wait_count, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&module->wait_ticks, ticks, __ATOMIC_RELAXED);
+
+	max_ticks = __atomic_load_n(&module->max_wait_ticks, __ATOMIC_RELAXED);
+	while (ticks > max_ticks &&
+	       !__atomic_compare_exchange_n(&module->max_wait_ticks, &max_ticks, ticks, true,
+					    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+	}
+}
+
 int
 spdk_iobuf_channel_init(struct spdk_iobuf_channel *ch, const char *name,
 			uint32_t small_cache_size, uint32_t large_cache_size)
@@ -238,16 +712,14 @@ spdk_iobuf_channel_init(struct spdk_iobuf_channel *ch, const char *name,
 	struct spdk_io_channel *ioch;
 	struct iobuf_channel *iobuf_ch;
 	struct iobuf_module *module;
+	struct iobuf_class *cls;
+	struct spdk_iobuf_pool *pool;
 	struct spdk_iobuf_buffer *buf;
-	uint32_t i;
+	uint32_t i, j;
+	int socket_id;
 
-	TAILQ_FOREACH(module, &g_iobuf.modules, tailq) {
-		if (strcmp(name, module->name) == 0) {
-			break;
-		}
-	}
-
-	if (module == NULL) {
+	module = iobuf_find_module(name);
+	if (module == NULL || !module->registered) {
 		SPDK_ERRLOG("Couldn't find iobuf module: '%s'\n", name);
 		return -ENODEV;
 	}
@@ -260,39 +732,44 @@ spdk_iobuf_channel_init(struct spdk_iobuf_channel *ch, const char *name,
 
 	iobuf_ch = spdk_io_channel_get_ctx(ioch);
 
-	ch->small.queue = &iobuf_ch->small_queue;
-	ch->large.queue = &iobuf_ch->large_queue;
-	ch->small.pool = g_iobuf.small_pool;
-	ch->large.pool = g_iobuf.large_pool;
-	ch->small.bufsize = g_iobuf.opts.small_bufsize;
-	ch->large.bufsize = g_iobuf.opts.large_bufsize;
+	socket_id = spdk_thread_get_socket_id(spdk_get_thread());
+	if (socket_id == SPDK_ENV_SOCKET_ID_ANY) {
+		socket_id = (int)spdk_env_get_socket_id(spdk_env_get_current_core());
+	}
+
 	ch->parent = ioch;
 	ch->module = module;
-	ch->small.cache_size = small_cache_size;
-	ch->large.cache_size = large_cache_size;
-	ch->small.cache_count = 0;
-	ch->large.cache_count = 0;
-
-	STAILQ_INIT(&ch->small.cache);
-	STAILQ_INIT(&ch->large.cache);
-
-	for (i = 0; i < small_cache_size; ++i) {
-		if (spdk_ring_dequeue(g_iobuf.small_pool, (void **)&buf, 1) == 0) {
-			SPDK_ERRLOG("Failed to populate iobuf small buffer cache. "
-				    "You may need to increase spdk_iobuf_opts.small_pool_count\n");
-			goto error;
-		}
-		STAILQ_INSERT_TAIL(&ch->small.cache, buf, stailq);
-		ch->small.cache_count++;
+	ch->medium_count = g_iobuf.num_classes - 2;
+
+	for (i = 0; i < g_iobuf.num_classes; ++i) {
+		cls = &g_iobuf.classes[i];
+		pool = iobuf_channel_get_pool(ch, i);
+		pool->pool = iobuf_class_get_local_node(cls, socket_id)->pool;
+		pool->queue = &iobuf_ch->queues[i][module->slot].entries;
+		pool->bufsize = cls->bufsize;
+		pool->cache_size = i == 0 ? small_cache_size : large_cache_size;
+		pool->cache_count = 0;
+		STAILQ_INIT(&pool->cache);
 	}
-	for (i = 0; i < large_cache_size; ++i) {
-		if (spdk_ring_dequeue(g_iobuf.large_pool, (void **)&buf, 1) == 0) {
-			SPDK_ERRLOG("Failed to populate iobuf large buffer cache. "
-				    "You may need to increase spdk_iobuf_opts.large_pool_count\n");
-			goto error;
+
+	for (i = 0; i < g_iobuf.num_classes; ++i) {
+		cls = &g_iobuf.classes[i];
+		pool = iobuf_channel_get_pool(ch, i);
+		for (j = 0; j < pool->cache_size; ++j) {
+			if (spdk_ring_dequeue(pool->pool, (void **)&buf, 1) == 0) {
+				/* Rather take a buffer from a remote node than fail */
+				buf = iobuf_class_get_remote(cls, pool->pool);
+				if (buf == NULL) {
+					SPDK_ERRLOG("Failed to populate iobuf %"PRIu32"B buffer cache. "
+						    "You may need to increase the pool_count of that class "
+						    "in spdk_iobuf_opts\n", cls->bufsize);
+					goto error;
+				}
+			}
+			STAILQ_INSERT_TAIL(&pool->cache, buf, stailq);
+			pool->cache_count++;
+			iobuf_module_update_in_use(module, i, 1);
 		}
-		STAILQ_INSERT_TAIL(&ch->large.cache, buf, stailq);
-		ch->large.cache_count++;
 	}
 
 	return 0;
@@ -305,33 +782,30 @@ error:
 void
 spdk_iobuf_channel_fini(struct spdk_iobuf_channel *ch)
 {
-	struct spdk_iobuf_entry *entry __attribute__((unused));
+	struct iobuf_module *module = (struct iobuf_module *)ch->module;
 	struct spdk_iobuf_buffer *buf;
+	struct spdk_iobuf_pool *pool;
+	struct iobuf_class *cls;
+	uint32_t i;
 
-	/* Make sure none of the wait queue entries are coming from this module */
-	STAILQ_FOREACH(entry, ch->small.queue, stailq) {
-		assert(entry->module != ch->module);
-	}
-	STAILQ_FOREACH(entry, ch->large.queue, stailq) {
-		assert(entry->module != ch->module);
-	}
+	for (i = 0; i < g_iobuf.num_classes; ++i) {
+		cls = &g_iobuf.classes[i];
+		pool = iobuf_channel_get_pool(ch, i);
 
-	/* Release cached buffers back to the pool */
-	while (!STAILQ_EMPTY(&ch->small.cache)) {
-		buf = STAILQ_FIRST(&ch->small.cache);
-		STAILQ_REMOVE_HEAD(&ch->small.cache, stailq);
-		spdk_ring_enqueue(g_iobuf.small_pool, (void **)&buf, 1, NULL);
-		ch->small.cache_count--;
-	}
-	while (!STAILQ_EMPTY(&ch->large.cache)) {
-		buf = STAILQ_FIRST(&ch->large.cache);
-		STAILQ_REMOVE_HEAD(&ch->large.cache, stailq);
-		spdk_ring_enqueue(g_iobuf.large_pool, (void **)&buf, 1, NULL);
-		ch->large.cache_count--;
-	}
+		/* Make sure none of the wait queue entries are coming from this module */
+		assert(STAILQ_EMPTY(pool->queue));
+
+		/* Release cached buffers back to the pools they came from */
+		while (!STAILQ_EMPTY(&pool->cache)) {
+			buf = STAILQ_FIRST(&pool->cache);
+			STAILQ_REMOVE_HEAD(&pool->cache, stailq);
+			spdk_ring_enqueue(iobuf_class_find_node(cls, buf)->pool, (void **)&buf, 1, NULL);
+			pool->cache_count--;
+			iobuf_module_update_in_use(module, i, -1);
+		}
 
-	assert(ch->small.cache_count == 0);
-	assert(ch->large.cache_count == 0);
+		assert(pool->cache_count == 0);
+	}
 
 	spdk_put_io_channel(ch->parent);
 	ch->parent = NULL;
@@ -341,25 +815,29 @@ int
 spdk_iobuf_register_module(const char *name)
 {
 	struct iobuf_module *module;
+	uint32_t slot;
 
-	TAILQ_FOREACH(module, &g_iobuf.modules, tailq) {
-		if (strcmp(name, module->name) == 0) {
-			return -EEXIST;
-		}
+	module = iobuf_find_module(name);
+	if (module != NULL && module->registered) {
+		return -EEXIST;
 	}
 
-	module = calloc(1, sizeof(*module));
-	if (module == NULL) {
-		return -ENOMEM;
+	if (g_iobuf.module_slots == UINT32_MAX) {
+		SPDK_ERRLOG("Too many iobuf modules, at most %d are supported\n", IOBUF_MAX_MODULES);
+		return -ENOSPC;
 	}
 
-	module->name = strdup(name);
-	if (module->name == NULL) {
-		free(module);
-		return -ENOMEM;
+	if (module == NULL) {
+		module = iobuf_create_module(name);
+		if (module == NULL) {
+			return -ENOMEM;
+		}
 	}
 
-	TAILQ_INSERT_TAIL(&g_iobuf.modules, module, tailq);
+	slot = __builtin_ctz(~g_iobuf.module_slots);
+	g_iobuf.module_slots |= 1u << slot;
+	module->slot = slot;
+	module->registered = true;
 
 	return 0;
 }
@@ -369,16 +847,80 @@ spdk_iobuf_unregister_module(const char *name)
 {
 	struct iobuf_module *module;
 
-	TAILQ_FOREACH(module, &g_iobuf.modules, tailq) {
-		if (strcmp(name, module->name) == 0) {
-			TAILQ_REMOVE(&g_iobuf.modules, module, tailq);
-			free(module->name);
-			free(module);
-			return 0;
+	module = iobuf_find_module(name);
+	if (module == NULL || !module->registered) {
+		return -ENOENT;
+	}
+
+	g_iobuf.module_slots &= ~(1u << module->slot);
+	module->registered = false;
+
+	/* Keep the options in case the module registers again */
+	if (module->opts.reserved_percent == 0 && module->opts.max_percent == 0 &&
+	    module->opts.weight == IOBUF_DEFAULT_WEIGHT) {
+		iobuf_free_module(module);
+	}
+
+	return 0;
+}
+
+int
+spdk_iobuf_set_module_opts(const char *name, const struct spdk_iobuf_module_opts *opts)
+{
+	struct iobuf_module *module;
+
+	/* The channels read the options without any synchronization */
+	if (g_iobuf.num_classes != 0) {
+		SPDK_ERRLOG("iobuf module options can't be changed once the pools are allocated\n");
+		return -EBUSY;
+	}
+
+	if (opts->reserved_percent > 100 || opts->max_percent > 100) {
+		SPDK_ERRLOG("reserved_percent and max_percent must be at most 100\n");
+		return -EINVAL;
+	}
+	if (opts->max_percent != 0 && opts->max_percent < opts->reserved_percent) {
+		SPDK_ERRLOG("max_percent must be at least reserved_percent\n");
+		return -EINVAL;
+	}
+	if (opts->weight == 0 || opts->weight > IOBUF_MAX_WEIGHT) {
+		SPDK_ERRLOG("weight must be between 1 and %d\n", IOBUF_MAX_WEIGHT);
+		return -EINVAL;
+	}
+
+	module = iobuf_find_module(name);
+	if (g_iobuf.reserved_percent - (module != NULL ? module->opts.reserved_percent : 0) +
+	    opts->reserved_percent > 100) {
+		SPDK_ERRLOG("The reservations of all modules must add up to at most 100%%\n");
+		return -EINVAL;
+	}
+
+	if (module == NULL) {
+		module = iobuf_create_module(name);
+		if (module == NULL) {
+			return -ENOMEM;
 		}
 	}
 
-	return -ENOENT;
+	g_iobuf.reserved_percent -= module->opts.reserved_percent;
+	g_iobuf.reserved_percent += opts->reserved_percent;
+	module->opts = *opts;
+
+	return 0;
+}
+
+void
+spdk_iobuf_get_module_opts(const char *name, struct spdk_iobuf_module_opts *opts)
+{
+	struct iobuf_module *module;
+
+	module = iobuf_find_module(name);
+	if (module != NULL) {
+		*opts = module->opts;
+	} else {
+		memset(opts, 0, sizeof(*opts));
+		opts->weight = IOBUF_DEFAULT_WEIGHT;
+	}
 }
 
 int
@@ -407,34 +949,61 @@ void
 spdk_iobuf_entry_abort(struct spdk_iobuf_channel *ch, struct spdk_iobuf_entry *entry,
 		       uint64_t len)
 {
+	struct iobuf_channel *iobuf_ch = spdk_io_channel_get_ctx(ch->parent);
+	struct iobuf_module *module = (struct iobuf_module *)entry->module;
 	struct spdk_iobuf_pool *pool;
+	uint32_t index;
 
-	if (len <= ch->small.bufsize) {
-		pool = &ch->small;
-	} else {
-		assert(len <= ch->large.bufsize);
-		pool = &ch->large;
-	}
+	pool = iobuf_channel_find_pool(ch, len, &index);
 
 	STAILQ_REMOVE(pool->queue, entry, spdk_iobuf_entry, stailq);
+	if (STAILQ_EMPTY(pool->queue)) {
+		iobuf_ch->waiting[index] &= ~(1u << module->slot);
+	}
 }
 
 #define IOBUF_BATCH_SIZE 32
 
+/* Returns a batch of buffers to the pools of the nodes they were allocated on */
+static void
+iobuf_class_release(struct iobuf_class *cls, struct spdk_iobuf_buffer **bufs, size_t count)
+{
+	struct spdk_iobuf_buffer *node_bufs[IOBUF_BATCH_SIZE];
+	struct iobuf_node *node;
+	size_t i, node_count;
+	uint32_t n;
+
+	assert(count <= IOBUF_BATCH_SIZE);
+	if (cls->num_nodes == 1) {
+		spdk_ring_enqueue(cls->nodes[0].pool, (void **)bufs, count, NULL);
+		return;
+	}
+
+	for (n = 0; n < cls->num_nodes; n++) {
+		node = &cls->nodes[n];
+		node_count = 0;
+		for (i = 0; i < count; i++) {
+			if (iobuf_class_find_node(cls, bufs[i]) == node) {
+				node_bufs[node_count++] = bufs[i];
+			}
+		}
+		if (node_count > 0) {
+			spdk_ring_enqueue(node->pool, (void **)node_bufs, node_count, NULL);
+		}
+	}
+}
+
 void *
 spdk_iobuf_get(struct spdk_iobuf_channel *ch, uint64_t len,
 	       struct spdk_iobuf_entry *entry, spdk_iobuf_get_cb cb_fn)
 {
+	struct iobuf_module *module = (struct iobuf_module *)ch->module;
 	struct spdk_iobuf_pool *pool;
+	uint32_t index;
 	void *buf;
 
 	assert(spdk_io_channel_get_thread(ch->parent) == spdk_get_thread());
-	if (len <= ch->small.bufsize) {
-		pool = &ch->small;
-	} else {
-		assert(len <= ch->large.bufsize);
-		pool = &ch->large;
-	}
+	pool = iobuf_channel_find_pool(ch, len, &index);
 
 	buf = (void *)STAILQ_FIRST(&pool->cache);
 	if (buf) {
@@ -443,21 +1012,35 @@ spdk_iobuf_get(struct spdk_iobuf_channel *ch, uint64_t len,
 		pool->cache_count--;
 	} else {
 		struct spdk_iobuf_buffer *bufs[IOBUF_BATCH_SIZE];
-		size_t sz, i;
+		size_t sz = 0, i;
+		uint64_t count;
 
 		/* If we're going to dequeue, we may as well dequeue a batch. */
-		sz = spdk_ring_dequeue(pool->pool, (void **)bufs, spdk_min(IOBUF_BATCH_SIZE,
-				       spdk_max(pool->cache_size, 1)));
+		count = spdk_min(IOBUF_BATCH_SIZE, spdk_max(pool->cache_size, 1));
+		count = iobuf_module_get_quota(module, index, count);
+		if (count > 0) {
+			sz = spdk_ring_dequeue(pool->pool, (void **)bufs, count);
+			if (sz == 0) {
+				/* Don't cache the remote buffers, they should go back home as soon
+				 * as possible */
+				buf = iobuf_class_get_remote(&g_iobuf.classes[index], pool->pool);
+				if (buf != NULL) {
+					iobuf_module_update_in_use(module, index, 1);
+					return buf;
+				}
+			}
+		}
+
 		if (sz == 0) {
 			if (entry) {
-				STAILQ_INSERT_TAIL(pool->queue, entry, stailq);
-				entry->module = ch->module;
-				entry->cb_fn = cb_fn;
+				iobuf_channel_queue_entry(ch, index, entry, cb_fn);
 			}
 
 			return NULL;
 		}
 
+		iobuf_module_update_in_use(module, index, sz);
+
 		for (i = 0; i < (sz - 1); i++) {
 			STAILQ_INSERT_HEAD(&pool->cache, bufs[i], stailq);
 			pool->cache_count++;
@@ -473,21 +1056,41 @@ spdk_iobuf_get(struct spdk_iobuf_channel *ch, uint64_t len,
 void
 spdk_iobuf_put(struct spdk_iobuf_channel *ch, void *buf, uint64_t len)
 {
-	struct spdk_iobuf_entry *entry;
+	struct iobuf_channel *iobuf_ch = spdk_io_channel_get_ctx(ch->parent);
+	struct iobuf_module *module = (struct iobuf_module *)ch->module, *waiter;
+	struct spdk_iobuf_entry *entry = NULL;
 	struct spdk_iobuf_buffer *iobuf_buf;
 	struct spdk_iobuf_pool *pool;
+	struct iobuf_class *cls;
+	struct iobuf_node *node;
+	uint32_t index;
 	size_t sz;
 
 	assert(spdk_io_channel_get_thread(ch->parent) == spdk_get_thread());
-	if (len <= ch->small.bufsize) {
-		pool = &ch->small;
-	} else {
-		pool = &ch->large;
+	pool = iobuf_channel_find_pool(ch, len, &index);
+	cls = &g_iobuf.classes[index];
+
+	if (iobuf_ch->waiting[index] != 0) {
+		/* Give up the buffer before checking the limits of the waiting modules */
+		iobuf_module_update_in_use(module, index, -1);
+		entry = iobuf_channel_dequeue_entry(iobuf_ch, index);
+		iobuf_module_update_in_use(module, index, 1);
 	}
 
-	if (STAILQ_EMPTY(pool->queue)) {
+	if (entry == NULL) {
+		if (spdk_unlikely(cls->num_nodes > 1)) {
+			/* Only keep the buffers allocated on the local node */
+			node = iobuf_class_find_node(cls, buf);
+			if (node->pool != pool->pool) {
+				spdk_ring_enqueue(node->pool, (void **)&buf, 1, NULL);
+				iobuf_module_update_in_use(module, index, -1);
+				return;
+			}
+		}
+
 		if (pool->cache_size == 0) {
 			spdk_ring_enqueue(pool->pool, (void **)&buf, 1, NULL);
+			iobuf_module_update_in_use(module, index, -1);
 			return;
 		}
 
@@ -511,11 +1114,70 @@ spdk_iobuf_put(struct spdk_iobuf_channel *ch, void *buf, uint64_t len)
 				pool->cache_count--;
 			}
 
-			spdk_ring_enqueue(pool->pool, (void **)bufs, sz, NULL);
+			/* The cache may still hold remote buffers taken while it was populated */
+			iobuf_class_release(cls, bufs, sz);
+			iobuf_module_update_in_use(module, index, -(int64_t)sz);
 		}
 	} else {
-		entry = STAILQ_FIRST(pool->queue);
-		STAILQ_REMOVE_HEAD(pool->queue, stailq);
+		waiter = (struct iobuf_module *)entry->module;
+		if (waiter != module) {
+			iobuf_module_update_in_use(module, index, -1);
+			iobuf_module_update_in_use(waiter, index, 1);
+		}
+		iobuf_module_update_wait(waiter, spdk_get_ticks() - entry->wait_tsc);
 		entry->cb_fn(entry, buf);
 	}
 }
+
+int
+spdk_iobuf_get_class_stats(uint32_t index, struct spdk_iobuf_class_stats *stats)
+{
+	struct iobuf_class *cls;
+	struct iobuf_node *node;
+	uint32_t n;
+
+	if (index >= g_iobuf.num_classes) {
+		return -ENOENT;
+	}
+
+	cls = &g_iobuf.classes[index];
+	memset(stats, 0, sizeof(*stats));
+	stats->bufsize = cls->bufsize;
+	stats->num_nodes = cls->num_nodes;
+	for (n = 0; n < cls->num_nodes; n++) {
+		node = &cls->nodes[n];
+		stats->nodes[n].socket_id = node->socket_id;
+		stats->nodes[n].count = node->count;
+		stats->nodes[n].available = spdk_ring_count(node->pool);
+	}
+
+	return 0;
+}
+
+int
+spdk_iobuf_get_module_stats(uint32_t index, struct spdk_iobuf_module_stats *stats)
+{
+	struct iobuf_module *module;
+	uint32_t i = 0;
+
+	TAILQ_FOREACH(module, &g_iobuf.modules, tailq) {
+		if (i++ == index) {
+			break;
+		}
+	}
+
+	if (module == NULL) {
+		return -ENOENT;
+	}
+
+	memset(stats, 0, sizeof(*stats));
+	stats->name = module->name;
+	for (i = 0; i < IOBUF_MAX_CLASSES; i++) {
+		stats->in_use[i] = __atomic_load_n(&module->in_use[i], __ATOMIC_RELAXED);
+	}
+	stats->wait_count = __atomic_load_n(&module->wait_count, __ATOMIC_RELAXED);
+	stats->wait_ticks = __atomic_load_n(&module->wait_ticks, __ATOMIC_RELAXED);
+	stats->max_wait_ticks = __atomic_load_n(&module->max_wait_ticks, __ATOMIC_RELAXED);
+
+	return 0;
+}
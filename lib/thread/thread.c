@@ -14,6 +14,7 @@
 #include "spdk/trace.h"
 #include "spdk/util.h"
 #include "spdk/fd_group.h"
+#include "spdk/histogram_data.h"
 
 #include "spdk/log.h"
 #include "spdk_internal/thread.h"
@@ -33,10 +34,22 @@
 #endif
 
 #define SPDK_MSG_BATCH_SIZE		8
+#define SPDK_MSG_LANE_SIZE		256
+/* A lane which carried no message for this long is released by its sender. */
+#define SPDK_MSG_LANE_IDLE_SEC		1
 #define SPDK_MAX_DEVICE_NAME_LEN	256
 #define SPDK_THREAD_EXIT_TIMEOUT_SEC	5
 #define SPDK_MAX_POLLER_NAME_LEN	256
 #define SPDK_MAX_THREAD_NAME_LEN	256
+/* Each power-of-two range of poller execution times is split into 4 buckets. */
+#define SPDK_POLLER_HISTOGRAM_BUCKET_SHIFT	2
+#define SPDK_WORK_DEFAULT_MAX_TASKS	64
+#define SPDK_WORK_DEFAULT_BUDGET_US	50
+
+/* How often a polled thread refreshes its entry in the statistics region. */
+#define SPDK_THREAD_STATS_SHM_PERIOD_US	10000
+SPDK_STATIC_ASSERT(SPDK_THREAD_STATS_SHM_NAME_LEN == SPDK_MAX_THREAD_NAME_LEN + 1,
+		   "Thread names must fit in the statistics shared memory whole");
 
 static struct spdk_thread *g_app_thread;
 
@@ -70,8 +83,12 @@ enum spdk_poller_state {
 };
 
 struct spdk_poller {
+	/* Links the poller into the active or paused list, or into a slot
+	 * of the timer wheel if it is a waiting timed poller.
+	 */
 	TAILQ_ENTRY(spdk_poller)	tailq;
-	RB_ENTRY(spdk_poller)		node;
+	/* Index of the timer wheel slot the poller is linked into. */
+	uint32_t			timer_slot;
 
 	/* Current state of the poller; should only be accessed from the poller's thread. */
 	enum spdk_poller_state		state;
@@ -80,6 +97,8 @@ struct spdk_poller {
 	uint64_t			next_run_tick;
 	uint64_t			run_count;
 	uint64_t			busy_count;
+	/* Number of executions that took at least g_slow_poller_ticks. */
+	uint64_t			slow_count;
 	uint64_t			id;
 	spdk_poller_fn			fn;
 	void				*arg;
@@ -87,10 +106,39 @@ struct spdk_poller {
 	struct spdk_interrupt		*intr;
 	spdk_poller_set_interrupt_mode_cb set_intr_cb_fn;
 	void				*set_intr_cb_arg;
+	/* Execution times in ticks, allocated on the first run after histograms
+	 * are enabled.
+	 */
+	struct spdk_histogram_data	*histogram;
 
 	char				name[SPDK_MAX_POLLER_NAME_LEN + 1];
 };
 
+/*
+ * Timed pollers are kept in a hierarchical timing wheel keyed by next_run_tick.
+ * Level N has TIMER_WHEEL_SLOTS slots, each covering 2^(N * TIMER_WHEEL_LEVEL_BITS)
+ * ticks, so the levels together cover the full 64-bit tick space.  A poller
+ * is placed on the lowest level where its next_run_tick and the wheel's base
+ * tick share all of the higher digits, which makes insert and remove O(1).
+ * Slots on level 0 hold pollers expiring at exactly one tick.  Slots on
+ * higher levels are cascaded down once the base reaches them, so pollers
+ * expire in next_run_tick order and, for the same tick, in insertion order.
+ */
+#define TIMER_WHEEL_LEVEL_BITS	6
+#define TIMER_WHEEL_SLOTS	(1U << TIMER_WHEEL_LEVEL_BITS)
+#define TIMER_WHEEL_LEVELS	SPDK_CEIL_DIV(64, TIMER_WHEEL_LEVEL_BITS)
+
+TAILQ_HEAD(timer_wheel_slot, spdk_poller);
+
+struct timer_wheel {
+	/* All pollers in the wheel expire at or after this tick. */
+	uint64_t			base;
+	/* Bit N is set if level N has a non-empty slot. */
+	uint32_t			level_map;
+	uint64_t			slot_map[TIMER_WHEEL_LEVELS];
+	struct timer_wheel_slot		slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+};
+
 enum spdk_thread_state {
 	/* The thread is processing poller and message by spdk_thread_poll(). */
 	SPDK_THREAD_STATE_RUNNING,
@@ -117,7 +165,7 @@ struct spdk_thread {
 	/**
 	 * Contains pollers running on this thread with a periodic timer.
 	 */
-	RB_HEAD(timed_pollers_tree, spdk_poller)	timed_pollers;
+	struct timer_wheel				timed_pollers;
 	struct spdk_poller				*first_timed_poller;
 	/*
 	 * Contains paused pollers.  Pollers on this queue are waiting until
@@ -125,9 +173,34 @@ struct spdk_thread {
 	 * queues) or unregistered.
 	 */
 	TAILQ_HEAD(paused_pollers_head, spdk_poller)	paused_pollers;
+	/* Messages from senders which are not SPDK threads. */
 	struct spdk_ring		*messages;
+	/*
+	 * Lanes carrying messages from other SPDK threads, linked through their
+	 * next pointer.  Senders push new lanes at the head.
+	 */
+	struct spdk_msg_lane		*msg_lanes;
+	/*
+	 * Doorbell of the lanes: senders push a lane which received messages
+	 * here, unless it is already pending or active.  The thread moves pending
+	 * lanes to its active list and drains those round-robin, so it never has
+	 * to look at idle lanes.
+	 */
+	struct spdk_msg_lane		*msg_lanes_pending;
+	TAILQ_HEAD(, spdk_msg_lane)	msg_active_lanes;
+	uint32_t			msg_active_lane_count;
+	/* The shared ring is served first in the next batch. */
+	bool				msg_ring_first;
+	bool				msg_lanes_reap;
+	/* Lanes this thread sends messages through, keyed by the receiver id. */
+	RB_HEAD(msg_lane_tree, spdk_msg_lane)		msg_send_lanes;
+	struct spdk_msg_lane		*msg_last_lane;
+	/* Next time the lanes which stayed idle are released. */
+	uint64_t			msg_lanes_sweep_tsc;
+	/* Lanes which were full and still have messages waiting in overflow. */
+	TAILQ_HEAD(, spdk_msg_lane)	msg_overflow_lanes;
 	int				msg_fd;
-	SLIST_HEAD(, spdk_msg)		msg_cache;
+	STAILQ_HEAD(, spdk_msg)		msg_cache;
 	size_t				msg_cache_count;
 	spdk_msg_fn			critical_msg;
 	uint64_t			id;
@@ -140,6 +213,8 @@ struct spdk_thread {
 
 	char				name[SPDK_MAX_THREAD_NAME_LEN + 1];
 	struct spdk_cpuset		cpumask;
+	/* NUMA socket of the devices polled by the thread, a hint for schedulers. */
+	int				socket_id;
 	uint64_t			exit_timeout_tsc;
 
 	int32_t				lock_count;
@@ -152,11 +227,36 @@ struct spdk_thread {
 	bool				poller_unregistered;
 	struct spdk_fd_group		*fgrp;
 
+	/*
+	 * Background work jobs submitted by this thread with indices left to take.
+	 * The thread takes tasks from the tail, other threads steal from the head.
+	 * Protected by g_work_mutex.
+	 */
+	TAILQ_HEAD(work_jobs_head, spdk_work_job)	work_jobs;
+	/* Number of jobs on work_jobs, read without the lock when polling. */
+	uint32_t			work_queued_jobs;
+	/* Links the thread into g_work_threads while work_jobs is not empty. */
+	TAILQ_ENTRY(spdk_thread)	work_tailq;
+	/* Jobs submitted by this thread and not completed yet, protected by g_work_mutex. */
+	TAILQ_HEAD(, spdk_work_job)	work_owned_jobs;
+	uint32_t			work_job_count;
+	/* Tasks being processed by this thread. */
+	TAILQ_HEAD(, spdk_work_task)	work_tasks;
+	uint32_t			work_task_count;
+
+	/* Entry of the statistics region, claimed on the first update. */
+	struct spdk_thread_stats_shm_entry	*stats_entry;
+	uint64_t			stats_publish_tsc;
+
 	/* User context allocated at the end */
 	uint8_t				ctx[0];
 };
 
 static pthread_mutex_t g_devlist_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* Protects the lifetime of message lanes.  Messages are sent with g_devlist_mutex
+ * held, so this lock must never be held while taking another one.
+ */
+static pthread_mutex_t g_msg_lane_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static spdk_new_thread_fn g_new_thread_fn = NULL;
 static spdk_thread_op_fn g_thread_op_fn = NULL;
@@ -168,6 +268,78 @@ static size_t g_ctx_sz = 0;
  */
 static uint64_t g_thread_id = 1;
 
+/* Pollers are only timed if histograms are enabled or the slow poller threshold is set. */
+static bool g_poller_histograms = false;
+static uint64_t g_slow_poller_threshold_us = 0;
+static uint64_t g_slow_poller_ticks = 0;
+
+struct spdk_work_job {
+	spdk_work_fn			fn;
+	void				*ctx;
+	spdk_work_cpl			cpl_fn;
+	void				*cpl_ctx;
+	void				*io_device;
+	/*
+	 * Thread which submitted the job, the deque holding it and the completion.
+	 * Cleared, under g_work_mutex, if the thread is destroyed before the job completes.
+	 */
+	struct spdk_thread		*thread;
+	uint64_t			count;
+	uint32_t			chunk;
+	uint32_t			max_tasks;
+	/* Next index to take, protected by g_work_mutex. */
+	uint64_t			next;
+	/* The fields below are updated atomically by the threads processing tasks. */
+	uint32_t			running;
+	uint64_t			completed;
+	int				status;
+	/* The completion was sent to the thread, protected by g_work_mutex. */
+	bool				cpl_sent;
+	TAILQ_ENTRY(spdk_work_job)	tailq;
+	TAILQ_ENTRY(spdk_work_job)	owner_tailq;
+};
+
+struct spdk_work_task {
+	struct spdk_work_job		*job;
+	struct spdk_thread		*thread;
+	struct spdk_io_channel		*ch;
+	uint64_t			first;
+	uint64_t			index;
+	uint64_t			end;
+	/* The task yields to the thread once this is reached. */
+	uint64_t			deadline;
+	/* The work function is on the stack, spdk_work_task_done() must not recurse. */
+	bool				in_fn;
+	bool				done;
+	TAILQ_ENTRY(spdk_work_task)	tailq;
+};
+
+/*
+ * All work deques are protected by a single lock.  Tasks are meant to be coarse,
+ * so it is only taken once per task, and threads check whether there is anything
+ * to take before they take it.  The only message sent with it held is the job
+ * completion, so that the thread receiving it can't be destroyed in the meantime.
+ */
+static pthread_mutex_t g_work_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* Threads with jobs left to take, in the order they are stolen from. */
+static TAILQ_HEAD(, spdk_thread) g_work_threads = TAILQ_HEAD_INITIALIZER(g_work_threads);
+/* Number of jobs with indices left to take, read without the lock when polling. */
+static uint32_t g_work_queued = 0;
+/* Number of tasks being processed by all threads. */
+static uint32_t g_work_running = 0;
+static uint32_t g_work_max_tasks = SPDK_WORK_DEFAULT_MAX_TASKS;
+static uint32_t g_work_budget_us = SPDK_WORK_DEFAULT_BUDGET_US;
+
+/*
+ * Statistics region shared with other processes.  Each entry is written only by
+ * the thread owning it, readers detect concurrent updates by its sequence number.
+ * Entries are claimed and released under g_devlist_mutex.
+ */
+static struct spdk_thread_stats_shm *g_stats_shm = NULL;
+static size_t g_stats_shm_size = 0;
+static char g_stats_shm_name[64];
+static uint64_t g_stats_shm_period = 0;
+
 enum spin_error {
 	SPIN_ERR_NONE,
 	/* Trying to use an SPDK lock while not on an SPDK thread */
@@ -276,9 +448,62 @@ struct spdk_msg {
 	spdk_msg_fn		fn;
 	void			*arg;
 
-	SLIST_ENTRY(spdk_msg)	link;
+	STAILQ_ENTRY(spdk_msg)	link;
+};
+
+struct msg_lane_entry {
+	spdk_msg_fn		fn;
+	void			*arg;
+};
+
+/*
+ * Single-producer single-consumer message queue from one SPDK thread to another.
+ * The sender owns the tail and the receiver owns the head, so neither side
+ * contends with any other thread, and messages are copied into the lane rather
+ * than allocated.  If the lane is full, the sender keeps further messages in
+ * its overflow list and moves them into the lane once there is room again, so
+ * messages between two threads are always executed in the order they were sent.
+ *
+ * A lane is referenced by both threads and freed once both have released it.
+ * References are only dropped with g_msg_lane_mutex held.  The sender releases
+ * its lanes when it exits, or once they have been idle for SPDK_MSG_LANE_IDLE_SEC,
+ * so that the number of lanes doesn't grow with the square of the thread count.
+ */
+struct spdk_msg_lane {
+	/* Owned by the receiver */
+	uint32_t			head;
+	struct spdk_msg_lane		*next;
+	TAILQ_ENTRY(spdk_msg_lane)	active_link;
+
+	/* Owned by the sender */
+	uint32_t			tail __attribute__((aligned(SPDK_CACHE_LINE_SIZE)));
+	bool				overflow_pending;
+	bool				sender_released;
+	/* Set by the sender when it queues messages, cleared by the idle sweep. */
+	bool				used;
+	/* Set while the lane is pending or active on the receiver. */
+	bool				notified;
+	uint32_t			refs;
+	struct spdk_msg_lane		*pending_next;
+	uint64_t			receiver_id;
+	struct spdk_thread		*receiver;
+	STAILQ_HEAD(, spdk_msg)		overflow;
+	RB_ENTRY(spdk_msg_lane)		node;
+	TAILQ_ENTRY(spdk_msg_lane)	overflow_link;
+
+	struct msg_lane_entry		entries[SPDK_MSG_LANE_SIZE]
+	__attribute__((aligned(SPDK_CACHE_LINE_SIZE)));
 };
 
+static int
+msg_lane_cmp(struct spdk_msg_lane *lane1, struct spdk_msg_lane *lane2)
+{
+	return (lane1->receiver_id < lane2->receiver_id ? -1 :
+		lane1->receiver_id > lane2->receiver_id);
+}
+
+RB_GENERATE_STATIC(msg_lane_tree, spdk_msg_lane, node, msg_lane_cmp);
+
 static struct spdk_mempool *g_spdk_msg_mempool = NULL;
 
 static TAILQ_HEAD(, spdk_thread) g_threads = TAILQ_HEAD_INITIALIZER(g_threads);
@@ -288,6 +513,18 @@ static __thread struct spdk_thread *tls_thread = NULL;
 
 SPDK_TRACE_REGISTER_FN(thread_trace, "thread", TRACE_GROUP_THREAD)
 {
+	struct spdk_trace_tpoint_opts opts[] = {
+		{
+			"THREAD_SLOW_POLLER", TRACE_THREAD_SLOW_POLLER,
+			OWNER_NONE, OBJECT_NONE, 0,
+			{
+				{ "poller_id", SPDK_TRACE_ARG_TYPE_INT, 8 },
+				{ "ticks", SPDK_TRACE_ARG_TYPE_INT, 8 },
+				{ "name", SPDK_TRACE_ARG_TYPE_STR, 32 },
+			}
+		},
+	};
+
 	spdk_trace_register_description("THREAD_IOCH_GET",
 					TRACE_THREAD_IOCH_GET,
 					OWNER_NONE, OBJECT_NONE, 0,
@@ -296,30 +533,225 @@ SPDK_TRACE_REGISTER_FN(thread_trace, "thread", TRACE_GROUP_THREAD)
 					TRACE_THREAD_IOCH_PUT,
 					OWNER_NONE, OBJECT_NONE, 0,
 					SPDK_TRACE_ARG_TYPE_INT, "refcnt");
+	spdk_trace_register_description_ext(opts, SPDK_COUNTOF(opts));
+}
+
+static void
+timer_wheel_init(struct timer_wheel *wheel, uint64_t now)
+{
+	uint32_t level, slot;
+
+	wheel->base = now;
+	wheel->level_map = 0;
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		wheel->slot_map[level] = 0;
+		for (slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+			TAILQ_INIT(&wheel->slots[level][slot]);
+		}
+	}
+}
+
+static inline bool
+timer_wheel_empty(struct timer_wheel *wheel)
+{
+	return wheel->level_map == 0;
+}
+
+/* Returns the first tick covered by a slot, given the current base. */
+static inline uint64_t
+timer_wheel_slot_start(struct timer_wheel *wheel, uint32_t level, uint32_t slot)
+{
+	uint32_t shift = level * TIMER_WHEEL_LEVEL_BITS;
+	uint64_t prefix = 0;
+
+	if (shift + TIMER_WHEEL_LEVEL_BITS < 64) {
+		prefix = wheel->base >> (shift + TIMER_WHEEL_LEVEL_BITS);
+		prefix <<= shift + TIMER_WHEEL_LEVEL_BITS;
+	}
+
+	return prefix | ((uint64_t)slot << shift);
+}
+
+static inline void
+timer_wheel_insert(struct timer_wheel *wheel, struct spdk_poller *poller)
+{
+	uint64_t tick = spdk_max(poller->next_run_tick, wheel->base);
+	uint64_t diff = tick ^ wheel->base;
+	uint32_t level = 0, slot;
+
+	if (diff != 0) {
+		level = (63 - __builtin_clzll(diff)) / TIMER_WHEEL_LEVEL_BITS;
+	}
+	slot = (tick >> (level * TIMER_WHEEL_LEVEL_BITS)) & (TIMER_WHEEL_SLOTS - 1);
+
+	poller->timer_slot = level * TIMER_WHEEL_SLOTS + slot;
+	TAILQ_INSERT_TAIL(&wheel->slots[level][slot], poller, tailq);
+	wheel->slot_map[level] |= 1ULL << slot;
+	wheel->level_map |= 1U << level;
+}
+
+static inline void
+timer_wheel_remove(struct timer_wheel *wheel, struct spdk_poller *poller)
+{
+	uint32_t level = poller->timer_slot / TIMER_WHEEL_SLOTS;
+	uint32_t slot = poller->timer_slot % TIMER_WHEEL_SLOTS;
+
+	TAILQ_REMOVE(&wheel->slots[level][slot], poller, tailq);
+	if (TAILQ_EMPTY(&wheel->slots[level][slot])) {
+		wheel->slot_map[level] &= ~(1ULL << slot);
+		if (wheel->slot_map[level] == 0) {
+			wheel->level_map &= ~(1U << level);
+		}
+	}
 }
 
 /*
- * If this compare function returns zero when two next_run_ticks are equal,
- * the macro RB_INSERT() returns a pointer to the element with the same
- * next_run_tick.
- *
- * Fortunately, the macro RB_REMOVE() takes not a key but a pointer to the element
- * to remove as a parameter.
- *
- * Hence we allow RB_INSERT() to insert elements with the same keys on the right
- * side by returning 1 when two next_run_ticks are equal.
+ * Returns the poller with the smallest next_run_tick, the earliest inserted one
+ * if several expire at the same tick.  All pollers on a higher level expire
+ * after any poller on a lower level, so only the first non-empty slot of the
+ * lowest non-empty level has to be looked at.
  */
-static inline int
-timed_poller_compare(struct spdk_poller *poller1, struct spdk_poller *poller2)
+static struct spdk_poller *
+timer_wheel_min(struct timer_wheel *wheel)
 {
-	if (poller1->next_run_tick < poller2->next_run_tick) {
-		return -1;
-	} else {
-		return 1;
+	struct spdk_poller *poller, *min;
+	uint32_t level;
+
+	if (timer_wheel_empty(wheel)) {
+		return NULL;
+	}
+
+	level = __builtin_ctz(wheel->level_map);
+	min = TAILQ_FIRST(&wheel->slots[level][__builtin_ctzll(wheel->slot_map[level])]);
+	if (level == 0) {
+		return min;
+	}
+
+	poller = min;
+	while ((poller = TAILQ_NEXT(poller, tailq)) != NULL) {
+		if (poller->next_run_tick < min->next_run_tick) {
+			min = poller;
+		}
+	}
+
+	return min;
+}
+
+/*
+ * Places all pollers again relative to a base which is earlier than the current
+ * one.  Pollers which were due before the current base have been kept in its
+ * slot and would otherwise wait until the clock reaches that base again.
+ */
+static void
+timer_wheel_rebase(struct timer_wheel *wheel, uint64_t base)
+{
+	struct timer_wheel_slot pollers = TAILQ_HEAD_INITIALIZER(pollers);
+	struct spdk_poller *poller;
+	uint32_t level, slot;
+
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		for (slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+			TAILQ_CONCAT(&pollers, &wheel->slots[level][slot], tailq);
+		}
+	}
+
+	timer_wheel_init(wheel, base);
+
+	while ((poller = TAILQ_FIRST(&pollers)) != NULL) {
+		TAILQ_REMOVE(&pollers, poller, tailq);
+		timer_wheel_insert(wheel, poller);
+	}
+}
+
+/*
+ * Removes and returns the next poller which expires at or before now, or NULL
+ * if there is none.  Advances the base of the wheel, cascading the pollers of
+ * higher level slots down as the base reaches them.
+ */
+static struct spdk_poller *
+timer_wheel_expire(struct timer_wheel *wheel, uint64_t now)
+{
+	struct timer_wheel_slot *head;
+	struct spdk_poller *poller;
+	uint32_t level, slot;
+	uint64_t start;
+
+	if (spdk_unlikely(now < wheel->base)) {
+		/* The clock went backwards, e.g. a mocked one in the unit tests. */
+		timer_wheel_rebase(wheel, now);
+	}
+
+	while (!timer_wheel_empty(wheel)) {
+		level = __builtin_ctz(wheel->level_map);
+		slot = __builtin_ctzll(wheel->slot_map[level]);
+		start = timer_wheel_slot_start(wheel, level, slot);
+		if (start > now) {
+			break;
+		}
+
+		wheel->base = start;
+		head = &wheel->slots[level][slot];
+		if (level == 0) {
+			poller = TAILQ_FIRST(head);
+			timer_wheel_remove(wheel, poller);
+			return poller;
+		}
+
+		while ((poller = TAILQ_FIRST(head)) != NULL) {
+			timer_wheel_remove(wheel, poller);
+			timer_wheel_insert(wheel, poller);
+			assert(poller->timer_slot < level * TIMER_WHEEL_SLOTS);
+		}
+	}
+
+	if (now > wheel->base) {
+		wheel->base = now;
+	}
+
+	return NULL;
+}
+
+/* Returns the first poller in the first non-empty slot at or after index. */
+static struct spdk_poller *
+timer_wheel_find(struct timer_wheel *wheel, uint32_t index)
+{
+	uint32_t level = index / TIMER_WHEEL_SLOTS;
+	uint32_t slot = index % TIMER_WHEEL_SLOTS;
+	uint64_t map;
+
+	for (; level < TIMER_WHEEL_LEVELS; level++, slot = 0) {
+		map = wheel->slot_map[level] & (UINT64_MAX << slot);
+		if (map != 0) {
+			return TAILQ_FIRST(&wheel->slots[level][__builtin_ctzll(map)]);
+		}
+	}
+
+	return NULL;
+}
+
+static inline struct spdk_poller *
+timer_wheel_first(struct timer_wheel *wheel)
+{
+	return timer_wheel_find(wheel, 0);
+}
+
+static inline struct spdk_poller *
+timer_wheel_next(struct timer_wheel *wheel, struct spdk_poller *poller)
+{
+	struct spdk_poller *next;
+
+	next = TAILQ_NEXT(poller, tailq);
+	if (next != NULL) {
+		return next;
 	}
+
+	return timer_wheel_find(wheel, poller->timer_slot + 1);
 }
 
-RB_GENERATE_STATIC(timed_pollers_tree, spdk_poller, node, timed_poller_compare);
+#define TIMER_WHEEL_FOREACH_SAFE(poller, wheel, tmp) \
+	for ((poller) = timer_wheel_first(wheel); \
+	     (poller) != NULL && ((tmp) = timer_wheel_next(wheel, poller), 1); \
+	     (poller) = (tmp))
 
 static inline struct spdk_thread *
 _get_thread(void)
@@ -351,118 +783,410 @@ _thread_lib_init(size_t ctx_sz, size_t msg_mempool_sz)
 	return 0;
 }
 
-static void thread_interrupt_destroy(struct spdk_thread *thread);
-static int thread_interrupt_create(struct spdk_thread *thread);
-
-static void
-_free_thread(struct spdk_thread *thread)
+static inline struct spdk_msg *
+thread_alloc_msg(struct spdk_thread *thread)
 {
-	struct spdk_io_channel *ch;
 	struct spdk_msg *msg;
-	struct spdk_poller *poller, *ptmp;
 
-	RB_FOREACH(ch, io_channel_tree, &thread->io_channels) {
-		SPDK_ERRLOG("thread %s still has channel for io_device %s\n",
-			    thread->name, ch->dev->name);
+	if (thread != NULL && thread->msg_cache_count > 0) {
+		msg = STAILQ_FIRST(&thread->msg_cache);
+		assert(msg != NULL);
+		STAILQ_REMOVE_HEAD(&thread->msg_cache, link);
+		thread->msg_cache_count--;
+		return msg;
 	}
 
-	TAILQ_FOREACH_SAFE(poller, &thread->active_pollers, tailq, ptmp) {
-		if (poller->state != SPDK_POLLER_STATE_UNREGISTERED) {
-			SPDK_WARNLOG("active_poller %s still registered at thread exit\n",
-				     poller->name);
-		}
-		TAILQ_REMOVE(&thread->active_pollers, poller, tailq);
-		free(poller);
-	}
+	return spdk_mempool_get(g_spdk_msg_mempool);
+}
 
-	RB_FOREACH_SAFE(poller, timed_pollers_tree, &thread->timed_pollers, ptmp) {
-		if (poller->state != SPDK_POLLER_STATE_UNREGISTERED) {
-			SPDK_WARNLOG("timed_poller %s still registered at thread exit\n",
-				     poller->name);
-		}
-		RB_REMOVE(timed_pollers_tree, &thread->timed_pollers, poller);
-		free(poller);
+static inline void
+thread_free_msg(struct spdk_thread *thread, struct spdk_msg *msg)
+{
+	if (thread->msg_cache_count < SPDK_MSG_MEMPOOL_CACHE_SIZE) {
+		/* Insert the messages at the head. We want to re-use the hot
+		 * ones. */
+		STAILQ_INSERT_HEAD(&thread->msg_cache, msg, link);
+		thread->msg_cache_count++;
+	} else {
+		spdk_mempool_put(g_spdk_msg_mempool, msg);
 	}
+}
 
-	TAILQ_FOREACH_SAFE(poller, &thread->paused_pollers, tailq, ptmp) {
-		SPDK_WARNLOG("paused_poller %s still registered at thread exit\n", poller->name);
-		TAILQ_REMOVE(&thread->paused_pollers, poller, tailq);
-		free(poller);
-	}
+static inline uint32_t
+msg_lane_free_count(struct spdk_msg_lane *lane)
+{
+	return SPDK_MSG_LANE_SIZE - (lane->tail - __atomic_load_n(&lane->head, __ATOMIC_ACQUIRE));
+}
 
-	pthread_mutex_lock(&g_devlist_mutex);
-	assert(g_thread_count > 0);
-	g_thread_count--;
-	TAILQ_REMOVE(&g_threads, thread, tailq);
-	pthread_mutex_unlock(&g_devlist_mutex);
+static inline bool
+msg_lane_is_empty(struct spdk_msg_lane *lane)
+{
+	return __atomic_load_n(&lane->tail, __ATOMIC_ACQUIRE) ==
+	       __atomic_load_n(&lane->head, __ATOMIC_RELAXED) &&
+	       !__atomic_load_n(&lane->overflow_pending, __ATOMIC_ACQUIRE);
+}
 
-	msg = SLIST_FIRST(&thread->msg_cache);
-	while (msg != NULL) {
-		SLIST_REMOVE_HEAD(&thread->msg_cache, link);
+/* Returns whether any message is waiting to be executed by the thread. */
+static bool
+thread_has_msgs(struct spdk_thread *thread)
+{
+	return !TAILQ_EMPTY(&thread->msg_active_lanes) ||
+	       __atomic_load_n(&thread->msg_lanes_pending, __ATOMIC_ACQUIRE) != NULL ||
+	       spdk_ring_count(thread->messages) > 0;
+}
 
-		assert(thread->msg_cache_count > 0);
-		thread->msg_cache_count--;
-		spdk_mempool_put(g_spdk_msg_mempool, msg);
+/*
+ * Rings the doorbell of the receiver after messages were queued on the lane.
+ * The fence pairs with the one in msg_lane_deactivate(): either the receiver
+ * sees the new tail, or the sender sees that the lane is no longer notified.
+ */
+static inline void
+msg_lane_notify(struct spdk_msg_lane *lane)
+{
+	struct spdk_thread *receiver = lane->receiver;
+	struct spdk_msg_lane *head;
 
-		msg = SLIST_FIRST(&thread->msg_cache);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&lane->notified, __ATOMIC_RELAXED) ||
+	    __atomic_exchange_n(&lane->notified, true, __ATOMIC_ACQ_REL)) {
+		return;
 	}
 
-	assert(thread->msg_cache_count == 0);
+	head = __atomic_load_n(&receiver->msg_lanes_pending, __ATOMIC_RELAXED);
+	do {
+		lane->pending_next = head;
+	} while (!__atomic_compare_exchange_n(&receiver->msg_lanes_pending, &head, lane, true,
+					      __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
 
-	if (spdk_interrupt_mode_is_enabled()) {
-		thread_interrupt_destroy(thread);
-	}
+/*
+ * Takes a drained lane off the active list.  If the sender queued new messages
+ * in the meantime, the lane is either kept active or already pending again.
+ */
+static void
+msg_lane_deactivate(struct spdk_thread *thread, struct spdk_msg_lane *lane)
+{
+	TAILQ_REMOVE(&thread->msg_active_lanes, lane, active_link);
+	thread->msg_active_lane_count--;
 
-	spdk_ring_free(thread->messages);
-	free(thread);
+	__atomic_store_n(&lane->notified, false, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (!msg_lane_is_empty(lane) &&
+	    !__atomic_exchange_n(&lane->notified, true, __ATOMIC_ACQ_REL)) {
+		TAILQ_INSERT_TAIL(&thread->msg_active_lanes, lane, active_link);
+		thread->msg_active_lane_count++;
+	}
 }
 
-int
-spdk_thread_lib_init(spdk_new_thread_fn new_thread_fn, size_t ctx_sz)
+/* Moves the lanes which rang the doorbell to the active list, in the order they did. */
+static void
+thread_activate_msg_lanes(struct spdk_thread *thread)
 {
-	assert(g_new_thread_fn == NULL);
-	assert(g_thread_op_fn == NULL);
+	struct spdk_msg_lane *lane, *prev = NULL, *next;
 
-	if (new_thread_fn == NULL) {
-		SPDK_INFOLOG(thread, "new_thread_fn was not specified at spdk_thread_lib_init\n");
-	} else {
-		g_new_thread_fn = new_thread_fn;
+	lane = __atomic_exchange_n(&thread->msg_lanes_pending, NULL, __ATOMIC_ACQUIRE);
+	while (lane != NULL) {
+		next = lane->pending_next;
+		lane->pending_next = prev;
+		prev = lane;
+		lane = next;
 	}
 
-	return _thread_lib_init(ctx_sz, SPDK_DEFAULT_MSG_MEMPOOL_SIZE);
+	for (lane = prev; lane != NULL; lane = lane->pending_next) {
+		TAILQ_INSERT_TAIL(&thread->msg_active_lanes, lane, active_link);
+		thread->msg_active_lane_count++;
+	}
 }
 
-int
-spdk_thread_lib_init_ext(spdk_thread_op_fn thread_op_fn,
-			 spdk_thread_op_supported_fn thread_op_supported_fn,
-			 size_t ctx_sz, size_t msg_mempool_sz)
+static inline uint32_t
+msg_lane_dequeue(struct spdk_msg_lane *lane, struct msg_lane_entry *entries, uint32_t count)
 {
-	assert(g_new_thread_fn == NULL);
-	assert(g_thread_op_fn == NULL);
-	assert(g_thread_op_supported_fn == NULL);
+	uint32_t head = lane->head, avail, i;
 
-	if ((thread_op_fn != NULL) != (thread_op_supported_fn != NULL)) {
-		SPDK_ERRLOG("Both must be defined or undefined together.\n");
-		return -EINVAL;
+	avail = __atomic_load_n(&lane->tail, __ATOMIC_ACQUIRE) - head;
+	count = spdk_min(count, avail);
+	for (i = 0; i < count; i++) {
+		entries[i] = lane->entries[(head + i) % SPDK_MSG_LANE_SIZE];
 	}
+	__atomic_store_n(&lane->head, head + count, __ATOMIC_RELEASE);
 
-	if (thread_op_fn == NULL && thread_op_supported_fn == NULL) {
-		SPDK_INFOLOG(thread, "thread_op_fn and thread_op_supported_fn were not specified\n");
-	} else {
-		g_thread_op_fn = thread_op_fn;
-		g_thread_op_supported_fn = thread_op_supported_fn;
+	return count;
+}
+
+/* Returns the overflow messages of a lane to the sender's cache. */
+static void
+msg_lane_drop_overflow(struct spdk_thread *sender, struct spdk_msg_lane *lane)
+{
+	struct spdk_msg *msg;
+
+	if (STAILQ_EMPTY(&lane->overflow)) {
+		return;
 	}
 
-	return _thread_lib_init(ctx_sz, msg_mempool_sz);
+	while ((msg = STAILQ_FIRST(&lane->overflow)) != NULL) {
+		STAILQ_REMOVE_HEAD(&lane->overflow, link);
+		thread_free_msg(sender, msg);
+	}
+	TAILQ_REMOVE(&sender->msg_overflow_lanes, lane, overflow_link);
+	__atomic_store_n(&lane->overflow_pending, false, __ATOMIC_RELEASE);
 }
 
-void
-spdk_thread_lib_fini(void)
+/* Must be called with g_msg_lane_mutex held. */
+static void
+msg_lane_put(struct spdk_msg_lane *lane)
 {
-	struct io_device *dev;
-
-	RB_FOREACH(dev, io_device_tree, &g_io_devices) {
-		SPDK_ERRLOG("io_device %s not unregistered\n", dev->name);
+	assert(lane->refs > 0);
+	if (__atomic_sub_fetch(&lane->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+		assert(STAILQ_EMPTY(&lane->overflow));
+		free(lane);
+	}
+}
+
+/* Releases the sender's reference of a lane.  Must be called with g_msg_lane_mutex held. */
+static void
+msg_lane_release(struct spdk_thread *sender, struct spdk_msg_lane *lane)
+{
+	RB_REMOVE(msg_lane_tree, &sender->msg_send_lanes, lane);
+	msg_lane_drop_overflow(sender, lane);
+	if (lane->refs > 1) {
+		/* Let the receiver unlink the lane once it has drained it. */
+		__atomic_store_n(&lane->sender_released, true, __ATOMIC_RELEASE);
+		__atomic_store_n(&lane->receiver->msg_lanes_reap, true, __ATOMIC_RELEASE);
+	}
+	msg_lane_put(lane);
+}
+
+/* Must be called with g_msg_lane_mutex held. */
+static void
+thread_release_msg_lanes(struct spdk_thread *thread)
+{
+	struct spdk_msg_lane *lane, *tmp;
+
+	RB_FOREACH_SAFE(lane, msg_lane_tree, &thread->msg_send_lanes, tmp) {
+		msg_lane_release(thread, lane);
+	}
+	thread->msg_last_lane = NULL;
+
+	lane = thread->msg_lanes;
+	while (lane != NULL) {
+		tmp = lane->next;
+		msg_lane_put(lane);
+		lane = tmp;
+	}
+	thread->msg_lanes = NULL;
+	thread->msg_lanes_pending = NULL;
+	TAILQ_INIT(&thread->msg_active_lanes);
+	thread->msg_active_lane_count = 0;
+}
+
+/*
+ * Releases the lanes which carried no message since the previous sweep and
+ * which the receiver has drained.  Messages sent to the same receiver later on
+ * go through a new lane, and are still executed after the drained ones.
+ */
+static void
+thread_sweep_msg_lanes(struct spdk_thread *thread)
+{
+	struct spdk_msg_lane *lane, *tmp;
+	bool locked = false;
+
+	RB_FOREACH_SAFE(lane, msg_lane_tree, &thread->msg_send_lanes, tmp) {
+		if (lane->used || !STAILQ_EMPTY(&lane->overflow) ||
+		    lane->tail != __atomic_load_n(&lane->head, __ATOMIC_ACQUIRE)) {
+			lane->used = false;
+			continue;
+		}
+
+		if (!locked) {
+			pthread_mutex_lock(&g_msg_lane_mutex);
+			locked = true;
+		}
+		if (thread->msg_last_lane == lane) {
+			thread->msg_last_lane = NULL;
+		}
+		msg_lane_release(thread, lane);
+	}
+
+	if (locked) {
+		pthread_mutex_unlock(&g_msg_lane_mutex);
+	}
+}
+
+static void thread_interrupt_destroy(struct spdk_thread *thread);
+static int thread_interrupt_create(struct spdk_thread *thread);
+static void thread_stats_publish(struct spdk_thread *thread);
+
+static void
+poller_free(struct spdk_poller *poller)
+{
+	spdk_histogram_data_free(poller->histogram);
+	free(poller);
+}
+
+static void work_job_dequeue(struct spdk_work_job *job);
+static void work_task_cancel(struct spdk_work_task *task);
+
+static void
+_free_thread(struct spdk_thread *thread)
+{
+	struct spdk_io_channel *ch;
+	struct spdk_msg *msg;
+	struct spdk_poller *poller, *ptmp;
+	struct spdk_work_job *job;
+	struct spdk_work_task *task;
+	uint64_t skipped, completed;
+
+	RB_FOREACH(ch, io_channel_tree, &thread->io_channels) {
+		SPDK_ERRLOG("thread %s still has channel for io_device %s\n",
+			    thread->name, ch->dev->name);
+	}
+
+	TAILQ_FOREACH_SAFE(poller, &thread->active_pollers, tailq, ptmp) {
+		if (poller->state != SPDK_POLLER_STATE_UNREGISTERED) {
+			SPDK_WARNLOG("active_poller %s still registered at thread exit\n",
+				     poller->name);
+		}
+		TAILQ_REMOVE(&thread->active_pollers, poller, tailq);
+		poller_free(poller);
+	}
+
+	TIMER_WHEEL_FOREACH_SAFE(poller, &thread->timed_pollers, ptmp) {
+		if (poller->state != SPDK_POLLER_STATE_UNREGISTERED) {
+			SPDK_WARNLOG("timed_poller %s still registered at thread exit\n",
+				     poller->name);
+		}
+		timer_wheel_remove(&thread->timed_pollers, poller);
+		poller_free(poller);
+	}
+
+	TAILQ_FOREACH_SAFE(poller, &thread->paused_pollers, tailq, ptmp) {
+		SPDK_WARNLOG("paused_poller %s still registered at thread exit\n", poller->name);
+		TAILQ_REMOVE(&thread->paused_pollers, poller, tailq);
+		poller_free(poller);
+	}
+
+	/* The thread won't resume its tasks anymore, fail their jobs. */
+	if (!TAILQ_EMPTY(&thread->work_tasks)) {
+		SPDK_WARNLOG("thread %s still has background tasks at thread exit\n", thread->name);
+		while ((task = TAILQ_FIRST(&thread->work_tasks)) != NULL) {
+			work_task_cancel(task);
+		}
+	}
+
+	/* Tasks of the remaining jobs may still be processed by other threads, so those
+	 * jobs are released by the last task instead of being completed.
+	 */
+	pthread_mutex_lock(&g_work_mutex);
+	if (!TAILQ_EMPTY(&thread->work_owned_jobs)) {
+		SPDK_WARNLOG("thread %s still has background work at thread exit\n", thread->name);
+	}
+	while ((job = TAILQ_FIRST(&thread->work_owned_jobs)) != NULL) {
+		TAILQ_REMOVE(&thread->work_owned_jobs, job, owner_tailq);
+		if (job->next < job->count) {
+			skipped = job->count - job->next;
+			job->next = job->count;
+			work_job_dequeue(job);
+			completed = __atomic_add_fetch(&job->completed, skipped, __ATOMIC_ACQ_REL);
+			if (completed == job->count) {
+				free(job);
+				continue;
+			}
+		}
+
+		if (job->cpl_sent) {
+			/* The completion message is dropped along with the thread. */
+			free(job);
+		} else {
+			job->thread = NULL;
+		}
+	}
+	pthread_mutex_unlock(&g_work_mutex);
+
+	pthread_mutex_lock(&g_devlist_mutex);
+	assert(g_thread_count > 0);
+	g_thread_count--;
+	TAILQ_REMOVE(&g_threads, thread, tailq);
+	if (thread->stats_entry != NULL) {
+		thread->stats_entry->seq++;
+		spdk_smp_wmb();
+		thread->stats_entry->id = 0;
+		spdk_smp_wmb();
+		thread->stats_entry->seq++;
+		thread->stats_entry = NULL;
+	}
+	pthread_mutex_unlock(&g_devlist_mutex);
+
+	pthread_mutex_lock(&g_msg_lane_mutex);
+	thread_release_msg_lanes(thread);
+	pthread_mutex_unlock(&g_msg_lane_mutex);
+
+	msg = STAILQ_FIRST(&thread->msg_cache);
+	while (msg != NULL) {
+		STAILQ_REMOVE_HEAD(&thread->msg_cache, link);
+
+		assert(thread->msg_cache_count > 0);
+		thread->msg_cache_count--;
+		spdk_mempool_put(g_spdk_msg_mempool, msg);
+
+		msg = STAILQ_FIRST(&thread->msg_cache);
+	}
+
+	assert(thread->msg_cache_count == 0);
+
+	if (spdk_interrupt_mode_is_enabled()) {
+		thread_interrupt_destroy(thread);
+	}
+
+	spdk_ring_free(thread->messages);
+	free(thread);
+}
+
+int
+spdk_thread_lib_init(spdk_new_thread_fn new_thread_fn, size_t ctx_sz)
+{
+	assert(g_new_thread_fn == NULL);
+	assert(g_thread_op_fn == NULL);
+
+	if (new_thread_fn == NULL) {
+		SPDK_INFOLOG(thread, "new_thread_fn was not specified at spdk_thread_lib_init\n");
+	} else {
+		g_new_thread_fn = new_thread_fn;
+	}
+
+	return _thread_lib_init(ctx_sz, SPDK_DEFAULT_MSG_MEMPOOL_SIZE);
+}
+
+int
+spdk_thread_lib_init_ext(spdk_thread_op_fn thread_op_fn,
+			 spdk_thread_op_supported_fn thread_op_supported_fn,
+			 size_t ctx_sz, size_t msg_mempool_sz)
+{
+	assert(g_new_thread_fn == NULL);
+	assert(g_thread_op_fn == NULL);
+	assert(g_thread_op_supported_fn == NULL);
+
+	if ((thread_op_fn != NULL) != (thread_op_supported_fn != NULL)) {
+		SPDK_ERRLOG("Both must be defined or undefined together.\n");
+		return -EINVAL;
+	}
+
+	if (thread_op_fn == NULL && thread_op_supported_fn == NULL) {
+		SPDK_INFOLOG(thread, "thread_op_fn and thread_op_supported_fn were not specified\n");
+	} else {
+		g_thread_op_fn = thread_op_fn;
+		g_thread_op_supported_fn = thread_op_supported_fn;
+	}
+
+	return _thread_lib_init(ctx_sz, msg_mempool_sz);
+}
+
+void
+spdk_thread_lib_fini(void)
+{
+	struct io_device *dev;
+
+	RB_FOREACH(dev, io_device_tree, &g_io_devices) {
+		SPDK_ERRLOG("io_device %s not unregistered\n", dev->name);
 	}
 
 	g_new_thread_fn = NULL;
@@ -498,13 +1222,20 @@ spdk_thread_create(const char *name, const struct spdk_cpuset *cpumask)
 	} else {
 		spdk_cpuset_negate(&thread->cpumask);
 	}
+	thread->socket_id = SPDK_ENV_SOCKET_ID_ANY;
 
 	RB_INIT(&thread->io_channels);
 	TAILQ_INIT(&thread->active_pollers);
-	RB_INIT(&thread->timed_pollers);
+	timer_wheel_init(&thread->timed_pollers, spdk_get_ticks());
 	TAILQ_INIT(&thread->paused_pollers);
-	SLIST_INIT(&thread->msg_cache);
+	STAILQ_INIT(&thread->msg_cache);
 	thread->msg_cache_count = 0;
+	TAILQ_INIT(&thread->msg_active_lanes);
+	RB_INIT(&thread->msg_send_lanes);
+	TAILQ_INIT(&thread->msg_overflow_lanes);
+	TAILQ_INIT(&thread->work_jobs);
+	TAILQ_INIT(&thread->work_owned_jobs);
+	TAILQ_INIT(&thread->work_tasks);
 
 	thread->tsc_last = spdk_get_ticks();
 
@@ -526,7 +1257,7 @@ spdk_thread_create(const char *name, const struct spdk_cpuset *cpumask)
 		/* If we can't populate the cache it's ok. The cache will get filled
 		 * up organically as messages are passed to the thread. */
 		for (i = 0; i < SPDK_MSG_MEMPOOL_CACHE_SIZE; i++) {
-			SLIST_INSERT_HEAD(&thread->msg_cache, msgs[i], link);
+			STAILQ_INSERT_HEAD(&thread->msg_cache, msgs[i], link);
 			thread->msg_cache_count++;
 		}
 	}
@@ -561,6 +1292,11 @@ spdk_thread_create(const char *name, const struct spdk_cpuset *cpumask)
 		}
 	}
 
+	/* Publish the thread right away, so that it is listed even before it is polled. */
+	if (__atomic_load_n(&g_stats_shm, __ATOMIC_ACQUIRE) != NULL) {
+		thread_stats_publish(thread);
+	}
+
 	if (g_new_thread_fn) {
 		rc = g_new_thread_fn(thread);
 	} else if (g_thread_op_supported_fn && g_thread_op_supported_fn(SPDK_THREAD_OP_NEW)) {
@@ -621,11 +1357,16 @@ thread_exit(struct spdk_thread *thread, uint64_t now)
 		goto exited;
 	}
 
-	if (spdk_ring_count(thread->messages) > 0) {
+	if (thread_has_msgs(thread)) {
 		SPDK_INFOLOG(thread, "thread %s still has messages\n", thread->name);
 		return;
 	}
 
+	if (!TAILQ_EMPTY(&thread->msg_overflow_lanes)) {
+		SPDK_INFOLOG(thread, "thread %s still has messages to send\n", thread->name);
+		return;
+	}
+
 	TAILQ_FOREACH(poller, &thread->active_pollers, tailq) {
 		if (poller->state != SPDK_POLLER_STATE_UNREGISTERED) {
 			SPDK_INFOLOG(thread,
@@ -635,7 +1376,8 @@ thread_exit(struct spdk_thread *thread, uint64_t now)
 		}
 	}
 
-	RB_FOREACH(poller, timed_pollers_tree, &thread->timed_pollers) {
+	for (poller = timer_wheel_first(&thread->timed_pollers); poller != NULL;
+	     poller = timer_wheel_next(&thread->timed_pollers, poller)) {
 		if (poller->state != SPDK_POLLER_STATE_UNREGISTERED) {
 			SPDK_INFOLOG(thread,
 				     "thread %s still has active timed poller %s\n",
@@ -665,6 +1407,13 @@ thread_exit(struct spdk_thread *thread, uint64_t now)
 		return;
 	}
 
+	if (thread->work_job_count > 0 || thread->work_task_count > 0) {
+		SPDK_INFOLOG(thread,
+			     "thread %s still has background work\n",
+			     thread->name);
+		return;
+	}
+
 exited:
 	thread->state = SPDK_THREAD_STATE_EXITED;
 	if (spdk_unlikely(thread->in_interrupt)) {
@@ -774,6 +1523,18 @@ spdk_thread_set_cpumask(struct spdk_cpuset *cpumask)
 	return 0;
 }
 
+void
+spdk_thread_set_socket_id(struct spdk_thread *thread, int socket_id)
+{
+	thread->socket_id = socket_id;
+}
+
+int
+spdk_thread_get_socket_id(const struct spdk_thread *thread)
+{
+	return thread->socket_id;
+}
+
 struct spdk_thread *
 spdk_thread_get_from_ctx(void *ctx)
 {
@@ -787,102 +1548,259 @@ spdk_thread_get_from_ctx(void *ctx)
 	return SPDK_CONTAINEROF(ctx, struct spdk_thread, ctx);
 }
 
-static inline uint32_t
-msg_queue_run_batch(struct spdk_thread *thread, uint32_t max_msgs)
-{
-	unsigned count, i;
-	void *messages[SPDK_MSG_BATCH_SIZE];
-	uint64_t notify = 1;
-	int rc;
+static inline int thread_send_msg_notification(const struct spdk_thread *target_thread);
 
-#ifdef DEBUG
-	/*
-	 * spdk_ring_dequeue() fills messages and returns how many entries it wrote,
-	 * so we will never actually read uninitialized data from events, but just to be sure
-	 * (and to silence a static analyzer false positive), initialize the array to NULL pointers.
-	 */
-	memset(messages, 0, sizeof(messages));
-#endif
+/*
+ * Moves overflow messages into the lane as far as there is room for them.
+ * Returns the number of messages moved.
+ */
+static uint32_t
+msg_lane_flush_overflow(struct spdk_thread *sender, struct spdk_msg_lane *lane)
+{
+	struct spdk_msg *msg;
+	uint32_t count, tail, moved;
 
-	if (max_msgs > 0) {
-		max_msgs = spdk_min(max_msgs, SPDK_MSG_BATCH_SIZE);
-	} else {
-		max_msgs = SPDK_MSG_BATCH_SIZE;
+	if (spdk_unlikely(__atomic_load_n(&lane->refs, __ATOMIC_ACQUIRE) == 1)) {
+		/* The receiver is gone, nobody will ever execute these messages. */
+		msg_lane_drop_overflow(sender, lane);
+		return 0;
 	}
 
-	count = spdk_ring_dequeue(thread->messages, messages, max_msgs);
-	if (spdk_unlikely(thread->in_interrupt) &&
-	    spdk_ring_count(thread->messages) != 0) {
-		rc = write(thread->msg_fd, &notify, sizeof(notify));
-		if (rc < 0) {
-			SPDK_ERRLOG("failed to notify msg_queue: %s.\n", spdk_strerror(errno));
-		}
-	}
+	count = msg_lane_free_count(lane);
 	if (count == 0) {
 		return 0;
 	}
 
-	for (i = 0; i < count; i++) {
-		struct spdk_msg *msg = messages[i];
+	tail = moved = lane->tail;
+	while (count > 0 && (msg = STAILQ_FIRST(&lane->overflow)) != NULL) {
+		lane->entries[tail % SPDK_MSG_LANE_SIZE].fn = msg->fn;
+		lane->entries[tail % SPDK_MSG_LANE_SIZE].arg = msg->arg;
+		STAILQ_REMOVE_HEAD(&lane->overflow, link);
+		thread_free_msg(sender, msg);
+		tail++;
+		count--;
+	}
+	__atomic_store_n(&lane->tail, tail, __ATOMIC_RELEASE);
+	moved = tail - moved;
 
-		assert(msg != NULL);
+	if (STAILQ_EMPTY(&lane->overflow)) {
+		TAILQ_REMOVE(&sender->msg_overflow_lanes, lane, overflow_link);
+		__atomic_store_n(&lane->overflow_pending, false, __ATOMIC_RELEASE);
+	}
 
-		SPDK_DTRACE_PROBE2(msg_exec, msg->fn, msg->arg);
+	msg_lane_notify(lane);
+	thread_send_msg_notification(lane->receiver);
 
-		msg->fn(msg->arg);
+	return moved;
+}
 
-		SPIN_ASSERT(thread->lock_count == 0, SPIN_ERR_HOLD_DURING_SWITCH);
+static uint32_t
+thread_flush_msg_overflow(struct spdk_thread *thread)
+{
+	struct spdk_msg_lane *lane, *tmp;
+	uint32_t moved = 0;
+	uint64_t notify = 1;
+	int rc;
 
-		if (thread->msg_cache_count < SPDK_MSG_MEMPOOL_CACHE_SIZE) {
-			/* Insert the messages at the head. We want to re-use the hot
-			 * ones. */
-			SLIST_INSERT_HEAD(&thread->msg_cache, msg, link);
-			thread->msg_cache_count++;
-		} else {
-			spdk_mempool_put(g_spdk_msg_mempool, msg);
+	TAILQ_FOREACH_SAFE(lane, &thread->msg_overflow_lanes, overflow_link, tmp) {
+		moved += msg_lane_flush_overflow(thread, lane);
+	}
+
+	if (spdk_unlikely(thread->in_interrupt) && !TAILQ_EMPTY(&thread->msg_overflow_lanes)) {
+		/* Come back to it, the thread is not polled in interrupt mode. */
+		rc = write(thread->msg_fd, &notify, sizeof(notify));
+		if (rc < 0) {
+			SPDK_ERRLOG("failed to notify msg_queue: %s.\n", spdk_strerror(errno));
 		}
 	}
 
-	return count;
+	return moved;
 }
 
+/* Unlinks and releases the drained lanes which their senders have released. */
 static void
-poller_insert_timer(struct spdk_thread *thread, struct spdk_poller *poller, uint64_t now)
+thread_reap_msg_lanes(struct spdk_thread *thread)
 {
-	struct spdk_poller *tmp __attribute__((unused));
+	struct spdk_msg_lane *lane, *prev = NULL, *next, *expected;
 
-	poller->next_run_tick = now + poller->period_ticks;
+	__atomic_store_n(&thread->msg_lanes_reap, false, __ATOMIC_RELAXED);
 
-	/*
-	 * Insert poller in the thread's timed_pollers tree by next scheduled run time
-	 * as its key.
-	 */
-	tmp = RB_INSERT(timed_pollers_tree, &thread->timed_pollers, poller);
-	assert(tmp == NULL);
+	pthread_mutex_lock(&g_msg_lane_mutex);
+	lane = __atomic_load_n(&thread->msg_lanes, __ATOMIC_ACQUIRE);
+	while (lane != NULL) {
+		next = lane->next;
+		if (!__atomic_load_n(&lane->sender_released, __ATOMIC_ACQUIRE)) {
+			prev = lane;
+			lane = next;
+			continue;
+		}
 
-	/* Update the cache only if it is empty or the inserted poller is earlier than it.
-	 * RB_MIN() is not necessary here because all pollers, which has exactly the same
-	 * next_run_tick as the existing poller, are inserted on the right side.
-	 */
-	if (thread->first_timed_poller == NULL ||
-	    poller->next_run_tick < thread->first_timed_poller->next_run_tick) {
-		thread->first_timed_poller = poller;
+		if (!msg_lane_is_empty(lane) ||
+		    __atomic_load_n(&lane->notified, __ATOMIC_ACQUIRE)) {
+			/* Try again once the remaining messages are executed. */
+			thread->msg_lanes_reap = true;
+			prev = lane;
+			lane = next;
+			continue;
+		}
+
+		if (prev != NULL) {
+			prev->next = next;
+		} else {
+			/* Senders push new lanes concurrently, so the head can only be replaced
+			 * atomically.  If that fails, the lane is no longer the head and it is
+			 * unlinked on the next pass.
+			 */
+			expected = lane;
+			if (!__atomic_compare_exchange_n(&thread->msg_lanes, &expected, next, false,
+							 __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+				thread->msg_lanes_reap = true;
+				prev = lane;
+				lane = next;
+				continue;
+			}
+		}
+
+		msg_lane_put(lane);
+		lane = next;
 	}
+	pthread_mutex_unlock(&g_msg_lane_mutex);
 }
 
-static inline void
-poller_remove_timer(struct spdk_thread *thread, struct spdk_poller *poller)
+/* Dequeues up to max_msgs messages from the shared ring into entries. */
+static inline uint32_t
+msg_ring_dequeue(struct spdk_thread *thread, struct msg_lane_entry *entries, uint32_t max_msgs)
 {
-	struct spdk_poller *tmp __attribute__((unused));
-
-	tmp = RB_REMOVE(timed_pollers_tree, &thread->timed_pollers, poller);
-	assert(tmp != NULL);
+	void *messages[SPDK_MSG_BATCH_SIZE];
+	uint32_t i, count;
 
-	/* This function is not used in any case that is performance critical.
-	 * Update the cache simply by RB_MIN() if it needs to be changed.
+#ifdef DEBUG
+	/*
+	 * spdk_ring_dequeue() fills messages and returns how many entries it wrote,
+	 * so we will never actually read uninitialized data from events, but just to be sure
+	 * (and to silence a static analyzer false positive), initialize the array to NULL pointers.
 	 */
-	if (thread->first_timed_poller == poller) {
-		thread->first_timed_poller = RB_MIN(timed_pollers_tree, &thread->timed_pollers);
+	memset(messages, 0, sizeof(messages));
+#endif
+
+	count = spdk_ring_dequeue(thread->messages, messages, max_msgs);
+	for (i = 0; i < count; i++) {
+		struct spdk_msg *msg = messages[i];
+
+		assert(msg != NULL);
+		entries[i].fn = msg->fn;
+		entries[i].arg = msg->arg;
+		thread_free_msg(thread, msg);
+	}
+
+	return count;
+}
+
+/*
+ * Executes up to max_msgs messages.  The active lanes are served round-robin, so
+ * that a busy sender can't starve the others, and a lane which is left with
+ * messages goes to the end of the list.  If the lanes take up the whole batch,
+ * the shared ring is served first in the next one.  Overflow messages this thread
+ * sends to others are moved into their lanes first.  Returns the number of
+ * messages executed or moved.
+ */
+static inline uint32_t
+msg_queue_run_batch(struct spdk_thread *thread, uint32_t max_msgs)
+{
+	struct msg_lane_entry entries[SPDK_MSG_BATCH_SIZE];
+	struct spdk_msg_lane *lane;
+	uint32_t count = 0, flushed = 0, i, lanes;
+	uint64_t notify = 1;
+	int rc;
+
+	if (spdk_unlikely(!TAILQ_EMPTY(&thread->msg_overflow_lanes))) {
+		flushed = thread_flush_msg_overflow(thread);
+	}
+
+	if (spdk_unlikely(__atomic_load_n(&thread->msg_lanes_reap, __ATOMIC_ACQUIRE))) {
+		thread_reap_msg_lanes(thread);
+	}
+
+	if (max_msgs > 0) {
+		max_msgs = spdk_min(max_msgs, SPDK_MSG_BATCH_SIZE);
+	} else {
+		max_msgs = SPDK_MSG_BATCH_SIZE;
+	}
+
+	if (__atomic_load_n(&thread->msg_lanes_pending, __ATOMIC_RELAXED) != NULL) {
+		thread_activate_msg_lanes(thread);
+	}
+
+	if (spdk_unlikely(thread->msg_ring_first)) {
+		thread->msg_ring_first = false;
+		count = msg_ring_dequeue(thread, entries, max_msgs);
+	}
+
+	for (lanes = thread->msg_active_lane_count; lanes > 0 && count < max_msgs; lanes--) {
+		lane = TAILQ_FIRST(&thread->msg_active_lanes);
+		count += msg_lane_dequeue(lane, &entries[count], max_msgs - count);
+		if (msg_lane_is_empty(lane)) {
+			msg_lane_deactivate(thread, lane);
+		} else {
+			TAILQ_REMOVE(&thread->msg_active_lanes, lane, active_link);
+			TAILQ_INSERT_TAIL(&thread->msg_active_lanes, lane, active_link);
+		}
+	}
+
+	if (count < max_msgs) {
+		count += msg_ring_dequeue(thread, &entries[count], max_msgs - count);
+	} else {
+		thread->msg_ring_first = true;
+	}
+
+	if (spdk_unlikely(thread->in_interrupt) && thread_has_msgs(thread)) {
+		rc = write(thread->msg_fd, &notify, sizeof(notify));
+		if (rc < 0) {
+			SPDK_ERRLOG("failed to notify msg_queue: %s.\n", spdk_strerror(errno));
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		SPDK_DTRACE_PROBE2(msg_exec, entries[i].fn, entries[i].arg);
+
+		entries[i].fn(entries[i].arg);
+
+		SPIN_ASSERT(thread->lock_count == 0, SPIN_ERR_HOLD_DURING_SWITCH);
+	}
+
+	return count + flushed;
+}
+
+static void
+poller_insert_timer(struct spdk_thread *thread, struct spdk_poller *poller, uint64_t now)
+{
+	poller->next_run_tick = now + poller->period_ticks;
+
+	/*
+	 * Insert poller in the thread's timer wheel by next scheduled run time.
+	 */
+	timer_wheel_insert(&thread->timed_pollers, poller);
+
+	/* Update the cache only if it is empty or the inserted poller is earlier than it.
+	 * A poller which has exactly the same next_run_tick as the cached one expires
+	 * after it, because pollers expiring at the same tick are kept in insertion order.
+	 */
+	if (thread->first_timed_poller == NULL ||
+	    poller->next_run_tick < thread->first_timed_poller->next_run_tick) {
+		thread->first_timed_poller = poller;
+	}
+}
+
+static inline void
+poller_remove_timer(struct spdk_thread *thread, struct spdk_poller *poller)
+{
+	timer_wheel_remove(&thread->timed_pollers, poller);
+
+	/* This function is not used in any case that is performance critical.
+	 * Update the cache simply by timer_wheel_min() if it needs to be changed.
+	 */
+	if (thread->first_timed_poller == poller) {
+		thread->first_timed_poller = timer_wheel_min(&thread->timed_pollers);
 	}
 }
 
@@ -911,6 +1829,54 @@ thread_update_stats(struct spdk_thread *thread, uint64_t end,
 	thread->tsc_last = end;
 }
 
+static inline bool
+poller_timing_enabled(void)
+{
+	return g_poller_histograms || g_slow_poller_ticks != 0;
+}
+
+static int
+poller_run_timed(struct spdk_poller *poller)
+{
+	uint64_t start, ticks, threshold;
+	int rc;
+
+	start = spdk_get_ticks();
+	rc = poller->fn(poller->arg);
+	ticks = spdk_get_ticks() - start;
+
+	/* The poller may have been unregistered by fn, but it is only released
+	 * by the caller, after we are done with it.
+	 */
+	if (g_poller_histograms) {
+		if (spdk_unlikely(poller->histogram == NULL)) {
+			poller->histogram = spdk_histogram_data_alloc_sized(
+						    SPDK_POLLER_HISTOGRAM_BUCKET_SHIFT);
+		}
+		if (spdk_likely(poller->histogram != NULL)) {
+			spdk_histogram_data_tally(poller->histogram, ticks);
+		}
+	}
+
+	threshold = g_slow_poller_ticks;
+	if (threshold != 0 && ticks >= threshold) {
+		poller->slow_count++;
+		spdk_trace_record(TRACE_THREAD_SLOW_POLLER, 0, 0, 0, poller->id, ticks, poller->name);
+	}
+
+	return rc;
+}
+
+static inline int
+poller_run(struct spdk_poller *poller)
+{
+	if (spdk_likely(!poller_timing_enabled())) {
+		return poller->fn(poller->arg);
+	}
+
+	return poller_run_timed(poller);
+}
+
 static inline int
 thread_execute_poller(struct spdk_thread *thread, struct spdk_poller *poller)
 {
@@ -919,7 +1885,7 @@ thread_execute_poller(struct spdk_thread *thread, struct spdk_poller *poller)
 	switch (poller->state) {
 	case SPDK_POLLER_STATE_UNREGISTERED:
 		TAILQ_REMOVE(&thread->active_pollers, poller, tailq);
-		free(poller);
+		poller_free(poller);
 		return 0;
 	case SPDK_POLLER_STATE_PAUSING:
 		TAILQ_REMOVE(&thread->active_pollers, poller, tailq);
@@ -934,7 +1900,7 @@ thread_execute_poller(struct spdk_thread *thread, struct spdk_poller *poller)
 	}
 
 	poller->state = SPDK_POLLER_STATE_RUNNING;
-	rc = poller->fn(poller->arg);
+	rc = poller_run(poller);
 
 	SPIN_ASSERT(thread->lock_count == 0, SPIN_ERR_HOLD_DURING_SWITCH);
 
@@ -952,7 +1918,7 @@ thread_execute_poller(struct spdk_thread *thread, struct spdk_poller *poller)
 	switch (poller->state) {
 	case SPDK_POLLER_STATE_UNREGISTERED:
 		TAILQ_REMOVE(&thread->active_pollers, poller, tailq);
-		free(poller);
+		poller_free(poller);
 		break;
 	case SPDK_POLLER_STATE_PAUSING:
 		TAILQ_REMOVE(&thread->active_pollers, poller, tailq);
@@ -981,7 +1947,7 @@ thread_execute_timed_poller(struct spdk_thread *thread, struct spdk_poller *poll
 
 	switch (poller->state) {
 	case SPDK_POLLER_STATE_UNREGISTERED:
-		free(poller);
+		poller_free(poller);
 		return 0;
 	case SPDK_POLLER_STATE_PAUSING:
 		TAILQ_INSERT_TAIL(&thread->paused_pollers, poller, tailq);
@@ -995,7 +1961,7 @@ thread_execute_timed_poller(struct spdk_thread *thread, struct spdk_poller *poll
 	}
 
 	poller->state = SPDK_POLLER_STATE_RUNNING;
-	rc = poller->fn(poller->arg);
+	rc = poller_run(poller);
 
 	SPIN_ASSERT(thread->lock_count == 0, SPIN_ERR_HOLD_DURING_SWITCH);
 
@@ -1012,7 +1978,7 @@ thread_execute_timed_poller(struct spdk_thread *thread, struct spdk_poller *poll
 
 	switch (poller->state) {
 	case SPDK_POLLER_STATE_UNREGISTERED:
-		free(poller);
+		poller_free(poller);
 		break;
 	case SPDK_POLLER_STATE_PAUSING:
 		TAILQ_INSERT_TAIL(&thread->paused_pollers, poller, tailq);
@@ -1067,31 +2033,24 @@ thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 	}
 
 	poller = thread->first_timed_poller;
-	while (poller != NULL) {
-		int timer_rc = 0;
-
-		if (now < poller->next_run_tick) {
-			break;
-		}
-
-		tmp = RB_NEXT(timed_pollers_tree, &thread->timed_pollers, poller);
-		RB_REMOVE(timed_pollers_tree, &thread->timed_pollers, poller);
+	if (poller == NULL || now < poller->next_run_tick) {
+		return rc;
+	}
 
-		/* Update the cache to the next timed poller in the list
-		 * only if the current poller is still the closest, otherwise,
-		 * do nothing because the cache has been already updated.
-		 */
-		if (thread->first_timed_poller == poller) {
-			thread->first_timed_poller = tmp;
-		}
+	/* Expired pollers may be freed or reinserted while they are executed, so
+	 * clear the cache until all of them have run and look the closest timed
+	 * poller up once afterwards.
+	 */
+	thread->first_timed_poller = NULL;
+	while ((poller = timer_wheel_expire(&thread->timed_pollers, now)) != NULL) {
+		int timer_rc;
 
 		timer_rc = thread_execute_timed_poller(thread, poller, now);
 		if (timer_rc > rc) {
 			rc = timer_rc;
 		}
-
-		poller = tmp;
 	}
+	thread->first_timed_poller = timer_wheel_min(&thread->timed_pollers);
 
 	return rc;
 }
@@ -1106,35 +2065,602 @@ _thread_remove_pollers(void *ctx)
 				   active_pollers_head, tailq, tmp) {
 		if (poller->state == SPDK_POLLER_STATE_UNREGISTERED) {
 			TAILQ_REMOVE(&thread->active_pollers, poller, tailq);
-			free(poller);
+			poller_free(poller);
 		}
 	}
 
-	RB_FOREACH_SAFE(poller, timed_pollers_tree, &thread->timed_pollers, tmp) {
+	TIMER_WHEEL_FOREACH_SAFE(poller, &thread->timed_pollers, tmp) {
 		if (poller->state == SPDK_POLLER_STATE_UNREGISTERED) {
 			poller_remove_timer(thread, poller);
-			free(poller);
+			poller_free(poller);
+		}
+	}
+
+	thread->poller_unregistered = false;
+}
+
+static void
+_thread_exit(void *ctx)
+{
+	struct spdk_thread *thread = ctx;
+
+	assert(thread->state == SPDK_THREAD_STATE_EXITING);
+
+	thread_exit(thread, spdk_get_ticks());
+}
+
+static inline bool
+work_job_has_room(struct spdk_work_job *job)
+{
+	return job->max_tasks == 0 ||
+	       __atomic_load_n(&job->running, __ATOMIC_RELAXED) < job->max_tasks;
+}
+
+/* Called with g_work_mutex held, once all indices of the job are taken. */
+static void
+work_job_dequeue(struct spdk_work_job *job)
+{
+	struct spdk_thread *thread = job->thread;
+
+	TAILQ_REMOVE(&thread->work_jobs, job, tailq);
+	if (TAILQ_EMPTY(&thread->work_jobs)) {
+		TAILQ_REMOVE(&g_work_threads, thread, work_tailq);
+	}
+	__atomic_sub_fetch(&thread->work_queued_jobs, 1, __ATOMIC_RELAXED);
+	__atomic_sub_fetch(&g_work_queued, 1, __ATOMIC_RELAXED);
+}
+
+/* Called with g_work_mutex held. */
+static struct spdk_work_job *
+work_thread_find_job(struct spdk_thread *victim, bool steal)
+{
+	struct spdk_work_job *job;
+
+	/* The owner takes the newest job, while thieves take the oldest one. */
+	if (steal) {
+		TAILQ_FOREACH(job, &victim->work_jobs, tailq) {
+			if (work_job_has_room(job)) {
+				return job;
+			}
+		}
+	} else {
+		TAILQ_FOREACH_REVERSE(job, &victim->work_jobs, work_jobs_head, tailq) {
+			if (work_job_has_room(job)) {
+				return job;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/* Called with g_work_mutex held. */
+static struct spdk_work_job *
+work_steal_job(struct spdk_thread *thread)
+{
+	struct spdk_thread *victim;
+	struct spdk_work_job *job;
+	bool any_socket;
+
+	/* Prefer threads polling devices on the same socket. */
+	for (any_socket = false; ; any_socket = true) {
+		TAILQ_FOREACH(victim, &g_work_threads, work_tailq) {
+			if (victim == thread ||
+			    (!any_socket && victim->socket_id != thread->socket_id)) {
+				continue;
+			}
+
+			job = work_thread_find_job(victim, true);
+			if (job != NULL) {
+				/* Move on to the next victim the next time. */
+				TAILQ_REMOVE(&g_work_threads, victim, work_tailq);
+				TAILQ_INSERT_TAIL(&g_work_threads, victim, work_tailq);
+				return job;
+			}
+		}
+
+		if (any_socket) {
+			return NULL;
+		}
+	}
+}
+
+static inline uint64_t
+work_get_deadline(void)
+{
+	return spdk_get_ticks() + g_work_budget_us * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+}
+
+static struct spdk_work_task *
+work_take_task(struct spdk_thread *thread, bool steal)
+{
+	struct spdk_work_task *task = NULL;
+	struct spdk_work_job *job;
+
+	if (__atomic_load_n(&g_work_running, __ATOMIC_RELAXED) >= g_work_max_tasks) {
+		return NULL;
+	}
+
+	if (__atomic_load_n(&thread->work_queued_jobs, __ATOMIC_RELAXED) != 0) {
+		pthread_mutex_lock(&g_work_mutex);
+	} else if (steal) {
+		/* Another thief is looking already, try again in the next iteration. */
+		if (pthread_mutex_trylock(&g_work_mutex) != 0) {
+			return NULL;
+		}
+	} else {
+		return NULL;
+	}
+
+	if (__atomic_load_n(&g_work_running, __ATOMIC_RELAXED) >= g_work_max_tasks) {
+		goto out;
+	}
+
+	job = work_thread_find_job(thread, false);
+	if (job == NULL && steal) {
+		job = work_steal_job(thread);
+	}
+	if (job == NULL) {
+		goto out;
+	}
+
+	task = calloc(1, sizeof(*task));
+	if (task == NULL) {
+		goto out;
+	}
+
+	task->job = job;
+	task->thread = thread;
+	task->first = job->next;
+	task->index = job->next;
+	task->end = spdk_min(job->count, job->next + job->chunk);
+	job->next = task->end;
+	if (job->next == job->count) {
+		work_job_dequeue(job);
+	}
+
+	__atomic_add_fetch(&job->running, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&g_work_running, 1, __ATOMIC_RELAXED);
+	TAILQ_INSERT_TAIL(&thread->work_tasks, task, tailq);
+	thread->work_task_count++;
+out:
+	pthread_mutex_unlock(&g_work_mutex);
+
+	return task;
+}
+
+static void
+work_job_complete(void *ctx)
+{
+	struct spdk_work_job *job = ctx;
+	struct spdk_thread *thread = job->thread;
+
+	pthread_mutex_lock(&g_work_mutex);
+	TAILQ_REMOVE(&thread->work_owned_jobs, job, owner_tailq);
+	pthread_mutex_unlock(&g_work_mutex);
+
+	assert(thread->work_job_count > 0);
+	thread->work_job_count--;
+
+	job->cpl_fn(job->cpl_ctx, job->status);
+	free(job);
+}
+
+static void thread_work_kick(void *ctx);
+
+static void
+work_task_finish(struct spdk_work_task *task)
+{
+	struct spdk_work_job *job = task->job;
+	struct spdk_thread *thread = task->thread;
+	uint64_t count = task->end - task->first;
+	int rc __attribute__((unused));
+
+	if (spdk_unlikely(__atomic_load_n(&job->status, __ATOMIC_RELAXED) != 0)) {
+		/* Skip the indices of the failed job nobody took yet. */
+		pthread_mutex_lock(&g_work_mutex);
+		if (job->next < job->count) {
+			count += job->count - job->next;
+			job->next = job->count;
+			work_job_dequeue(job);
+		}
+		pthread_mutex_unlock(&g_work_mutex);
+	}
+
+	if (task->ch != NULL) {
+		spdk_put_io_channel(task->ch);
+	}
+	TAILQ_REMOVE(&thread->work_tasks, task, tailq);
+	free(task);
+
+	assert(thread->work_task_count > 0);
+	thread->work_task_count--;
+	__atomic_sub_fetch(&g_work_running, 1, __ATOMIC_RELAXED);
+	__atomic_sub_fetch(&job->running, 1, __ATOMIC_RELAXED);
+
+	/* The job may be released by its thread as soon as it is completed. */
+	if (__atomic_add_fetch(&job->completed, count, __ATOMIC_ACQ_REL) == job->count) {
+		pthread_mutex_lock(&g_work_mutex);
+		if (job->thread == NULL) {
+			/* Its thread is gone, nobody waits for the completion. */
+			free(job);
+		} else {
+			/* A thread forced to exit releases the job once it is destroyed. */
+			if (job->thread->state != SPDK_THREAD_STATE_EXITED) {
+				rc = spdk_thread_send_msg(job->thread, work_job_complete, job);
+				assert(rc == 0);
+			}
+			job->cpl_sent = true;
+		}
+		pthread_mutex_unlock(&g_work_mutex);
+	}
+
+	if (spdk_unlikely(thread->in_interrupt) &&
+	    thread->state != SPDK_THREAD_STATE_EXITED &&
+	    __atomic_load_n(&g_work_queued, __ATOMIC_RELAXED) != 0) {
+		rc = spdk_thread_send_msg(thread, thread_work_kick, thread);
+		assert(rc == 0);
+	}
+}
+
+/* Fails the job of a task the thread won't resume anymore. */
+static void
+work_task_cancel(struct spdk_work_task *task)
+{
+	int expected = 0;
+
+	__atomic_compare_exchange_n(&task->job->status, &expected, -ECANCELED, false,
+				    __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+	/* The channel goes away with the thread. */
+	task->ch = NULL;
+	work_task_finish(task);
+}
+
+static void work_task_run(struct spdk_work_task *task);
+
+static void
+work_task_resume(void *ctx)
+{
+	struct spdk_work_task *task = ctx;
+
+	task->deadline = work_get_deadline();
+	work_task_run(task);
+}
+
+static void
+work_task_run(struct spdk_work_task *task)
+{
+	struct spdk_work_job *job = task->job;
+	bool yield = false;
+	int rc __attribute__((unused));
+
+	while (task->index < task->end) {
+		if (spdk_unlikely(__atomic_load_n(&job->status, __ATOMIC_RELAXED) != 0)) {
+			break;
+		}
+
+		/* A task may cover more work than fits in the budget, so it yields
+		 * between indices and continues in a message.
+		 */
+		if (yield && spdk_get_ticks() >= task->deadline) {
+			rc = spdk_thread_send_msg(task->thread, work_task_resume, task);
+			assert(rc == 0);
+			return;
+		}
+
+		task->in_fn = true;
+		task->done = false;
+		job->fn(job->ctx, task->index, task);
+		task->in_fn = false;
+
+		if (!task->done) {
+			/* spdk_work_task_done() will resume the task. */
+			return;
+		}
+		task->index++;
+		yield = true;
+	}
+
+	work_task_finish(task);
+}
+
+static void
+work_task_start(struct spdk_work_task *task)
+{
+	struct spdk_work_job *job = task->job;
+
+	if (job->io_device != NULL) {
+		task->ch = spdk_get_io_channel(job->io_device);
+		if (spdk_unlikely(task->ch == NULL)) {
+			spdk_work_task_done(task, -ENOMEM);
+			return;
+		}
+	}
+
+	work_task_run(task);
+}
+
+/*
+ * Process tasks for up to the work budget.  Busy threads only take tasks of their
+ * own jobs, idle ones also steal tasks from other threads.
+ */
+static int
+thread_work_poll(struct spdk_thread *thread, bool busy)
+{
+	struct spdk_work_task *task;
+	uint64_t deadline;
+	int count = 0;
+
+	deadline = work_get_deadline();
+	do {
+		task = work_take_task(thread, !busy);
+		if (task == NULL) {
+			break;
+		}
+
+		task->deadline = deadline;
+		work_task_start(task);
+		count++;
+	} while (spdk_get_ticks() < deadline);
+
+	return count > 0 ? 1 : 0;
+}
+
+static void
+thread_work_kick(void *ctx)
+{
+	struct spdk_thread *thread = ctx;
+	int rc __attribute__((unused));
+
+	/* Threads in interrupt mode are not polled, so they process their own jobs
+	 * through messages.
+	 */
+	if (thread_work_poll(thread, true) > 0) {
+		rc = spdk_thread_send_msg(thread, thread_work_kick, thread);
+		assert(rc == 0);
+	}
+}
+
+int
+spdk_work_submit(const struct spdk_work_job_opts *opts, spdk_work_fn fn, void *ctx,
+		 spdk_work_cpl cpl_fn, void *cpl_ctx)
+{
+	struct spdk_thread *thread = spdk_get_thread();
+	struct spdk_work_job *job;
+	int rc __attribute__((unused));
+
+	if (thread == NULL) {
+		assert(false);
+		return -EINVAL;
+	}
+
+	if (opts == NULL || fn == NULL || cpl_fn == NULL) {
+		return -EINVAL;
+	}
+
+	job = calloc(1, sizeof(*job));
+	if (job == NULL) {
+		return -ENOMEM;
+	}
+
+	job->fn = fn;
+	job->ctx = ctx;
+	job->cpl_fn = cpl_fn;
+	job->cpl_ctx = cpl_ctx;
+	job->io_device = opts->io_device;
+	job->thread = thread;
+	job->count = opts->count;
+	job->chunk = spdk_max(opts->chunk, 1);
+	job->max_tasks = opts->max_tasks;
+
+	thread->work_job_count++;
+	pthread_mutex_lock(&g_work_mutex);
+	TAILQ_INSERT_TAIL(&thread->work_owned_jobs, job, owner_tailq);
+	if (job->count == 0) {
+		job->cpl_sent = true;
+		pthread_mutex_unlock(&g_work_mutex);
+		rc = spdk_thread_send_msg(thread, work_job_complete, job);
+		assert(rc == 0);
+		return 0;
+	}
+
+	if (TAILQ_EMPTY(&thread->work_jobs)) {
+		TAILQ_INSERT_TAIL(&g_work_threads, thread, work_tailq);
+	}
+	TAILQ_INSERT_TAIL(&thread->work_jobs, job, tailq);
+	__atomic_add_fetch(&thread->work_queued_jobs, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&g_work_queued, 1, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&g_work_mutex);
+
+	if (spdk_unlikely(thread->in_interrupt)) {
+		rc = spdk_thread_send_msg(thread, thread_work_kick, thread);
+		assert(rc == 0);
+	}
+
+	return 0;
+}
+
+void
+spdk_work_task_done(struct spdk_work_task *task, int status)
+{
+	int expected = 0;
+
+	assert(task->thread == spdk_get_thread());
+
+	if (spdk_unlikely(status != 0)) {
+		__atomic_compare_exchange_n(&task->job->status, &expected, status, false,
+					    __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+	}
+
+	if (task->in_fn) {
+		task->done = true;
+		return;
+	}
+
+	task->index++;
+	task->deadline = work_get_deadline();
+	work_task_run(task);
+}
+
+struct spdk_io_channel *
+spdk_work_task_get_io_channel(struct spdk_work_task *task)
+{
+	return task->ch;
+}
+
+int
+spdk_work_set_opts(const struct spdk_work_opts *opts)
+{
+	if (opts->max_tasks == 0) {
+		SPDK_ERRLOG("max_tasks must be at least 1\n");
+		return -EINVAL;
+	}
+
+	g_work_max_tasks = opts->max_tasks;
+	g_work_budget_us = opts->budget_us;
+
+	return 0;
+}
+
+void
+spdk_work_get_opts(struct spdk_work_opts *opts)
+{
+	opts->max_tasks = g_work_max_tasks;
+	opts->budget_us = g_work_budget_us;
+}
+
+static struct spdk_thread_stats_shm_entry *
+thread_stats_claim_entry(struct spdk_thread *thread)
+{
+	struct spdk_thread_stats_shm_entry *entry;
+	uint32_t i;
+
+	pthread_mutex_lock(&g_devlist_mutex);
+	for (i = 0; i < g_stats_shm->max_threads; i++) {
+		entry = &g_stats_shm->threads[i];
+		if (entry->id == 0) {
+			/* Keep the entry marked as being updated until it is filled. */
+			entry->seq++;
+			spdk_smp_wmb();
+			entry->id = thread->id;
+			thread->stats_entry = entry;
+			pthread_mutex_unlock(&g_devlist_mutex);
+			return entry;
+		}
+	}
+	pthread_mutex_unlock(&g_devlist_mutex);
+
+	return NULL;
+}
+
+static void
+thread_stats_add_poller(struct spdk_thread_stats_shm_entry *entry, struct spdk_poller *poller)
+{
+	entry->poller_run_count += poller->run_count;
+	entry->poller_busy_count += poller->busy_count;
+	entry->poller_slow_count += poller->slow_count;
+}
+
+static void
+thread_stats_fill(struct spdk_thread *thread, struct spdk_thread_stats_shm_entry *entry)
+{
+	struct spdk_poller *poller;
+	struct spdk_io_channel *ch;
+	struct spdk_msg_lane *lane;
+	uint64_t depth;
+
+	snprintf(entry->name, sizeof(entry->name), "%s", thread->name);
+	snprintf(entry->cpumask, sizeof(entry->cpumask), "%s", spdk_cpuset_fmt(&thread->cpumask));
+	entry->tsc = thread->tsc_last;
+	entry->busy_tsc = thread->stats.busy_tsc;
+	entry->idle_tsc = thread->stats.idle_tsc;
+	entry->in_interrupt = thread->in_interrupt;
+
+	entry->active_pollers_count = 0;
+	entry->timed_pollers_count = 0;
+	entry->paused_pollers_count = 0;
+	entry->poller_run_count = 0;
+	entry->poller_busy_count = 0;
+	entry->poller_slow_count = 0;
+
+	TAILQ_FOREACH(poller, &thread->active_pollers, tailq) {
+		entry->active_pollers_count++;
+		thread_stats_add_poller(entry, poller);
+	}
+
+	for (poller = timer_wheel_first(&thread->timed_pollers); poller != NULL;
+	     poller = timer_wheel_next(&thread->timed_pollers, poller)) {
+		entry->timed_pollers_count++;
+		thread_stats_add_poller(entry, poller);
+	}
+
+	TAILQ_FOREACH(poller, &thread->paused_pollers, tailq) {
+		entry->paused_pollers_count++;
+		thread_stats_add_poller(entry, poller);
+	}
+
+	entry->io_channel_count = 0;
+	RB_FOREACH(ch, io_channel_tree, &thread->io_channels) {
+		entry->io_channel_count++;
+	}
+
+	depth = spdk_ring_count(thread->messages);
+	for (lane = thread->msg_lanes; lane != NULL; lane = lane->next) {
+		depth += __atomic_load_n(&lane->tail, __ATOMIC_ACQUIRE) - lane->head;
+	}
+	entry->msg_queue_depth = depth;
+}
+
+static void
+thread_stats_publish(struct spdk_thread *thread)
+{
+	struct spdk_thread_stats_shm_entry *entry = thread->stats_entry;
+
+	thread->stats_publish_tsc = thread->tsc_last;
+
+	if (entry == NULL) {
+		if (thread->state == SPDK_THREAD_STATE_EXITED) {
+			return;
 		}
+		entry = thread_stats_claim_entry(thread);
+		if (entry == NULL) {
+			/* The region is full, try again in the next period. */
+			return;
+		}
+	} else {
+		entry->seq++;
+		spdk_smp_wmb();
 	}
 
-	thread->poller_unregistered = false;
+	thread_stats_fill(thread, entry);
+
+	spdk_smp_wmb();
+	entry->seq++;
 }
 
-static void
-_thread_exit(void *ctx)
+int
+spdk_thread_get_stats_entry(struct spdk_thread_stats_shm_entry *entry)
 {
-	struct spdk_thread *thread = ctx;
+	struct spdk_thread *thread;
 
-	assert(thread->state == SPDK_THREAD_STATE_EXITING);
+	thread = _get_thread();
+	if (!thread) {
+		SPDK_ERRLOG("No thread allocated\n");
+		return -EINVAL;
+	}
 
-	thread_exit(thread, spdk_get_ticks());
+	memset(entry, 0, sizeof(*entry));
+	entry->id = thread->id;
+	thread_stats_fill(thread, entry);
+
+	return 0;
 }
 
 int
 spdk_thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 {
 	struct spdk_thread *orig_thread;
-	int rc;
+	int rc, work_rc;
 
 	orig_thread = _get_thread();
 	tls_thread = thread;
@@ -1153,6 +2679,12 @@ spdk_thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 			rc = thread_poll(thread, max_msgs, now);
 		}
 
+		if (spdk_unlikely(__atomic_load_n(&g_work_queued, __ATOMIC_RELAXED) != 0)) {
+			work_rc = thread_work_poll(thread, rc != 0 ||
+						   thread->state != SPDK_THREAD_STATE_RUNNING);
+			rc = spdk_max(rc, work_rc);
+		}
+
 		if (spdk_unlikely(thread->state == SPDK_THREAD_STATE_EXITING)) {
 			thread_exit(thread, now);
 		}
@@ -1163,6 +2695,16 @@ spdk_thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 
 	thread_update_stats(thread, spdk_get_ticks(), now, rc);
 
+	if (spdk_unlikely(now >= thread->msg_lanes_sweep_tsc)) {
+		thread_sweep_msg_lanes(thread);
+		thread->msg_lanes_sweep_tsc = now + SPDK_MSG_LANE_IDLE_SEC * spdk_get_ticks_hz();
+	}
+
+	if (spdk_unlikely(__atomic_load_n(&g_stats_shm, __ATOMIC_ACQUIRE) != NULL) &&
+	    thread->tsc_last - thread->stats_publish_tsc >= g_stats_shm_period) {
+		thread_stats_publish(thread);
+	}
+
 	tls_thread = orig_thread;
 
 	return rc;
@@ -1191,7 +2733,7 @@ static bool
 thread_has_unpaused_pollers(struct spdk_thread *thread)
 {
 	if (TAILQ_EMPTY(&thread->active_pollers) &&
-	    RB_EMPTY(&thread->timed_pollers)) {
+	    timer_wheel_empty(&thread->timed_pollers)) {
 		return false;
 	}
 
@@ -1212,7 +2754,8 @@ spdk_thread_has_pollers(struct spdk_thread *thread)
 bool
 spdk_thread_is_idle(struct spdk_thread *thread)
 {
-	if (spdk_ring_count(thread->messages) ||
+	if (thread_has_msgs(thread) ||
+	    !TAILQ_EMPTY(&thread->msg_overflow_lanes) ||
 	    thread_has_unpaused_pollers(thread) ||
 	    thread->critical_msg != NULL) {
 		return false;
@@ -1289,6 +2832,99 @@ spdk_thread_get_stats(struct spdk_thread_stats *stats)
 	return 0;
 }
 
+int
+spdk_thread_stats_shm_init(const char *shm_name, uint32_t max_threads)
+{
+	struct spdk_thread_stats_shm *shm;
+	size_t size;
+	int fd, rc;
+
+	if (g_stats_shm != NULL) {
+		SPDK_ERRLOG("Thread statistics region %s already exists\n", g_stats_shm_name);
+		return -EEXIST;
+	}
+
+	if (shm_name == NULL || max_threads == 0 ||
+	    strlen(shm_name) >= sizeof(g_stats_shm_name)) {
+		return -EINVAL;
+	}
+
+	size = sizeof(*shm) + (size_t)max_threads * sizeof(shm->threads[0]);
+
+	fd = shm_open(shm_name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0) {
+		rc = -errno;
+		SPDK_ERRLOG("Unable to create thread statistics region %s: %s\n", shm_name,
+			    spdk_strerror(-rc));
+		return rc;
+	}
+
+	if (ftruncate(fd, size) != 0) {
+		rc = -errno;
+		SPDK_ERRLOG("Unable to size thread statistics region %s: %s\n", shm_name,
+			    spdk_strerror(-rc));
+		close(fd);
+		shm_unlink(shm_name);
+		return rc;
+	}
+
+	shm = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (shm == MAP_FAILED) {
+		rc = -errno;
+		SPDK_ERRLOG("Unable to map thread statistics region %s: %s\n", shm_name,
+			    spdk_strerror(-rc));
+		shm_unlink(shm_name);
+		return rc;
+	}
+
+	memset(shm, 0, size);
+	shm->version = SPDK_THREAD_STATS_SHM_VERSION;
+	shm->max_threads = max_threads;
+	shm->tsc_rate = spdk_get_ticks_hz();
+
+	snprintf(g_stats_shm_name, sizeof(g_stats_shm_name), "%s", shm_name);
+	g_stats_shm_size = size;
+	g_stats_shm_period = SPDK_THREAD_STATS_SHM_PERIOD_US * spdk_get_ticks_hz() /
+			     SPDK_SEC_TO_USEC;
+	__atomic_store_n(&g_stats_shm, shm, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+void
+spdk_thread_stats_shm_cleanup(void)
+{
+	struct spdk_thread *thread;
+	struct spdk_thread_stats_shm *shm = g_stats_shm;
+
+	if (shm == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&g_devlist_mutex);
+	__atomic_store_n(&g_stats_shm, NULL, __ATOMIC_RELEASE);
+	TAILQ_FOREACH(thread, &g_threads, tailq) {
+		thread->stats_entry = NULL;
+	}
+	pthread_mutex_unlock(&g_devlist_mutex);
+
+	munmap(shm, g_stats_shm_size);
+	shm_unlink(g_stats_shm_name);
+	g_stats_shm_size = 0;
+	g_stats_shm_name[0] = '\0';
+}
+
+const struct spdk_thread_stats_shm *
+spdk_thread_stats_shm_get(const char **shm_name)
+{
+	if (shm_name != NULL) {
+		*shm_name = g_stats_shm != NULL ? g_stats_shm_name : NULL;
+	}
+
+	return g_stats_shm;
+}
+
 uint64_t
 spdk_thread_get_last_tsc(struct spdk_thread *thread)
 {
@@ -1325,6 +2961,128 @@ thread_send_msg_notification(const struct spdk_thread *target_thread)
 	return 0;
 }
 
+/* Must be called with g_msg_lane_mutex held. */
+static struct spdk_msg_lane *
+msg_lane_create(struct spdk_thread *sender, struct spdk_thread *receiver)
+{
+	struct spdk_msg_lane *lane, *tmp, *head;
+
+	/* Release the lanes to threads which are gone in the meantime. */
+	RB_FOREACH_SAFE(lane, msg_lane_tree, &sender->msg_send_lanes, tmp) {
+		if (__atomic_load_n(&lane->refs, __ATOMIC_ACQUIRE) == 1) {
+			RB_REMOVE(msg_lane_tree, &sender->msg_send_lanes, lane);
+			msg_lane_drop_overflow(sender, lane);
+			msg_lane_put(lane);
+		}
+	}
+	sender->msg_last_lane = NULL;
+
+	if (posix_memalign((void **)&lane, SPDK_CACHE_LINE_SIZE, sizeof(*lane))) {
+		return NULL;
+	}
+	memset(lane, 0, sizeof(*lane));
+
+	lane->receiver_id = receiver->id;
+	lane->receiver = receiver;
+	lane->refs = 2;
+	STAILQ_INIT(&lane->overflow);
+	RB_INSERT(msg_lane_tree, &sender->msg_send_lanes, lane);
+
+	head = __atomic_load_n(&receiver->msg_lanes, __ATOMIC_RELAXED);
+	do {
+		lane->next = head;
+	} while (!__atomic_compare_exchange_n(&receiver->msg_lanes, &head, lane, true,
+					      __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+	return lane;
+}
+
+static inline struct spdk_msg_lane *
+thread_get_msg_lane(struct spdk_thread *sender, const struct spdk_thread *receiver)
+{
+	struct spdk_msg_lane *lane;
+
+	lane = sender->msg_last_lane;
+	if (spdk_likely(lane != NULL && lane->receiver_id == receiver->id)) {
+		return lane;
+	}
+
+	lane = _RB_ROOT(&sender->msg_send_lanes);
+	while (lane != NULL && lane->receiver_id != receiver->id) {
+		if (receiver->id < lane->receiver_id) {
+			lane = RB_LEFT(lane, node);
+		} else {
+			lane = RB_RIGHT(lane, node);
+		}
+	}
+
+	if (lane == NULL) {
+		pthread_mutex_lock(&g_msg_lane_mutex);
+		lane = msg_lane_create(sender, (struct spdk_thread *)receiver);
+		pthread_mutex_unlock(&g_msg_lane_mutex);
+		if (lane == NULL) {
+			return NULL;
+		}
+	}
+
+	sender->msg_last_lane = lane;
+
+	return lane;
+}
+
+/*
+ * Queues messages on the lane from sender to receiver.  Messages which don't fit
+ * into the lane are kept in its overflow list.  Returns the number of messages
+ * queued, which is less than count only if messages could not be allocated.
+ */
+static uint32_t
+thread_send_msg_lane(struct spdk_thread *sender, const struct spdk_thread *receiver,
+		     spdk_msg_fn fn, void **ctx, uint32_t count)
+{
+	struct spdk_msg_lane *lane;
+	struct spdk_msg *msg;
+	uint32_t sent = 0, tail;
+
+	lane = thread_get_msg_lane(sender, receiver);
+	if (spdk_unlikely(lane == NULL)) {
+		return 0;
+	}
+
+	if (spdk_unlikely(!STAILQ_EMPTY(&lane->overflow))) {
+		msg_lane_flush_overflow(sender, lane);
+	}
+
+	if (spdk_likely(STAILQ_EMPTY(&lane->overflow))) {
+		sent = msg_lane_free_count(lane);
+		sent = spdk_min(count, sent);
+		for (tail = lane->tail; tail != lane->tail + sent; tail++) {
+			lane->entries[tail % SPDK_MSG_LANE_SIZE].fn = fn;
+			lane->entries[tail % SPDK_MSG_LANE_SIZE].arg = ctx[tail - lane->tail];
+		}
+		__atomic_store_n(&lane->tail, tail, __ATOMIC_RELEASE);
+	}
+
+	for (; sent < count; sent++) {
+		msg = thread_alloc_msg(sender);
+		if (spdk_unlikely(msg == NULL)) {
+			break;
+		}
+
+		msg->fn = fn;
+		msg->arg = ctx[sent];
+		if (STAILQ_EMPTY(&lane->overflow)) {
+			TAILQ_INSERT_TAIL(&sender->msg_overflow_lanes, lane, overflow_link);
+			__atomic_store_n(&lane->overflow_pending, true, __ATOMIC_RELEASE);
+		}
+		STAILQ_INSERT_TAIL(&lane->overflow, msg, link);
+	}
+
+	lane->used = true;
+	msg_lane_notify(lane);
+
+	return sent;
+}
+
 int
 spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx)
 {
@@ -1340,23 +3098,19 @@ spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx
 	}
 
 	local_thread = _get_thread();
-
-	msg = NULL;
-	if (local_thread != NULL) {
-		if (local_thread->msg_cache_count > 0) {
-			msg = SLIST_FIRST(&local_thread->msg_cache);
-			assert(msg != NULL);
-			SLIST_REMOVE_HEAD(&local_thread->msg_cache, link);
-			local_thread->msg_cache_count--;
-		}
-	}
-
-	if (msg == NULL) {
-		msg = spdk_mempool_get(g_spdk_msg_mempool);
-		if (!msg) {
+	if (spdk_likely(local_thread != NULL)) {
+		if (spdk_unlikely(thread_send_msg_lane(local_thread, thread, fn, &ctx, 1) != 1)) {
 			SPDK_ERRLOG("msg could not be allocated\n");
 			return -ENOMEM;
 		}
+
+		return thread_send_msg_notification(thread);
+	}
+
+	msg = spdk_mempool_get(g_spdk_msg_mempool);
+	if (!msg) {
+		SPDK_ERRLOG("msg could not be allocated\n");
+		return -ENOMEM;
 	}
 
 	msg->fn = fn;
@@ -1372,6 +3126,51 @@ spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx
 	return thread_send_msg_notification(thread);
 }
 
+uint32_t
+spdk_thread_send_msg_batch(const struct spdk_thread *thread, spdk_msg_fn fn, void **ctx,
+			   uint32_t count)
+{
+	struct spdk_thread *local_thread;
+	struct spdk_msg *msg;
+	uint32_t sent;
+
+	assert(thread != NULL);
+
+	if (spdk_unlikely(thread->state == SPDK_THREAD_STATE_EXITED)) {
+		SPDK_ERRLOG("Thread %s is marked as exited.\n", thread->name);
+		return 0;
+	}
+
+	local_thread = _get_thread();
+	if (spdk_likely(local_thread != NULL)) {
+		sent = thread_send_msg_lane(local_thread, thread, fn, ctx, count);
+	} else {
+		for (sent = 0; sent < count; sent++) {
+			msg = spdk_mempool_get(g_spdk_msg_mempool);
+			if (msg == NULL) {
+				break;
+			}
+
+			msg->fn = fn;
+			msg->arg = ctx[sent];
+			if (spdk_ring_enqueue(thread->messages, (void **)&msg, 1, NULL) != 1) {
+				spdk_mempool_put(g_spdk_msg_mempool, msg);
+				break;
+			}
+		}
+	}
+
+	if (sent < count) {
+		SPDK_ERRLOG("Only %" PRIu32 " of %" PRIu32 " msgs could be sent\n", sent, count);
+	}
+
+	if (sent > 0) {
+		thread_send_msg_notification(thread);
+	}
+
+	return sent;
+}
+
 int
 spdk_thread_send_critical_msg(struct spdk_thread *thread, spdk_msg_fn fn)
 {
@@ -1900,6 +3699,38 @@ spdk_poller_get_stats(struct spdk_poller *poller, struct spdk_poller_stats *stat
 {
 	stats->run_count = poller->run_count;
 	stats->busy_count = poller->busy_count;
+	stats->slow_count = poller->slow_count;
+}
+
+const struct spdk_histogram_data *
+spdk_poller_get_histogram(struct spdk_poller *poller)
+{
+	return poller->histogram;
+}
+
+void
+spdk_poller_enable_histograms(bool enable)
+{
+	g_poller_histograms = enable;
+}
+
+bool
+spdk_poller_histograms_enabled(void)
+{
+	return g_poller_histograms;
+}
+
+void
+spdk_poller_set_slow_threshold(uint64_t threshold_us)
+{
+	g_slow_poller_threshold_us = threshold_us;
+	g_slow_poller_ticks = convert_us_to_ticks(threshold_us);
+}
+
+uint64_t
+spdk_poller_get_slow_threshold(void)
+{
+	return g_slow_poller_threshold_us;
 }
 
 struct spdk_poller *
@@ -1917,13 +3748,13 @@ spdk_thread_get_next_active_poller(struct spdk_poller *prev)
 struct spdk_poller *
 spdk_thread_get_first_timed_poller(struct spdk_thread *thread)
 {
-	return RB_MIN(timed_pollers_tree, &thread->timed_pollers);
+	return timer_wheel_first(&thread->timed_pollers);
 }
 
 struct spdk_poller *
 spdk_thread_get_next_timed_poller(struct spdk_poller *prev)
 {
-	return RB_NEXT(timed_pollers_tree, &thread->timed_pollers, prev);
+	return timer_wheel_next(&prev->thread->timed_pollers, prev);
 }
 
 struct spdk_poller *
@@ -2062,7 +3893,7 @@ spdk_thread_set_interrupt_mode(bool enable_interrupt)
 	}
 
 	/* Set pollers to expected mode */
-	RB_FOREACH_SAFE(poller, timed_pollers_tree, &thread->timed_pollers, tmp) {
+	TIMER_WHEEL_FOREACH_SAFE(poller, &thread->timed_pollers, tmp) {
 		poller_set_interrupt_mode(poller, enable_interrupt);
 	}
 	TAILQ_FOREACH_SAFE(poller, &thread->active_pollers, tailq, tmp) {
@@ -2074,6 +3905,8 @@ spdk_thread_set_interrupt_mode(bool enable_interrupt)
 	}
 
 	thread->in_interrupt = enable_interrupt;
+	/* Let the readers know about the new mode at the end of this poll. */
+	thread->stats_publish_tsc = thread->tsc_last - g_stats_shm_period;
 	return;
 }
 
@@ -2468,6 +4301,11 @@ struct spdk_io_channel_iter {
 
 	struct spdk_thread *orig_thread;
 	spdk_channel_for_each_cpl cpl;
+
+	/* Iterator of the spdk_for_each_channel_parallel() call this channel's iterator belongs to */
+	struct spdk_io_channel_iter *parent;
+	/* Channels of a parallel iteration not done yet, plus one while messages are being sent */
+	uint32_t outstanding;
 };
 
 void *
@@ -2591,6 +4429,117 @@ __pending_unregister(void *arg)
 	spdk_io_device_unregister(dev->io_device, dev->unregister_cb);
 }
 
+static void
+for_each_channel_parallel_put(struct spdk_io_channel_iter *i, int status)
+{
+	struct io_device *dev = i->dev;
+	int expected = 0;
+	int rc __attribute__((unused));
+
+	/* Report the first failure */
+	if (status != 0) {
+		__atomic_compare_exchange_n(&i->status, &expected, status, false,
+					    __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+	}
+
+	if (__atomic_sub_fetch(&i->outstanding, 1, __ATOMIC_ACQ_REL) != 0) {
+		return;
+	}
+
+	pthread_mutex_lock(&g_devlist_mutex);
+	dev->for_each_count--;
+	pthread_mutex_unlock(&g_devlist_mutex);
+
+	rc = spdk_thread_send_msg(i->orig_thread, _call_completion, i);
+	assert(rc == 0);
+
+	pthread_mutex_lock(&g_devlist_mutex);
+	if (dev->pending_unregister && dev->for_each_count == 0) {
+		rc = spdk_thread_send_msg(dev->unregister_thread, __pending_unregister, dev);
+		assert(rc == 0);
+	}
+	pthread_mutex_unlock(&g_devlist_mutex);
+}
+
+void
+spdk_for_each_channel_parallel(void *io_device, spdk_channel_msg fn, void *ctx,
+			       spdk_channel_for_each_cpl cpl)
+{
+	struct spdk_thread *thread;
+	struct spdk_io_channel *ch;
+	struct spdk_io_channel_iter *i, *ch_iter;
+	int rc __attribute__((unused));
+
+	i = calloc(1, sizeof(*i));
+	if (!i) {
+		SPDK_ERRLOG("Unable to allocate iterator\n");
+		assert(false);
+		return;
+	}
+
+	i->io_device = io_device;
+	i->fn = fn;
+	i->ctx = ctx;
+	i->cpl = cpl;
+	i->orig_thread = _get_thread();
+	i->outstanding = 1;
+
+	pthread_mutex_lock(&g_devlist_mutex);
+	i->dev = io_device_get(io_device);
+	if (i->dev == NULL) {
+		SPDK_ERRLOG("could not find io_device %p\n", io_device);
+		assert(false);
+		i->status = -ENODEV;
+		goto end;
+	}
+
+	if (i->dev->pending_unregister) {
+		SPDK_ERRLOG("io_device %p has a pending unregister\n", io_device);
+		i->status = -ENODEV;
+		goto end;
+	}
+
+	i->dev->for_each_count++;
+
+	TAILQ_FOREACH(thread, &g_threads, tailq) {
+		ch = thread_get_io_channel(thread, i->dev);
+		if (ch == NULL) {
+			continue;
+		}
+
+		ch_iter = calloc(1, sizeof(*ch_iter));
+		if (!ch_iter) {
+			SPDK_ERRLOG("Unable to allocate iterator\n");
+			i->status = -ENOMEM;
+			break;
+		}
+
+		ch_iter->io_device = io_device;
+		ch_iter->dev = i->dev;
+		ch_iter->fn = fn;
+		ch_iter->ctx = ctx;
+		ch_iter->ch = ch;
+		ch_iter->cur_thread = thread;
+		ch_iter->orig_thread = i->orig_thread;
+		ch_iter->parent = i;
+
+		__atomic_add_fetch(&i->outstanding, 1, __ATOMIC_RELAXED);
+		rc = spdk_thread_send_msg(thread, _call_channel, ch_iter);
+		assert(rc == 0);
+	}
+
+	pthread_mutex_unlock(&g_devlist_mutex);
+
+	for_each_channel_parallel_put(i, 0);
+	return;
+
+end:
+	pthread_mutex_unlock(&g_devlist_mutex);
+
+	rc = spdk_thread_send_msg(i->orig_thread, _call_completion, i);
+	assert(rc == 0);
+}
+
 void
 spdk_for_each_channel_continue(struct spdk_io_channel_iter *i, int status)
 {
@@ -2601,6 +4550,14 @@ spdk_for_each_channel_continue(struct spdk_io_channel_iter *i, int status)
 
 	assert(i->cur_thread == spdk_get_thread());
 
+	if (i->parent != NULL) {
+		struct spdk_io_channel_iter *parent = i->parent;
+
+		free(i);
+		for_each_channel_parallel_put(parent, status);
+		return;
+	}
+
 	i->status = status;
 
 	pthread_mutex_lock(&g_devlist_mutex);
@@ -131,6 +131,8 @@ static struct spdk_bdev_nvme_opts g_opts = {
 	.transport_tos = 0,
 	.nvme_error_stat = false,
 	.io_path_stat = false,
+	.enable_identify_cache = false,
+	.enable_warm_reconnect = false,
 };
 
 #define NVME_HOTPLUG_POLL_PERIOD_MAX			10000000ULL
@@ -190,6 +192,7 @@ static int bdev_nvme_reset(struct nvme_ctrlr *nvme_ctrlr);
 static int bdev_nvme_failover(struct nvme_ctrlr *nvme_ctrlr, bool remove);
 static void remove_cb(void *cb_ctx, struct spdk_nvme_ctrlr *ctrlr);
 static int nvme_ctrlr_read_ana_log_page(struct nvme_ctrlr *nvme_ctrlr);
+static int nvme_ctrlr_read_plm_log_page(struct nvme_ctrlr *nvme_ctrlr);
 
 static struct nvme_ns *nvme_ns_alloc(void);
 static void nvme_ns_free(struct nvme_ns *ns);
@@ -417,6 +420,7 @@ _nvme_ctrlr_delete(struct nvme_ctrlr *nvme_ctrlr)
 
 	free(nvme_ctrlr->copied_ana_desc);
 	spdk_free(nvme_ctrlr->ana_log_page);
+	free(nvme_ctrlr->plm_log_page);
 
 	if (nvme_ctrlr->opal_dev) {
 		spdk_opal_dev_destruct(nvme_ctrlr->opal_dev);
@@ -535,6 +539,10 @@ nvme_ctrlr_can_be_unregistered(struct nvme_ctrlr *nvme_ctrlr)
 		return false;
 	}
 
+	if (nvme_ctrlr->plm_log_page_updating) {
+		return false;
+	}
+
 	if (nvme_ctrlr->io_path_cache_clearing) {
 		return false;
 	}
@@ -880,6 +888,21 @@ nvme_ctrlr_is_available(struct nvme_ctrlr *nvme_ctrlr)
 	return true;
 }
 
+/* A namespace whose NVM set is in the non-deterministic window of Predictable Latency
+ * Mode is ranked like an ANA non-optimized path, so that paths with deterministic
+ * latency are preferred while one is available.
+ */
+static inline enum spdk_nvme_ana_state
+nvme_ns_get_path_state(struct nvme_ns *nvme_ns)
+{
+	if (spdk_unlikely(nvme_ns->plm_window == SPDK_NVME_PLM_WINDOW_NDWIN) &&
+	    nvme_ns->ana_state == SPDK_NVME_ANA_OPTIMIZED_STATE) {
+		return SPDK_NVME_ANA_NON_OPTIMIZED_STATE;
+	}
+
+	return nvme_ns->ana_state;
+}
+
 /* Simulate circular linked list. */
 static inline struct nvme_io_path *
 nvme_io_path_get_next(struct nvme_bdev_channel *nbdev_ch, struct nvme_io_path *prev_path)
@@ -907,7 +930,7 @@ _bdev_nvme_find_io_path(struct nvme_bdev_channel *nbdev_ch)
 	do {
 		if (spdk_likely(nvme_io_path_is_connected(io_path) &&
 				!io_path->nvme_ns->ana_state_updating)) {
-			switch (io_path->nvme_ns->ana_state) {
+			switch (nvme_ns_get_path_state(io_path->nvme_ns)) {
 			case SPDK_NVME_ANA_OPTIMIZED_STATE:
 				nbdev_ch->current_io_path = io_path;
 				return io_path;
@@ -952,7 +975,7 @@ _bdev_nvme_find_io_path_min_qd(struct nvme_bdev_channel *nbdev_ch)
 		}
 
 		num_outstanding_reqs = spdk_nvme_qpair_get_num_outstanding_reqs(io_path->qpair->qpair);
-		switch (io_path->nvme_ns->ana_state) {
+		switch (nvme_ns_get_path_state(io_path->nvme_ns)) {
 		case SPDK_NVME_ANA_OPTIMIZED_STATE:
 			if (num_outstanding_reqs < opt_min_qd) {
 				opt_min_qd = num_outstanding_reqs;
@@ -1943,6 +1966,13 @@ _bdev_nvme_reset_complete(struct spdk_io_channel_iter *i, int status)
 		reset_cb_fn(reset_cb_arg, success);
 	}
 
+	/* The window may have changed while disconnected, or the active path may now
+	 * lead to another controller.
+	 */
+	if (success && op_after_reset == OP_NONE && nvme_ctrlr->plm_log_page != NULL) {
+		nvme_ctrlr_read_plm_log_page(nvme_ctrlr);
+	}
+
 	switch (op_after_reset) {
 	case OP_COMPLETE_PENDING_DESTRUCT:
 		nvme_ctrlr_unregister(nvme_ctrlr);
@@ -2860,6 +2890,19 @@ bdev_nvme_get_module_ctx(void *ctx)
 	return nvme_ns->ns;
 }
 
+static const char *
+_nvme_plm_window_str(uint8_t plm_window)
+{
+	switch (plm_window) {
+	case SPDK_NVME_PLM_WINDOW_DTWIN:
+		return "deterministic";
+	case SPDK_NVME_PLM_WINDOW_NDWIN:
+		return "non_deterministic";
+	default:
+		return "reserved";
+	}
+}
+
 static const char *
 _nvme_ana_state_str(enum spdk_nvme_ana_state ana_state)
 {
@@ -3064,6 +3107,12 @@ nvme_namespace_info_json(struct spdk_json_write_ctx *w,
 					     _nvme_ana_state_str(nvme_ns->ana_state));
 	}
 
+	if (nvme_ns->plm_window != 0) {
+		spdk_json_write_named_uint32(w, "nvm_set_id", nsdata->nvmsetid);
+		spdk_json_write_named_string(w, "plm_window",
+					     _nvme_plm_window_str(nvme_ns->plm_window));
+	}
+
 	spdk_json_write_named_bool(w, "can_share", nsdata->nmic.can_share);
 
 	spdk_json_write_object_end(w);
@@ -3468,8 +3517,14 @@ nvme_disk_create(struct spdk_bdev *disk, const char *base_name,
 	}
 
 	if (cdata->oncs.copy) {
-		/* For now bdev interface allows only single segment copy */
+		/* For now bdev interface allows only single segment copy, so the
+		 * limit is the smaller of the single range length and the total
+		 * copy length.  A zero value means that field imposes no limit.
+		 */
 		disk->max_copy = nsdata->mssrl;
+		if (nsdata->mcl != 0 && (disk->max_copy == 0 || nsdata->mcl < disk->max_copy)) {
+			disk->max_copy = nsdata->mcl;
+		}
 	}
 
 	disk->ctxt = ctx;
@@ -3836,6 +3891,10 @@ nvme_ctrlr_populate_namespace(struct nvme_ctrlr *nvme_ctrlr, struct nvme_ns *nvm
 		bdev_nvme_parse_ana_log_page(nvme_ctrlr, nvme_ns_set_ana_state, nvme_ns);
 	}
 
+	if (nvme_ctrlr->plm_log_page != NULL && spdk_nvme_ns_get_data(ns)->nvmsetid != 0) {
+		nvme_ctrlr_read_plm_log_page(nvme_ctrlr);
+	}
+
 	bdev = nvme_bdev_ctrlr_get_bdev(nvme_ctrlr->nbdev_ctrlr, nvme_ns->id);
 	if (bdev == NULL) {
 		rc = nvme_bdev_create(nvme_ctrlr, nvme_ns);
@@ -4160,6 +4219,170 @@ nvme_ctrlr_read_ana_log_page(struct nvme_ctrlr *nvme_ctrlr)
 	return rc;
 }
 
+static uint16_t
+nvme_ctrlr_get_next_nvmsetid(struct nvme_ctrlr *nvme_ctrlr, uint16_t prev_nvmsetid)
+{
+	struct nvme_ns *nvme_ns;
+	uint16_t nvmsetid, next_nvmsetid = 0;
+
+	for (nvme_ns = nvme_ctrlr_get_first_active_ns(nvme_ctrlr);
+	     nvme_ns != NULL;
+	     nvme_ns = nvme_ctrlr_get_next_active_ns(nvme_ctrlr, nvme_ns)) {
+		if (nvme_ns->ns == NULL) {
+			continue;
+		}
+
+		nvmsetid = spdk_nvme_ns_get_data(nvme_ns->ns)->nvmsetid;
+		if (nvmsetid > prev_nvmsetid && (next_nvmsetid == 0 || nvmsetid < next_nvmsetid)) {
+			next_nvmsetid = nvmsetid;
+		}
+	}
+
+	return next_nvmsetid;
+}
+
+static void
+nvme_ctrlr_set_plm_window(struct nvme_ctrlr *nvme_ctrlr, uint16_t nvmsetid, uint8_t plm_window)
+{
+	struct nvme_ns *nvme_ns;
+
+	for (nvme_ns = nvme_ctrlr_get_first_active_ns(nvme_ctrlr);
+	     nvme_ns != NULL;
+	     nvme_ns = nvme_ctrlr_get_next_active_ns(nvme_ctrlr, nvme_ns)) {
+		if (nvme_ns->ns != NULL && spdk_nvme_ns_get_data(nvme_ns->ns)->nvmsetid == nvmsetid) {
+			nvme_ns->plm_window = plm_window;
+		}
+	}
+}
+
+static void
+nvme_ctrlr_read_plm_log_page_finish(struct nvme_ctrlr *nvme_ctrlr)
+{
+	bool pending;
+
+	pthread_mutex_lock(&nvme_ctrlr->mutex);
+
+	assert(nvme_ctrlr->plm_log_page_updating == true);
+	nvme_ctrlr->plm_log_page_updating = false;
+
+	if (nvme_ctrlr_can_be_unregistered(nvme_ctrlr)) {
+		pthread_mutex_unlock(&nvme_ctrlr->mutex);
+
+		nvme_ctrlr_unregister(nvme_ctrlr);
+		return;
+	}
+
+	pending = nvme_ctrlr->plm_log_page_pending;
+	nvme_ctrlr->plm_log_page_pending = false;
+	pthread_mutex_unlock(&nvme_ctrlr->mutex);
+
+	bdev_nvme_clear_io_path_caches(nvme_ctrlr);
+
+	if (pending) {
+		nvme_ctrlr_read_plm_log_page(nvme_ctrlr);
+	}
+}
+
+static void nvme_ctrlr_read_plm_set_log_page_done(void *ctx, const struct spdk_nvme_cpl *cpl);
+
+static void
+nvme_ctrlr_read_next_plm_set_log_page(struct nvme_ctrlr *nvme_ctrlr)
+{
+	int rc;
+
+	while (true) {
+		nvme_ctrlr->plm_nvmsetid = nvme_ctrlr_get_next_nvmsetid(nvme_ctrlr,
+					   nvme_ctrlr->plm_nvmsetid);
+		if (nvme_ctrlr->plm_nvmsetid == 0) {
+			break;
+		}
+
+		/* The NVM Set Identifier is the log specific identifier (CDW11 bits 31:16). */
+		rc = spdk_nvme_ctrlr_cmd_get_log_page_ext(nvme_ctrlr->ctrlr,
+				SPDK_NVME_LOG_PREDICATBLE_LATENCY,
+				SPDK_NVME_GLOBAL_NS_TAG,
+				nvme_ctrlr->plm_log_page,
+				sizeof(struct spdk_nvme_plm_page), 0, 0,
+				(uint32_t)nvme_ctrlr->plm_nvmsetid << 16, 0,
+				nvme_ctrlr_read_plm_set_log_page_done,
+				nvme_ctrlr);
+		if (rc == 0) {
+			return;
+		}
+
+		nvme_ctrlr_set_plm_window(nvme_ctrlr, nvme_ctrlr->plm_nvmsetid, 0);
+	}
+
+	nvme_ctrlr_read_plm_log_page_finish(nvme_ctrlr);
+}
+
+static void
+nvme_ctrlr_read_plm_set_log_page_done(void *ctx, const struct spdk_nvme_cpl *cpl)
+{
+	struct nvme_ctrlr *nvme_ctrlr = ctx;
+	struct spdk_nvme_plm_page *plm_page = nvme_ctrlr->plm_log_page;
+	uint8_t plm_window = 0;
+
+	if (spdk_nvme_cpl_is_success(cpl)) {
+		plm_window = plm_page->status.window;
+	}
+
+	nvme_ctrlr_set_plm_window(nvme_ctrlr, nvme_ctrlr->plm_nvmsetid, plm_window);
+
+	nvme_ctrlr_read_next_plm_set_log_page(nvme_ctrlr);
+}
+
+static void
+nvme_ctrlr_read_plm_event_log_page_done(void *ctx, const struct spdk_nvme_cpl *cpl)
+{
+	struct nvme_ctrlr *nvme_ctrlr = ctx;
+
+	/* Reading the event aggregate log page only serves to clear the pending
+	 * events so that new ones are reported.  Refresh all NVM sets in use.
+	 */
+	nvme_ctrlr->plm_nvmsetid = 0;
+	nvme_ctrlr_read_next_plm_set_log_page(nvme_ctrlr);
+}
+
+static int
+nvme_ctrlr_read_plm_log_page(struct nvme_ctrlr *nvme_ctrlr)
+{
+	int rc;
+
+	if (nvme_ctrlr->plm_log_page == NULL) {
+		return -EINVAL;
+	}
+
+	pthread_mutex_lock(&nvme_ctrlr->mutex);
+	if (!nvme_ctrlr_is_available(nvme_ctrlr)) {
+		pthread_mutex_unlock(&nvme_ctrlr->mutex);
+		return -EBUSY;
+	}
+
+	if (nvme_ctrlr->plm_log_page_updating) {
+		nvme_ctrlr->plm_log_page_pending = true;
+		pthread_mutex_unlock(&nvme_ctrlr->mutex);
+		return -EBUSY;
+	}
+
+	nvme_ctrlr->plm_log_page_updating = true;
+	pthread_mutex_unlock(&nvme_ctrlr->mutex);
+
+	rc = spdk_nvme_ctrlr_cmd_get_log_page(nvme_ctrlr->ctrlr,
+					      SPDK_NVME_LOG_PREDICTABLE_LATENCY_EVENT,
+					      SPDK_NVME_GLOBAL_NS_TAG,
+					      nvme_ctrlr->plm_log_page,
+					      nvme_ctrlr->plm_log_page_size, 0,
+					      nvme_ctrlr_read_plm_event_log_page_done,
+					      nvme_ctrlr);
+	if (rc != 0) {
+		nvme_ctrlr->plm_nvmsetid = 0;
+		nvme_ctrlr_read_next_plm_set_log_page(nvme_ctrlr);
+	}
+
+	return 0;
+}
+
 static void
 dummy_bdev_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev, void *ctx)
 {
@@ -4443,6 +4666,9 @@ aer_cb(void *arg, const struct spdk_nvme_cpl *cpl)
 	} else if ((event.bits.async_event_type == SPDK_NVME_ASYNC_EVENT_TYPE_NOTICE) &&
 		   (event.bits.async_event_info == SPDK_NVME_ASYNC_EVENT_ANA_CHANGE)) {
 		nvme_ctrlr_read_ana_log_page(nvme_ctrlr);
+	} else if ((event.bits.async_event_type == SPDK_NVME_ASYNC_EVENT_TYPE_NOTICE) &&
+		   (event.bits.async_event_info == SPDK_NVME_ASYNC_EVENT_PLEAL_CHANGE)) {
+		nvme_ctrlr_read_plm_log_page(nvme_ctrlr);
 	}
 }
 
@@ -4496,6 +4722,32 @@ nvme_ctrlr_init_ana_log_page_done(void *_ctx, const struct spdk_nvme_cpl *cpl)
 	nvme_ctrlr_create_done(nvme_ctrlr, ctx);
 }
 
+static int
+nvme_ctrlr_init_plm_log_page(struct nvme_ctrlr *nvme_ctrlr)
+{
+	const struct spdk_nvme_ctrlr_data *cdata;
+	uint32_t plm_log_page_size;
+
+	cdata = spdk_nvme_ctrlr_get_data(nvme_ctrlr->ctrlr);
+
+	/* The same buffer holds the per NVM set log page and the event aggregate log
+	 * page, which lists up to NSETIDMAX NVM sets.
+	 */
+	plm_log_page_size = sizeof(struct spdk_nvme_plm_event_aggregate_page) +
+			    SPDK_ALIGN_CEIL(cdata->nsetidmax * sizeof(uint16_t), sizeof(uint32_t));
+	plm_log_page_size = spdk_max(plm_log_page_size, sizeof(struct spdk_nvme_plm_page));
+
+	nvme_ctrlr->plm_log_page = calloc(1, plm_log_page_size);
+	if (nvme_ctrlr->plm_log_page == NULL) {
+		SPDK_ERRLOG("could not allocate predictable latency log page buffer\n");
+		return -ENOMEM;
+	}
+
+	nvme_ctrlr->plm_log_page_size = plm_log_page_size;
+
+	return 0;
+}
+
 static int
 nvme_ctrlr_init_ana_log_page(struct nvme_ctrlr *nvme_ctrlr,
 			     struct nvme_async_probe_ctx *ctx)
@@ -4708,6 +4960,13 @@ nvme_ctrlr_create(struct spdk_nvme_ctrlr *ctrlr,
 
 	cdata = spdk_nvme_ctrlr_get_data(ctrlr);
 
+	if (cdata->ctratt.predictable_latency_mode) {
+		rc = nvme_ctrlr_init_plm_log_page(nvme_ctrlr);
+		if (rc != 0) {
+			goto err;
+		}
+	}
+
 	if (cdata->cmic.ana_reporting) {
 		rc = nvme_ctrlr_init_ana_log_page(nvme_ctrlr, ctx);
 		if (rc == 0) {
@@ -5307,6 +5566,8 @@ bdev_nvme_create(struct spdk_nvme_transport_id *trid,
 	ctx->drv_opts.keep_alive_timeout_ms = g_opts.keep_alive_timeout_ms;
 	ctx->drv_opts.disable_read_ana_log_page = true;
 	ctx->drv_opts.transport_tos = g_opts.transport_tos;
+	ctx->drv_opts.enable_identify_cache = g_opts.enable_identify_cache;
+	ctx->drv_opts.enable_warm_reconnect = g_opts.enable_warm_reconnect;
 
 	if (nvme_bdev_ctrlr_get_by_name(base_name) == NULL || multipath) {
 		attach_cb = connect_attach_cb;
@@ -7215,6 +7476,8 @@ bdev_nvme_opts_config_json(struct spdk_json_write_ctx *w)
 	spdk_json_write_named_bool(w, "generate_uuids", g_opts.generate_uuids);
 	spdk_json_write_named_uint8(w, "transport_tos", g_opts.transport_tos);
 	spdk_json_write_named_bool(w, "io_path_stat", g_opts.io_path_stat);
+	spdk_json_write_named_bool(w, "enable_identify_cache", g_opts.enable_identify_cache);
+	spdk_json_write_named_bool(w, "enable_warm_reconnect", g_opts.enable_warm_reconnect);
 	spdk_json_write_object_end(w);
 
 	spdk_json_write_object_end(w);
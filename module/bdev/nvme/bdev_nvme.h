@@ -72,6 +72,8 @@ struct nvme_ns {
 	bool				ana_state_updating;
 	bool				ana_transition_timedout;
 	struct spdk_poller		*anatt_timer;
+	/* Predictable Latency Mode window of the NVM set, 0 if not known or not enabled */
+	uint8_t				plm_window;
 	struct nvme_async_probe_ctx	*probe_ctx;
 	TAILQ_ENTRY(nvme_ns)		tailq;
 	RB_ENTRY(nvme_ns)		node;
@@ -116,6 +118,8 @@ struct nvme_ctrlr {
 	uint32_t				ana_log_page_updating : 1;
 	uint32_t				io_path_cache_clearing : 1;
 	uint32_t				dont_retry : 1;
+	uint32_t				plm_log_page_updating : 1;
+	uint32_t				plm_log_page_pending : 1;
 
 	struct nvme_ctrlr_opts			opts;
 
@@ -147,6 +151,11 @@ struct nvme_ctrlr {
 	struct spdk_nvme_ana_page		*ana_log_page;
 	struct spdk_nvme_ana_group_descriptor	*copied_ana_desc;
 
+	/* Buffer for the predictable latency event aggregate and per NVM set log pages */
+	void					*plm_log_page;
+	uint32_t				plm_log_page_size;
+	uint16_t				plm_nvmsetid;
+
 	struct nvme_async_probe_ctx		*probe_ctx;
 
 	pthread_mutex_t				mutex;
@@ -286,6 +295,8 @@ struct spdk_bdev_nvme_opts {
 	bool nvme_error_stat;
 	uint32_t rdma_srq_size;
 	bool io_path_stat;
+	bool enable_identify_cache;
+	bool enable_warm_reconnect;
 };
 
 struct spdk_nvme_qpair *bdev_nvme_get_io_qpair(struct spdk_io_channel *ctrlr_io_ch);
@@ -452,7 +452,7 @@ bdev_blob_translate_lba(struct spdk_bs_dev *dev, uint64_t lba, uint64_t *base_lb
 }
 
 static void
-blob_bdev_init(struct blob_bdev *b, struct spdk_bdev_desc *desc)
+blob_bdev_init(struct blob_bdev *b, struct spdk_bdev_desc *desc, bool write)
 {
 	struct spdk_bdev *bdev;
 
@@ -474,7 +474,12 @@ blob_bdev_init(struct blob_bdev *b, struct spdk_bdev_desc *desc)
 	b->bs_dev.writev_ext = bdev_blob_writev_ext;
 	b->bs_dev.write_zeroes = bdev_blob_write_zeroes;
 	b->bs_dev.unmap = bdev_blob_unmap;
-	if (spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_COPY)) {
+	/* The bdev layer emulates copy with read/write when the underlying bdev
+	 * does not support it natively, so expose it on every writable device.
+	 * This lets the blobstore offload cluster copies (copy-on-write, inflate,
+	 * decouple) instead of staging each cluster in its own bounce buffer.
+	 */
+	if (write) {
 		b->bs_dev.copy = bdev_blob_copy;
 	}
 	b->bs_dev.get_base_bdev = bdev_blob_get_base_bdev;
@@ -512,7 +517,7 @@ spdk_bdev_create_bs_dev(const char *bdev_name, bool write,
 		return rc;
 	}
 
-	blob_bdev_init(b, desc);
+	blob_bdev_init(b, desc, write);
 
 	*bs_dev = &b->bs_dev;
 	b->write = write;
@@ -73,6 +73,9 @@ static void
 iobuf_write_config_json(struct spdk_json_write_ctx *w)
 {
 	struct spdk_iobuf_opts opts;
+	struct spdk_iobuf_module_opts module_opts;
+	struct spdk_iobuf_module_stats stats;
+	uint32_t i;
 
 	spdk_iobuf_get_opts(&opts);
 
@@ -89,6 +92,36 @@ iobuf_write_config_json(struct spdk_json_write_ctx *w)
 		spdk_json_write_named_uint64(w, "large_pool_count", opts.large_pool_count);
 		spdk_json_write_named_uint32(w, "small_bufsize", opts.small_bufsize);
 		spdk_json_write_named_uint32(w, "large_bufsize", opts.large_bufsize);
+		if (opts.medium_class_count > 0) {
+			spdk_json_write_named_array_begin(w, "medium_classes");
+			for (i = 0; i < opts.medium_class_count; i++) {
+				spdk_json_write_object_begin(w);
+				spdk_json_write_named_uint32(w, "bufsize", opts.medium_classes[i].bufsize);
+				spdk_json_write_named_uint64(w, "pool_count", opts.medium_classes[i].pool_count);
+				spdk_json_write_object_end(w);
+			}
+			spdk_json_write_array_end(w);
+		}
+		spdk_json_write_object_end(w);
+
+		spdk_json_write_object_end(w);
+	}
+
+	for (i = 0; spdk_iobuf_get_module_stats(i, &stats) == 0; i++) {
+		spdk_iobuf_get_module_opts(stats.name, &module_opts);
+		if (module_opts.reserved_percent == 0 && module_opts.max_percent == 0 &&
+		    module_opts.weight == 1) {
+			continue;
+		}
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "method", "iobuf_set_module_options");
+
+		spdk_json_write_named_object_begin(w, "params");
+		spdk_json_write_named_string(w, "name", stats.name);
+		spdk_json_write_named_uint32(w, "reserved_percent", module_opts.reserved_percent);
+		spdk_json_write_named_uint32(w, "max_percent", module_opts.max_percent);
+		spdk_json_write_named_uint32(w, "weight", module_opts.weight);
 		spdk_json_write_object_end(w);
 
 		spdk_json_write_object_end(w);
@@ -4,18 +4,50 @@
  */
 
 #include "spdk/stdinc.h"
+#include "spdk/env.h"
 #include "spdk/thread.h"
 #include "spdk/rpc.h"
 #include "spdk/string.h"
+#include "spdk/util.h"
 #include "spdk_internal/init.h"
 
 int iobuf_set_opts(struct spdk_iobuf_opts *opts);
 
+static const struct spdk_json_object_decoder rpc_iobuf_class_decoders[] = {
+	{"bufsize", offsetof(struct spdk_iobuf_class_opts, bufsize), spdk_json_decode_uint32},
+	{"pool_count", offsetof(struct spdk_iobuf_class_opts, pool_count), spdk_json_decode_uint64},
+};
+
+static int
+rpc_decode_iobuf_class(const struct spdk_json_val *val, void *out)
+{
+	return spdk_json_decode_object(val, rpc_iobuf_class_decoders,
+				       SPDK_COUNTOF(rpc_iobuf_class_decoders), out);
+}
+
+static int
+rpc_decode_iobuf_medium_classes(const struct spdk_json_val *val, void *out)
+{
+	struct spdk_iobuf_opts *opts = SPDK_CONTAINEROF(out, struct spdk_iobuf_opts, medium_classes);
+	size_t count;
+	int rc;
+
+	rc = spdk_json_decode_array(val, rpc_decode_iobuf_class, opts->medium_classes,
+				    SPDK_IOBUF_MAX_MEDIUM_CLASSES, &count,
+				    sizeof(struct spdk_iobuf_class_opts));
+	if (rc == 0) {
+		opts->medium_class_count = count;
+	}
+
+	return rc;
+}
+
 static const struct spdk_json_object_decoder rpc_iobuf_set_options_decoders[] = {
 	{"small_pool_count", offsetof(struct spdk_iobuf_opts, small_pool_count), spdk_json_decode_uint64, true},
 	{"large_pool_count", offsetof(struct spdk_iobuf_opts, large_pool_count), spdk_json_decode_uint64, true},
 	{"small_bufsize", offsetof(struct spdk_iobuf_opts, small_bufsize), spdk_json_decode_uint32, true},
 	{"large_bufsize", offsetof(struct spdk_iobuf_opts, large_bufsize), spdk_json_decode_uint32, true},
+	{"medium_classes", offsetof(struct spdk_iobuf_opts, medium_classes), rpc_decode_iobuf_medium_classes, true},
 };
 
 static void
@@ -42,3 +74,111 @@ rpc_iobuf_set_options(struct spdk_jsonrpc_request *request, const struct spdk_js
 	spdk_jsonrpc_send_bool_response(request, true);
 }
 SPDK_RPC_REGISTER("iobuf_set_options", rpc_iobuf_set_options, SPDK_RPC_STARTUP)
+
+struct rpc_iobuf_set_module_options {
+	char				*name;
+	struct spdk_iobuf_module_opts	opts;
+};
+
+static const struct spdk_json_object_decoder rpc_iobuf_set_module_options_decoders[] = {
+	{"name", offsetof(struct rpc_iobuf_set_module_options, name), spdk_json_decode_string},
+	{"reserved_percent", offsetof(struct rpc_iobuf_set_module_options, opts.reserved_percent), spdk_json_decode_uint32, true},
+	{"max_percent", offsetof(struct rpc_iobuf_set_module_options, opts.max_percent), spdk_json_decode_uint32, true},
+	{"weight", offsetof(struct rpc_iobuf_set_module_options, opts.weight), spdk_json_decode_uint32, true},
+};
+
+static void
+rpc_iobuf_set_module_options(struct spdk_jsonrpc_request *request,
+			     const struct spdk_json_val *params)
+{
+	struct rpc_iobuf_set_module_options req = {};
+	int rc;
+
+	/* Get the name first, so that the options not specified keep their current values */
+	rc = spdk_json_decode_object_relaxed(params, rpc_iobuf_set_module_options_decoders, 1, &req);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	spdk_iobuf_get_module_opts(req.name, &req.opts);
+	free(req.name);
+	req.name = NULL;
+
+	rc = spdk_json_decode_object(params, rpc_iobuf_set_module_options_decoders,
+				     SPDK_COUNTOF(rpc_iobuf_set_module_options_decoders), &req);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = spdk_iobuf_set_module_opts(req.name, &req.opts);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+cleanup:
+	free(req.name);
+}
+SPDK_RPC_REGISTER("iobuf_set_module_options", rpc_iobuf_set_module_options, SPDK_RPC_STARTUP)
+
+static void
+rpc_iobuf_get_stats(struct spdk_jsonrpc_request *request, const struct spdk_json_val *params)
+{
+	struct spdk_json_write_ctx *w;
+	struct spdk_iobuf_class_stats stats;
+	struct spdk_iobuf_module_stats module_stats;
+	uint64_t ticks_per_us = spdk_max(spdk_get_ticks_hz() / SPDK_SEC_TO_USEC, 1);
+	uint32_t i, n, num_classes;
+
+	if (params != NULL) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "iobuf_get_stats requires no parameters");
+		return;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_array_begin(w, "classes");
+	for (i = 0; spdk_iobuf_get_class_stats(i, &stats) == 0; i++) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_uint32(w, "bufsize", stats.bufsize);
+		spdk_json_write_named_array_begin(w, "nodes");
+		for (n = 0; n < stats.num_nodes; n++) {
+			spdk_json_write_object_begin(w);
+			spdk_json_write_named_int32(w, "socket_id", stats.nodes[n].socket_id);
+			spdk_json_write_named_uint64(w, "count", stats.nodes[n].count);
+			spdk_json_write_named_uint64(w, "available", stats.nodes[n].available);
+			spdk_json_write_object_end(w);
+		}
+		spdk_json_write_array_end(w);
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+
+	num_classes = i;
+	spdk_json_write_named_array_begin(w, "modules");
+	for (i = 0; spdk_iobuf_get_module_stats(i, &module_stats) == 0; i++) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "name", module_stats.name);
+		spdk_json_write_named_array_begin(w, "in_use");
+		for (n = 0; n < num_classes; n++) {
+			spdk_json_write_uint64(w, module_stats.in_use[n]);
+		}
+		spdk_json_write_array_end(w);
+		spdk_json_write_named_uint64(w, "wait_count", module_stats.wait_count);
+		spdk_json_write_named_uint64(w, "wait_time_us", module_stats.wait_ticks / ticks_per_us);
+		spdk_json_write_named_uint64(w, "max_wait_time_us",
+					     module_stats.max_wait_ticks / ticks_per_us);
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(request, w);
+}
+SPDK_RPC_REGISTER("iobuf_get_stats", rpc_iobuf_get_stats, SPDK_RPC_RUNTIME)
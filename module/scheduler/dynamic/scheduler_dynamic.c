@@ -16,10 +16,18 @@
 
 static uint32_t g_main_lcore;
 
+/* Physical core ID of a core which SMT siblings are unknown. */
+#define CORE_ID_UNKNOWN UINT32_MAX
+
 struct core_stats {
 	uint64_t busy;
 	uint64_t idle;
 	uint32_t thread_count;
+
+	/* Topology of the core, read once on init. */
+	uint32_t socket_id;
+	uint32_t llc_id;
+	uint32_t phys_core_id;
 };
 
 static struct core_stats *g_cores;
@@ -27,6 +35,33 @@ static struct core_stats *g_cores;
 uint8_t g_scheduler_load_limit = 20;
 uint8_t g_scheduler_core_limit = 80;
 uint8_t g_scheduler_core_busy = 95;
+uint8_t g_scheduler_hysteresis = 5;
+
+/* How far a core is from the one a thread runs on, or from the socket of its devices. */
+enum core_distance {
+	/* Shares the last level cache with the current core. */
+	CORE_DISTANCE_LLC,
+	/* On the preferred socket. */
+	CORE_DISTANCE_SOCKET,
+	/* On any other socket. */
+	CORE_DISTANCE_REMOTE,
+};
+
+/*
+ * Cores considered for an active thread, from the most to the least preferred
+ * ones.  A core next to a busy SMT sibling is only used when no core on the
+ * same socket without one can fit the thread.
+ */
+static const struct {
+	enum core_distance	distance;
+	bool			busy_sibling;
+} g_placement_tiers[] = {
+	{ CORE_DISTANCE_LLC, false },
+	{ CORE_DISTANCE_SOCKET, false },
+	{ CORE_DISTANCE_SOCKET, true },
+	{ CORE_DISTANCE_REMOTE, false },
+	{ CORE_DISTANCE_REMOTE, true },
+};
 
 static uint8_t
 _busy_pct(uint64_t busy, uint64_t idle)
@@ -113,6 +148,101 @@ _move_thread(struct spdk_scheduler_thread_info *thread_info, uint32_t dst_core)
 	thread_info->lcore = dst_core;
 }
 
+static int
+_read_cpu_topology(uint32_t lcore, const char *name, uint32_t *value)
+{
+	char path[PATH_MAX];
+	FILE *f;
+	int rc = 0;
+
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/%s", lcore, name);
+	f = fopen(path, "r");
+	if (f == NULL) {
+		return -errno;
+	}
+
+	if (fscanf(f, "%" SCNu32, value) != 1) {
+		rc = -EINVAL;
+	}
+	fclose(f);
+
+	return rc;
+}
+
+static void
+_init_core_topology(uint32_t lcore)
+{
+	struct core_stats *core = &g_cores[lcore];
+
+	core->socket_id = spdk_env_get_socket_id(lcore);
+
+	if (_read_cpu_topology(lcore, "topology/core_id", &core->phys_core_id) != 0) {
+		core->phys_core_id = CORE_ID_UNKNOWN;
+	}
+
+	/* Without the L3 cache information assume one cache per socket. */
+	if (_read_cpu_topology(lcore, "cache/index3/id", &core->llc_id) != 0) {
+		core->llc_id = core->socket_id;
+	}
+}
+
+static enum core_distance
+_get_core_distance(uint32_t current_lcore, uint32_t socket_id, uint32_t lcore)
+{
+	struct core_stats *current = &g_cores[current_lcore];
+	struct core_stats *core = &g_cores[lcore];
+
+	if (core->socket_id != socket_id) {
+		return CORE_DISTANCE_REMOTE;
+	}
+
+	if (current->socket_id == core->socket_id && current->llc_id == core->llc_id) {
+		return CORE_DISTANCE_LLC;
+	}
+
+	return CORE_DISTANCE_SOCKET;
+}
+
+/*
+ * Checks whether another hardware thread of the same physical core runs active
+ * threads.  The core the thread would be moved from is counted without it.
+ */
+static bool
+_has_busy_sibling(struct spdk_scheduler_thread_info *thread_info, uint32_t lcore)
+{
+	struct core_stats *core = &g_cores[lcore];
+	struct core_stats *sibling;
+	uint64_t busy, idle;
+	uint32_t i, thread_count;
+
+	if (core->phys_core_id == CORE_ID_UNKNOWN) {
+		return false;
+	}
+
+	SPDK_ENV_FOREACH_CORE(i) {
+		sibling = &g_cores[i];
+		if (i == lcore || sibling->socket_id != core->socket_id ||
+		    sibling->phys_core_id != core->phys_core_id) {
+			continue;
+		}
+
+		busy = sibling->busy;
+		idle = sibling->idle;
+		thread_count = sibling->thread_count;
+		if (i == thread_info->lcore) {
+			busy -= spdk_min(busy, thread_info->current_stats.busy_tsc);
+			idle += thread_info->current_stats.busy_tsc;
+			thread_count--;
+		}
+
+		if (thread_count > 0 && _busy_pct(busy, idle) >= g_scheduler_load_limit) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 static bool
 _is_core_at_limit(uint32_t core_id)
 {
@@ -171,19 +301,26 @@ _can_core_fit_thread(struct spdk_scheduler_thread_info *thread_info, uint32_t ds
 	new_idle_tsc = dst->idle - thread_info->current_stats.busy_tsc;
 
 	/* Core cannot fit this thread if it would put it over the
-	 * g_scheduler_core_limit. */
-	return _busy_pct(new_busy_tsc, new_idle_tsc) < g_scheduler_core_limit;
+	 * g_scheduler_core_limit.  Leave a margin of g_scheduler_hysteresis,
+	 * so that the core does not go over the limit and push the thread
+	 * back on the next period after a small change of its load. */
+	return _busy_pct(new_busy_tsc, new_idle_tsc) + g_scheduler_hysteresis <
+	       g_scheduler_core_limit;
 }
 
 static uint32_t
 _find_optimal_core(struct spdk_scheduler_thread_info *thread_info)
 {
-	uint32_t i;
+	uint32_t i, tier;
 	uint32_t current_lcore = thread_info->lcore;
 	uint32_t least_busy_lcore = thread_info->lcore;
+	uint32_t least_busy_local_lcore = thread_info->lcore;
+	uint32_t socket_id;
+	enum core_distance distance, current_distance;
 	struct spdk_thread *thread;
 	struct spdk_cpuset *cpumask;
 	bool core_at_limit = _is_core_at_limit(current_lcore);
+	int thread_socket_id;
 
 	thread = spdk_thread_get_by_id(thread_info->thread_id);
 	if (thread == NULL) {
@@ -191,37 +328,84 @@ _find_optimal_core(struct spdk_scheduler_thread_info *thread_info)
 	}
 	cpumask = spdk_thread_get_cpumask(thread);
 
-	/* Find a core that can fit the thread. */
-	SPDK_ENV_FOREACH_CORE(i) {
-		/* Ignore cores outside cpumask. */
-		if (!spdk_cpuset_get_cpu(cpumask, i)) {
-			continue;
-		}
+	/* Keep the thread close to its devices if it has any, or to the memory
+	 * it has touched so far otherwise. */
+	thread_socket_id = spdk_thread_get_socket_id(thread);
+	if (thread_socket_id != SPDK_ENV_SOCKET_ID_ANY) {
+		socket_id = thread_socket_id;
+	} else {
+		socket_id = g_cores[current_lcore].socket_id;
+	}
+	current_distance = _get_core_distance(current_lcore, socket_id, current_lcore);
+
+	/* Find a core that can fit the thread, going from the closest cores to
+	 * the farthest ones. */
+	for (tier = 0; tier < SPDK_COUNTOF(g_placement_tiers); tier++) {
+		SPDK_ENV_FOREACH_CORE(i) {
+			/* Ignore cores outside cpumask. */
+			if (!spdk_cpuset_get_cpu(cpumask, i)) {
+				continue;
+			}
 
-		/* Search for least busy core. */
-		if (g_cores[i].busy < g_cores[least_busy_lcore].busy) {
-			least_busy_lcore = i;
-		}
+			distance = _get_core_distance(current_lcore, socket_id, i);
+
+			if (tier == 0) {
+				/* Search for least busy core, preferably on the thread's socket. */
+				if (g_cores[i].busy < g_cores[least_busy_lcore].busy) {
+					least_busy_lcore = i;
+				}
+				if (distance != CORE_DISTANCE_REMOTE &&
+				    (g_cores[least_busy_local_lcore].socket_id != socket_id ||
+				     g_cores[i].busy < g_cores[least_busy_local_lcore].busy)) {
+					least_busy_local_lcore = i;
+				}
+			}
 
-		/* Skip cores that cannot fit the thread and current one. */
-		if (!_can_core_fit_thread(thread_info, i) || i == current_lcore) {
-			continue;
-		}
-		if (i == g_main_lcore) {
-			/* First consider g_main_lcore, consolidate threads on main lcore if possible. */
-			return i;
-		} else if (i < current_lcore && current_lcore != g_main_lcore) {
-			/* Lower core id was found, move to consolidate threads on lowest core ids. */
-			return i;
-		} else if (core_at_limit) {
-			/* When core is over the limit, any core id is better than current one. */
-			return i;
+			if (distance > g_placement_tiers[tier].distance) {
+				continue;
+			}
+
+			/* Only a core over the limit justifies moving the thread
+			 * away from the socket it is on. */
+			if (distance == CORE_DISTANCE_REMOTE &&
+			    current_distance != CORE_DISTANCE_REMOTE && !core_at_limit) {
+				continue;
+			}
+
+			/* Skip cores that cannot fit the thread and current one. */
+			if (!_can_core_fit_thread(thread_info, i) || i == current_lcore) {
+				continue;
+			}
+			if (!g_placement_tiers[tier].busy_sibling &&
+			    _has_busy_sibling(thread_info, i)) {
+				continue;
+			}
+			if (i == g_main_lcore) {
+				/* First consider g_main_lcore, consolidate threads on main
+				 * lcore if possible. */
+				return i;
+			} else if (i < current_lcore && current_lcore != g_main_lcore) {
+				/* Lower core id was found, move to consolidate threads on
+				 * lowest core ids. */
+				return i;
+			} else if (core_at_limit) {
+				/* When core is over the limit, any core id is better than
+				 * current one. */
+				return i;
+			} else if (distance < current_distance) {
+				/* The thread runs away from the socket of its devices. */
+				return i;
+			}
 		}
 	}
 
 	/* For cores over the limit, place the thread on least busy core
-	 * to balance threads. */
+	 * to balance threads, on the same socket if possible. */
 	if (core_at_limit) {
+		if (least_busy_local_lcore != current_lcore &&
+		    g_cores[least_busy_local_lcore].socket_id == socket_id) {
+			return least_busy_local_lcore;
+		}
 		return least_busy_lcore;
 	}
 
@@ -232,6 +416,8 @@ _find_optimal_core(struct spdk_scheduler_thread_info *thread_info)
 static int
 init(void)
 {
+	uint32_t i;
+
 	g_main_lcore = spdk_env_get_current_core();
 
 	if (spdk_governor_set("dpdk_governor") != 0) {
@@ -244,6 +430,10 @@ init(void)
 		return -ENOMEM;
 	}
 
+	SPDK_ENV_FOREACH_CORE(i) {
+		_init_core_topology(i);
+	}
+
 	if (spdk_scheduler_get_period() == 0) {
 		/* set default scheduling period to one second */
 		spdk_scheduler_set_period(SPDK_SEC_TO_USEC);
@@ -260,10 +450,16 @@ deinit(void)
 	spdk_governor_set(NULL);
 }
 
+/*
+ * A thread has to get g_scheduler_hysteresis below the load limit to be moved
+ * to the main core, and as much over the limit to be moved out of it.  Threads
+ * with a load close to the limit stay where they are, instead of moving back
+ * and forth on every period.
+ */
 static void
 _balance_idle(struct spdk_scheduler_thread_info *thread_info)
 {
-	if (_get_thread_load(thread_info) >= g_scheduler_load_limit) {
+	if (_get_thread_load(thread_info) + g_scheduler_hysteresis >= g_scheduler_load_limit) {
 		return;
 	}
 	/* This thread is idle, move it to the main core. */
@@ -274,8 +470,13 @@ static void
 _balance_active(struct spdk_scheduler_thread_info *thread_info)
 {
 	uint32_t target_lcore;
+	uint32_t load_limit = g_scheduler_load_limit;
 
-	if (_get_thread_load(thread_info) < g_scheduler_load_limit) {
+	if (thread_info->lcore == g_main_lcore) {
+		load_limit += g_scheduler_hysteresis;
+	}
+
+	if (_get_thread_load(thread_info) < load_limit) {
 		return;
 	}
 
@@ -357,12 +558,14 @@ struct json_scheduler_opts {
 	uint8_t load_limit;
 	uint8_t core_limit;
 	uint8_t core_busy;
+	uint8_t hysteresis;
 };
 
 static const struct spdk_json_object_decoder sched_decoders[] = {
 	{"load_limit", offsetof(struct json_scheduler_opts, load_limit), spdk_json_decode_uint8, true},
 	{"core_limit", offsetof(struct json_scheduler_opts, core_limit), spdk_json_decode_uint8, true},
 	{"core_busy", offsetof(struct json_scheduler_opts, core_busy), spdk_json_decode_uint8, true},
+	{"hysteresis", offsetof(struct json_scheduler_opts, hysteresis), spdk_json_decode_uint8, true},
 };
 
 static int
@@ -373,6 +576,7 @@ set_opts(const struct spdk_json_val *opts)
 	scheduler_opts.load_limit = g_scheduler_load_limit;
 	scheduler_opts.core_limit = g_scheduler_core_limit;
 	scheduler_opts.core_busy = g_scheduler_core_busy;
+	scheduler_opts.hysteresis = g_scheduler_hysteresis;
 
 	if (opts != NULL) {
 		if (spdk_json_decode_object_relaxed(opts, sched_decoders,
@@ -382,12 +586,23 @@ set_opts(const struct spdk_json_val *opts)
 		}
 	}
 
+	/* A margin as big as either limit would keep threads from ever being moved. */
+	if (scheduler_opts.hysteresis >= scheduler_opts.load_limit ||
+	    scheduler_opts.hysteresis >= scheduler_opts.core_limit) {
+		SPDK_ERRLOG("Hysteresis %d must be below the load limit %d and the core limit %d\n",
+			    scheduler_opts.hysteresis, scheduler_opts.load_limit,
+			    scheduler_opts.core_limit);
+		return -EINVAL;
+	}
+
 	SPDK_NOTICELOG("Setting scheduler load limit to %d\n", scheduler_opts.load_limit);
 	g_scheduler_load_limit = scheduler_opts.load_limit;
 	SPDK_NOTICELOG("Setting scheduler core limit to %d\n", scheduler_opts.core_limit);
 	g_scheduler_core_limit = scheduler_opts.core_limit;
 	SPDK_NOTICELOG("Setting scheduler core busy to %d\n", scheduler_opts.core_busy);
 	g_scheduler_core_busy = scheduler_opts.core_busy;
+	SPDK_NOTICELOG("Setting scheduler hysteresis to %d\n", scheduler_opts.hysteresis);
+	g_scheduler_hysteresis = scheduler_opts.hysteresis;
 
 	return 0;
 }
@@ -398,6 +613,7 @@ get_opts(struct spdk_json_write_ctx *ctx)
 	spdk_json_write_named_uint8(ctx, "load_limit", g_scheduler_load_limit);
 	spdk_json_write_named_uint8(ctx, "core_limit", g_scheduler_core_limit);
 	spdk_json_write_named_uint8(ctx, "core_busy", g_scheduler_core_busy);
+	spdk_json_write_named_uint8(ctx, "hysteresis", g_scheduler_hysteresis);
 }
 
 static struct spdk_scheduler scheduler_dynamic = {
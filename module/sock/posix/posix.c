@@ -1535,7 +1535,9 @@ posix_sock_readv(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 {
 	struct spdk_posix_sock *sock = __posix_sock(_sock);
 	struct spdk_posix_sock_group_impl *group = __posix_group_impl(sock->base.group_impl);
-	int rc, i;
+	struct iovec riov[IOV_BATCH_SIZE];
+	int rc, i, riovcnt;
+	ssize_t bytes;
 	size_t len;
 
 	if (sock->recv_pipe == NULL) {
@@ -1551,16 +1553,16 @@ posix_sock_readv(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 		}
 	}
 
+	len = 0;
+	for (i = 0; i < iovcnt; i++) {
+		len += iov[i].iov_len;
+	}
+
 	/* If the socket is not in a group, we must assume it always has
 	 * data waiting for us because it is not epolled */
 	if (!sock->pipe_has_data && (group == NULL || sock->socket_has_data)) {
 		/* If the user is receiving a sufficiently large amount of data,
 		 * receive directly to their buffers. */
-		len = 0;
-		for (i = 0; i < iovcnt; i++) {
-			len += iov[i].iov_len;
-		}
-
 		if (len >= MIN_SOCK_PIPE_SIZE) {
 			/* TODO: Should this detect if kernel socket is drained? */
 			if (sock->ssl) {
@@ -1577,7 +1579,31 @@ posix_sock_readv(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 		}
 	}
 
-	return posix_sock_recv_from_pipe(sock, iov, iovcnt);
+	bytes = posix_sock_recv_from_pipe(sock, iov, iovcnt);
+	if (bytes <= 0 || (size_t)bytes == len || len < MIN_SOCK_PIPE_SIZE) {
+		return bytes;
+	}
+
+	/* The pipe only held the beginning of a large read (typically the tail of
+	 * a previous big read into the pipe).  Rather than going through the pipe
+	 * again, receive the rest directly into the user's buffers. */
+	if (sock->pipe_has_data || (group != NULL && !sock->socket_has_data)) {
+		return bytes;
+	}
+
+	riovcnt = sock_iov_advance(riov, iov, iovcnt, bytes);
+	if (riovcnt <= 0) {
+		return bytes;
+	}
+
+	if (sock->ssl) {
+		rc = SSL_readv(sock->ssl, riov, riovcnt);
+	} else {
+		rc = readv(sock->fd, riov, riovcnt);
+	}
+
+	/* Any error will be reported by the next read */
+	return rc > 0 ? bytes + rc : bytes;
 }
 
 static ssize_t
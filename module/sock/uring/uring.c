@@ -957,7 +957,9 @@ static ssize_t
 uring_sock_readv(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 {
 	struct spdk_uring_sock *sock = __uring_sock(_sock);
-	int rc, i;
+	struct iovec riov[IOV_BATCH_SIZE];
+	int rc, i, riovcnt;
+	ssize_t bytes;
 	size_t len;
 
 	if (sock->connection_status < 0) {
@@ -988,7 +990,23 @@ uring_sock_readv(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 		}
 	}
 
-	return uring_sock_recv_from_pipe(sock, iov, iovcnt);
+	bytes = uring_sock_recv_from_pipe(sock, iov, iovcnt);
+	if (bytes <= 0 || (size_t)bytes == len || len < MIN_SOCK_PIPE_SIZE ||
+	    spdk_pipe_reader_bytes_available(sock->recv_pipe) != 0) {
+		return bytes;
+	}
+
+	/* The pipe only held the beginning of a large read.  Receive the rest
+	 * directly into the user's buffers instead of going through the pipe. */
+	riovcnt = sock_iov_advance(riov, iov, iovcnt, bytes);
+	if (riovcnt <= 0) {
+		return bytes;
+	}
+
+	rc = sock_readv(sock->fd, riov, riovcnt);
+
+	/* Any error will be reported by the next read */
+	return rc > 0 ? bytes + rc : bytes;
 }
 
 static ssize_t
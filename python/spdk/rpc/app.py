@@ -28,6 +28,27 @@ def framework_monitor_context_switch(client, enabled=None):
     return client.call('framework_monitor_context_switch', params)
 
 
+def framework_reactor_idle_policy(client, spin_us=None, pause_us=None, max_sleep_us=None):
+    """Query or set the idle policy of the reactors in poll mode.
+
+    Args:
+        spin_us: time in microseconds a reactor keeps busy polling once idle (optional)
+        pause_us: time in microseconds a reactor pauses the CPU between iterations after spinning (optional)
+        max_sleep_us: maximum time in microseconds a reactor sleeps between iterations, 0 to never sleep (optional)
+
+    Returns:
+        Current idle policy (after applying the parameters).
+    """
+    params = {}
+    if spin_us is not None:
+        params['spin_us'] = spin_us
+    if pause_us is not None:
+        params['pause_us'] = pause_us
+    if max_sleep_us is not None:
+        params['max_sleep_us'] = max_sleep_us
+    return client.call('framework_reactor_idle_policy', params)
+
+
 def framework_get_reactors(client):
     """Query list of all reactors.
 
@@ -38,7 +59,7 @@ def framework_get_reactors(client):
 
 
 def framework_set_scheduler(client, name, period=None, load_limit=None, core_limit=None,
-                            core_busy=None):
+                            core_busy=None, hysteresis=None):
     """Select threads scheduler that will be activated and its period.
 
     Args:
@@ -56,6 +77,8 @@ def framework_set_scheduler(client, name, period=None, load_limit=None, core_lim
         params['core_limit'] = core_limit
     if core_busy is not None:
         params['core_busy'] = core_busy
+    if hysteresis is not None:
+        params['hysteresis'] = hysteresis
     return client.call('framework_set_scheduler', params)
 
 
@@ -113,6 +136,25 @@ def thread_get_pollers(client):
     return client.call('thread_get_pollers')
 
 
+def thread_monitor_pollers(client, histograms=None, slow_threshold_us=None):
+    """Query or set poller execution time monitoring.
+
+    Args:
+        histograms: True to collect execution time histograms of pollers, False to stop (optional)
+        slow_threshold_us: execution time in microseconds above which a poller run is counted
+        as slow, 0 to disable (optional)
+
+    Returns:
+        Current poller monitoring settings.
+    """
+    params = {}
+    if histograms is not None:
+        params['histograms'] = histograms
+    if slow_threshold_us is not None:
+        params['slow_threshold_us'] = slow_threshold_us
+    return client.call('thread_monitor_pollers', params)
+
+
 def thread_get_io_channels(client):
     """Query current IO channels.
 
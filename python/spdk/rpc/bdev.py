@@ -550,7 +550,8 @@ def bdev_nvme_set_options(client, action_on_timeout=None, timeout_us=None, timeo
                           delay_cmd_submit=None, transport_retry_count=None, bdev_retry_count=None,
                           transport_ack_timeout=None, ctrlr_loss_timeout_sec=None, reconnect_delay_sec=None,
                           fast_io_fail_timeout_sec=None, disable_auto_failback=None, generate_uuids=None,
-                          transport_tos=None, nvme_error_stat=None, rdma_srq_size=None, io_path_stat=None):
+                          transport_tos=None, nvme_error_stat=None, rdma_srq_size=None, io_path_stat=None,
+                          enable_identify_cache=None, enable_warm_reconnect=None):
     """Set options for the bdev nvme. This is startup command.
 
     Args:
@@ -595,6 +596,8 @@ def bdev_nvme_set_options(client, action_on_timeout=None, timeout_us=None, timeo
         nvme_error_stat: Enable collecting NVMe error counts. (optional)
         rdma_srq_size: Set the size of a shared rdma receive queue. Default: 0 (disabled) (optional)
         io_path_stat: Enable collection I/O path stat of each io path. (optional)
+        enable_identify_cache: Reuse cached namespace identify data when a controller is reset or reconnected. (optional)
+        enable_warm_reconnect: Ask NVMe-oF targets to resume the previous controller when a controller is reset or reconnected. (optional)
 
     """
     params = {}
@@ -675,6 +678,12 @@ def bdev_nvme_set_options(client, action_on_timeout=None, timeout_us=None, timeo
     if io_path_stat is not None:
         params['io_path_stat'] = io_path_stat
 
+    if enable_identify_cache is not None:
+        params['enable_identify_cache'] = enable_identify_cache
+
+    if enable_warm_reconnect is not None:
+        params['enable_warm_reconnect'] = enable_warm_reconnect
+
     return client.call('bdev_nvme_set_options', params)
 
 
@@ -3,7 +3,8 @@
 #  All rights reserved.
 
 
-def iobuf_set_options(client, small_pool_count, large_pool_count, small_bufsize, large_bufsize):
+def iobuf_set_options(client, small_pool_count, large_pool_count, small_bufsize, large_bufsize,
+                      medium_classes=None):
     """Set iobuf pool options.
 
     Args:
@@ -11,6 +12,7 @@ def iobuf_set_options(client, small_pool_count, large_pool_count, small_bufsize,
         large_pool_count: number of large buffers in the global pool
         small_bufsize: size of a small buffer
         large_bufsize: size of a large buffer
+        medium_classes: list of {'bufsize': size, 'pool_count': count} size classes between the small and the large one
     """
     params = {}
 
@@ -22,5 +24,38 @@ def iobuf_set_options(client, small_pool_count, large_pool_count, small_bufsize,
         params['small_bufsize'] = small_bufsize
     if large_bufsize is not None:
         params['large_bufsize'] = large_bufsize
+    if medium_classes is not None:
+        params['medium_classes'] = medium_classes
 
     return client.call('iobuf_set_options', params)
+
+
+def iobuf_set_module_options(client, name, reserved_percent=None, max_percent=None, weight=None):
+    """Set the options of an iobuf pool user.
+
+    Args:
+        name: name of the module
+        reserved_percent: percentage of each buffer pool reserved for the module
+        max_percent: maximum percentage of each buffer pool the module can hold (0 means no limit)
+        weight: share of the released buffers the module gets while several modules are waiting
+    """
+    params = {'name': name}
+
+    if reserved_percent is not None:
+        params['reserved_percent'] = reserved_percent
+    if max_percent is not None:
+        params['max_percent'] = max_percent
+    if weight is not None:
+        params['weight'] = weight
+
+    return client.call('iobuf_set_module_options', params)
+
+
+def iobuf_get_stats(client):
+    """Get occupancy of the iobuf pools, per size class and NUMA node, and usage per module.
+
+    Returns:
+        Buffer size and per-node buffer counts of each size class, buffers held and time spent
+        waiting for buffers by each module.
+    """
+    return client.call('iobuf_get_stats')
@@ -113,6 +113,8 @@ def nvmf_create_transport(client, **params):
         zcopy: Use zero-copy operations if the underlying bdev supports them (optional)
         num_cqe: The number of CQ entries to configure CQ size. Only used when no_srq=true - RDMA specific (optional)
         max_srq_depth: Max number of outstanding I/O per shared receive queue - RDMA specific (optional)
+        initial_srq_depth: Initial number of outstanding I/O per shared receive queue, grown up to max_srq_depth
+        on demand - RDMA specific (optional)
         no_srq: Boolean flag to disable SRQ even for devices that support it - RDMA specific (optional)
         c2h_success: Boolean flag to disable the C2H success optimization - TCP specific (optional)
         dif_insert_or_strip: Boolean flag to enable DIF insert/strip for I/O - TCP specific (optional)
@@ -186,7 +188,8 @@ def nvmf_create_subsystem(client,
                           max_namespaces=0,
                           ana_reporting=False,
                           min_cntlid=1,
-                          max_cntlid=0xffef):
+                          max_cntlid=0xffef,
+                          resume_timeout_ms=None):
     """Construct an NVMe over Fabrics target subsystem.
 
     Args:
@@ -199,6 +202,7 @@ def nvmf_create_subsystem(client,
         ana_reporting: Enable ANA reporting feature. Default: False.
         min_cntlid: Minimum controller ID. Default: 1
         max_cntlid: Maximum controller ID. Default: 0xffef
+        resume_timeout_ms: Time to keep a controller whose host lost its connections, so that the host can resume it (optional). Default: 0
 
 
     Returns:
@@ -232,6 +236,9 @@ def nvmf_create_subsystem(client,
     if max_cntlid is not None:
         params['max_cntlid'] = max_cntlid
 
+    if resume_timeout_ms is not None:
+        params['resume_timeout_ms'] = resume_timeout_ms
+
     return client.call('nvmf_create_subsystem', params)
 
 
@@ -466,6 +473,63 @@ def nvmf_subsystem_remove_host(client, nqn, host, tgt_name=None):
     return client.call('nvmf_subsystem_remove_host', params)
 
 
+def nvmf_subsystem_set_host_qos_limits(client, nqn, host, rw_ios_per_sec=None, rw_mbytes_per_sec=None,
+                                       weight=None, tgt_name=None):
+    """Set READ/WRITE rate limits for a host allowed on a subsystem.
+
+    Args:
+        nqn: Subsystem NQN.
+        host: Host NQN the limits apply to.
+        rw_ios_per_sec: R/W IOs per second limit, 0 means unlimited (optional)
+        rw_mbytes_per_sec: R/W megabytes per second limit, 0 means unlimited (optional)
+        weight: share of the namespace limits, 1 to 100 (optional)
+        tgt_name: name of the parent NVMe-oF target (optional).
+
+    Returns:
+        True or False
+    """
+    params = {'nqn': nqn,
+              'host': host}
+
+    if rw_ios_per_sec is not None:
+        params['rw_ios_per_sec'] = rw_ios_per_sec
+    if rw_mbytes_per_sec is not None:
+        params['rw_mbytes_per_sec'] = rw_mbytes_per_sec
+    if weight is not None:
+        params['weight'] = weight
+    if tgt_name:
+        params['tgt_name'] = tgt_name
+
+    return client.call('nvmf_subsystem_set_host_qos_limits', params)
+
+
+def nvmf_subsystem_set_ns_qos_limits(client, nqn, nsid, rw_ios_per_sec=None, rw_mbytes_per_sec=None,
+                                     tgt_name=None):
+    """Set READ/WRITE rate limits shared by all hosts of a namespace.
+
+    Args:
+        nqn: Subsystem NQN.
+        nsid: Namespace ID the limits apply to.
+        rw_ios_per_sec: R/W IOs per second limit, 0 means unlimited (optional)
+        rw_mbytes_per_sec: R/W megabytes per second limit, 0 means unlimited (optional)
+        tgt_name: name of the parent NVMe-oF target (optional).
+
+    Returns:
+        True or False
+    """
+    params = {'nqn': nqn,
+              'nsid': nsid}
+
+    if rw_ios_per_sec is not None:
+        params['rw_ios_per_sec'] = rw_ios_per_sec
+    if rw_mbytes_per_sec is not None:
+        params['rw_mbytes_per_sec'] = rw_mbytes_per_sec
+    if tgt_name:
+        params['tgt_name'] = tgt_name
+
+    return client.call('nvmf_subsystem_set_ns_qos_limits', params)
+
+
 def nvmf_subsystem_allow_any_host(client, nqn, disable, tgt_name=None):
     """Configure a subsystem to allow any host to connect or to enforce the host NQN list.
 
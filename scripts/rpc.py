@@ -154,6 +154,22 @@ if __name__ == "__main__":
     p.add_argument('-d', '--disable', action='store_true', help='Disable context switch monitoring')
     p.set_defaults(func=framework_monitor_context_switch)
 
+    def framework_reactor_idle_policy(args):
+        print_dict(rpc.app.framework_reactor_idle_policy(args.client,
+                                                         spin_us=args.spin_us,
+                                                         pause_us=args.pause_us,
+                                                         max_sleep_us=args.max_sleep_us))
+
+    p = subparsers.add_parser('framework_reactor_idle_policy',
+                              help='Query or set how idle reactors in poll mode back off from busy polling')
+    p.add_argument('-s', '--spin-us', type=int,
+                   help='Time in microseconds a reactor keeps busy polling once idle')
+    p.add_argument('-p', '--pause-us', type=int,
+                   help='Time in microseconds a reactor pauses the CPU between iterations after spinning')
+    p.add_argument('-m', '--max-sleep-us', type=int,
+                   help='Maximum time in microseconds a reactor sleeps between iterations, 0 to never sleep')
+    p.set_defaults(func=framework_reactor_idle_policy)
+
     def framework_get_reactors(args):
         print_dict(rpc.app.framework_get_reactors(args.client))
 
@@ -167,7 +183,8 @@ if __name__ == "__main__":
                                         period=args.period,
                                         load_limit=args.load_limit,
                                         core_limit=args.core_limit,
-                                        core_busy=args.core_busy)
+                                        core_busy=args.core_busy,
+                                        hysteresis=args.hysteresis)
 
     p = subparsers.add_parser(
         'framework_set_scheduler', help='Select thread scheduler that will be activated and its period (experimental)')
@@ -176,6 +193,7 @@ if __name__ == "__main__":
     p.add_argument('--load-limit', help="Scheduler load limit. Reserved for dynamic scheduler", type=int, required=False)
     p.add_argument('--core-limit', help="Scheduler core limit. Reserved for dynamic scheduler", type=int, required=False)
     p.add_argument('--core-busy', help="Scheduler core busy limit. Reserved for dynamic schedler", type=int, required=False)
+    p.add_argument('--hysteresis', help="Scheduler load hysteresis. Reserved for dynamic scheduler", type=int, required=False)
     p.set_defaults(func=framework_set_scheduler)
 
     def framework_get_scheduler(args):
@@ -566,7 +584,9 @@ if __name__ == "__main__":
                                        transport_tos=args.transport_tos,
                                        nvme_error_stat=args.nvme_error_stat,
                                        rdma_srq_size=args.rdma_srq_size,
-                                       io_path_stat=args.io_path_stat)
+                                       io_path_stat=args.io_path_stat,
+                                       enable_identify_cache=args.enable_identify_cache,
+                                       enable_warm_reconnect=args.enable_warm_reconnect)
 
     p = subparsers.add_parser('bdev_nvme_set_options',
                               help='Set options for the bdev nvme type. This is startup command.')
@@ -644,6 +664,12 @@ if __name__ == "__main__":
     p.add_argument('--io-path-stat',
                    help="""Enable collecting I/O path stat of each io path.""",
                    action='store_true')
+    p.add_argument('--enable-identify-cache',
+                   help="""Reuse cached namespace identify data when a controller is reset or reconnected.""",
+                   action='store_true')
+    p.add_argument('--enable-warm-reconnect',
+                   help="""Ask NVMe-oF targets to resume the previous controller when a controller is reset or reconnected.""",
+                   action='store_true')
 
     p.set_defaults(func=bdev_nvme_set_options)
 
@@ -1219,7 +1245,7 @@ if __name__ == "__main__":
                               help='Set QoS rate limit on a blockdev')
     p.add_argument('name', help='Blockdev name to set QoS. Example: Malloc0')
     p.add_argument('--rw-ios-per-sec',
-                   help='R/W IOs per second limit (>=1000, example: 20000). 0 means unlimited.',
+                   help='R/W IOs per second limit. 0 means unlimited.',
                    type=int, required=False)
     p.add_argument('--rw-mbytes-per-sec',
                    help="R/W megabytes per second limit (>=10, example: 100). 0 means unlimited.",
@@ -2362,6 +2388,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-d', '--num-cqe', help="""The number of CQ entries. Only used when no_srq=true.
     Relevant only for RDMA transport""", type=int)
     p.add_argument('-s', '--max-srq-depth', help='Max number of outstanding I/O per SRQ. Relevant only for RDMA transport', type=int)
+    p.add_argument('--initial-srq-depth', help="""Initial number of outstanding I/O per SRQ, grown up to max_srq_depth
+    on demand. Relevant only for RDMA transport""", type=int)
     p.add_argument('-r', '--no-srq', action='store_true', help='Disable per-thread shared receive queue. Relevant only for RDMA transport')
     p.add_argument('-o', '--c2h-success', action='store_false', help='Disable C2H success optimization. Relevant only for TCP transport')
     p.add_argument('-f', '--dif-insert-or-strip', action='store_true', help='Enable DIF insert/strip. Relevant only for TCP transport')
@@ -2406,7 +2434,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                        max_namespaces=args.max_namespaces,
                                        ana_reporting=args.ana_reporting,
                                        min_cntlid=args.min_cntlid,
-                                       max_cntlid=args.max_cntlid)
+                                       max_cntlid=args.max_cntlid,
+                                       resume_timeout_ms=args.resume_timeout_ms)
 
     p = subparsers.add_parser('nvmf_create_subsystem', help='Create an NVMe-oF subsystem')
     p.add_argument('nqn', help='Subsystem NQN (ASCII)')
@@ -2423,6 +2452,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument("-r", "--ana-reporting", action='store_true', help="Enable ANA reporting feature")
     p.add_argument("-i", "--min_cntlid", help="Minimum controller ID", type=int)
     p.add_argument("-I", "--max_cntlid", help="Maximum controller ID", type=int)
+    p.add_argument("--resume-timeout-ms", help="""Time in ms to keep a controller whose host lost its
+    connections, so that the host can resume it. Default: 0 (destroy it immediately)""", type=int)
     p.set_defaults(func=nvmf_create_subsystem)
 
     def nvmf_delete_subsystem(args):
@@ -2551,6 +2582,47 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-t', '--tgt-name', help='The name of the parent NVMe-oF target (optional)', type=str)
     p.set_defaults(func=nvmf_subsystem_remove_host)
 
+    def nvmf_subsystem_set_host_qos_limits(args):
+        rpc.nvmf.nvmf_subsystem_set_host_qos_limits(args.client,
+                                                    nqn=args.nqn,
+                                                    host=args.host,
+                                                    rw_ios_per_sec=args.rw_ios_per_sec,
+                                                    rw_mbytes_per_sec=args.rw_mbytes_per_sec,
+                                                    weight=args.weight,
+                                                    tgt_name=args.tgt_name)
+
+    p = subparsers.add_parser('nvmf_subsystem_set_host_qos_limits',
+                              help='Set READ/WRITE rate limits for a host of an NVMe-oF subsystem')
+    p.add_argument('nqn', help='NVMe-oF subsystem NQN')
+    p.add_argument('host', help='Host NQN')
+    p.add_argument('--rw-ios-per-sec', help='R/W IOs per second limit. 0 means unlimited.',
+                   type=int)
+    p.add_argument('--rw-mbytes-per-sec', help='R/W megabytes per second limit. 0 means unlimited.',
+                   type=int)
+    p.add_argument('-w', '--weight', help='Share of the namespace limits, 1 to 100. Default: 1.',
+                   type=int)
+    p.add_argument('-t', '--tgt-name', help='The name of the parent NVMe-oF target (optional)', type=str)
+    p.set_defaults(func=nvmf_subsystem_set_host_qos_limits)
+
+    def nvmf_subsystem_set_ns_qos_limits(args):
+        rpc.nvmf.nvmf_subsystem_set_ns_qos_limits(args.client,
+                                                  nqn=args.nqn,
+                                                  nsid=args.nsid,
+                                                  rw_ios_per_sec=args.rw_ios_per_sec,
+                                                  rw_mbytes_per_sec=args.rw_mbytes_per_sec,
+                                                  tgt_name=args.tgt_name)
+
+    p = subparsers.add_parser('nvmf_subsystem_set_ns_qos_limits',
+                              help='Set READ/WRITE rate limits shared by all hosts of a namespace')
+    p.add_argument('nqn', help='NVMe-oF subsystem NQN')
+    p.add_argument('nsid', help='Namespace ID', type=int)
+    p.add_argument('--rw-ios-per-sec', help='R/W IOs per second limit. 0 means unlimited.',
+                   type=int)
+    p.add_argument('--rw-mbytes-per-sec', help='R/W megabytes per second limit. 0 means unlimited.',
+                   type=int)
+    p.add_argument('-t', '--tgt-name', help='The name of the parent NVMe-oF target (optional)', type=str)
+    p.set_defaults(func=nvmf_subsystem_set_ns_qos_limits)
+
     def nvmf_subsystem_allow_any_host(args):
         rpc.nvmf.nvmf_subsystem_allow_any_host(args.client,
                                                nqn=args.nqn,
@@ -3155,6 +3227,26 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
         'thread_get_pollers', help='Display current pollers of all the threads')
     p.set_defaults(func=thread_get_pollers)
 
+    def thread_monitor_pollers(args):
+        histograms = None
+        if args.enable_histograms:
+            histograms = True
+        if args.disable_histograms:
+            histograms = False
+        print_dict(rpc.app.thread_monitor_pollers(args.client,
+                                                  histograms=histograms,
+                                                  slow_threshold_us=args.slow_threshold_us))
+
+    p = subparsers.add_parser('thread_monitor_pollers',
+                              help='Control poller execution time histograms and slow poller detection')
+    p.add_argument('-e', '--enable-histograms', action='store_true',
+                   help='Collect execution time histograms of all pollers')
+    p.add_argument('-d', '--disable-histograms', action='store_true',
+                   help='Stop collecting execution time histograms')
+    p.add_argument('-s', '--slow-threshold-us', type=int,
+                   help='Execution time in microseconds above which a poller run is counted as slow, 0 to disable')
+    p.set_defaults(func=thread_monitor_pollers)
+
     def thread_get_io_channels(args):
         print_dict(rpc.app.thread_get_io_channels(args.client))
 
@@ -3369,18 +3461,47 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.set_defaults(func=bdev_daos_resize)
 
     def iobuf_set_options(args):
+        medium_classes = None
+        if args.medium_classes is not None:
+            medium_classes = []
+            for c in args.medium_classes.split(','):
+                bufsize, pool_count = c.split(':')
+                medium_classes.append({'bufsize': int(bufsize), 'pool_count': int(pool_count)})
         rpc.iobuf.iobuf_set_options(args.client,
                                     small_pool_count=args.small_pool_count,
                                     large_pool_count=args.large_pool_count,
                                     small_bufsize=args.small_bufsize,
-                                    large_bufsize=args.large_bufsize)
+                                    large_bufsize=args.large_bufsize,
+                                    medium_classes=medium_classes)
     p = subparsers.add_parser('iobuf_set_options', help='Set iobuf pool options')
     p.add_argument('--small-pool-count', help='number of small buffers in the global pool', type=int)
     p.add_argument('--large-pool-count', help='number of large buffers in the global pool', type=int)
     p.add_argument('--small-bufsize', help='size of a small buffer', type=int)
     p.add_argument('--large-bufsize', help='size of a large buffer', type=int)
+    p.add_argument('--medium-classes', help="""comma-separated list of bufsize:pool_count size classes
+    between the small and the large one, in increasing order of size, e.g. 16384:2048,65536:512""")
     p.set_defaults(func=iobuf_set_options)
 
+    def iobuf_set_module_options(args):
+        rpc.iobuf.iobuf_set_module_options(args.client,
+                                           name=args.name,
+                                           reserved_percent=args.reserved_percent,
+                                           max_percent=args.max_percent,
+                                           weight=args.weight)
+    p = subparsers.add_parser('iobuf_set_module_options', help='Set the options of an iobuf pool user')
+    p.add_argument('name', help='name of the module, e.g. bdev or accel')
+    p.add_argument('-r', '--reserved-percent', help='percentage of each buffer pool reserved for the module', type=int)
+    p.add_argument('-m', '--max-percent', help='maximum percentage of each buffer pool the module can hold, 0 means no limit',
+                   type=int)
+    p.add_argument('-w', '--weight', help='share of the released buffers the module gets while several modules are waiting',
+                   type=int)
+    p.set_defaults(func=iobuf_set_module_options)
+
+    def iobuf_get_stats(args):
+        print_dict(rpc.iobuf.iobuf_get_stats(args.client))
+    p = subparsers.add_parser('iobuf_get_stats', help='Display occupancy of the iobuf pools and usage per module')
+    p.set_defaults(func=iobuf_get_stats)
+
     def bdev_nvme_start_mdns_discovery(args):
         rpc.bdev.bdev_nvme_start_mdns_discovery(args.client,
                                                 name=args.name,
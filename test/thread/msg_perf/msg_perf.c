@@ -0,0 +1,344 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+/*
+ * Measures the throughput of messages passed between SPDK threads, one thread per
+ * core.  In the many-to-one pattern all threads send to the first one, in the
+ * all-to-all pattern every thread sends to all the others.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/env.h"
+#include "spdk/event.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+#define MAX_BATCH_SIZE		64
+#define MAX_OUTSTANDING		1024
+
+enum msg_perf_pattern {
+	MSG_PERF_MANY_TO_ONE,
+	MSG_PERF_ALL_TO_ALL,
+};
+
+struct msg_perf_thread;
+
+/* Passed as context of the messages from one thread to another. */
+struct msg_perf_pair {
+	struct msg_perf_thread	*sender;
+	/* Only updated by the receiving thread. */
+	uint64_t		received;
+};
+
+struct msg_perf_thread {
+	struct spdk_thread	*thread;
+	struct spdk_poller	*poller;
+	uint32_t		index;
+	uint32_t		next_target;
+	/* Messages sent by this thread and not executed yet. */
+	uint32_t		outstanding;
+	uint64_t		sent;
+};
+
+static enum msg_perf_pattern g_pattern = MSG_PERF_MANY_TO_ONE;
+static int g_batch_size = 1;
+static int g_time_in_sec = 1;
+
+static struct msg_perf_thread *g_threads;
+/* Indexed by sender * g_num_threads + receiver. */
+static struct msg_perf_pair *g_pairs;
+static uint32_t g_num_threads;
+static uint32_t g_num_running;
+static struct spdk_poller *g_timer;
+static bool g_stop;
+static uint64_t g_start_tsc;
+static uint64_t g_end_tsc;
+
+static void
+msg_perf_msg(void *ctx)
+{
+	struct msg_perf_pair *pair = ctx;
+
+	pair->received++;
+	__atomic_sub_fetch(&pair->sender->outstanding, 1, __ATOMIC_RELAXED);
+}
+
+static struct msg_perf_thread *
+msg_perf_next_target(struct msg_perf_thread *sender)
+{
+	uint32_t index;
+
+	if (g_pattern == MSG_PERF_MANY_TO_ONE) {
+		return &g_threads[0];
+	}
+
+	index = sender->next_target++ % (g_num_threads - 1);
+	if (index >= sender->index) {
+		index++;
+	}
+
+	return &g_threads[index];
+}
+
+static void
+msg_perf_thread_exited(void *ctx)
+{
+	if (--g_num_running == 0) {
+		spdk_app_stop(0);
+	}
+}
+
+static void
+msg_perf_thread_exit(void *ctx)
+{
+	spdk_thread_exit(spdk_get_thread());
+	spdk_thread_send_msg(spdk_thread_get_app_thread(), msg_perf_thread_exited, NULL);
+}
+
+static void
+msg_perf_thread_done(void *ctx)
+{
+	uint64_t total = 0, received, tsc_hz, elapsed;
+	uint32_t i, j;
+
+	if (--g_num_running > 0) {
+		return;
+	}
+
+	elapsed = g_end_tsc - g_start_tsc;
+	tsc_hz = spdk_get_ticks_hz();
+
+	printf("\r ======================================\n");
+	for (i = 0; i < g_num_threads; i++) {
+		received = 0;
+		for (j = 0; j < g_num_threads; j++) {
+			received += g_pairs[j * g_num_threads + i].received;
+		}
+		printf("\r thread %2u sent: %12" PRIu64 " received: %12" PRIu64 "\n", i,
+		       g_threads[i].sent, received);
+		total += received;
+	}
+	printf("\r ======================================\n");
+	printf("\r total: %" PRIu64 " msgs, %" PRIu64 " msgs/sec\n", total,
+	       elapsed ? total * tsc_hz / elapsed : 0);
+
+	/* All messages are executed, let the threads go. */
+	g_num_running = g_num_threads;
+	for (i = 0; i < g_num_threads; i++) {
+		spdk_thread_send_msg(g_threads[i].thread, msg_perf_thread_exit, NULL);
+	}
+}
+
+static int
+msg_perf_send(void *arg)
+{
+	struct msg_perf_thread *sender = arg;
+	struct msg_perf_thread *receiver;
+	struct msg_perf_pair *pair;
+	void *ctx[MAX_BATCH_SIZE];
+	uint32_t count, sent, i;
+
+	if (__atomic_load_n(&g_stop, __ATOMIC_RELAXED)) {
+		if (__atomic_load_n(&sender->outstanding, __ATOMIC_RELAXED) == 0) {
+			spdk_poller_unregister(&sender->poller);
+			spdk_thread_send_msg(spdk_thread_get_app_thread(), msg_perf_thread_done, NULL);
+		}
+		return SPDK_POLLER_IDLE;
+	}
+
+	count = MAX_OUTSTANDING - __atomic_load_n(&sender->outstanding, __ATOMIC_RELAXED);
+	count = spdk_min(count, (uint32_t)g_batch_size);
+	if (count == 0) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	receiver = msg_perf_next_target(sender);
+	pair = &g_pairs[sender->index * g_num_threads + receiver->index];
+	__atomic_add_fetch(&sender->outstanding, count, __ATOMIC_RELAXED);
+
+	if (g_batch_size == 1) {
+		sent = spdk_thread_send_msg(receiver->thread, msg_perf_msg, pair) == 0 ? 1 : 0;
+	} else {
+		for (i = 0; i < count; i++) {
+			ctx[i] = pair;
+		}
+		sent = spdk_thread_send_msg_batch(receiver->thread, msg_perf_msg, ctx, count);
+	}
+
+	__atomic_sub_fetch(&sender->outstanding, count - sent, __ATOMIC_RELAXED);
+	sender->sent += sent;
+
+	return sent > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
+static void
+msg_perf_thread_start(void *ctx)
+{
+	struct msg_perf_thread *thread = ctx;
+
+	if (g_pattern == MSG_PERF_MANY_TO_ONE && thread == &g_threads[0]) {
+		/* The receiver only executes messages. */
+		spdk_thread_send_msg(spdk_thread_get_app_thread(), msg_perf_thread_done, NULL);
+		return;
+	}
+
+	thread->poller = SPDK_POLLER_REGISTER(msg_perf_send, thread, 0);
+}
+
+static int
+msg_perf_end(void *arg)
+{
+	spdk_poller_unregister(&g_timer);
+	g_end_tsc = spdk_get_ticks();
+	__atomic_store_n(&g_stop, true, __ATOMIC_RELAXED);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+msg_perf_start(void *arg1)
+{
+	struct spdk_cpuset cpumask;
+	char name[32];
+	uint32_t i = 0, j, core;
+
+	g_num_threads = spdk_env_get_core_count();
+	if (g_num_threads < 2) {
+		fprintf(stderr, "At least two cores are required\n");
+		spdk_app_stop(-EINVAL);
+		return;
+	}
+
+	g_threads = calloc(g_num_threads, sizeof(*g_threads));
+	g_pairs = calloc(g_num_threads * g_num_threads, sizeof(*g_pairs));
+	if (g_threads == NULL || g_pairs == NULL) {
+		fprintf(stderr, "Unable to allocate threads\n");
+		spdk_app_stop(-ENOMEM);
+		return;
+	}
+
+	printf("Running %s messaging on %u threads with batches of %d for %d seconds.\n",
+	       g_pattern == MSG_PERF_MANY_TO_ONE ? "many-to-one" : "all-to-all",
+	       g_num_threads, g_batch_size, g_time_in_sec);
+	fflush(stdout);
+
+	SPDK_ENV_FOREACH_CORE(core) {
+		spdk_cpuset_zero(&cpumask);
+		spdk_cpuset_set_cpu(&cpumask, core, true);
+		snprintf(name, sizeof(name), "msg_perf_%u", core);
+		g_threads[i].thread = spdk_thread_create(name, &cpumask);
+		if (g_threads[i].thread == NULL) {
+			fprintf(stderr, "Unable to create thread on core %u\n", core);
+			spdk_app_stop(-ENOMEM);
+			return;
+		}
+		g_threads[i].index = i;
+		for (j = 0; j < g_num_threads; j++) {
+			g_pairs[i * g_num_threads + j].sender = &g_threads[i];
+		}
+		i++;
+	}
+
+	g_num_running = g_num_threads;
+	g_start_tsc = spdk_get_ticks();
+	g_timer = SPDK_POLLER_REGISTER(msg_perf_end, NULL, g_time_in_sec * SPDK_SEC_TO_USEC);
+
+	for (i = 0; i < g_num_threads; i++) {
+		spdk_thread_send_msg(g_threads[i].thread, msg_perf_thread_start, &g_threads[i]);
+	}
+}
+
+static int
+msg_perf_parse_arg(int ch, char *arg)
+{
+	int tmp;
+
+	if (ch == 'P') {
+		if (strcmp(arg, "many-to-one") == 0) {
+			g_pattern = MSG_PERF_MANY_TO_ONE;
+		} else if (strcmp(arg, "all-to-all") == 0) {
+			g_pattern = MSG_PERF_ALL_TO_ALL;
+		} else {
+			fprintf(stderr, "Unknown pattern %s\n", arg);
+			return -EINVAL;
+		}
+		return 0;
+	}
+
+	tmp = spdk_strtol(optarg, 10);
+	if (tmp < 0) {
+		fprintf(stderr, "Parse failed for the option %c.\n", ch);
+		return tmp;
+	}
+
+	switch (ch) {
+	case 'b':
+		g_batch_size = tmp;
+		break;
+	case 't':
+		g_time_in_sec = tmp;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void
+msg_perf_usage(void)
+{
+	printf(" -P <pattern>           many-to-one or all-to-all\n");
+	printf(" -b <number>            number of messages sent at once\n");
+	printf(" -t <time>              run time in seconds\n");
+}
+
+static int
+msg_perf_verify_params(void)
+{
+	if (g_batch_size <= 0 || g_batch_size > MAX_BATCH_SIZE) {
+		fprintf(stderr, "batch size must be between 1 and %d\n", MAX_BATCH_SIZE);
+		return -EINVAL;
+	}
+
+	if (g_time_in_sec <= 0) {
+		fprintf(stderr, "run time must be positive\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct spdk_app_opts opts;
+	int rc;
+
+	spdk_app_opts_init(&opts, sizeof(opts));
+	opts.name = "msg_perf";
+
+	rc = spdk_app_parse_args(argc, argv, &opts, "P:b:t:", NULL,
+				 msg_perf_parse_arg, msg_perf_usage);
+	if (rc != SPDK_APP_PARSE_ARGS_SUCCESS) {
+		return rc;
+	}
+
+	rc = msg_perf_verify_params();
+	if (rc != 0) {
+		return rc;
+	}
+
+	rc = spdk_app_start(&opts, msg_perf_start, NULL);
+
+	spdk_app_fini();
+
+	free(g_pairs);
+	free(g_threads);
+
+	return rc;
+}
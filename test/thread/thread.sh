@@ -10,10 +10,13 @@ source $rootdir/test/common/autotest_common.sh
 
 run_test "thread_poller_perf" $testdir/poller_perf/poller_perf -b 1000 -l 1 -t 1
 run_test "thread_poller_perf" $testdir/poller_perf/poller_perf -b 1000 -l 0 -t 1
+run_test "thread_msg_perf" $testdir/msg_perf/msg_perf -m 0x3 -P many-to-one -t 1
+run_test "thread_msg_perf" $testdir/msg_perf/msg_perf -m 0x3 -P all-to-all -b 8 -t 1
 
-# spdk_lock.c includes thread.c, which causes problems when registering the same
-# tracepoint for "thread" in the program and shared library. It is sufficient
+# spdk_lock.c and timer_perf.c include thread.c, which causes problems when registering
+# the same tracepoint for "thread" in the program and shared library. It is sufficient
 # to test this only on static builds.
 if [[ "$CONFIG_SHARED" != "y" ]]; then
 	run_test "thread_spdk_lock" $testdir/lock/spdk_lock
+	run_test "thread_timer_perf" $testdir/timer_perf/timer_perf -b 1000 -l 1000 -t 1
 fi
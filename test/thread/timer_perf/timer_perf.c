@@ -0,0 +1,337 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2023 Intel Corporation.
+ *   All rights reserved.
+ */
+
+/*
+ * Compares the timer wheel that keeps the timed pollers of a thread with the
+ * red-black tree it replaced.  Both are driven by a simulated clock, so only
+ * the cost of the data structure itself is measured.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/env.h"
+#include "spdk/event.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+#include "thread/thread.c"
+
+#define MAX_NUM_POLLERS	1000000
+
+struct tree_poller {
+	struct spdk_poller		poller;
+	RB_ENTRY(tree_poller)		node;
+};
+
+static inline int
+tree_poller_compare(struct tree_poller *poller1, struct tree_poller *poller2)
+{
+	/* Equal keys are inserted on the right side, as the thread library did. */
+	if (poller1->poller.next_run_tick < poller2->poller.next_run_tick) {
+		return -1;
+	} else {
+		return 1;
+	}
+}
+
+RB_HEAD(timer_tree, tree_poller);
+RB_GENERATE_STATIC(timer_tree, tree_poller, node, tree_poller_compare);
+
+struct timer_perf_result {
+	uint64_t	insert_tsc;
+	uint64_t	expire_tsc;
+	uint64_t	expire_count;
+	uint64_t	next_expiry_tsc;
+	uint64_t	remove_tsc;
+};
+
+static int g_num_pollers = 1000;
+static int g_max_period_in_usec = 100000;
+static int g_time_in_sec = 1;
+
+static struct tree_poller *g_pollers;
+static uint64_t *g_periods;
+static uint32_t *g_remove_order;
+static uint64_t g_ticks_per_usec;
+static uint64_t g_checksum;
+
+static void
+timer_perf_init_pollers(uint64_t start)
+{
+	uint64_t seed = 1;
+	uint32_t tmp;
+	int i, j;
+
+	for (i = 0; i < g_num_pollers; i++) {
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		g_periods[i] = ((seed >> 33) % g_max_period_in_usec + 1) * g_ticks_per_usec;
+		g_pollers[i].poller.period_ticks = g_periods[i];
+		g_pollers[i].poller.next_run_tick = start + g_periods[i];
+		g_remove_order[i] = i;
+	}
+
+	for (i = g_num_pollers - 1; i > 0; i--) {
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		j = (seed >> 33) % (i + 1);
+		tmp = g_remove_order[i];
+		g_remove_order[i] = g_remove_order[j];
+		g_remove_order[j] = tmp;
+	}
+}
+
+static void
+timer_perf_tree(struct timer_perf_result *result)
+{
+	struct timer_tree tree = RB_INITIALIZER(&tree);
+	struct tree_poller *first = NULL, *poller, *tmp;
+	uint64_t now = 0, end, tsc;
+	int i;
+
+	timer_perf_init_pollers(now);
+
+	tsc = spdk_get_ticks();
+	for (i = 0; i < g_num_pollers; i++) {
+		RB_INSERT(timer_tree, &tree, &g_pollers[i]);
+		if (first == NULL || g_pollers[i].poller.next_run_tick < first->poller.next_run_tick) {
+			first = &g_pollers[i];
+		}
+	}
+	result->insert_tsc = spdk_get_ticks() - tsc;
+
+	end = (uint64_t)g_time_in_sec * SPDK_SEC_TO_USEC * g_ticks_per_usec;
+	tsc = spdk_get_ticks();
+	for (now = g_ticks_per_usec; now <= end; now += g_ticks_per_usec) {
+		poller = first;
+		while (poller != NULL && now >= poller->poller.next_run_tick) {
+			tmp = RB_NEXT(timer_tree, &tree, poller);
+			RB_REMOVE(timer_tree, &tree, poller);
+			if (first == poller) {
+				first = tmp;
+			}
+
+			result->expire_count++;
+			poller->poller.next_run_tick = now + poller->poller.period_ticks;
+			RB_INSERT(timer_tree, &tree, poller);
+			if (first == NULL || poller->poller.next_run_tick < first->poller.next_run_tick) {
+				first = poller;
+			}
+
+			poller = tmp;
+		}
+	}
+	result->expire_tsc = spdk_get_ticks() - tsc;
+
+	/* Next expiry without a cached closest poller. */
+	tsc = spdk_get_ticks();
+	for (i = 0; i < g_num_pollers; i++) {
+		g_checksum += RB_MIN(timer_tree, &tree)->poller.next_run_tick;
+	}
+	result->next_expiry_tsc = spdk_get_ticks() - tsc;
+
+	tsc = spdk_get_ticks();
+	for (i = 0; i < g_num_pollers; i++) {
+		RB_REMOVE(timer_tree, &tree, &g_pollers[g_remove_order[i]]);
+	}
+	result->remove_tsc = spdk_get_ticks() - tsc;
+	assert(RB_EMPTY(&tree));
+}
+
+static void
+timer_perf_wheel(struct timer_perf_result *result)
+{
+	struct timer_wheel *wheel;
+	struct spdk_poller *first = NULL, *poller;
+	uint64_t now = 0, end, tsc;
+	int i;
+
+	wheel = calloc(1, sizeof(*wheel));
+	if (wheel == NULL) {
+		fprintf(stderr, "Unable to allocate timer wheel\n");
+		return;
+	}
+
+	timer_wheel_init(wheel, now);
+	timer_perf_init_pollers(now);
+
+	tsc = spdk_get_ticks();
+	for (i = 0; i < g_num_pollers; i++) {
+		timer_wheel_insert(wheel, &g_pollers[i].poller);
+		if (first == NULL || g_pollers[i].poller.next_run_tick < first->next_run_tick) {
+			first = &g_pollers[i].poller;
+		}
+	}
+	result->insert_tsc = spdk_get_ticks() - tsc;
+
+	end = (uint64_t)g_time_in_sec * SPDK_SEC_TO_USEC * g_ticks_per_usec;
+	tsc = spdk_get_ticks();
+	for (now = g_ticks_per_usec; now <= end; now += g_ticks_per_usec) {
+		if (first == NULL || now < first->next_run_tick) {
+			continue;
+		}
+
+		while ((poller = timer_wheel_expire(wheel, now)) != NULL) {
+			result->expire_count++;
+			poller->next_run_tick = now + poller->period_ticks;
+			timer_wheel_insert(wheel, poller);
+		}
+		first = timer_wheel_min(wheel);
+	}
+	result->expire_tsc = spdk_get_ticks() - tsc;
+
+	tsc = spdk_get_ticks();
+	for (i = 0; i < g_num_pollers; i++) {
+		g_checksum += timer_wheel_min(wheel)->next_run_tick;
+	}
+	result->next_expiry_tsc = spdk_get_ticks() - tsc;
+
+	tsc = spdk_get_ticks();
+	for (i = 0; i < g_num_pollers; i++) {
+		timer_wheel_remove(wheel, &g_pollers[g_remove_order[i]].poller);
+	}
+	result->remove_tsc = spdk_get_ticks() - tsc;
+	assert(timer_wheel_empty(wheel));
+
+	free(wheel);
+}
+
+static void
+timer_perf_print(const char *name, struct timer_perf_result *result)
+{
+	printf("\r %-6s insert: %8.1f (cyc) expire: %8.1f (cyc) next_expiry: %8.1f (cyc) "
+	       "remove: %8.1f (cyc)\n", name,
+	       (double)result->insert_tsc / g_num_pollers,
+	       result->expire_count ? (double)result->expire_tsc / result->expire_count : 0.0,
+	       (double)result->next_expiry_tsc / g_num_pollers,
+	       (double)result->remove_tsc / g_num_pollers);
+}
+
+static void
+timer_perf_start(void *arg1)
+{
+	struct timer_perf_result tree = {}, wheel = {};
+	int rc = 0;
+
+	g_ticks_per_usec = spdk_max(spdk_get_ticks_hz() / SPDK_SEC_TO_USEC, 1);
+
+	g_pollers = calloc(g_num_pollers, sizeof(*g_pollers));
+	g_periods = calloc(g_num_pollers, sizeof(*g_periods));
+	g_remove_order = calloc(g_num_pollers, sizeof(*g_remove_order));
+	if (g_pollers == NULL || g_periods == NULL || g_remove_order == NULL) {
+		fprintf(stderr, "Unable to allocate pollers\n");
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	printf("Running %d timed pollers with periods up to %d microseconds for %d simulated "
+	       "seconds.\n", g_num_pollers, g_max_period_in_usec, g_time_in_sec);
+	fflush(stdout);
+
+	timer_perf_tree(&tree);
+	timer_perf_wheel(&wheel);
+
+	printf("\r ======================================\n");
+	printf("\r expirations: %" PRIu64 "\n", wheel.expire_count);
+	timer_perf_print("tree", &tree);
+	timer_perf_print("wheel", &wheel);
+	printf("\r ======================================\n");
+
+	if (tree.expire_count != wheel.expire_count) {
+		fprintf(stderr, "Tree expired %" PRIu64 " pollers but wheel %" PRIu64 "\n",
+			tree.expire_count, wheel.expire_count);
+		rc = -EIO;
+	}
+
+out:
+	free(g_remove_order);
+	free(g_periods);
+	free(g_pollers);
+
+	spdk_app_stop(rc);
+}
+
+static int
+timer_perf_parse_arg(int ch, char *arg)
+{
+	int tmp;
+
+	tmp = spdk_strtol(optarg, 10);
+	if (tmp < 0) {
+		fprintf(stderr, "Parse failed for the option %c.\n", ch);
+		return tmp;
+	}
+
+	switch (ch) {
+	case 'b':
+		g_num_pollers = tmp;
+		break;
+	case 'l':
+		g_max_period_in_usec = tmp;
+		break;
+	case 't':
+		g_time_in_sec = tmp;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void
+timer_perf_usage(void)
+{
+	printf(" -b <number>            number of timed pollers\n");
+	printf(" -l <period>            maximum poller period in usec\n");
+	printf(" -t <time>              simulated time in seconds\n");
+}
+
+static int
+timer_perf_verify_params(void)
+{
+	if (g_num_pollers <= 0 || g_num_pollers > MAX_NUM_POLLERS) {
+		fprintf(stderr, "number of pollers must be between 1 and %d\n", MAX_NUM_POLLERS);
+		return -EINVAL;
+	}
+
+	if (g_max_period_in_usec <= 0) {
+		fprintf(stderr, "maximum period must be positive\n");
+		return -EINVAL;
+	}
+
+	if (g_time_in_sec <= 0) {
+		fprintf(stderr, "simulated time must be positive\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct spdk_app_opts opts;
+	int rc;
+
+	spdk_app_opts_init(&opts, sizeof(opts));
+	opts.name = "timer_perf";
+
+	rc = spdk_app_parse_args(argc, argv, &opts, "b:l:t:", NULL,
+				 timer_perf_parse_arg, timer_perf_usage);
+	if (rc != SPDK_APP_PARSE_ARGS_SUCCESS) {
+		return rc;
+	}
+
+	rc = timer_perf_verify_params();
+	if (rc != 0) {
+		return rc;
+	}
+
+	rc = spdk_app_start(&opts, timer_perf_start, NULL);
+
+	spdk_app_fini();
+
+	return rc;
+}
@@ -895,6 +895,29 @@ spdk_nvme_ctrlr_cmd_get_log_page(struct spdk_nvme_ctrlr *ctrlr,
 				      cb_fn, cb_arg);
 }
 
+/* PLM window reported for each NVM set, indexed by the NVM set identifier. */
+static uint8_t g_ut_plm_window[4];
+
+int
+spdk_nvme_ctrlr_cmd_get_log_page_ext(struct spdk_nvme_ctrlr *ctrlr, uint8_t log_page,
+				     uint32_t nsid, void *payload, uint32_t payload_size,
+				     uint64_t offset, uint32_t cdw10, uint32_t cdw11,
+				     uint32_t cdw14, spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	struct spdk_nvme_plm_page *plm_page = payload;
+	uint16_t nvmsetid = cdw11 >> 16;
+
+	if (log_page == SPDK_NVME_LOG_PREDICATBLE_LATENCY) {
+		SPDK_CU_ASSERT_FATAL(nvmsetid < SPDK_COUNTOF(g_ut_plm_window));
+		SPDK_CU_ASSERT_FATAL(payload_size >= sizeof(*plm_page));
+		memset(plm_page, 0, sizeof(*plm_page));
+		plm_page->status.window = g_ut_plm_window[nvmsetid];
+	}
+
+	return ut_submit_nvme_request(NULL, &ctrlr->adminq, SPDK_NVME_OPC_GET_LOG_PAGE,
+				      cb_fn, cb_arg);
+}
+
 int
 spdk_nvme_ctrlr_cmd_admin_raw(struct spdk_nvme_ctrlr *ctrlr,
 			      struct spdk_nvme_cmd *cmd, void *buf, uint32_t len,
@@ -4234,6 +4257,29 @@ test_find_io_path(void)
 	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path1);
 
 	nbdev_ch.current_io_path = NULL;
+
+	/* Test if io_path whose NVM set is in the non-deterministic window of
+	 * Predictable Latency Mode is ranked like ANA non-optimized state.
+	 */
+
+	nvme_ns1.ana_state = SPDK_NVME_ANA_OPTIMIZED_STATE;
+	nvme_ns1.plm_window = SPDK_NVME_PLM_WINDOW_NDWIN;
+	nvme_ns2.ana_state = SPDK_NVME_ANA_OPTIMIZED_STATE;
+	nvme_ns2.plm_window = SPDK_NVME_PLM_WINDOW_DTWIN;
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path2);
+
+	nbdev_ch.current_io_path = NULL;
+
+	nvme_ns2.plm_window = SPDK_NVME_PLM_WINDOW_NDWIN;
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path1);
+
+	nbdev_ch.current_io_path = NULL;
+
+	nvme_ns1.plm_window = SPDK_NVME_PLM_WINDOW_DTWIN;
+	nvme_ns2.plm_window = 0;
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path1);
+
+	nbdev_ch.current_io_path = NULL;
 }
 
 static void
@@ -4851,6 +4897,127 @@ test_concurrent_read_ana_log_page(void)
 	CU_ASSERT(nvme_ctrlr_get_by_name("nvme0") == NULL);
 }
 
+static void
+ut_poll_adminq(int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		spdk_delay_us(g_opts.nvme_adminq_poll_period_us);
+		poll_threads();
+	}
+}
+
+static void
+test_read_plm_log_page(void)
+{
+	struct spdk_nvme_transport_id trid = {};
+	struct spdk_nvme_ctrlr *ctrlr;
+	struct nvme_ctrlr *nvme_ctrlr;
+	struct nvme_ns *nvme_ns1, *nvme_ns2, *nvme_ns3;
+	const int STRING_SIZE = 32;
+	const char *attached_names[STRING_SIZE];
+	int rc;
+
+	memset(attached_names, 0, sizeof(char *) * STRING_SIZE);
+	ut_init_trid(&trid);
+
+	set_thread(0);
+
+	ctrlr = ut_attach_ctrlr(&trid, 3, false, false);
+	SPDK_CU_ASSERT_FATAL(ctrlr != NULL);
+
+	ctrlr->cdata.ctratt.predictable_latency_mode = 1;
+	ctrlr->cdata.nsetidmax = 3;
+	ctrlr->nsdata[0].nvmsetid = 1;
+	ctrlr->nsdata[1].nvmsetid = 2;
+	ctrlr->nsdata[2].nvmsetid = 0;
+	g_ut_plm_window[1] = SPDK_NVME_PLM_WINDOW_DTWIN;
+	g_ut_plm_window[2] = SPDK_NVME_PLM_WINDOW_NDWIN;
+
+	g_ut_attach_ctrlr_status = 0;
+	g_ut_attach_bdev_count = 3;
+
+	rc = bdev_nvme_create(&trid, "nvme0", attached_names, STRING_SIZE,
+			      attach_ctrlr_done, NULL, NULL, NULL, false);
+	CU_ASSERT(rc == 0);
+
+	spdk_delay_us(1000);
+	poll_threads();
+	ut_poll_adminq(8);
+
+	nvme_ctrlr = nvme_ctrlr_get_by_name("nvme0");
+	SPDK_CU_ASSERT_FATAL(nvme_ctrlr != NULL);
+	SPDK_CU_ASSERT_FATAL(nvme_ctrlr->plm_log_page != NULL);
+	nvme_ns1 = nvme_ctrlr_get_ns(nvme_ctrlr, 1);
+	nvme_ns2 = nvme_ctrlr_get_ns(nvme_ctrlr, 2);
+	nvme_ns3 = nvme_ctrlr_get_ns(nvme_ctrlr, 3);
+	SPDK_CU_ASSERT_FATAL(nvme_ns1 != NULL && nvme_ns2 != NULL && nvme_ns3 != NULL);
+
+	/* The windows of the NVM sets are read when the namespaces are populated. */
+	CU_ASSERT(nvme_ctrlr->plm_log_page_updating == false);
+	CU_ASSERT(ctrlr->adminq.num_outstanding_reqs == 0);
+	CU_ASSERT(nvme_ns1->plm_window == SPDK_NVME_PLM_WINDOW_DTWIN);
+	CU_ASSERT(nvme_ns2->plm_window == SPDK_NVME_PLM_WINDOW_NDWIN);
+	CU_ASSERT(nvme_ns3->plm_window == 0);
+
+	/* The event aggregate log page is read first, then each NVM set in use. */
+	g_ut_plm_window[1] = SPDK_NVME_PLM_WINDOW_NDWIN;
+	rc = nvme_ctrlr_read_plm_log_page(nvme_ctrlr);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(nvme_ctrlr->plm_log_page_updating == true);
+	CU_ASSERT(ctrlr->adminq.num_outstanding_reqs == 1);
+
+	/* A read while one is in progress is done once the current one completes. */
+	rc = nvme_ctrlr_read_plm_log_page(nvme_ctrlr);
+	CU_ASSERT(rc == -EBUSY);
+	CU_ASSERT(nvme_ctrlr->plm_log_page_pending == true);
+	CU_ASSERT(ctrlr->adminq.num_outstanding_reqs == 1);
+
+	ut_poll_adminq(1);
+	CU_ASSERT(nvme_ctrlr->plm_nvmsetid == 1);
+	CU_ASSERT(ctrlr->adminq.num_outstanding_reqs == 1);
+	ut_poll_adminq(1);
+	CU_ASSERT(nvme_ctrlr->plm_nvmsetid == 2);
+	CU_ASSERT(nvme_ns1->plm_window == SPDK_NVME_PLM_WINDOW_NDWIN);
+	ut_poll_adminq(1);
+	CU_ASSERT(nvme_ctrlr->plm_log_page_pending == false);
+	CU_ASSERT(nvme_ctrlr->plm_log_page_updating == true);
+	ut_poll_adminq(3);
+	CU_ASSERT(nvme_ctrlr->plm_log_page_updating == false);
+	CU_ASSERT(ctrlr->adminq.num_outstanding_reqs == 0);
+
+	/* A reserved window is kept and reported as such. */
+	g_ut_plm_window[2] = 0x5;
+	rc = nvme_ctrlr_read_plm_log_page(nvme_ctrlr);
+	CU_ASSERT(rc == 0);
+	ut_poll_adminq(3);
+	CU_ASSERT(nvme_ctrlr->plm_log_page_updating == false);
+	CU_ASSERT(nvme_ns2->plm_window == 0x5);
+	CU_ASSERT(strcmp(_nvme_plm_window_str(nvme_ns2->plm_window), "reserved") == 0);
+
+	/* The windows are read again after a reset. */
+	g_ut_plm_window[1] = SPDK_NVME_PLM_WINDOW_DTWIN;
+	rc = bdev_nvme_reset(nvme_ctrlr);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	ut_poll_adminq(6);
+	CU_ASSERT(nvme_ctrlr->resetting == false);
+	CU_ASSERT(nvme_ctrlr->plm_log_page_updating == false);
+	CU_ASSERT(nvme_ns1->plm_window == SPDK_NVME_PLM_WINDOW_DTWIN);
+
+	rc = bdev_nvme_delete("nvme0", &g_any_path);
+	CU_ASSERT(rc == 0);
+
+	poll_threads();
+	spdk_delay_us(1000);
+	poll_threads();
+
+	CU_ASSERT(nvme_ctrlr_get_by_name("nvme0") == NULL);
+
+	memset(g_ut_plm_window, 0, sizeof(g_ut_plm_window));
+}
+
 static void
 test_retry_io_for_ana_error(void)
 {
@@ -5993,6 +6160,10 @@ test_find_io_path_min_qd(void)
 
 	qpair2.num_outstanding_reqs = 4;
 	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path1);
+
+	/* A path in the non-deterministic window is used only if no other optimized path is. */
+	nvme_ns1.plm_window = SPDK_NVME_PLM_WINDOW_NDWIN;
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path2);
 }
 
 static void
@@ -6516,6 +6687,7 @@ main(int argc, const char **argv)
 	CU_ADD_TEST(suite, test_retry_io_for_io_path_error);
 	CU_ADD_TEST(suite, test_retry_io_count);
 	CU_ADD_TEST(suite, test_concurrent_read_ana_log_page);
+	CU_ADD_TEST(suite, test_read_plm_log_page);
 	CU_ADD_TEST(suite, test_retry_io_for_ana_error);
 	CU_ADD_TEST(suite, test_check_io_error_resiliency_params);
 	CU_ADD_TEST(suite, test_retry_io_if_ctrlr_is_resetting);
@@ -13,6 +13,8 @@
 #include "event/scheduler_static.c"
 #include "../module/scheduler/dynamic/scheduler_dynamic.c"
 
+DEFINE_STUB_V(spdk_pause, (void));
+
 static void
 test_create_reactor(void)
 {
@@ -488,6 +490,122 @@ test_reactor_stats(void)
 	MOCK_CLEAR(spdk_env_get_current_core);
 }
 
+static void
+test_reactor_idle(void)
+{
+	struct spdk_cpuset cpuset = {};
+	struct spdk_thread *thread;
+	struct spdk_reactor *reactor;
+	struct spdk_poller *poller;
+	struct spdk_reactor_idle_opts opts, saved_opts;
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	allocate_cores(1);
+
+	CU_ASSERT(spdk_reactors_init(SPDK_DEFAULT_MSG_MEMPOOL_SIZE) == 0);
+
+	spdk_cpuset_set_cpu(&cpuset, 0, true);
+
+	reactor = spdk_reactor_get(0);
+	SPDK_CU_ASSERT_FATAL(reactor != NULL);
+
+	/* The policy is disabled by default. */
+	spdk_reactor_get_idle_opts(&saved_opts);
+	CU_ASSERT(saved_opts.spin_us == SPDK_REACTOR_IDLE_DEFAULT_SPIN_US);
+	CU_ASSERT(saved_opts.pause_us == 0);
+	CU_ASSERT(saved_opts.max_sleep_us == 0);
+	CU_ASSERT(!g_reactor_idle_enabled);
+
+	opts.spin_us = 10;
+	opts.pause_us = 10;
+	opts.max_sleep_us = SPDK_REACTOR_IDLE_MAX_SLEEP_US + 1;
+	CU_ASSERT(spdk_reactor_set_idle_opts(&opts) == -EINVAL);
+	opts.max_sleep_us = 8;
+	CU_ASSERT(spdk_reactor_set_idle_opts(&opts) == 0);
+	CU_ASSERT(g_reactor_idle_enabled);
+	spdk_reactor_get_idle_opts(&opts);
+	CU_ASSERT(opts.spin_us == 10);
+	CU_ASSERT(opts.pause_us == 10);
+	CU_ASSERT(opts.max_sleep_us == 8);
+
+	MOCK_SET(spdk_get_ticks, 100);
+	reactor->tsc_last = spdk_get_ticks();
+
+	thread = spdk_thread_create(NULL, &cpuset);
+	SPDK_CU_ASSERT_FATAL(thread != NULL);
+
+	/* Scheduling the new thread is some work. */
+	CU_ASSERT(_reactor_run(reactor));
+	reactor_idle(reactor, true);
+	CU_ASSERT(reactor->last_busy_tsc == 100);
+	CU_ASSERT(!_reactor_run(reactor));
+
+	/* Neither spinning nor pausing sleeps. */
+	MOCK_SET(spdk_get_ticks, 105);
+	reactor->tsc_last = spdk_get_ticks();
+	reactor_idle(reactor, false);
+	CU_ASSERT(reactor->sleep_backoff_tsc == 0);
+	CU_ASSERT(reactor->tsc_last == 105);
+
+	MOCK_SET(spdk_get_ticks, 115);
+	reactor->tsc_last = spdk_get_ticks();
+	reactor_idle(reactor, false);
+	CU_ASSERT(reactor->sleep_backoff_tsc == 0);
+	CU_ASSERT(reactor->tsc_last == 115);
+
+	/* Then each sleep is twice as long as the previous one, up to the maximum. */
+	reactor->tsc_last = 120;
+	reactor->idle_tsc = 0;
+	MOCK_SET(spdk_get_ticks, 121);
+	reactor_idle(reactor, false);
+	CU_ASSERT(reactor->sleep_backoff_tsc == 2);
+	CU_ASSERT(reactor->sleep_tsc == 1);
+	CU_ASSERT(reactor->idle_tsc == 1);
+	CU_ASSERT(reactor->tsc_last == 121);
+
+	reactor_idle(reactor, false);
+	CU_ASSERT(reactor->sleep_backoff_tsc == 4);
+	reactor_idle(reactor, false);
+	CU_ASSERT(reactor->sleep_backoff_tsc == 8);
+	reactor_idle(reactor, false);
+	CU_ASSERT(reactor->sleep_backoff_tsc == 16);
+	reactor_idle(reactor, false);
+	CU_ASSERT(reactor->sleep_backoff_tsc == 16);
+
+	/* A reactor does not sleep past the expiration of a timed poller. */
+	spdk_set_thread(thread);
+	poller = spdk_poller_register(poller_run_idle, NULL, 1);
+	SPDK_CU_ASSERT_FATAL(poller != NULL);
+	CU_ASSERT(reactor_next_poller_expiration(reactor) == 122);
+	MOCK_SET(spdk_get_ticks, 122);
+	reactor->tsc_last = 122;
+	reactor_idle(reactor, false);
+	CU_ASSERT(reactor->tsc_last == 122);
+	CU_ASSERT(reactor->sleep_tsc == 1);
+
+	/* Some work resets the back-off. */
+	reactor_idle(reactor, true);
+	CU_ASSERT(reactor->sleep_backoff_tsc == 0);
+	CU_ASSERT(reactor->last_busy_tsc == 122);
+
+	spdk_poller_unregister(&poller);
+	spdk_thread_exit(thread);
+
+	_reactor_run(reactor);
+
+	CU_ASSERT(TAILQ_EMPTY(&reactor->threads));
+
+	CU_ASSERT(spdk_reactor_set_idle_opts(&saved_opts) == 0);
+	CU_ASSERT(!g_reactor_idle_enabled);
+
+	spdk_reactors_fini();
+
+	free_cores();
+
+	MOCK_CLEAR(spdk_env_get_current_core);
+}
+
 static uint32_t
 _run_events_till_completion(uint32_t reactor_count)
 {
@@ -1077,6 +1195,183 @@ test_governor(void)
 	free_cores();
 }
 
+static void
+ut_set_core_topology(uint32_t lcore, uint32_t socket_id, uint32_t phys_core_id)
+{
+	g_cores[lcore].socket_id = socket_id;
+	g_cores[lcore].llc_id = socket_id;
+	g_cores[lcore].phys_core_id = phys_core_id;
+}
+
+static void
+ut_set_thread_info(struct spdk_scheduler_core_info *core_info, struct spdk_thread *thread,
+		   uint64_t busy_tsc)
+{
+	struct spdk_scheduler_thread_info *thread_info;
+
+	thread_info = &core_info->thread_infos[core_info->threads_count++];
+	thread_info->lcore = core_info->lcore;
+	thread_info->thread_id = spdk_thread_get_id(thread);
+	thread_info->current_stats.busy_tsc = busy_tsc;
+	thread_info->current_stats.idle_tsc = 100 - busy_tsc;
+
+	core_info->current_busy_tsc += busy_tsc;
+	core_info->current_idle_tsc -= busy_tsc;
+}
+
+static void
+ut_init_core_infos(struct spdk_scheduler_core_info *core_infos,
+		   struct spdk_scheduler_thread_info thread_infos[][2], uint32_t count)
+{
+	uint32_t i;
+
+	memset(core_infos, 0, count * sizeof(*core_infos));
+	memset(thread_infos, 0, count * sizeof(*thread_infos));
+	for (i = 0; i < count; i++) {
+		core_infos[i].lcore = i;
+		core_infos[i].current_idle_tsc = 100;
+		core_infos[i].thread_infos = thread_infos[i];
+	}
+}
+
+static void
+test_scheduler_topology(void)
+{
+	struct spdk_scheduler_core_info core_infos[4];
+	struct spdk_scheduler_thread_info thread_infos[4][2];
+	struct spdk_cpuset cpuset = {};
+	struct spdk_thread *thread[2];
+	struct spdk_reactor *reactor;
+	int i;
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	allocate_cores(4);
+
+	CU_ASSERT(spdk_reactors_init(SPDK_DEFAULT_MSG_MEMPOOL_SIZE) == 0);
+
+	/* Reinitialize the scheduler for the new number of cores. */
+	spdk_scheduler_set(NULL);
+	spdk_scheduler_set("dynamic");
+
+	for (i = 0; i < 4; i++) {
+		spdk_cpuset_set_cpu(&g_reactor_core_mask, i, true);
+		spdk_cpuset_set_cpu(&cpuset, i, true);
+	}
+	g_next_core = 0;
+
+	for (i = 0; i < 2; i++) {
+		thread[i] = spdk_thread_create(NULL, &cpuset);
+		CU_ASSERT(thread[i] != NULL);
+	}
+	for (i = 0; i < 4; i++) {
+		reactor = spdk_reactor_get(i);
+		CU_ASSERT(reactor != NULL);
+		MOCK_SET(spdk_env_get_current_core, i);
+		event_queue_run_batch(reactor);
+	}
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	/* Cores 0 and 1 are SMT siblings.  When the main core is over the limit,
+	 * an active thread is moved to core 2 rather than next to the other busy
+	 * thread on core 1.
+	 */
+	for (i = 0; i < 4; i++) {
+		ut_set_core_topology(i, 0, i == 0 ? 0 : i - 1);
+	}
+	ut_init_core_infos(core_infos, thread_infos, 4);
+	ut_set_thread_info(&core_infos[0], thread[0], 50);
+	ut_set_thread_info(&core_infos[0], thread[1], 50);
+	scheduler_dynamic.balance(core_infos, 4);
+	CU_ASSERT(thread_infos[0][0].lcore == 2);
+	CU_ASSERT(thread_infos[0][1].lcore == 0);
+
+	/* Cores 0 and 1 are on socket 0, cores 2 and 3 on socket 1. */
+	for (i = 0; i < 4; i++) {
+		ut_set_core_topology(i, i / 2, i);
+	}
+
+	/* An active thread is moved to the socket of its devices, even if its
+	 * core is not over the limit.
+	 */
+	spdk_thread_set_socket_id(thread[0], 1);
+	ut_init_core_infos(core_infos, thread_infos, 4);
+	ut_set_thread_info(&core_infos[1], thread[0], 60);
+	scheduler_dynamic.balance(core_infos, 4);
+	CU_ASSERT(thread_infos[1][0].lcore == 2);
+	spdk_thread_set_socket_id(thread[0], SPDK_ENV_SOCKET_ID_ANY);
+
+	/* An active thread is consolidated on its own socket, not on the main
+	 * core of the other one.
+	 */
+	ut_init_core_infos(core_infos, thread_infos, 4);
+	ut_set_thread_info(&core_infos[3], thread[0], 60);
+	scheduler_dynamic.balance(core_infos, 4);
+	CU_ASSERT(thread_infos[3][0].lcore == 2);
+
+	/* Only a thread clearly below the load limit is moved to the main core. */
+	ut_init_core_infos(core_infos, thread_infos, 4);
+	ut_set_thread_info(&core_infos[2], thread[0], g_scheduler_load_limit - 3);
+	ut_set_thread_info(&core_infos[3], thread[1], g_scheduler_load_limit - 10);
+	scheduler_dynamic.balance(core_infos, 4);
+	CU_ASSERT(thread_infos[2][0].lcore == 2);
+	CU_ASSERT(thread_infos[3][0].lcore == 0);
+
+	/* Destroy threads */
+	for (i = 0; i < 2; i++) {
+		spdk_set_thread(thread[i]);
+		spdk_thread_exit(thread[i]);
+	}
+	for (i = 0; i < 4; i++) {
+		reactor = spdk_reactor_get(i);
+		CU_ASSERT(reactor != NULL);
+		reactor_run(reactor);
+	}
+
+	spdk_set_thread(NULL);
+
+	MOCK_CLEAR(spdk_env_get_current_core);
+
+	spdk_reactors_fini();
+
+	free_cores();
+}
+
+static int
+ut_scheduler_set_opts(const char *json)
+{
+	struct spdk_json_val values[16];
+	char buf[128];
+	ssize_t rc;
+
+	snprintf(buf, sizeof(buf), "%s", json);
+	rc = spdk_json_parse(buf, strlen(buf), values, SPDK_COUNTOF(values), NULL, 0);
+	SPDK_CU_ASSERT_FATAL(rc > 0);
+
+	return scheduler_dynamic.set_opts(values);
+}
+
+static void
+test_scheduler_opts(void)
+{
+	/* The hysteresis has to stay below both limits. */
+	CU_ASSERT(ut_scheduler_set_opts("{\"load_limit\": 20, \"hysteresis\": 20}") == -EINVAL);
+	CU_ASSERT(ut_scheduler_set_opts("{\"core_limit\": 10, \"load_limit\": 5, "
+					"\"hysteresis\": 10}") == -EINVAL);
+	CU_ASSERT(g_scheduler_load_limit == 20);
+	CU_ASSERT(g_scheduler_core_limit == 80);
+	CU_ASSERT(g_scheduler_hysteresis == 5);
+
+	CU_ASSERT(ut_scheduler_set_opts("{\"load_limit\": 30, \"core_limit\": 90, "
+					"\"hysteresis\": 10}") == 0);
+	CU_ASSERT(g_scheduler_load_limit == 30);
+	CU_ASSERT(g_scheduler_core_limit == 90);
+	CU_ASSERT(g_scheduler_hysteresis == 10);
+
+	CU_ASSERT(ut_scheduler_set_opts("{\"load_limit\": 20, \"core_limit\": 80, "
+					"\"hysteresis\": 5}") == 0);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -1096,8 +1391,11 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_bind_thread);
 	CU_ADD_TEST(suite, test_for_each_reactor);
 	CU_ADD_TEST(suite, test_reactor_stats);
+	CU_ADD_TEST(suite, test_reactor_idle);
 	CU_ADD_TEST(suite, test_scheduler);
 	CU_ADD_TEST(suite, test_governor);
+	CU_ADD_TEST(suite, test_scheduler_topology);
+	CU_ADD_TEST(suite, test_scheduler_opts);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
@@ -333,6 +333,9 @@ spdk_nvme_ctrlr_cmd_get_feature(struct spdk_nvme_ctrlr *ctrlr, uint8_t feature,
 
 struct spdk_nvme_ana_page *g_ana_hdr;
 struct spdk_nvme_ana_group_descriptor **g_ana_descs;
+static uint32_t *g_changed_ns_list;
+static uint32_t g_changed_ns_list_length;
+static bool g_fail_changed_ns_list;
 
 int
 spdk_nvme_ctrlr_cmd_get_log_page(struct spdk_nvme_ctrlr *ctrlr, uint8_t log_page,
@@ -359,6 +362,20 @@ spdk_nvme_ctrlr_cmd_get_log_page(struct spdk_nvme_ctrlr *ctrlr, uint8_t log_page
 		log_page_directory->temperature_statistics_log_len = true;
 		log_page_directory->smart_log_len = true;
 		log_page_directory->marketing_description_log_len =  true;
+	} else if (log_page == SPDK_NVME_LOG_CHANGED_NS_LIST) {
+		memset(payload, 0, payload_size);
+		if (g_changed_ns_list) {
+			memcpy(payload, g_changed_ns_list,
+			       g_changed_ns_list_length * sizeof(*g_changed_ns_list));
+		}
+		if (g_fail_changed_ns_list) {
+			struct spdk_nvme_cpl cpl = {};
+
+			cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+			cpl.status.sc = SPDK_NVME_SC_INVALID_LOG_PAGE;
+			cb_fn(cb_arg, &cpl);
+			return 0;
+		}
 	}
 
 	fake_cpl_sc(cb_fn, cb_arg);
@@ -474,6 +491,7 @@ static uint32_t *g_active_ns_list = NULL;
 static uint32_t g_active_ns_list_length = 0;
 static struct spdk_nvme_ctrlr_data *g_cdata = NULL;
 static bool g_fail_next_identify = false;
+static uint32_t g_identify_ns_count = 0;
 
 int
 nvme_ctrlr_cmd_identify(struct spdk_nvme_ctrlr *ctrlr, uint8_t cns, uint16_t cntid, uint32_t nsid,
@@ -519,6 +537,8 @@ nvme_ctrlr_cmd_identify(struct spdk_nvme_ctrlr *ctrlr, uint8_t cns, uint16_t cnt
 		if (g_cdata) {
 			memcpy(payload, g_cdata, sizeof(*g_cdata));
 		}
+	} else if (cns == SPDK_NVME_IDENTIFY_NS) {
+		g_identify_ns_count++;
 	} else if (cns == SPDK_NVME_IDENTIFY_NS_IOCS) {
 		return 0;
 	}
@@ -3210,6 +3230,134 @@ test_nvme_ctrlr_parse_ana_log_page(void)
 	free(ctrlr.copied_ana_desc);
 }
 
+static void
+ut_identify_cache_reset(struct spdk_nvme_ctrlr *ctrlr)
+{
+	g_identify_ns_count = 0;
+	ctrlr->state = NVME_CTRLR_STATE_IDENTIFY;
+	while (ctrlr->state != NVME_CTRLR_STATE_READY) {
+		SPDK_CU_ASSERT_FATAL(nvme_ctrlr_process_init(ctrlr) == 0);
+	}
+}
+
+static void
+test_nvme_ctrlr_identify_cache(void)
+{
+	DECLARE_AND_CONSTRUCT_CTRLR();
+	uint32_t active_ns_list[] = { 1, 2, 3 };
+	uint32_t changed_ns_list[] = { 2 };
+	uint32_t overflow_ns_list[] = { 0xFFFFFFFF };
+	struct spdk_nvme_ctrlr_data cdata = { .nn = 4, .sn = "SN0001" };
+	union spdk_nvme_async_event_completion aer_event = {
+		.bits.async_event_type = SPDK_NVME_ASYNC_EVENT_TYPE_NOTICE,
+		.bits.async_event_info = SPDK_NVME_ASYNC_EVENT_NS_ATTR_CHANGED
+	};
+	struct spdk_nvme_cpl aer_cpl = {
+		.status.sct = SPDK_NVME_SCT_GENERIC,
+		.status.sc = SPDK_NVME_SC_SUCCESS,
+		.cdw0 = aer_event.raw
+	};
+
+	SPDK_CU_ASSERT_FATAL(nvme_ctrlr_construct(&ctrlr) == 0);
+
+	ctrlr.vs.raw = SPDK_NVME_VERSION(1, 2, 0);
+	ctrlr.opts.enable_identify_cache = true;
+	g_cdata = &cdata;
+	g_active_ns_list = active_ns_list;
+	g_active_ns_list_length = SPDK_COUNTOF(active_ns_list);
+	CU_ASSERT(nvme_ctrlr_add_process(&ctrlr, NULL) == 0);
+
+	/* The initial identify has nothing to reuse */
+	ut_identify_cache_reset(&ctrlr);
+	CU_ASSERT(g_identify_ns_count == 3);
+	/* Initialization completed, namespace data can be reused from now on */
+	CU_ASSERT(ctrlr.identify_cache.valid == true);
+	CU_ASSERT(ctrlr.identify_cache.hit == false);
+
+	/* Reset: same controller, one namespace was attached while disconnected */
+	active_ns_list[2] = 4;
+	ctrlr.state = NVME_CTRLR_STATE_IDENTIFY;
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.identify_cache.hit == true);
+	CU_ASSERT(ctrlr.identify_cache.valid == false);
+
+	g_identify_ns_count = 0;
+	while (ctrlr.state != NVME_CTRLR_STATE_READY) {
+		SPDK_CU_ASSERT_FATAL(nvme_ctrlr_process_init(&ctrlr) == 0);
+	}
+	CU_ASSERT(g_identify_ns_count == 1);
+	CU_ASSERT(!spdk_nvme_ctrlr_is_active_ns(&ctrlr, 3));
+	CU_ASSERT(spdk_nvme_ctrlr_is_active_ns(&ctrlr, 4));
+	/* The decision only holds for the initialization that made it */
+	CU_ASSERT(ctrlr.identify_cache.hit == false);
+	CU_ASSERT(ctrlr.identify_cache.valid == true);
+
+	/* Reset: the controller reports a changed namespace */
+	g_changed_ns_list = changed_ns_list;
+	g_changed_ns_list_length = SPDK_COUNTOF(changed_ns_list);
+	ut_identify_cache_reset(&ctrlr);
+	CU_ASSERT(g_identify_ns_count == 1);
+
+	/* Reset: the changed namespace list overflowed */
+	g_changed_ns_list = overflow_ns_list;
+	g_changed_ns_list_length = SPDK_COUNTOF(overflow_ns_list);
+	ut_identify_cache_reset(&ctrlr);
+	CU_ASSERT(g_identify_ns_count == 3);
+	g_changed_ns_list = NULL;
+	g_changed_ns_list_length = 0;
+
+	/* Reset: the changed namespace list cannot be read */
+	g_fail_changed_ns_list = true;
+	ut_identify_cache_reset(&ctrlr);
+	CU_ASSERT(g_identify_ns_count == 3);
+	g_fail_changed_ns_list = false;
+
+	ut_identify_cache_reset(&ctrlr);
+	CU_ASSERT(g_identify_ns_count == 0);
+
+	/* A namespace attribute change notice received before the reset drops the cache */
+	nvme_ctrlr_async_event_cb(&ctrlr.aer[0], &aer_cpl);
+	CU_ASSERT(ctrlr.identify_cache.valid == false);
+	ut_identify_cache_reset(&ctrlr);
+	CU_ASSERT(g_identify_ns_count == 3);
+	/* The cache isn't valid until the event has been processed */
+	CU_ASSERT(ctrlr.identify_cache.valid == false);
+	nvme_ctrlr_complete_queued_async_events(&ctrlr);
+	CU_ASSERT(ctrlr.identify_cache.valid == true);
+	CU_ASSERT(ctrlr.identify_cache.ns_changed == false);
+
+	/*
+	 * A notice received in the middle of the initialization doesn't change the namespaces
+	 * already taken from the cache, but keeps it invalid.
+	 */
+	g_identify_ns_count = 0;
+	ctrlr.state = NVME_CTRLR_STATE_IDENTIFY;
+	while (ctrlr.state != NVME_CTRLR_STATE_IDENTIFY_NS) {
+		SPDK_CU_ASSERT_FATAL(nvme_ctrlr_process_init(&ctrlr) == 0);
+	}
+	CU_ASSERT(ctrlr.identify_cache.hit == true);
+	nvme_ctrlr_async_event_cb(&ctrlr.aer[0], &aer_cpl);
+	CU_ASSERT(ctrlr.identify_cache.hit == true);
+	while (ctrlr.state != NVME_CTRLR_STATE_READY) {
+		SPDK_CU_ASSERT_FATAL(nvme_ctrlr_process_init(&ctrlr) == 0);
+	}
+	CU_ASSERT(g_identify_ns_count == 0);
+	CU_ASSERT(ctrlr.identify_cache.valid == false);
+	nvme_ctrlr_complete_queued_async_events(&ctrlr);
+	CU_ASSERT(ctrlr.identify_cache.valid == true);
+
+	/* Reset: a different controller answers on the same address */
+	memcpy(cdata.sn, "SN0002", sizeof("SN0002"));
+	ut_identify_cache_reset(&ctrlr);
+	CU_ASSERT(g_identify_ns_count == 3);
+
+	g_cdata = NULL;
+	g_active_ns_list = NULL;
+	g_active_ns_list_length = 0;
+	nvme_ctrlr_free_processes(&ctrlr);
+	nvme_ctrlr_destruct(&ctrlr);
+}
+
 static void
 test_nvme_ctrlr_ana_resize(void)
 {
@@ -3296,6 +3444,78 @@ test_nvme_ctrlr_ana_resize(void)
 	nvme_ctrlr_destruct(&ctrlr);
 }
 
+static void
+test_nvme_ctrlr_warm_reconnect(void)
+{
+	DECLARE_AND_CONSTRUCT_CTRLR();
+
+	memset(&g_ut_nvme_regs, 0, sizeof(g_ut_nvme_regs));
+	SPDK_CU_ASSERT_FATAL(nvme_ctrlr_construct(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.resume.cntlid == 0xFFFF);
+
+	ctrlr.trid.trtype = SPDK_NVME_TRANSPORT_TCP;
+	ctrlr.cntlid = 3;
+	ctrlr.cdata.nn = 1;
+
+	/* Disabled by default, the next connect asks for a new controller */
+	ctrlr.state = NVME_CTRLR_STATE_READY;
+	CU_ASSERT(nvme_ctrlr_disconnect(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.resume.cntlid == 0xFFFF);
+	ctrlr.is_resetting = false;
+
+	/* Only a ready controller is resumed */
+	ctrlr.opts.enable_warm_reconnect = true;
+	ctrlr.state = NVME_CTRLR_STATE_IDENTIFY;
+	CU_ASSERT(nvme_ctrlr_disconnect(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.resume.cntlid == 0xFFFF);
+	ctrlr.is_resetting = false;
+
+	ctrlr.state = NVME_CTRLR_STATE_READY;
+	CU_ASSERT(nvme_ctrlr_disconnect(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.resume.cntlid == 3);
+	CU_ASSERT(ctrlr.resume.resumed == false);
+
+	/* The target resumed the controller, VS/CAP/IDENTIFY are skipped */
+	ctrlr.resume.cntlid = 0xFFFF;
+	ctrlr.resume.resumed = true;
+	g_ut_nvme_regs.cc.bits.en = 1;
+	g_ut_nvme_regs.csts.bits.rdy = 1;
+	ctrlr.state = NVME_CTRLR_STATE_WAIT_FOR_CONNECT_ADMINQ;
+	ctrlr.adminq->state = NVME_QPAIR_CONNECTED;
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_CHECK_EN);
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_CONFIGURE_AER);
+	CU_ASSERT(ctrlr.resume.resumed == false);
+
+	/* The resumed controller got disabled in the meantime, initialize it */
+	ctrlr.resume.resumed = true;
+	g_ut_nvme_regs.cc.bits.en = 0;
+	g_ut_nvme_regs.csts.bits.rdy = 0;
+	ctrlr.state = NVME_CTRLR_STATE_CHECK_EN;
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_DISABLE_WAIT_FOR_READY_0);
+	CU_ASSERT(ctrlr.resume.resumed == false);
+
+	/* The target refused to resume the controller, fall back to a new one */
+	ctrlr.resume.cntlid = 3;
+	ctrlr.state = NVME_CTRLR_STATE_WAIT_FOR_CONNECT_ADMINQ;
+	ctrlr.adminq->state = NVME_QPAIR_DISCONNECTED;
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_CONNECT_ADMINQ);
+	CU_ASSERT(ctrlr.resume.cntlid == 0xFFFF);
+
+	/* No second chance */
+	ctrlr.state = NVME_CTRLR_STATE_WAIT_FOR_CONNECT_ADMINQ;
+	ctrlr.adminq->state = NVME_QPAIR_DISCONNECTED;
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ERROR);
+
+	ctrlr.is_resetting = false;
+	g_ut_nvme_regs.csts.bits.shst = SPDK_NVME_SHST_COMPLETE;
+	nvme_ctrlr_destruct(&ctrlr);
+}
+
 static void
 test_nvme_ctrlr_get_memory_domains(void)
 {
@@ -3414,6 +3634,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_ctrlr_set_intel_supported_log_pages);
 	CU_ADD_TEST(suite, test_nvme_ctrlr_parse_ana_log_page);
 	CU_ADD_TEST(suite, test_nvme_ctrlr_ana_resize);
+	CU_ADD_TEST(suite, test_nvme_ctrlr_identify_cache);
+	CU_ADD_TEST(suite, test_nvme_ctrlr_warm_reconnect);
 	CU_ADD_TEST(suite, test_nvme_ctrlr_get_memory_domains);
 	CU_ADD_TEST(suite, test_nvme_transport_ctrlr_ready);
 	CU_ADD_TEST(suite, test_nvme_ctrlr_disable);
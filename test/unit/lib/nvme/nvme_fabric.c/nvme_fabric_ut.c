@@ -389,6 +389,7 @@ test_nvme_fabric_qpair_connect(void)
 	memset(&reserved_req, 0, sizeof(reserved_req));
 	qpair.id = 0;
 	ctrlr.cntlid = 0;
+	ctrlr.resume.cntlid = 0xFFFF;
 
 	rc = nvme_fabric_qpair_connect(&qpair, 1);
 	CU_ASSERT(rc == 0);
@@ -399,6 +400,7 @@ test_nvme_fabric_qpair_connect(void)
 	CU_ASSERT(cmd->kato == 100);
 	CU_ASSERT(ctrlr.cntlid == 1);
 	CU_ASSERT(g_nvmf_data.cntlid == 0xffff);
+	CU_ASSERT(ctrlr.resume.resumed == false);
 	CU_ASSERT(!strncmp(g_nvmf_data.hostid, ctrlr.opts.extended_host_id, sizeof(g_nvmf_data.hostid)));
 	CU_ASSERT(!strncmp(g_nvmf_data.hostnqn, ctrlr.opts.hostnqn, sizeof(ctrlr.opts.hostnqn)));
 	CU_ASSERT(!strncmp(g_nvmf_data.subnqn, ctrlr.trid.subnqn, sizeof(ctrlr.trid.subnqn)));
@@ -406,6 +408,30 @@ test_nvme_fabric_qpair_connect(void)
 	CU_ASSERT(g_request == qpair.reserved_req);
 	CU_ASSERT(!STAILQ_EMPTY(&qpair.free_req));
 
+	/* adminq resuming the previous controller */
+	memset(&g_nvmf_data, 0, sizeof(g_nvmf_data));
+	memset(&reserved_req, 0, sizeof(reserved_req));
+	ctrlr.resume.cntlid = 1;
+
+	rc = nvme_fabric_qpair_connect(&qpair, 1);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_nvmf_data.cntlid == 1);
+	CU_ASSERT(ctrlr.cntlid == 1);
+	CU_ASSERT(ctrlr.resume.resumed == true);
+	CU_ASSERT(ctrlr.resume.cntlid == 0xFFFF);
+
+	/* adminq resume rejected, the target allocated a new controller */
+	memset(&g_nvmf_data, 0, sizeof(g_nvmf_data));
+	memset(&reserved_req, 0, sizeof(reserved_req));
+	ctrlr.resume.cntlid = 2;
+
+	rc = nvme_fabric_qpair_connect(&qpair, 1);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_nvmf_data.cntlid == 2);
+	CU_ASSERT(ctrlr.cntlid == 1);
+	CU_ASSERT(ctrlr.resume.resumed == false);
+	CU_ASSERT(ctrlr.resume.cntlid == 0xFFFF);
+
 	/* Wait_for completion timeout */
 	g_nvme_wait_for_completion_timeout = true;
 
@@ -744,6 +744,46 @@ test_nvme_get_sgl_print_info(void)
 			   NVME_CMD_DPTR_STR_SIZE));
 }
 
+static void
+test_nvme_qpair_select_least_outstanding(void)
+{
+	struct spdk_nvme_qpair qpair[3] = {};
+	struct spdk_nvme_qpair *qpairs[3] = { &qpair[0], &qpair[1], &qpair[2] };
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		nvme_qpair_set_state(&qpair[i], NVME_QPAIR_ENABLED);
+	}
+
+	/* Equally loaded qpairs - the search start wins */
+	for (i = 0; i < 3; i++) {
+		CU_ASSERT(spdk_nvme_qpair_select_least_outstanding(qpairs, 3, i) == (uint32_t)i);
+	}
+
+	/* The least loaded qpair is selected wherever the search starts */
+	qpair[0].num_outstanding_reqs = 4;
+	qpair[1].num_outstanding_reqs = 2;
+	qpair[2].num_outstanding_reqs = 3;
+	for (i = 0; i < 3; i++) {
+		CU_ASSERT(spdk_nvme_qpair_select_least_outstanding(qpairs, 3, i) == 1);
+	}
+
+	/* Ties go to the first qpair found from the start */
+	qpair[2].num_outstanding_reqs = 2;
+	CU_ASSERT(spdk_nvme_qpair_select_least_outstanding(qpairs, 3, 0) == 1);
+	CU_ASSERT(spdk_nvme_qpair_select_least_outstanding(qpairs, 3, 2) == 2);
+
+	/* Qpairs that aren't connected are skipped */
+	nvme_qpair_set_state(&qpair[1], NVME_QPAIR_DISCONNECTED);
+	CU_ASSERT(spdk_nvme_qpair_select_least_outstanding(qpairs, 3, 0) == 2);
+	nvme_qpair_set_state(&qpair[2], NVME_QPAIR_CONNECTING);
+	CU_ASSERT(spdk_nvme_qpair_select_least_outstanding(qpairs, 3, 1) == 0);
+
+	/* None of them is connected - the start is returned */
+	nvme_qpair_set_state(&qpair[0], NVME_QPAIR_DISCONNECTING);
+	CU_ASSERT(spdk_nvme_qpair_select_least_outstanding(qpairs, 3, 1) == 1);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -769,6 +809,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_qpair_manual_complete_request);
 	CU_ADD_TEST(suite, test_nvme_qpair_init_deinit);
 	CU_ADD_TEST(suite, test_nvme_get_sgl_print_info);
+	CU_ADD_TEST(suite, test_nvme_qpair_select_least_outstanding);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
@@ -1374,6 +1374,84 @@ test_nvme_tcp_capsule_resp_hdr_handle(void)
 	nvme_tcp_free_reqs(&tqpair);
 }
 
+static void
+test_nvme_tcp_read_pdu_header(void)
+{
+	struct nvme_tcp_qpair	tqpair = {};
+	struct spdk_nvme_ctrlr	ctrlr = {};
+	struct spdk_nvme_tcp_stat	stats = {};
+	struct nvme_request	req = {};
+	struct nvme_tcp_req	*tcp_req;
+	struct nvme_tcp_pdu	*pdu;
+	uint32_t		reaped = 0;
+	int			rc;
+
+	tqpair.num_entries = 1;
+	tqpair.stats = &stats;
+	tqpair.sock = (struct spdk_sock *)0xDEADBEEF;
+	tqpair.state = NVME_TCP_QPAIR_STATE_RUNNING;
+	req.qpair = &tqpair.qpair;
+	req.qpair->ctrlr = &ctrlr;
+	req.payload = NVME_PAYLOAD_CONTIG(NULL, NULL);
+
+	rc = nvme_tcp_alloc_reqs(&tqpair);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	tcp_req = nvme_tcp_req_get(&tqpair);
+	SPDK_CU_ASSERT_FATAL(tcp_req != NULL);
+	rc = nvme_tcp_req_init(&tqpair, &req, tcp_req);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	tcp_req->ordering.bits.send_ack = 1;
+	tqpair.qpair.num_outstanding_reqs = 1;
+
+	/* The socket returns what is written in the PDU beforehand. */
+	pdu = tqpair.recv_pdu;
+	pdu->hdr.common.pdu_type = SPDK_NVME_TCP_PDU_TYPE_CAPSULE_RESP;
+	pdu->hdr.common.hlen = sizeof(struct spdk_nvme_tcp_rsp);
+	pdu->hdr.common.plen = sizeof(struct spdk_nvme_tcp_rsp);
+	pdu->hdr.capsule_resp.rccqe.cid = 0;
+	tqpair.recv_state = NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_CH;
+
+	/* A short read keeps waiting for the common header. */
+	MOCK_SET(spdk_sock_recv, 6);
+	rc = nvme_tcp_read_pdu(&tqpair, &reaped, 1);
+	CU_ASSERT(rc == NVME_TCP_PDU_IN_PROGRESS);
+	CU_ASSERT(tqpair.recv_state == NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_CH);
+	CU_ASSERT(pdu->ch_valid_bytes == 6);
+	CU_ASSERT(reaped == 0);
+
+	/* The rest of the common header and the whole PDU specific header of a
+	 * CapsuleResp arrive in one read, which completes the request.
+	 */
+	MOCK_SET(spdk_sock_recv, sizeof(struct spdk_nvme_tcp_rsp) - 6);
+	rc = nvme_tcp_read_pdu(&tqpair, &reaped, 1);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(reaped == 1);
+	CU_ASSERT(tqpair.recv_state == NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_READY);
+	CU_ASSERT(tqpair.qpair.num_outstanding_reqs == 0);
+	CU_ASSERT(TAILQ_EMPTY(&tqpair.outstanding_reqs));
+
+	/* The PDU specific header of a longer header is completed by the next reads,
+	 * each of them returning 24 bytes here.
+	 */
+	tqpair.async_complete = 0;
+	memset(pdu, 0, sizeof(*pdu));
+	pdu->hdr.common.pdu_type = SPDK_NVME_TCP_PDU_TYPE_IC_RESP;
+	pdu->hdr.common.hlen = sizeof(struct spdk_nvme_tcp_ic_resp);
+	pdu->hdr.common.plen = sizeof(struct spdk_nvme_tcp_ic_resp);
+	tqpair.state = NVME_TCP_QPAIR_STATE_INVALID;
+	tqpair.recv_state = NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_CH;
+	MOCK_SET(spdk_sock_recv, sizeof(struct spdk_nvme_tcp_rsp));
+	rc = nvme_tcp_read_pdu(&tqpair, &reaped, 1);
+	CU_ASSERT(rc == NVME_TCP_PDU_IN_PROGRESS);
+	CU_ASSERT(tqpair.recv_state == NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PSH);
+	CU_ASSERT(pdu->ch_valid_bytes == sizeof(struct spdk_nvme_tcp_common_pdu_hdr));
+	CU_ASSERT(pdu->psh_valid_bytes == 2 * sizeof(struct spdk_nvme_tcp_rsp) -
+		  sizeof(struct spdk_nvme_tcp_common_pdu_hdr));
+
+	MOCK_SET(spdk_sock_recv, 1);
+	nvme_tcp_free_reqs(&tqpair);
+}
+
 static void
 test_nvme_tcp_ctrlr_connect_qpair(void)
 {
@@ -1800,6 +1878,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_tcp_icresp_handle);
 	CU_ADD_TEST(suite, test_nvme_tcp_pdu_payload_handle);
 	CU_ADD_TEST(suite, test_nvme_tcp_capsule_resp_hdr_handle);
+	CU_ADD_TEST(suite, test_nvme_tcp_read_pdu_header);
 	CU_ADD_TEST(suite, test_nvme_tcp_ctrlr_connect_qpair);
 	CU_ADD_TEST(suite, test_nvme_tcp_ctrlr_disconnect_qpair);
 	CU_ADD_TEST(suite, test_nvme_tcp_ctrlr_create_io_qpair);
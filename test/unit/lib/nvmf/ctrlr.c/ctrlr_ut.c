@@ -91,7 +91,8 @@ DEFINE_STUB(nvmf_ctrlr_copy_supported,
 
 DEFINE_STUB_V(nvmf_get_discovery_log_page,
 	      (struct spdk_nvmf_tgt *tgt, const char *hostnqn, struct iovec *iov,
-	       uint32_t iovcnt, uint64_t offset, uint32_t length, struct spdk_nvme_transport_id *cmd_src_trid));
+	       uint32_t iovcnt, uint64_t offset, uint32_t length, struct spdk_nvme_transport_id *cmd_src_trid,
+	       struct spdk_nvmf_discovery_log_page **cached_log));
 
 DEFINE_STUB(spdk_nvmf_qpair_get_listen_trid,
 	    int,
@@ -2471,6 +2472,157 @@ test_nvmf_ctrlr_create_destruct(void)
 	CU_ASSERT(TAILQ_EMPTY(&qpair.outstanding));
 }
 
+static void
+test_nvmf_ctrlr_resume(void)
+{
+	struct spdk_nvmf_fabric_connect_data connect_data = {};
+	struct spdk_nvmf_poll_group group = {};
+	struct spdk_nvmf_subsystem_poll_group sgroups[2] = {};
+	struct spdk_nvmf_transport transport = {};
+	struct spdk_nvmf_transport_ops tops = {};
+	struct spdk_nvmf_subsystem subsystem = {};
+	struct spdk_nvmf_request req = {};
+	struct spdk_nvmf_qpair qpair = {};
+	struct spdk_nvmf_ctrlr *ctrlr = NULL;
+	struct spdk_nvmf_tgt tgt = {};
+	union nvmf_h2c_msg cmd = {};
+	union nvmf_c2h_msg rsp = {};
+	const uint8_t hostid[16] = {
+		0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+		0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F
+	};
+	const char subnqn[] = "nqn.2016-06.io.spdk:subsystem1";
+	const char hostnqn[] = "nqn.2016-06.io.spdk:host1";
+	int rc;
+
+	group.thread = spdk_get_thread();
+	group.sgroups = sgroups;
+	tops.type = SPDK_NVME_TRANSPORT_TCP;
+	transport.ops = &tops;
+	transport.opts.max_aq_depth = 32;
+	transport.opts.max_queue_depth = 64;
+	transport.opts.max_qpairs_per_ctrlr = 3;
+	transport.tgt = &tgt;
+	qpair.transport = &transport;
+	qpair.group = &group;
+	qpair.state = SPDK_NVMF_QPAIR_ACTIVE;
+	TAILQ_INIT(&qpair.outstanding);
+
+	memcpy(connect_data.hostid, hostid, sizeof(hostid));
+	connect_data.cntlid = 0xFFFF;
+	snprintf(connect_data.subnqn, sizeof(connect_data.subnqn), "%s", subnqn);
+	snprintf(connect_data.hostnqn, sizeof(connect_data.hostnqn), "%s", hostnqn);
+
+	subsystem.thread = spdk_get_thread();
+	subsystem.id = 1;
+	TAILQ_INIT(&subsystem.ctrlrs);
+	subsystem.tgt = &tgt;
+	subsystem.subtype = SPDK_NVMF_SUBTYPE_NVME;
+	subsystem.state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
+	subsystem.resume_timeout_ms = 1000;
+	snprintf(subsystem.subnqn, sizeof(subsystem.subnqn), "%s", subnqn);
+
+	cmd.connect_cmd.opcode = SPDK_NVME_OPC_FABRIC;
+	cmd.connect_cmd.cid = 1;
+	cmd.connect_cmd.fctype = SPDK_NVMF_FABRIC_COMMAND_CONNECT;
+	cmd.connect_cmd.qid = 0;
+	cmd.connect_cmd.sqsize = 31;
+	cmd.connect_cmd.kato = 120000;
+
+	req.qpair = &qpair;
+	req.xfer = SPDK_NVME_DATA_HOST_TO_CONTROLLER;
+	req.data = &connect_data;
+	req.length = sizeof(connect_data);
+	spdk_iov_one(req.iov, &req.iovcnt, &connect_data, req.length);
+	req.cmd = &cmd;
+	req.rsp = &rsp;
+
+	TAILQ_INSERT_TAIL(&qpair.outstanding, &req, link);
+	sgroups[subsystem.id].mgmt_io_outstanding++;
+
+	ctrlr = nvmf_ctrlr_create(&subsystem, &req, &req.cmd->connect_cmd, req.iov[0].iov_base);
+	poll_threads();
+	SPDK_CU_ASSERT_FATAL(ctrlr != NULL);
+	CU_ASSERT(ctrlr->dynamic_ctrlr == true);
+	ctrlr->cntlid = 1;
+
+	MOCK_SET(spdk_nvmf_tgt_find_subsystem, &subsystem);
+	MOCK_SET(nvmf_subsystem_get_ctrlr, ctrlr);
+
+	/* The host lost its connection to an enabled controller, it is kept */
+	ctrlr->vcprop.cc.bits.en = 1;
+	ctrlr->vcprop.csts.bits.rdy = 1;
+	ctrlr->in_destruct = true;
+	spdk_bit_array_clear(ctrlr->qpair_mask, 0);
+	qpair.ctrlr = NULL;
+	nvmf_ctrlr_destruct(ctrlr);
+	poll_threads();
+	CU_ASSERT(ctrlr->resume_timer != NULL);
+	CU_ASSERT(ctrlr->keep_alive_poller == NULL);
+
+	/* Another host cannot take it over */
+	snprintf(connect_data.hostnqn, sizeof(connect_data.hostnqn), "%s", "nqn.2016-06.io.spdk:host2");
+	connect_data.cntlid = 1;
+	memset(&rsp, 0, sizeof(rsp));
+	sgroups[subsystem.id].mgmt_io_outstanding++;
+	TAILQ_INSERT_TAIL(&qpair.outstanding, &req, link);
+	rc = nvmf_ctrlr_cmd_connect(&req);
+	poll_threads();
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	CU_ASSERT(rsp.nvme_cpl.status.sct == SPDK_NVME_SCT_COMMAND_SPECIFIC);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVMF_FABRIC_SC_INVALID_PARAM);
+	CU_ASSERT(rsp.connect_rsp.status_code_specific.invalid.iattr == 1);
+	CU_ASSERT(rsp.connect_rsp.status_code_specific.invalid.ipo == 16);
+	CU_ASSERT(qpair.ctrlr == NULL);
+	CU_ASSERT(ctrlr->resume_timer != NULL);
+	CU_ASSERT(sgroups[subsystem.id].mgmt_io_outstanding == 0);
+
+	/* The same host resumes it with a different keep alive timeout */
+	snprintf(connect_data.hostnqn, sizeof(connect_data.hostnqn), "%s", hostnqn);
+	cmd.connect_cmd.kato = 30000;
+	memset(&rsp, 0, sizeof(rsp));
+	sgroups[subsystem.id].mgmt_io_outstanding++;
+	TAILQ_INSERT_TAIL(&qpair.outstanding, &req, link);
+	rc = nvmf_ctrlr_cmd_connect(&req);
+	poll_threads();
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	CU_ASSERT(nvme_status_success(&rsp.nvme_cpl.status));
+	CU_ASSERT(rsp.connect_rsp.status_code_specific.success.cntlid == 1);
+	CU_ASSERT(qpair.ctrlr == ctrlr);
+	CU_ASSERT(ctrlr->admin_qpair == &qpair);
+	CU_ASSERT(ctrlr->resume_timer == NULL);
+	CU_ASSERT(ctrlr->in_destruct == false);
+	CU_ASSERT(ctrlr->keep_alive_poller != NULL);
+	CU_ASSERT(ctrlr->feat.keep_alive_timer.bits.kato == 30000);
+	CU_ASSERT(ctrlr->vcprop.cc.bits.en == 1);
+	CU_ASSERT(sgroups[subsystem.id].mgmt_io_outstanding == 0);
+
+	/* It is destroyed if the host does not come back in time */
+	ctrlr->in_destruct = true;
+	spdk_bit_array_clear(ctrlr->qpair_mask, 0);
+	qpair.ctrlr = NULL;
+	nvmf_ctrlr_destruct(ctrlr);
+	poll_threads();
+	CU_ASSERT(ctrlr->resume_timer != NULL);
+	spdk_delay_us(1000 * 1000);
+	poll_threads();
+	CU_ASSERT(TAILQ_EMPTY(&qpair.outstanding));
+
+	/* The controller is gone, a new one has to be created */
+	MOCK_SET(nvmf_subsystem_get_ctrlr, NULL);
+	memset(&rsp, 0, sizeof(rsp));
+	sgroups[subsystem.id].mgmt_io_outstanding++;
+	TAILQ_INSERT_TAIL(&qpair.outstanding, &req, link);
+	rc = nvmf_ctrlr_cmd_connect(&req);
+	poll_threads();
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVMF_FABRIC_SC_INVALID_PARAM);
+	CU_ASSERT(qpair.ctrlr == NULL);
+
+	MOCK_CLEAR(nvmf_subsystem_get_ctrlr);
+	MOCK_CLEAR(spdk_nvmf_tgt_find_subsystem);
+}
+
 static void
 test_nvmf_ctrlr_use_zcopy(void)
 {
@@ -2876,6 +3028,276 @@ test_zcopy_write(void)
 	CU_ASSERT(nvme_status_success(&rsp.nvme_cpl.status));
 }
 
+static void
+test_nvmf_ctrlr_host_qos(void)
+{
+	struct spdk_nvmf_request req[3] = {};
+	struct spdk_nvme_cmd cmd[3] = {};
+	union nvmf_c2h_msg rsp[3] = {};
+	struct spdk_nvmf_qpair qpair = {};
+	struct spdk_nvmf_ctrlr ctrlr = {};
+	struct spdk_nvmf_subsystem subsystem = {};
+	struct spdk_nvmf_ns ns = {};
+	struct spdk_nvmf_ns *subsys_ns[1] = {};
+	enum spdk_nvme_ana_state ana_state[1];
+	struct spdk_nvmf_subsystem_listener listener = { .ana_state = ana_state };
+	struct spdk_bdev bdev = { .blockcnt = 100, .blocklen = 512};
+	struct spdk_nvmf_poll_group group = {};
+	struct spdk_nvmf_subsystem_poll_group sgroups = {};
+	struct spdk_nvmf_subsystem_pg_ns_info ns_info = {};
+	struct spdk_io_channel io_ch = {};
+	int i, rc;
+
+	ns.bdev = &bdev;
+	ns.anagrpid = 1;
+
+	subsystem.id = 0;
+	subsystem.max_nsid = 1;
+	subsys_ns[0] = &ns;
+	subsystem.ns = (struct spdk_nvmf_ns **)&subsys_ns;
+
+	listener.ana_state[0] = SPDK_NVME_ANA_OPTIMIZED_STATE;
+
+	ctrlr.vcprop.cc.bits.en = 1;
+	ctrlr.subsys = &subsystem;
+	ctrlr.listener = &listener;
+
+	group.thread = spdk_get_thread();
+	group.num_sgroups = 1;
+	sgroups.state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
+	sgroups.num_ns = 1;
+	ns_info.state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
+	ns_info.channel = &io_ch;
+	sgroups.ns_info = &ns_info;
+	group.sgroups = &sgroups;
+	TAILQ_INIT(&group.qos_qpairs);
+
+	qpair.ctrlr = &ctrlr;
+	qpair.group = &group;
+	qpair.qid = 1;
+	qpair.state = SPDK_NVMF_QPAIR_ACTIVE;
+	TAILQ_INIT(&qpair.qos_queued);
+
+	for (i = 0; i < 3; i++) {
+		cmd[i].opc = SPDK_NVME_OPC_READ;
+		cmd[i].nsid = 1;
+		req[i].qpair = &qpair;
+		req[i].cmd = (union nvmf_h2c_msg *)&cmd[i];
+		req[i].rsp = &rsp[i];
+		req[i].length = 4096;
+	}
+
+	MOCK_SET(nvmf_bdev_ctrlr_read_cmd, SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+
+	/* No limits - nothing is queued */
+	for (i = 0; i < 3; i++) {
+		rc = nvmf_ctrlr_process_io_cmd(&req[i]);
+		CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	}
+	CU_ASSERT(TAILQ_EMPTY(&group.qos_qpairs));
+
+	/* 2000 IOPS allows two commands per 1ms timeslice, the third one is queued */
+	nvmf_ctrlr_set_qos_limits(&ctrlr, 2000, 0, NVMF_QOS_DEFAULT_WEIGHT);
+	CU_ASSERT(ctrlr.qos.max_ios_per_timeslice == 2);
+	CU_ASSERT(ctrlr.qos.max_bytes_per_timeslice == 0);
+
+	for (i = 0; i < 3; i++) {
+		rc = nvmf_ctrlr_process_io_cmd(&req[i]);
+		CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	}
+	CU_ASSERT(TAILQ_FIRST(&qpair.qos_queued) == &req[2]);
+	CU_ASSERT(TAILQ_NEXT(&req[2], qos_link) == NULL);
+	CU_ASSERT(TAILQ_FIRST(&group.qos_qpairs) == &qpair);
+	CU_ASSERT(group.qos_poller != NULL);
+
+	/* Nothing is resubmitted until the next timeslice */
+	CU_ASSERT(nvmf_poll_group_process_qos_queued(&group) == 0);
+	CU_ASSERT(TAILQ_FIRST(&qpair.qos_queued) == &req[2]);
+
+	/* The timed poller resubmits it once the timeslice is over and unregisters itself */
+	spdk_delay_us(NVMF_QOS_TIMESLICE_IN_USEC);
+	poll_threads();
+	CU_ASSERT(TAILQ_EMPTY(&group.qos_qpairs));
+	CU_ASSERT(TAILQ_EMPTY(&qpair.qos_queued));
+	CU_ASSERT(group.qos_poller == NULL);
+
+	/* Only READ and WRITE are limited, a flush always goes through */
+	cmd[0].opc = SPDK_NVME_OPC_FLUSH;
+	for (i = 0; i < 3; i++) {
+		rc = nvmf_ctrlr_process_io_cmd(&req[0]);
+		CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	}
+	CU_ASSERT(TAILQ_EMPTY(&group.qos_qpairs));
+	cmd[0].opc = SPDK_NVME_OPC_READ;
+
+	/* A bandwidth limit of 1MiB/s lets a single 4KiB read through per timeslice */
+	spdk_delay_us(NVMF_QOS_TIMESLICE_IN_USEC);
+	nvmf_ctrlr_set_qos_limits(&ctrlr, 0, 1, NVMF_QOS_DEFAULT_WEIGHT);
+	CU_ASSERT(ctrlr.qos.max_ios_per_timeslice == 0);
+	CU_ASSERT(ctrlr.qos.max_bytes_per_timeslice == 1049);
+
+	rc = nvmf_ctrlr_process_io_cmd(&req[0]);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	rc = nvmf_ctrlr_process_io_cmd(&req[1]);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	CU_ASSERT(TAILQ_FIRST(&qpair.qos_queued) == &req[1]);
+
+	/* The overshoot of the first read is carried over, so the second one waits 3 timeslices */
+	for (i = 0; i < 2; i++) {
+		spdk_delay_us(NVMF_QOS_TIMESLICE_IN_USEC);
+		CU_ASSERT(nvmf_poll_group_process_qos_queued(&group) == 0);
+	}
+	spdk_delay_us(NVMF_QOS_TIMESLICE_IN_USEC);
+	CU_ASSERT(nvmf_poll_group_process_qos_queued(&group) == 1);
+	CU_ASSERT(TAILQ_EMPTY(&group.qos_qpairs));
+
+	/* Removing the limits */
+	nvmf_ctrlr_set_qos_limits(&ctrlr, 0, 0, NVMF_QOS_DEFAULT_WEIGHT);
+	for (i = 0; i < 3; i++) {
+		rc = nvmf_ctrlr_process_io_cmd(&req[i]);
+		CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	}
+	CU_ASSERT(TAILQ_EMPTY(&group.qos_qpairs));
+
+	spdk_poller_unregister(&group.qos_poller);
+	MOCK_CLEAR(nvmf_bdev_ctrlr_read_cmd);
+}
+
+static void
+test_nvmf_ctrlr_ns_qos(void)
+{
+	struct spdk_nvmf_request req[2][4] = {};
+	struct spdk_nvme_cmd cmd[2][4] = {};
+	union nvmf_c2h_msg rsp[2][4] = {};
+	struct spdk_nvmf_qpair qpair[2] = {};
+	struct spdk_nvmf_ctrlr ctrlr[2] = {};
+	struct spdk_nvmf_subsystem subsystem = {};
+	struct spdk_nvmf_ns ns = {};
+	struct spdk_nvmf_ns *subsys_ns[1] = {};
+	enum spdk_nvme_ana_state ana_state[1];
+	struct spdk_nvmf_subsystem_listener listener = { .ana_state = ana_state };
+	struct spdk_bdev bdev = { .blockcnt = 100, .blocklen = 512};
+	struct spdk_nvmf_poll_group group = {};
+	struct spdk_nvmf_subsystem_poll_group sgroups = {};
+	struct spdk_nvmf_subsystem_pg_ns_info ns_info = {};
+	struct spdk_io_channel io_ch = {};
+	int i, j, rc;
+
+	ns.bdev = &bdev;
+	ns.anagrpid = 1;
+
+	subsystem.id = 0;
+	subsystem.max_nsid = 1;
+	subsys_ns[0] = &ns;
+	subsystem.ns = (struct spdk_nvmf_ns **)&subsys_ns;
+
+	listener.ana_state[0] = SPDK_NVME_ANA_OPTIMIZED_STATE;
+
+	group.thread = spdk_get_thread();
+	group.num_sgroups = 1;
+	sgroups.state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
+	sgroups.num_ns = 1;
+	ns_info.state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
+	ns_info.channel = &io_ch;
+	sgroups.ns_info = &ns_info;
+	group.sgroups = &sgroups;
+	TAILQ_INIT(&group.qos_qpairs);
+	/* The virtual time wraps around while the commands below are queued */
+	group.qos_vtime = UINT64_MAX - NVMF_QOS_WEIGHT_SCALE / 2;
+
+	/* Two hosts share the namespace, the second one with three times the weight */
+	for (i = 0; i < 2; i++) {
+		ctrlr[i].vcprop.cc.bits.en = 1;
+		ctrlr[i].subsys = &subsystem;
+		ctrlr[i].listener = &listener;
+		nvmf_ctrlr_set_qos_limits(&ctrlr[i], 0, 0, i == 0 ? 1 : 3);
+
+		qpair[i].ctrlr = &ctrlr[i];
+		qpair[i].group = &group;
+		qpair[i].qid = 1;
+		qpair[i].state = SPDK_NVMF_QPAIR_ACTIVE;
+		TAILQ_INIT(&qpair[i].outstanding);
+		TAILQ_INIT(&qpair[i].qos_queued);
+
+		for (j = 0; j < 4; j++) {
+			cmd[i][j].opc = SPDK_NVME_OPC_READ;
+			cmd[i][j].nsid = 1;
+			req[i][j].qpair = &qpair[i];
+			req[i][j].cmd = (union nvmf_h2c_msg *)&cmd[i][j];
+			req[i][j].rsp = &rsp[i][j];
+			req[i][j].length = 4096;
+		}
+	}
+
+	MOCK_SET(nvmf_bdev_ctrlr_read_cmd, SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+
+	/* 1000 IOPS on the namespace allows a single command per timeslice for both hosts */
+	nvmf_qos_bucket_set_limits(&ns.qos, 1000, 0);
+	CU_ASSERT(ns.qos.max_ios_per_timeslice == 1);
+
+	rc = nvmf_ctrlr_process_io_cmd(&req[0][0]);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	CU_ASSERT(TAILQ_EMPTY(&group.qos_qpairs));
+
+	for (j = 1; j < 4; j++) {
+		for (i = 0; i < 2; i++) {
+			rc = nvmf_ctrlr_process_io_cmd(&req[i][j]);
+			CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+		}
+	}
+	CU_ASSERT(TAILQ_FIRST(&qpair[0].qos_queued) == &req[0][1]);
+	CU_ASSERT(TAILQ_FIRST(&qpair[1].qos_queued) == &req[1][1]);
+	CU_ASSERT(nvmf_poll_group_process_qos_queued(&group) == 0);
+
+	/* The heavier host gets three of every four commands */
+	spdk_delay_us(NVMF_QOS_TIMESLICE_IN_USEC);
+	CU_ASSERT(nvmf_poll_group_process_qos_queued(&group) == 1);
+	CU_ASSERT(TAILQ_FIRST(&qpair[1].qos_queued) == &req[1][2]);
+	spdk_delay_us(NVMF_QOS_TIMESLICE_IN_USEC);
+	CU_ASSERT(nvmf_poll_group_process_qos_queued(&group) == 1);
+	CU_ASSERT(TAILQ_FIRST(&qpair[1].qos_queued) == &req[1][3]);
+	spdk_delay_us(NVMF_QOS_TIMESLICE_IN_USEC);
+	CU_ASSERT(nvmf_poll_group_process_qos_queued(&group) == 1);
+	CU_ASSERT(TAILQ_EMPTY(&qpair[1].qos_queued));
+	spdk_delay_us(NVMF_QOS_TIMESLICE_IN_USEC);
+	CU_ASSERT(nvmf_poll_group_process_qos_queued(&group) == 1);
+	CU_ASSERT(TAILQ_FIRST(&qpair[0].qos_queued) == &req[0][2]);
+	CU_ASSERT(TAILQ_FIRST(&group.qos_qpairs) == &qpair[0]);
+	CU_ASSERT(TAILQ_NEXT(&qpair[0], qos_link) == NULL);
+
+	/* Disconnecting the queue pair aborts the commands it still has queued */
+	for (j = 2; j < 4; j++) {
+		TAILQ_INSERT_TAIL(&qpair[0].outstanding, &req[0][j], link);
+		sgroups.ns_info[0].io_outstanding++;
+	}
+	nvmf_qpair_abort_qos_queued(&qpair[0]);
+	CU_ASSERT(TAILQ_EMPTY(&group.qos_qpairs));
+	CU_ASSERT(TAILQ_EMPTY(&qpair[0].qos_queued));
+	CU_ASSERT(TAILQ_EMPTY(&qpair[0].outstanding));
+	for (j = 2; j < 4; j++) {
+		CU_ASSERT(rsp[0][j].nvme_cpl.status.sct == SPDK_NVME_SCT_GENERIC);
+		CU_ASSERT(rsp[0][j].nvme_cpl.status.sc == SPDK_NVME_SC_ABORTED_SQ_DELETION);
+	}
+	CU_ASSERT(sgroups.ns_info[0].io_outstanding == 0);
+
+	/* A command whose namespace was removed while it waited is failed */
+	rc = nvmf_ctrlr_process_io_cmd(&req[1][0]);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	CU_ASSERT(TAILQ_FIRST(&qpair[1].qos_queued) == &req[1][0]);
+	TAILQ_INSERT_TAIL(&qpair[1].outstanding, &req[1][0], link);
+	sgroups.ns_info[0].io_outstanding++;
+	subsys_ns[0] = NULL;
+	spdk_delay_us(NVMF_QOS_TIMESLICE_IN_USEC);
+	CU_ASSERT(nvmf_poll_group_process_qos_queued(&group) == 1);
+	CU_ASSERT(TAILQ_EMPTY(&group.qos_qpairs));
+	CU_ASSERT(rsp[1][0].nvme_cpl.status.sct == SPDK_NVME_SCT_GENERIC);
+	CU_ASSERT(rsp[1][0].nvme_cpl.status.sc == SPDK_NVME_SC_INVALID_NAMESPACE_OR_FORMAT);
+	CU_ASSERT(sgroups.ns_info[0].io_outstanding == 0);
+
+	spdk_poller_unregister(&group.qos_poller);
+	MOCK_CLEAR(nvmf_bdev_ctrlr_read_cmd);
+}
+
 static void
 test_nvmf_property_set(void)
 {
@@ -3099,11 +3521,14 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_multi_async_events);
 	CU_ADD_TEST(suite, test_rae);
 	CU_ADD_TEST(suite, test_nvmf_ctrlr_create_destruct);
+	CU_ADD_TEST(suite, test_nvmf_ctrlr_resume);
 	CU_ADD_TEST(suite, test_nvmf_ctrlr_use_zcopy);
 	CU_ADD_TEST(suite, test_spdk_nvmf_request_zcopy_start);
 	CU_ADD_TEST(suite, test_zcopy_read);
 	CU_ADD_TEST(suite, test_zcopy_write);
 	CU_ADD_TEST(suite, test_nvmf_property_set);
+	CU_ADD_TEST(suite, test_nvmf_ctrlr_host_qos);
+	CU_ADD_TEST(suite, test_nvmf_ctrlr_ns_qos);
 	CU_ADD_TEST(suite, test_nvmf_ctrlr_get_features_host_behavior_support);
 	CU_ADD_TEST(suite, test_nvmf_ctrlr_set_features_host_behavior_support);
 
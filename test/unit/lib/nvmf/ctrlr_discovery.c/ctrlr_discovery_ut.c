@@ -37,6 +37,10 @@ DEFINE_STUB(spdk_nvmf_transport_get_next,
 
 DEFINE_STUB_V(spdk_bdev_close, (struct spdk_bdev_desc *desc));
 
+DEFINE_STUB(nvmf_ptpl_write_submit, int, (nvmf_ptpl_write_fn write_fn,
+		nvmf_ptpl_write_done_fn done_fn, void *ctx), 0);
+DEFINE_STUB_V(nvmf_ctrlr_abort_resume, (struct spdk_nvmf_ctrlr *ctrlr));
+
 DEFINE_STUB_V(nvmf_ctrlr_async_event_discovery_log_change_notice, (void *ctx));
 
 DEFINE_STUB(spdk_nvmf_qpair_disconnect, int,
@@ -67,6 +71,12 @@ DEFINE_STUB_V(nvmf_ctrlr_reservation_notice_log,
 	      (struct spdk_nvmf_ctrlr *ctrlr, struct spdk_nvmf_ns *ns,
 	       enum spdk_nvme_reservation_notification_log_page_type type));
 
+DEFINE_STUB_V(nvmf_ctrlr_set_qos_limits,
+	      (struct spdk_nvmf_ctrlr *ctrlr, uint64_t rw_ios_per_sec, uint64_t rw_mbytes_per_sec,
+	       uint32_t weight));
+DEFINE_STUB_V(nvmf_qos_bucket_set_limits,
+	      (struct nvmf_qos_bucket *qos, uint64_t rw_ios_per_sec, uint64_t rw_mbytes_per_sec));
+
 DEFINE_STUB(spdk_nvmf_request_complete, int,
 	    (struct spdk_nvmf_request *req), -1);
 
@@ -299,7 +309,7 @@ test_discovery_log(void)
 	memset(buffer, 0xCC, sizeof(buffer));
 	disc_log = (struct spdk_nvmf_discovery_log_page *)buffer;
 	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, sizeof(disc_log->genctr),
-				    &trid);
+				    &trid, NULL);
 	/* No listeners yet on new subsystem, so genctr should still be 0. */
 	CU_ASSERT(disc_log->genctr == 0);
 
@@ -311,14 +321,14 @@ test_discovery_log(void)
 	memset(buffer, 0xCC, sizeof(buffer));
 	disc_log = (struct spdk_nvmf_discovery_log_page *)buffer;
 	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, sizeof(disc_log->genctr),
-				    &trid);
+				    &trid, NULL);
 	CU_ASSERT(disc_log->genctr == 1); /* one added subsystem and listener */
 
 	/* Get only the header, no entries */
 	memset(buffer, 0xCC, sizeof(buffer));
 	disc_log = (struct spdk_nvmf_discovery_log_page *)buffer;
 	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, sizeof(*disc_log),
-				    &trid);
+				    &trid, NULL);
 	CU_ASSERT(disc_log->genctr == 1);
 	CU_ASSERT(disc_log->numrec == 1);
 
@@ -326,7 +336,7 @@ test_discovery_log(void)
 	memset(buffer, 0xCC, sizeof(buffer));
 	disc_log = (struct spdk_nvmf_discovery_log_page *)buffer;
 	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0,
-				    sizeof(*disc_log) + sizeof(disc_log->entries[0]), &trid);
+				    sizeof(*disc_log) + sizeof(disc_log->entries[0]), &trid, NULL);
 	CU_ASSERT(disc_log->genctr != 0);
 	CU_ASSERT(disc_log->numrec == 1);
 	CU_ASSERT(disc_log->entries[0].trtype == 42);
@@ -334,7 +344,7 @@ test_discovery_log(void)
 	/* Offset 0, oversize buffer */
 	memset(buffer, 0xCC, sizeof(buffer));
 	disc_log = (struct spdk_nvmf_discovery_log_page *)buffer;
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, sizeof(buffer), &trid);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, sizeof(buffer), &trid, NULL);
 	CU_ASSERT(disc_log->genctr != 0);
 	CU_ASSERT(disc_log->numrec == 1);
 	CU_ASSERT(disc_log->entries[0].trtype == 42);
@@ -345,7 +355,7 @@ test_discovery_log(void)
 	memset(buffer, 0xCC, sizeof(buffer));
 	entry = (struct spdk_nvmf_discovery_log_page_entry *)buffer;
 	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1,
-				    offsetof(struct spdk_nvmf_discovery_log_page, entries[0]), sizeof(*entry), &trid);
+				    offsetof(struct spdk_nvmf_discovery_log_page, entries[0]), sizeof(*entry), &trid, NULL);
 	CU_ASSERT(entry->trtype == 42);
 
 	/* remove the host and verify that the discovery log contains nothing */
@@ -356,7 +366,7 @@ test_discovery_log(void)
 	memset(buffer, 0xCC, sizeof(buffer));
 	disc_log = (struct spdk_nvmf_discovery_log_page *)buffer;
 	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, sizeof(*disc_log),
-				    &trid);
+				    &trid, NULL);
 	CU_ASSERT(disc_log->genctr != 0);
 	CU_ASSERT(disc_log->numrec == 0);
 
@@ -369,7 +379,7 @@ test_discovery_log(void)
 	memset(buffer, 0xCC, sizeof(buffer));
 	disc_log = (struct spdk_nvmf_discovery_log_page *)buffer;
 	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, sizeof(*disc_log),
-				    &trid);
+				    &trid, NULL);
 	CU_ASSERT(disc_log->genctr != 0);
 	CU_ASSERT(disc_log->numrec == 0);
 
@@ -465,18 +475,18 @@ test_discovery_log_with_filters(void)
 
 	/* Test case 1 - check that all trids are reported */
 	tgt.discovery_filter = SPDK_NVMF_TGT_DISCOVERY_MATCH_ANY;
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_1);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_1, NULL);
 	CU_ASSERT(disc_log->numrec == 6);
 
 	/* Test case 2 - check that only entries of the same transport type are returned */
 	tgt.discovery_filter = SPDK_NVMF_TGT_DISCOVERY_MATCH_TRANSPORT_TYPE;
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_1);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_1, NULL);
 	CU_ASSERT(disc_log->numrec == 3);
 	CU_ASSERT(disc_log->entries[0].trtype == rdma_trid_1.trtype);
 	CU_ASSERT(disc_log->entries[1].trtype == rdma_trid_1.trtype);
 	CU_ASSERT(disc_log->entries[2].trtype == rdma_trid_1.trtype);
 
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_1);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_1, NULL);
 	CU_ASSERT(disc_log->numrec == 3);
 	CU_ASSERT(disc_log->entries[0].trtype == tcp_trid_1.trtype);
 	CU_ASSERT(disc_log->entries[1].trtype == tcp_trid_1.trtype);
@@ -484,7 +494,7 @@ test_discovery_log_with_filters(void)
 
 	/* Test case 3 - check that only entries of the same transport address are returned */
 	tgt.discovery_filter = SPDK_NVMF_TGT_DISCOVERY_MATCH_TRANSPORT_ADDRESS;
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_1);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_1, NULL);
 	CU_ASSERT(disc_log->numrec == 3);
 	/* one tcp and 2 rdma  */
 	CU_ASSERT((disc_log->entries[0].trtype ^ disc_log->entries[1].trtype ^ disc_log->entries[2].trtype)
@@ -493,7 +503,7 @@ test_discovery_log_with_filters(void)
 	CU_ASSERT(strcasecmp(disc_log->entries[1].traddr, rdma_trid_1.traddr) == 0);
 	CU_ASSERT(strcasecmp(disc_log->entries[2].traddr, rdma_trid_1.traddr) == 0);
 
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_1);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_1, NULL);
 	CU_ASSERT(disc_log->numrec == 3);
 	/* one rdma and two tcp */
 	CU_ASSERT((disc_log->entries[0].trtype ^ disc_log->entries[1].trtype ^ disc_log->entries[2].trtype)
@@ -505,26 +515,26 @@ test_discovery_log_with_filters(void)
 	/* Test case 4 - check that only entries of the same transport address and type returned */
 	tgt.discovery_filter = SPDK_NVMF_TGT_DISCOVERY_MATCH_TRANSPORT_TYPE |
 			       SPDK_NVMF_TGT_DISCOVERY_MATCH_TRANSPORT_ADDRESS;
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_1);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_1, NULL);
 	CU_ASSERT(disc_log->numrec == 2);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].traddr, rdma_trid_1.traddr) == 0);
 	CU_ASSERT(strcasecmp(disc_log->entries[1].traddr, rdma_trid_1.traddr) == 0);
 	CU_ASSERT(disc_log->entries[0].trtype == rdma_trid_1.trtype);
 	CU_ASSERT(disc_log->entries[1].trtype == rdma_trid_1.trtype);
 
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_2);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_2, NULL);
 	CU_ASSERT(disc_log->numrec == 1);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].traddr, rdma_trid_2.traddr) == 0);
 	CU_ASSERT(disc_log->entries[0].trtype == rdma_trid_2.trtype);
 
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_1);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_1, NULL);
 	CU_ASSERT(disc_log->numrec == 2);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].traddr, tcp_trid_1.traddr) == 0);
 	CU_ASSERT(strcasecmp(disc_log->entries[1].traddr, tcp_trid_1.traddr) == 0);
 	CU_ASSERT(disc_log->entries[0].trtype == tcp_trid_1.trtype);
 	CU_ASSERT(disc_log->entries[1].trtype == tcp_trid_1.trtype);
 
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_2);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_2, NULL);
 	CU_ASSERT(disc_log->numrec == 1);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].traddr, rdma_trid_2.traddr) == 0);
 	CU_ASSERT(disc_log->entries[0].trtype == rdma_trid_2.trtype);
@@ -532,24 +542,24 @@ test_discovery_log_with_filters(void)
 	/* Test case 5 - check that only entries of the same transport address and type returned */
 	tgt.discovery_filter = SPDK_NVMF_TGT_DISCOVERY_MATCH_TRANSPORT_TYPE |
 			       SPDK_NVMF_TGT_DISCOVERY_MATCH_TRANSPORT_SVCID;
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_1);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_1, NULL);
 	CU_ASSERT(disc_log->numrec == 2);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].trsvcid, rdma_trid_1.trsvcid) == 0);
 	CU_ASSERT(strcasecmp(disc_log->entries[1].trsvcid, rdma_trid_2.trsvcid) == 0);
 	CU_ASSERT(disc_log->entries[0].trtype == rdma_trid_1.trtype);
 	CU_ASSERT(disc_log->entries[1].trtype == rdma_trid_2.trtype);
 
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_3);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_3, NULL);
 	CU_ASSERT(disc_log->numrec == 1);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].trsvcid, rdma_trid_3.trsvcid) == 0);
 	CU_ASSERT(disc_log->entries[0].trtype == rdma_trid_3.trtype);
 
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_1);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_1, NULL);
 	CU_ASSERT(disc_log->numrec == 1);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].trsvcid, tcp_trid_1.trsvcid) == 0);
 	CU_ASSERT(disc_log->entries[0].trtype == tcp_trid_1.trtype);
 
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_2);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_2, NULL);
 	CU_ASSERT(disc_log->numrec == 2);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].trsvcid, tcp_trid_2.trsvcid) == 0);
 	CU_ASSERT(strcasecmp(disc_log->entries[1].trsvcid, tcp_trid_2.trsvcid) == 0);
@@ -560,37 +570,37 @@ test_discovery_log_with_filters(void)
 	 * That also implies trtype since RDMA and TCP listeners can't occupy the same socket */
 	tgt.discovery_filter = SPDK_NVMF_TGT_DISCOVERY_MATCH_TRANSPORT_ADDRESS |
 			       SPDK_NVMF_TGT_DISCOVERY_MATCH_TRANSPORT_SVCID;
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_1);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_1, NULL);
 	CU_ASSERT(disc_log->numrec == 1);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].traddr, rdma_trid_1.traddr) == 0);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].trsvcid, rdma_trid_1.trsvcid) == 0);
 	CU_ASSERT(disc_log->entries[0].trtype == rdma_trid_1.trtype);
 
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_2);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_2, NULL);
 	CU_ASSERT(disc_log->numrec == 1);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].traddr, rdma_trid_2.traddr) == 0);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].trsvcid, rdma_trid_2.trsvcid) == 0);
 	CU_ASSERT(disc_log->entries[0].trtype == rdma_trid_2.trtype);
 
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_3);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_3, NULL);
 	CU_ASSERT(disc_log->numrec == 1);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].traddr, rdma_trid_3.traddr) == 0);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].trsvcid, rdma_trid_3.trsvcid) == 0);
 	CU_ASSERT(disc_log->entries[0].trtype == rdma_trid_3.trtype);
 
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_1);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_1, NULL);
 	CU_ASSERT(disc_log->numrec == 1);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].traddr, tcp_trid_1.traddr) == 0);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].trsvcid, tcp_trid_1.trsvcid) == 0);
 	CU_ASSERT(disc_log->entries[0].trtype == tcp_trid_1.trtype);
 
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_2);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_2, NULL);
 	CU_ASSERT(disc_log->numrec == 1);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].traddr, tcp_trid_2.traddr) == 0);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].trsvcid, tcp_trid_2.trsvcid) == 0);
 	CU_ASSERT(disc_log->entries[0].trtype == tcp_trid_2.trtype);
 
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_3);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_3, NULL);
 	CU_ASSERT(disc_log->numrec == 1);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].traddr, tcp_trid_3.traddr) == 0);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].trsvcid, tcp_trid_3.trsvcid) == 0);
@@ -600,37 +610,37 @@ test_discovery_log_with_filters(void)
 	tgt.discovery_filter = SPDK_NVMF_TGT_DISCOVERY_MATCH_TRANSPORT_TYPE |
 			       SPDK_NVMF_TGT_DISCOVERY_MATCH_TRANSPORT_ADDRESS |
 			       SPDK_NVMF_TGT_DISCOVERY_MATCH_TRANSPORT_SVCID;
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_1);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_1, NULL);
 	CU_ASSERT(disc_log->numrec == 1);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].traddr, rdma_trid_1.traddr) == 0);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].trsvcid, rdma_trid_1.trsvcid) == 0);
 	CU_ASSERT(disc_log->entries[0].trtype == rdma_trid_1.trtype);
 
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_2);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_2, NULL);
 	CU_ASSERT(disc_log->numrec == 1);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].traddr, rdma_trid_2.traddr) == 0);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].trsvcid, rdma_trid_2.trsvcid) == 0);
 	CU_ASSERT(disc_log->entries[0].trtype == rdma_trid_2.trtype);
 
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_3);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &rdma_trid_3, NULL);
 	CU_ASSERT(disc_log->numrec == 1);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].traddr, rdma_trid_3.traddr) == 0);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].trsvcid, rdma_trid_3.trsvcid) == 0);
 	CU_ASSERT(disc_log->entries[0].trtype == rdma_trid_3.trtype);
 
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_1);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_1, NULL);
 	CU_ASSERT(disc_log->numrec == 1);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].traddr, tcp_trid_1.traddr) == 0);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].trsvcid, tcp_trid_1.trsvcid) == 0);
 	CU_ASSERT(disc_log->entries[0].trtype == tcp_trid_1.trtype);
 
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_2);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_2, NULL);
 	CU_ASSERT(disc_log->numrec == 1);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].traddr, tcp_trid_2.traddr) == 0);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].trsvcid, tcp_trid_2.trsvcid) == 0);
 	CU_ASSERT(disc_log->entries[0].trtype == tcp_trid_2.trtype);
 
-	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_3);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, 8192, &tcp_trid_3, NULL);
 	CU_ASSERT(disc_log->numrec == 1);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].traddr, tcp_trid_3.traddr) == 0);
 	CU_ASSERT(strcasecmp(disc_log->entries[0].trsvcid, tcp_trid_3.trsvcid) == 0);
@@ -641,6 +651,89 @@ test_discovery_log_with_filters(void)
 	spdk_bit_array_free(&tgt.subsystem_ids);
 }
 
+static void
+test_discovery_log_cache(void)
+{
+	struct spdk_nvmf_tgt tgt = {};
+	struct spdk_nvmf_subsystem *subsystem[20];
+	struct spdk_nvmf_discovery_log_page *disc_log, *cached_log = NULL, *prev_log;
+	struct spdk_nvme_transport_id trid = {};
+	const char *hostnqn = "nqn.2016-06.io.spdk:host1";
+	char nqn[SPDK_NVMF_NQN_MAX_LEN + 1], svcid[16];
+	struct iovec iov;
+	size_t len;
+	uint32_t i;
+	int rc;
+
+	/* More entries than the log is initially allocated for */
+	len = offsetof(struct spdk_nvmf_discovery_log_page, entries[SPDK_COUNTOF(subsystem)]);
+	disc_log = calloc(1, len);
+	SPDK_CU_ASSERT_FATAL(disc_log != NULL);
+	iov.iov_base = disc_log;
+	iov.iov_len = len;
+
+	tgt.max_subsystems = 1024;
+	tgt.subsystem_ids = spdk_bit_array_create(tgt.max_subsystems);
+	RB_INIT(&tgt.subsystems);
+
+	for (i = 0; i < SPDK_COUNTOF(subsystem); i++) {
+		snprintf(nqn, sizeof(nqn), "nqn.2016-06.io.spdk:subsystem%u", i);
+		subsystem[i] = spdk_nvmf_subsystem_create(&tgt, nqn, SPDK_NVMF_SUBTYPE_NVME, 0);
+		SPDK_CU_ASSERT_FATAL(subsystem[i] != NULL);
+
+		rc = spdk_nvmf_subsystem_add_host(subsystem[i], hostnqn, NULL);
+		CU_ASSERT(rc == 0);
+
+		snprintf(svcid, sizeof(svcid), "%u", 4420 + i);
+		test_gen_trid(&trid, SPDK_NVME_TRANSPORT_RDMA, SPDK_NVMF_ADRFAM_IPV4, "1234", svcid);
+		spdk_nvmf_subsystem_add_listener(subsystem[i], &trid, _subsystem_add_listen_done, NULL);
+		subsystem[i]->state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
+	}
+
+	/* The first read generates the log and keeps it */
+	memset(disc_log, 0xCC, len);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, len, &trid, &cached_log);
+	SPDK_CU_ASSERT_FATAL(cached_log != NULL);
+	CU_ASSERT(cached_log->genctr == tgt.discovery_genctr);
+	CU_ASSERT(disc_log->genctr == tgt.discovery_genctr);
+	CU_ASSERT(disc_log->numrec == SPDK_COUNTOF(subsystem));
+	CU_ASSERT(disc_log->entries[SPDK_COUNTOF(subsystem) - 1].trtype == 42);
+	CU_ASSERT(memcmp(disc_log, cached_log, len) == 0);
+
+	/* The same genctr is served from the kept log */
+	prev_log = cached_log;
+	subsystem[0]->state = SPDK_NVMF_SUBSYSTEM_INACTIVE;
+	memset(disc_log, 0xCC, len);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, sizeof(*disc_log), &trid, &cached_log);
+	CU_ASSERT(cached_log == prev_log);
+	CU_ASSERT(disc_log->numrec == SPDK_COUNTOF(subsystem));
+
+	/* A new genctr regenerates it */
+	tgt.discovery_genctr++;
+	memset(disc_log, 0xCC, len);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, sizeof(*disc_log), &trid, &cached_log);
+	SPDK_CU_ASSERT_FATAL(cached_log != NULL);
+	CU_ASSERT(cached_log->genctr == tgt.discovery_genctr);
+	CU_ASSERT(disc_log->genctr == tgt.discovery_genctr);
+	CU_ASSERT(disc_log->numrec == SPDK_COUNTOF(subsystem) - 1);
+
+	/* Removing a host invalidates the log, too */
+	rc = spdk_nvmf_subsystem_remove_host(subsystem[1], hostnqn);
+	CU_ASSERT(rc == 0);
+	nvmf_get_discovery_log_page(&tgt, hostnqn, &iov, 1, 0, sizeof(*disc_log), &trid, &cached_log);
+	CU_ASSERT(disc_log->genctr == tgt.discovery_genctr);
+	CU_ASSERT(disc_log->numrec == SPDK_COUNTOF(subsystem) - 2);
+
+	free(cached_log);
+	for (i = 0; i < SPDK_COUNTOF(subsystem); i++) {
+		subsystem[i]->state = SPDK_NVMF_SUBSYSTEM_INACTIVE;
+		rc = spdk_nvmf_subsystem_destroy(subsystem[i], NULL, NULL);
+		CU_ASSERT(rc == 0);
+	}
+	spdk_bit_array_free(&tgt.subsystem_ids);
+	free(disc_log);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -654,6 +747,7 @@ main(int argc, char **argv)
 
 	CU_ADD_TEST(suite, test_discovery_log);
 	CU_ADD_TEST(suite, test_discovery_log_with_filters);
+	CU_ADD_TEST(suite, test_discovery_log_cache);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
@@ -38,12 +38,21 @@ DEFINE_STUB(spdk_nvme_transport_id_compare, int,
 	     const struct spdk_nvme_transport_id *trid2), 0);
 DEFINE_STUB(spdk_bdev_get_name, const char *, (const struct spdk_bdev *bdev), "fc_ut_test");
 DEFINE_STUB_V(nvmf_ctrlr_destruct, (struct spdk_nvmf_ctrlr *ctrlr));
+DEFINE_STUB(nvmf_ptpl_write_submit, int, (nvmf_ptpl_write_fn write_fn,
+		nvmf_ptpl_write_done_fn done_fn, void *ctx), 0);
+DEFINE_STUB_V(nvmf_ctrlr_abort_resume, (struct spdk_nvmf_ctrlr *ctrlr));
 DEFINE_STUB_V(nvmf_qpair_free_aer, (struct spdk_nvmf_qpair *qpair));
 DEFINE_STUB_V(nvmf_qpair_abort_pending_zcopy_reqs, (struct spdk_nvmf_qpair *qpair));
 DEFINE_STUB(spdk_bdev_get_io_channel, struct spdk_io_channel *, (struct spdk_bdev_desc *desc),
 	    NULL);
 DEFINE_STUB_V(spdk_nvmf_request_exec, (struct spdk_nvmf_request *req));
 DEFINE_STUB_V(nvmf_ctrlr_ns_changed, (struct spdk_nvmf_ctrlr *ctrlr, uint32_t nsid));
+DEFINE_STUB_V(nvmf_ctrlr_set_qos_limits, (struct spdk_nvmf_ctrlr *ctrlr, uint64_t rw_ios_per_sec,
+		uint64_t rw_mbytes_per_sec, uint32_t weight));
+DEFINE_STUB_V(nvmf_qos_bucket_set_limits, (struct nvmf_qos_bucket *qos, uint64_t rw_ios_per_sec,
+		uint64_t rw_mbytes_per_sec));
+DEFINE_STUB_V(nvmf_qpair_abort_qos_queued, (struct spdk_nvmf_qpair *qpair));
+DEFINE_STUB_V(nvmf_ptpl_writer_fini, (void));
 DEFINE_STUB_V(spdk_bdev_close, (struct spdk_bdev_desc *desc));
 DEFINE_STUB(spdk_bdev_module_claim_bdev, int,
 	    (struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
@@ -108,6 +108,8 @@ DEFINE_STUB_V(nvmf_transport_dump_opts, (struct spdk_nvmf_transport *transport,
 		struct spdk_json_write_ctx *w, bool named));
 DEFINE_STUB_V(nvmf_transport_listen_dump_opts, (struct spdk_nvmf_transport *transport,
 		const struct spdk_nvme_transport_id *trid, struct spdk_json_write_ctx *w));
+DEFINE_STUB_V(nvmf_qpair_abort_qos_queued, (struct spdk_nvmf_qpair *qpair));
+DEFINE_STUB_V(nvmf_ptpl_writer_fini, (void));
 
 struct spdk_io_channel {
 	struct spdk_thread		*thread;
@@ -5,7 +5,7 @@
 
 #include "spdk/stdinc.h"
 #include "spdk_cunit.h"
-#include "common/lib/test_env.c"
+#include "common/lib/ut_multithread.c"
 #include "common/lib/test_iobuf.c"
 #include "common/lib/test_rdma.c"
 #include "nvmf/rdma.c"
@@ -1318,6 +1318,131 @@ test_nvmf_rdma_resources_create(void)
 	nvmf_rdma_resources_destroy(rdma_resource);
 }
 
+static uint32_t
+ut_rdma_free_queue_len(struct spdk_nvmf_rdma_resources *resources)
+{
+	struct spdk_nvmf_rdma_request *rdma_req;
+	uint32_t count = 0;
+
+	STAILQ_FOREACH(rdma_req, &resources->free_queue, state_link) {
+		count++;
+	}
+
+	return count;
+}
+
+static void
+test_nvmf_rdma_srq_grow(void)
+{
+	struct spdk_nvmf_rdma_transport rtransport = {};
+	struct spdk_nvmf_rdma_poll_group rgroup = {};
+	struct spdk_nvmf_rdma_device device = {};
+	struct spdk_nvmf_rdma_poller rpoller = {};
+	struct spdk_nvmf_rdma_resource_opts opts = {};
+	struct spdk_nvmf_rdma_resources *resources, *tmp;
+	uint32_t count;
+
+	allocate_threads(1);
+	set_thread(0);
+
+	rtransport.transport.opts.in_capsule_data_size = 4096;
+	rgroup.group.transport = &rtransport.transport;
+	device.socket_id = SPDK_ENV_SOCKET_ID_ANY;
+	rpoller.group = &rgroup;
+	rpoller.device = &device;
+	rpoller.srq = &g_spdk_rdma_srq;
+	rpoller.max_srq_depth = 64;
+	rpoller.srq_depth = 16;
+	STAILQ_INIT(&rpoller.srq_resources);
+
+	opts.qp = rpoller.srq;
+	opts.shared = true;
+	opts.max_queue_depth = rpoller.srq_depth;
+	opts.in_capsule_data_size = 4096;
+	opts.socket_id = SPDK_ENV_SOCKET_ID_ANY;
+	rpoller.resources = nvmf_rdma_resources_create(&opts);
+	SPDK_CU_ASSERT_FATAL(rpoller.resources != NULL);
+	STAILQ_INSERT_TAIL(&rpoller.srq_resources, rpoller.resources, link);
+	rpoller.stat.qp_stats.recv.num_submitted_wrs = 16;
+
+	/* Enough receive WRs posted, nothing to do */
+	rpoller.srq_recv_completions = 14;
+	nvmf_rdma_poller_check_srq_watermark(&rpoller);
+	CU_ASSERT(rpoller.srq_depth == 16);
+	CU_ASSERT(rpoller.stat.srq_low_watermark == 0);
+	CU_ASSERT(rpoller.srq_grow_poller == NULL);
+
+	/* Below the watermark, growing the queue is deferred to the grow poller */
+	rpoller.srq_recv_completions = 15;
+	nvmf_rdma_poller_check_srq_watermark(&rpoller);
+	CU_ASSERT(rpoller.srq_depth == 16);
+	CU_ASSERT(rpoller.stat.srq_low_watermark == 1);
+	CU_ASSERT(rpoller.srq_grow_poller != NULL);
+	poll_threads();
+	CU_ASSERT(rpoller.srq_depth == 16);
+
+	/* The depth is doubled once the grow delay expires */
+	spdk_delay_us(NVMF_RDMA_SRQ_GROW_DELAY_US);
+	poll_threads();
+	CU_ASSERT(rpoller.srq_depth == 32);
+	CU_ASSERT(rpoller.srq_grow_poller == NULL);
+	CU_ASSERT(ut_rdma_free_queue_len(rpoller.resources) == 32);
+	resources = STAILQ_NEXT(rpoller.resources, link);
+	SPDK_CU_ASSERT_FATAL(resources != NULL);
+	CU_ASSERT(resources->max_queue_depth == 16);
+	CU_ASSERT(STAILQ_EMPTY(&resources->free_queue));
+
+	/* The new WRs are not reported as posted yet, the same event is not counted twice */
+	nvmf_rdma_poller_check_srq_watermark(&rpoller);
+	CU_ASSERT(rpoller.stat.srq_low_watermark == 1);
+	CU_ASSERT(rpoller.srq_grow_poller == NULL);
+
+	rpoller.stat.qp_stats.recv.num_submitted_wrs += 16;
+	nvmf_rdma_poller_check_srq_watermark(&rpoller);
+	CU_ASSERT(rpoller.srq_below_watermark == false);
+
+	/* The queue is not grown if it is back above the watermark when the poller runs */
+	rpoller.srq_recv_completions += 14;
+	nvmf_rdma_poller_check_srq_watermark(&rpoller);
+	CU_ASSERT(rpoller.stat.srq_low_watermark == 2);
+	CU_ASSERT(rpoller.srq_grow_poller != NULL);
+	rpoller.srq_recv_completions -= 14;
+	nvmf_rdma_poller_check_srq_watermark(&rpoller);
+	spdk_delay_us(NVMF_RDMA_SRQ_GROW_DELAY_US);
+	poll_threads();
+	CU_ASSERT(rpoller.srq_depth == 32);
+	CU_ASSERT(rpoller.srq_grow_poller == NULL);
+
+	/* Grow up to max_srq_depth */
+	rpoller.srq_recv_completions += 14;
+	nvmf_rdma_poller_check_srq_watermark(&rpoller);
+	CU_ASSERT(rpoller.stat.srq_low_watermark == 3);
+	spdk_delay_us(NVMF_RDMA_SRQ_GROW_DELAY_US);
+	poll_threads();
+	CU_ASSERT(rpoller.srq_depth == 64);
+	CU_ASSERT(ut_rdma_free_queue_len(rpoller.resources) == 64);
+
+	/* Further low watermark events are counted, but the depth stays the same */
+	rpoller.stat.qp_stats.recv.num_submitted_wrs += 32;
+	nvmf_rdma_poller_check_srq_watermark(&rpoller);
+	rpoller.srq_recv_completions = rpoller.stat.qp_stats.recv.num_submitted_wrs;
+	nvmf_rdma_poller_check_srq_watermark(&rpoller);
+	CU_ASSERT(rpoller.stat.srq_low_watermark == 4);
+	CU_ASSERT(rpoller.srq_grow_poller == NULL);
+	spdk_delay_us(NVMF_RDMA_SRQ_GROW_DELAY_US);
+	poll_threads();
+	CU_ASSERT(rpoller.srq_depth == 64);
+
+	count = 0;
+	STAILQ_FOREACH_SAFE(resources, &rpoller.srq_resources, link, tmp) {
+		count += resources->max_queue_depth;
+		nvmf_rdma_resources_destroy(resources);
+	}
+	CU_ASSERT(count == 64);
+
+	free_threads();
+}
+
 static void
 test_nvmf_rdma_qpair_compare(void)
 {
@@ -1425,6 +1550,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvmf_rdma_request_free_data);
 	CU_ADD_TEST(suite, test_nvmf_rdma_update_ibv_state);
 	CU_ADD_TEST(suite, test_nvmf_rdma_resources_create);
+	CU_ADD_TEST(suite, test_nvmf_rdma_srq_grow);
 	CU_ADD_TEST(suite, test_nvmf_rdma_qpair_compare);
 	CU_ADD_TEST(suite, test_nvmf_rdma_resize_cq);
 
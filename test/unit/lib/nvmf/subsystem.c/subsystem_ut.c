@@ -37,6 +37,9 @@ DEFINE_STUB(spdk_bdev_io_type_supported, bool,
 	    (struct spdk_bdev *bdev,
 	     enum spdk_bdev_io_type io_type), false);
 
+DEFINE_STUB_V(spdk_unaffinitize_thread, (void));
+DEFINE_STUB_V(nvmf_ctrlr_abort_resume, (struct spdk_nvmf_ctrlr *ctrlr));
+
 DEFINE_STUB_V(nvmf_update_discovery_log,
 	      (struct spdk_nvmf_tgt *tgt, const char *hostnqn));
 
@@ -72,6 +75,10 @@ DEFINE_STUB(spdk_nvme_transport_id_adrfam_str, const char *,
 DEFINE_STUB(spdk_nvmf_qpair_get_listen_trid, int,
 	    (struct spdk_nvmf_qpair *qpair,
 	     struct spdk_nvme_transport_id *trid), 0);
+DEFINE_STUB_V(nvmf_ctrlr_set_qos_limits, (struct spdk_nvmf_ctrlr *ctrlr, uint64_t rw_ios_per_sec,
+		uint64_t rw_mbytes_per_sec, uint32_t weight));
+DEFINE_STUB_V(nvmf_qos_bucket_set_limits, (struct nvmf_qos_bucket *qos, uint64_t rw_ios_per_sec,
+		uint64_t rw_mbytes_per_sec));
 
 static struct spdk_nvmf_transport g_transport = {};
 
@@ -478,6 +485,7 @@ ut_reservation_init(void)
 
 	memset(&g_ns, 0, sizeof(g_ns));
 	TAILQ_INIT(&g_ns.registrants);
+	TAILQ_INIT(&g_ns.ptpl_write.waiters);
 	g_ns.subsystem = &g_subsystem;
 	g_ns.ptpl_file = NULL;
 	g_ns.ptpl_activated = false;
@@ -783,6 +791,73 @@ test_reservation_register(void)
 	ut_reservation_deinit();
 }
 
+static void
+ut_reservation_persist_done(void *cb_arg, int status)
+{
+	int *rc = cb_arg;
+
+	*rc = status;
+}
+
+struct ut_ptpl_write {
+	nvmf_ptpl_write_fn		write_fn;
+	nvmf_ptpl_write_done_fn		done_fn;
+	void				*ctx;
+	TAILQ_ENTRY(ut_ptpl_write)	link;
+};
+
+static TAILQ_HEAD(, ut_ptpl_write) g_ut_ptpl_writes = TAILQ_HEAD_INITIALIZER(g_ut_ptpl_writes);
+static int g_ut_ptpl_write_submit_rc;
+
+int
+nvmf_ptpl_write_submit(nvmf_ptpl_write_fn write_fn, nvmf_ptpl_write_done_fn done_fn, void *ctx)
+{
+	struct ut_ptpl_write *write;
+
+	if (g_ut_ptpl_write_submit_rc != 0) {
+		return g_ut_ptpl_write_submit_rc;
+	}
+
+	write = calloc(1, sizeof(*write));
+	SPDK_CU_ASSERT_FATAL(write != NULL);
+	write->write_fn = write_fn;
+	write->done_fn = done_fn;
+	write->ctx = ctx;
+	TAILQ_INSERT_TAIL(&g_ut_ptpl_writes, write, link);
+
+	return 0;
+}
+
+/* Do the oldest queued write, as the PTPL writer thread would */
+static bool
+ut_ptpl_writer_run(void)
+{
+	struct ut_ptpl_write *write;
+
+	write = TAILQ_FIRST(&g_ut_ptpl_writes);
+	if (write == NULL) {
+		return false;
+	}
+
+	TAILQ_REMOVE(&g_ut_ptpl_writes, write, link);
+	write->done_fn(write->ctx, write->write_fn(write->ctx));
+	free(write);
+
+	return true;
+}
+
+static int
+ut_reservation_persist(struct spdk_nvmf_ns *ns)
+{
+	int rc = 1;
+
+	SPDK_CU_ASSERT_FATAL(nvmf_ns_reservation_persist(ns, ut_reservation_persist_done, &rc) == 0);
+	CU_ASSERT(ut_ptpl_writer_run());
+	CU_ASSERT(TAILQ_EMPTY(&g_ut_ptpl_writes));
+
+	return rc;
+}
+
 static void
 test_reservation_register_with_ptpl(void)
 {
@@ -820,6 +895,8 @@ test_reservation_register_with_ptpl(void)
 	reg = nvmf_ns_reservation_get_registrant(&g_ns, &g_ctrlr1_A.hostid);
 	SPDK_CU_ASSERT_FATAL(reg != NULL);
 	SPDK_CU_ASSERT_FATAL(!spdk_uuid_compare(&g_ctrlr1_A.hostid, &reg->hostid));
+	rc = ut_reservation_persist(&g_ns);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
 	/* Load reservation information from configuration file */
 	memset(&info, 0, sizeof(info));
 	rc = nvmf_ns_load_reservation(g_ns.ptpl_file, &info);
@@ -834,6 +911,8 @@ test_reservation_register_with_ptpl(void)
 	SPDK_CU_ASSERT_FATAL(update_sgroup == true);
 	SPDK_CU_ASSERT_FATAL(rsp->status.sc == SPDK_NVME_SC_SUCCESS);
 	SPDK_CU_ASSERT_FATAL(g_ns.ptpl_activated == false);
+	rc = ut_reservation_persist(&g_ns);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
 	rc = nvmf_ns_load_reservation(g_ns.ptpl_file, &info);
 	SPDK_CU_ASSERT_FATAL(rc < 0);
 	unlink(g_ns.ptpl_file);
@@ -842,6 +921,83 @@ test_reservation_register_with_ptpl(void)
 	ut_reservation_deinit();
 }
 
+static void
+test_reservation_persist_batching(void)
+{
+	struct spdk_nvmf_request *req;
+	struct spdk_nvme_cpl *rsp;
+	struct spdk_nvmf_reservation_info info;
+	struct spdk_uuid holder_uuid;
+	int rc1 = 1, rc2 = 1, rc3 = 1;
+	int rc;
+
+	ut_reservation_init();
+
+	req = ut_reservation_build_req(16);
+	SPDK_CU_ASSERT_FATAL(req != NULL);
+	rsp = &req->rsp->nvme_cpl;
+
+	g_ns.ptpl_file = "/tmp/Ns1PR.cfg";
+	ut_reservation_build_register_request(req, SPDK_NVME_RESERVE_REGISTER_KEY, 0,
+					      SPDK_NVME_RESERVE_PTPL_PERSIST_POWER_LOSS, 0, 0xa1);
+	nvmf_ns_reservation_register(&g_ns, &g_ctrlr1_A, req);
+	SPDK_CU_ASSERT_FATAL(rsp->status.sc == SPDK_NVME_SC_SUCCESS);
+
+	/* TEST CASE: The first request starts a write, the following ones queue up behind it */
+	rc = nvmf_ns_reservation_persist(&g_ns, ut_reservation_persist_done, &rc1);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	CU_ASSERT(g_ns.ptpl_write.in_progress == true);
+
+	ut_reservation_build_acquire_request(req, SPDK_NVME_RESERVE_ACQUIRE, 0,
+					     SPDK_NVME_RESERVE_WRITE_EXCLUSIVE_REG_ONLY, 0xa1, 0x0);
+	nvmf_ns_reservation_acquire(&g_ns, &g_ctrlr1_A, req);
+	SPDK_CU_ASSERT_FATAL(rsp->status.sc == SPDK_NVME_SC_SUCCESS);
+
+	rc = nvmf_ns_reservation_persist(&g_ns, ut_reservation_persist_done, &rc2);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	rc = nvmf_ns_reservation_persist(&g_ns, ut_reservation_persist_done, &rc3);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	CU_ASSERT(g_ns.ptpl_write.seq == 3);
+	CU_ASSERT(rc1 == 1 && rc2 == 1 && rc3 == 1);
+
+	/* TEST CASE: The two queued requests are served by a single follow-up write */
+	CU_ASSERT(ut_ptpl_writer_run());
+	CU_ASSERT(rc1 == 0);
+	CU_ASSERT(g_ns.ptpl_write.in_progress == true);
+	CU_ASSERT(rc2 == 1 && rc3 == 1);
+
+	CU_ASSERT(ut_ptpl_writer_run());
+	CU_ASSERT(rc2 == 0);
+	CU_ASSERT(rc3 == 0);
+	CU_ASSERT(g_ns.ptpl_write.in_progress == false);
+	CU_ASSERT(TAILQ_EMPTY(&g_ns.ptpl_write.waiters));
+	CU_ASSERT(!ut_ptpl_writer_run());
+
+	/* The file holds the latest state */
+	memset(&info, 0, sizeof(info));
+	rc = nvmf_ns_load_reservation(g_ns.ptpl_file, &info);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	CU_ASSERT(info.ptpl_activated == true);
+	CU_ASSERT(info.rtype == SPDK_NVME_RESERVE_WRITE_EXCLUSIVE_REG_ONLY);
+	CU_ASSERT(info.crkey == 0xa1);
+	spdk_uuid_parse(&holder_uuid, info.holder_uuid);
+	CU_ASSERT(!spdk_uuid_compare(&g_ctrlr1_A.hostid, &holder_uuid));
+	unlink(g_ns.ptpl_file);
+
+	/* TEST CASE: A write that can't be queued fails the requests waiting for it */
+	rc1 = 1;
+	g_ut_ptpl_write_submit_rc = -ENOMEM;
+	rc = nvmf_ns_reservation_persist(&g_ns, ut_reservation_persist_done, &rc1);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(rc1 == -ENOMEM);
+	CU_ASSERT(g_ns.ptpl_write.in_progress == false);
+	CU_ASSERT(TAILQ_EMPTY(&g_ns.ptpl_write.waiters));
+	g_ut_ptpl_write_submit_rc = 0;
+
+	ut_reservation_free_req(req);
+	ut_reservation_deinit();
+}
+
 static void
 test_reservation_acquire_preempt_1(void)
 {
@@ -941,6 +1097,8 @@ test_reservation_acquire_release_with_ptpl(void)
 	reg = nvmf_ns_reservation_get_registrant(&g_ns, &g_ctrlr1_A.hostid);
 	SPDK_CU_ASSERT_FATAL(reg != NULL);
 	SPDK_CU_ASSERT_FATAL(!spdk_uuid_compare(&g_ctrlr1_A.hostid, &reg->hostid));
+	rc = ut_reservation_persist(&g_ns);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
 	/* Load reservation information from configuration file */
 	memset(&info, 0, sizeof(info));
 	rc = nvmf_ns_load_reservation(g_ns.ptpl_file, &info);
@@ -954,6 +1112,8 @@ test_reservation_acquire_release_with_ptpl(void)
 	update_sgroup = nvmf_ns_reservation_acquire(&g_ns, &g_ctrlr1_A, req);
 	SPDK_CU_ASSERT_FATAL(update_sgroup == true);
 	SPDK_CU_ASSERT_FATAL(rsp->status.sc == SPDK_NVME_SC_SUCCESS);
+	rc = ut_reservation_persist(&g_ns);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
 	memset(&info, 0, sizeof(info));
 	rc = nvmf_ns_load_reservation(g_ns.ptpl_file, &info);
 	SPDK_CU_ASSERT_FATAL(rc == 0);
@@ -970,6 +1130,8 @@ test_reservation_acquire_release_with_ptpl(void)
 	update_sgroup = nvmf_ns_reservation_release(&g_ns, &g_ctrlr1_A, req);
 	SPDK_CU_ASSERT_FATAL(update_sgroup == true);
 	SPDK_CU_ASSERT_FATAL(rsp->status.sc == SPDK_NVME_SC_SUCCESS);
+	rc = ut_reservation_persist(&g_ns);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
 	memset(&info, 0, sizeof(info));
 	rc = nvmf_ns_load_reservation(g_ns.ptpl_file, &info);
 	SPDK_CU_ASSERT_FATAL(rc == 0);
@@ -1466,6 +1628,7 @@ test_spdk_nvmf_subsystem_add_host(void)
 	struct spdk_nvmf_subsystem *subsystem = NULL;
 	int rc;
 	const char hostnqn[] = "nqn.2016-06.io.spdk:host1";
+	const char hostnqn2[] = "nqn.2016-06.io.spdk:host2";
 	const char subsystemnqn[] = "nqn.2016-06.io.spdk:subsystem1";
 	struct spdk_nvmf_transport_opts opts = {.opts_size = 1};
 	const struct spdk_nvmf_transport_ops test_ops = {
@@ -1486,14 +1649,29 @@ test_spdk_nvmf_subsystem_add_host(void)
 	rc = spdk_nvmf_subsystem_add_host(subsystem, hostnqn, NULL);
 	CU_ASSERT(rc == 0);
 	CU_ASSERT(!TAILQ_EMPTY(&subsystem->hosts));
+	CU_ASSERT(spdk_nvmf_subsystem_host_allowed(subsystem, hostnqn));
 
 	/* Add existing nqn, this function is allowed to be called if the nqn was previously added. */
 	rc = spdk_nvmf_subsystem_add_host(subsystem, hostnqn, NULL);
 	CU_ASSERT(rc == 0);
 
+	/* Hosts are looked up by their full NQN */
+	rc = spdk_nvmf_subsystem_add_host(subsystem, hostnqn2, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(spdk_nvmf_subsystem_host_allowed(subsystem, hostnqn2));
+	CU_ASSERT(!spdk_nvmf_subsystem_host_allowed(subsystem, "nqn.2016-06.io.spdk:host"));
+	CU_ASSERT(!spdk_nvmf_subsystem_host_allowed(subsystem, "nqn.2016-06.io.spdk:host3"));
+
+	rc = spdk_nvmf_subsystem_remove_host(subsystem, hostnqn2);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(!spdk_nvmf_subsystem_host_allowed(subsystem, hostnqn2));
+	CU_ASSERT(spdk_nvmf_subsystem_host_allowed(subsystem, hostnqn));
+
 	rc = spdk_nvmf_subsystem_remove_host(subsystem, hostnqn);
 	CU_ASSERT(rc == 0);
 	CU_ASSERT(TAILQ_EMPTY(&subsystem->hosts));
+	CU_ASSERT(RB_EMPTY(&subsystem->host_index));
+	CU_ASSERT(!spdk_nvmf_subsystem_host_allowed(subsystem, hostnqn));
 
 	/* No available nqn */
 	rc = spdk_nvmf_subsystem_remove_host(subsystem, hostnqn);
@@ -1792,6 +1970,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_spdk_nvmf_subsystem_set_sn);
 	CU_ADD_TEST(suite, test_reservation_register);
 	CU_ADD_TEST(suite, test_reservation_register_with_ptpl);
+	CU_ADD_TEST(suite, test_reservation_persist_batching);
 	CU_ADD_TEST(suite, test_reservation_acquire_preempt_1);
 	CU_ADD_TEST(suite, test_reservation_acquire_release_with_ptpl);
 	CU_ADD_TEST(suite, test_reservation_release);
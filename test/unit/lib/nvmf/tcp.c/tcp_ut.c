@@ -66,7 +66,8 @@ DEFINE_STUB(nvmf_subsystem_find_listener,
 
 DEFINE_STUB_V(nvmf_get_discovery_log_page,
 	      (struct spdk_nvmf_tgt *tgt, const char *hostnqn, struct iovec *iov,
-	       uint32_t iovcnt, uint64_t offset, uint32_t length, struct spdk_nvme_transport_id *cmd_src_trid));
+	       uint32_t iovcnt, uint64_t offset, uint32_t length, struct spdk_nvme_transport_id *cmd_src_trid,
+	       struct spdk_nvmf_discovery_log_page **cached_log));
 
 DEFINE_STUB_V(nvmf_subsystem_remove_ctrlr,
 	      (struct spdk_nvmf_subsystem *subsystem, struct spdk_nvmf_ctrlr *ctrlr));
@@ -247,11 +248,79 @@ spdk_accel_get_io_channel(void)
 	return spdk_get_io_channel(g_accel_p);
 }
 
-DEFINE_STUB(spdk_accel_submit_crc32cv,
-	    int,
-	    (struct spdk_io_channel *ch, uint32_t *dst, struct iovec *iovs,
-	     uint32_t iovcnt, uint32_t seed, spdk_accel_completion_cb cb_fn, void *cb_arg),
-	    0);
+#define UT_SEQ_MAX_TASKS 32
+
+struct ut_accel_sequence {
+	uint32_t		num_tasks;
+	uint32_t		*dst[UT_SEQ_MAX_TASKS];
+	struct iovec		*iovs[UT_SEQ_MAX_TASKS];
+	uint32_t		iovcnt[UT_SEQ_MAX_TASKS];
+	uint32_t		seed[UT_SEQ_MAX_TASKS];
+	spdk_accel_completion_cb	cb_fn;
+	void			*cb_arg;
+};
+
+static struct ut_accel_sequence g_ut_seq[2];
+static uint32_t g_ut_num_seqs;
+/* Number of tasks left before spdk_accel_append_crc32c() fails with g_ut_append_rc */
+static uint32_t g_ut_append_tasks = UINT32_MAX;
+static int g_ut_append_rc;
+
+int
+spdk_accel_append_crc32c(struct spdk_accel_sequence **pseq, struct spdk_io_channel *ch,
+			 uint32_t *dst, struct iovec *iovs, uint32_t iovcnt,
+			 struct spdk_memory_domain *domain, void *domain_ctx,
+			 uint32_t seed, spdk_accel_step_cb cb_fn, void *cb_arg)
+{
+	struct ut_accel_sequence *seq = (struct ut_accel_sequence *)*pseq;
+
+	if (g_ut_append_tasks == 0) {
+		return g_ut_append_rc;
+	}
+	g_ut_append_tasks--;
+
+	if (seq == NULL) {
+		SPDK_CU_ASSERT_FATAL(g_ut_num_seqs < SPDK_COUNTOF(g_ut_seq));
+		seq = &g_ut_seq[g_ut_num_seqs++];
+		memset(seq, 0, sizeof(*seq));
+	}
+
+	SPDK_CU_ASSERT_FATAL(seq->num_tasks < UT_SEQ_MAX_TASKS);
+	seq->dst[seq->num_tasks] = dst;
+	seq->iovs[seq->num_tasks] = iovs;
+	seq->iovcnt[seq->num_tasks] = iovcnt;
+	seq->seed[seq->num_tasks] = seed;
+	seq->num_tasks++;
+	*pseq = (struct spdk_accel_sequence *)seq;
+
+	return 0;
+}
+
+void
+spdk_accel_sequence_finish(struct spdk_accel_sequence *_seq, spdk_accel_completion_cb cb_fn,
+			   void *cb_arg)
+{
+	struct ut_accel_sequence *seq = (struct ut_accel_sequence *)_seq;
+
+	seq->cb_fn = cb_fn;
+	seq->cb_arg = cb_arg;
+}
+
+/* Execute the sequence, as an accel module would */
+static void
+ut_accel_sequence_complete(struct ut_accel_sequence *seq, int status)
+{
+	uint32_t i;
+
+	for (i = 0; i < seq->num_tasks; i++) {
+		*seq->dst[i] = spdk_crc32c_iov_update(seq->iovs[i], seq->iovcnt[i], ~seq->seed[i]);
+	}
+
+	seq->cb_fn(seq->cb_arg, status);
+}
+
+DEFINE_STUB(spdk_accel_get_opc_module_name, int,
+	    (enum accel_opcode opcode, const char **module_name), -ENOENT);
 
 DEFINE_STUB(spdk_nvmf_bdev_ctrlr_nvme_passthru_admin,
 	    int,
@@ -529,6 +598,49 @@ test_nvmf_tcp_poll_group_create(void)
 	spdk_thread_destroy(thread);
 }
 
+#define TEST_GROUPS_COUNT 3
+static void
+test_nvmf_tcp_get_optimal_poll_group(void)
+{
+	struct spdk_nvmf_tcp_transport ttransport = {};
+	struct spdk_nvmf_tcp_qpair tqpair = {};
+	struct spdk_nvmf_tcp_poll_group tgroups[TEST_GROUPS_COUNT] = {};
+	struct spdk_nvmf_poll_group groups[TEST_GROUPS_COUNT] = {};
+	uint32_t i;
+
+	tqpair.qpair.transport = &ttransport.transport;
+	TAILQ_INIT(&ttransport.poll_groups);
+
+	/* No poll groups */
+	CU_ASSERT(nvmf_tcp_get_optimal_poll_group(&tqpair.qpair) == NULL);
+
+	for (i = 0; i < TEST_GROUPS_COUNT; i++) {
+		tgroups[i].group.group = &groups[i];
+		TAILQ_INSERT_TAIL(&ttransport.poll_groups, &tgroups[i], link);
+	}
+	ttransport.next_pg = &tgroups[0];
+
+	/* Idle poll groups are handed out round-robin */
+	for (i = 0; i < TEST_GROUPS_COUNT; i++) {
+		nvmf_tcp_get_optimal_poll_group(&tqpair.qpair);
+		CU_ASSERT(ttransport.next_pg == &tgroups[(i + 1) % TEST_GROUPS_COUNT]);
+	}
+
+	/* The least loaded poll group is picked, even if it isn't next in line */
+	groups[0].stat.current_io_qpairs = 2;
+	groups[1].current_unassociated_qpairs = 3;
+	groups[2].stat.current_io_qpairs = 1;
+	nvmf_tcp_get_optimal_poll_group(&tqpair.qpair);
+	CU_ASSERT(ttransport.next_pg == &tgroups[0]);
+
+	/* Ties are resolved in favor of the group next in line */
+	groups[0].stat.current_io_qpairs = 1;
+	ttransport.next_pg = &tgroups[0];
+	nvmf_tcp_get_optimal_poll_group(&tqpair.qpair);
+	CU_ASSERT(ttransport.next_pg == &tgroups[1]);
+}
+#undef TEST_GROUPS_COUNT
+
 static void
 test_nvmf_tcp_send_c2h_data(void)
 {
@@ -555,6 +667,7 @@ test_nvmf_tcp_send_c2h_data(void)
 	tqpair.recv_state = NVME_TCP_PDU_RECV_STATE_ERROR;
 
 	tcp_req.req.cmd = (union nvmf_h2c_msg *)&tcp_req.cmd;
+	tcp_req.req.rsp = (union nvmf_c2h_msg *)&tcp_req.rsp;
 
 	tcp_req.req.iov[0].iov_base = (void *)0xDEADBEEF;
 	tcp_req.req.iov[0].iov_len = 101;
@@ -581,13 +694,22 @@ test_nvmf_tcp_send_c2h_data(void)
 	CU_ASSERT(pdu.data_iov[1].iov_len == 100);
 	CU_ASSERT((uint64_t)pdu.data_iov[2].iov_base == 0xC0FFEE);
 	CU_ASSERT(pdu.data_iov[2].iov_len == 99);
+	CU_ASSERT(tcp_req.rsp_coalesced == false);
+	CU_ASSERT(pdu.sock_req.iovcnt == 4);
 
+	/* The capsule response is sent along with the data when SUCCESS can't be used */
 	tcp_req.pdu_in_use = false;
 	tcp_req.rsp.cdw0 = 1;
 	nvmf_tcp_send_c2h_data(&tqpair, &tcp_req);
 
 	CU_ASSERT(c2h_data->common.flags & SPDK_NVME_TCP_C2H_DATA_FLAGS_LAST_PDU);
 	CU_ASSERT((c2h_data->common.flags & SPDK_NVME_TCP_C2H_DATA_FLAGS_SUCCESS) == 0);
+	CU_ASSERT(tcp_req.rsp_coalesced == true);
+	CU_ASSERT(pdu.sock_req.iovcnt == 5);
+	CU_ASSERT(pdu.iov[4].iov_base == tcp_req.rsp_hdr.raw);
+	CU_ASSERT(pdu.iov[4].iov_len == sizeof(struct spdk_nvme_tcp_rsp));
+	CU_ASSERT(tcp_req.rsp_hdr.capsule_resp.common.pdu_type == SPDK_NVME_TCP_PDU_TYPE_CAPSULE_RESP);
+	CU_ASSERT(tcp_req.rsp_hdr.capsule_resp.rccqe.cdw0 == 1);
 
 	ttransport.tcp_opts.c2h_success = false;
 	tcp_req.pdu_in_use = false;
@@ -1469,6 +1591,170 @@ test_nvmf_tcp_tls_generate_tls_psk(void)
 					  NVME_TCP_CIPHER_AES_128_GCM_SHA256) < 0);
 }
 
+static int g_ut_digest_done;
+
+static void
+ut_digest_done(void *cb_arg, int status)
+{
+	struct nvme_tcp_pdu *pdu = cb_arg;
+
+	CU_ASSERT(status == 0);
+	CU_ASSERT(pdu->data_digest_crc32 == nvme_tcp_pdu_calc_data_digest(pdu));
+	g_ut_digest_done++;
+}
+
+static void
+ut_digest_tgroup_init(struct spdk_nvmf_tcp_poll_group *tgroup)
+{
+	int i;
+
+	TAILQ_INIT(&tgroup->send_digests);
+	TAILQ_INIT(&tgroup->recv_digests);
+	TAILQ_INIT(&tgroup->free_digest_batches);
+	for (i = 0; i < NVMF_TCP_DIGEST_BATCH_COUNT; i++) {
+		tgroup->digest_batches[i].tgroup = tgroup;
+		TAILQ_INIT(&tgroup->digest_batches[i].pdus);
+		TAILQ_INSERT_TAIL(&tgroup->free_digest_batches, &tgroup->digest_batches[i], link);
+	}
+}
+
+static void
+test_nvmf_tcp_flush_digests(void)
+{
+	struct spdk_nvmf_tcp_poll_group tgroup = {};
+	struct spdk_nvmf_tcp_qpair tqpair = {};
+	struct nvme_tcp_pdu pdu[NVMF_TCP_DIGEST_BATCH_SIZE + 2] = {};
+	uint8_t data[NVMF_TCP_DIGEST_BATCH_SIZE + 2][64];
+	int i, num_pdus = NVMF_TCP_DIGEST_BATCH_SIZE + 2;
+
+	ut_digest_tgroup_init(&tgroup);
+	for (i = 0; i < num_pdus; i++) {
+		memset(data[i], i + 1, sizeof(data[i]));
+		pdu[i].qpair = &tqpair;
+		pdu[i].data_iov[0].iov_base = data[i];
+		pdu[i].data_iov[0].iov_len = sizeof(data[i]);
+		pdu[i].data_iovcnt = 1;
+		pdu[i].data_len = sizeof(data[i]);
+		TAILQ_INSERT_TAIL(&tgroup.send_digests, &pdu[i], tailq);
+	}
+
+	/* Accel is out of tasks, the PDUs stay queued until the next poll */
+	g_ut_digest_done = 0;
+	g_ut_num_seqs = 0;
+	g_ut_append_tasks = 0;
+	g_ut_append_rc = -ENOMEM;
+	nvmf_tcp_poll_group_flush_digests(&tgroup, &tgroup.send_digests, ut_digest_done);
+	CU_ASSERT(g_ut_digest_done == 0);
+	CU_ASSERT(g_ut_num_seqs == 0);
+	CU_ASSERT(TAILQ_FIRST(&tgroup.send_digests) == &pdu[0]);
+
+	/* The digests are computed by one sequence per NVMF_TCP_DIGEST_BATCH_SIZE PDUs */
+	g_ut_append_tasks = UINT32_MAX;
+	nvmf_tcp_poll_group_flush_digests(&tgroup, &tgroup.send_digests, ut_digest_done);
+	CU_ASSERT(TAILQ_EMPTY(&tgroup.send_digests));
+	CU_ASSERT(g_ut_num_seqs == 2);
+	CU_ASSERT(g_ut_seq[0].num_tasks == NVMF_TCP_DIGEST_BATCH_SIZE);
+	CU_ASSERT(g_ut_seq[1].num_tasks == 2);
+	CU_ASSERT(tqpair.digests_in_flight == (uint32_t)num_pdus);
+	CU_ASSERT(g_ut_digest_done == 0);
+
+	ut_accel_sequence_complete(&g_ut_seq[0], 0);
+	CU_ASSERT(g_ut_digest_done == NVMF_TCP_DIGEST_BATCH_SIZE);
+	ut_accel_sequence_complete(&g_ut_seq[1], 0);
+	CU_ASSERT(g_ut_digest_done == num_pdus);
+	CU_ASSERT(tqpair.digests_in_flight == 0);
+	for (i = 0; i < NVMF_TCP_DIGEST_BATCH_COUNT; i++) {
+		CU_ASSERT(TAILQ_EMPTY(&tgroup.digest_batches[i].pdus));
+	}
+
+	/* Running out of tasks in the middle submits what was appended, the rest waits */
+	g_ut_digest_done = 0;
+	g_ut_num_seqs = 0;
+	g_ut_append_tasks = 1;
+	for (i = 0; i < 3; i++) {
+		TAILQ_INSERT_TAIL(&tgroup.send_digests, &pdu[i], tailq);
+	}
+	nvmf_tcp_poll_group_flush_digests(&tgroup, &tgroup.send_digests, ut_digest_done);
+	CU_ASSERT(g_ut_num_seqs == 1);
+	CU_ASSERT(g_ut_seq[0].num_tasks == 1);
+	CU_ASSERT(TAILQ_FIRST(&tgroup.send_digests) == &pdu[1]);
+	ut_accel_sequence_complete(&g_ut_seq[0], 0);
+	CU_ASSERT(g_ut_digest_done == 1);
+
+	/* Other append errors fall back to computing the digest in place */
+	g_ut_append_tasks = 0;
+	g_ut_append_rc = -EINVAL;
+	nvmf_tcp_poll_group_flush_digests(&tgroup, &tgroup.send_digests, ut_digest_done);
+	CU_ASSERT(g_ut_digest_done == 3);
+	CU_ASSERT(TAILQ_EMPTY(&tgroup.send_digests));
+	g_ut_append_tasks = UINT32_MAX;
+	g_ut_append_rc = 0;
+
+	/* With the software module, the whole batch is computed during the flush */
+	g_ut_digest_done = 0;
+	g_ut_num_seqs = 0;
+	tgroup.sw_digests = true;
+	for (i = 0; i < 3; i++) {
+		pdu[i].data_digest_crc32 = 0;
+		TAILQ_INSERT_TAIL(&tgroup.send_digests, &pdu[i], tailq);
+	}
+	nvmf_tcp_poll_group_flush_digests(&tgroup, &tgroup.send_digests, ut_digest_done);
+	CU_ASSERT(g_ut_digest_done == 3);
+	CU_ASSERT(g_ut_num_seqs == 0);
+	CU_ASSERT(TAILQ_EMPTY(&tgroup.send_digests));
+}
+
+static void
+test_nvmf_tcp_purge_digests(void)
+{
+	struct spdk_nvmf_tcp_poll_group tgroup = {};
+	struct spdk_nvmf_tcp_qpair tqpair[2] = {};
+	struct nvme_tcp_pdu pdu[4] = {};
+	uint8_t data[4][64];
+	int i;
+
+	ut_digest_tgroup_init(&tgroup);
+	for (i = 0; i < 4; i++) {
+		memset(data[i], i + 1, sizeof(data[i]));
+		tqpair[i % 2].group = &tgroup;
+		pdu[i].qpair = &tqpair[i % 2];
+		pdu[i].data_iov[0].iov_base = data[i];
+		pdu[i].data_iov[0].iov_len = sizeof(data[i]);
+		pdu[i].data_iovcnt = 1;
+		pdu[i].data_len = sizeof(data[i]);
+	}
+
+	/* The queued PDUs of a removed qpair are dropped, the others stay in order */
+	TAILQ_INSERT_TAIL(&tgroup.send_digests, &pdu[0], tailq);
+	TAILQ_INSERT_TAIL(&tgroup.send_digests, &pdu[1], tailq);
+	TAILQ_INSERT_TAIL(&tgroup.recv_digests, &pdu[2], tailq);
+	TAILQ_INSERT_TAIL(&tgroup.recv_digests, &pdu[3], tailq);
+	nvmf_tcp_poll_group_purge_digests(&tgroup, &tqpair[0]);
+	CU_ASSERT(TAILQ_FIRST(&tgroup.send_digests) == &pdu[1]);
+	CU_ASSERT(TAILQ_NEXT(&pdu[1], tailq) == NULL);
+	CU_ASSERT(TAILQ_FIRST(&tgroup.recv_digests) == &pdu[3]);
+	CU_ASSERT(TAILQ_NEXT(&pdu[3], tailq) == NULL);
+
+	/* A qpair with digests in flight is destroyed only once they complete */
+	g_ut_digest_done = 0;
+	g_ut_num_seqs = 0;
+	nvmf_tcp_poll_group_flush_digests(&tgroup, &tgroup.send_digests, ut_digest_done);
+	nvmf_tcp_poll_group_flush_digests(&tgroup, &tgroup.recv_digests, ut_digest_done);
+	CU_ASSERT(g_ut_num_seqs == 2);
+	CU_ASSERT(tqpair[1].digests_in_flight == 2);
+
+	_nvmf_tcp_qpair_destroy(&tqpair[1]);
+	CU_ASSERT(tqpair[1].destroy_deferred == true);
+
+	/* Completing its digests doesn't call back into the qpair */
+	tqpair[1].digests_in_flight++;
+	ut_accel_sequence_complete(&g_ut_seq[0], 0);
+	CU_ASSERT(g_ut_digest_done == 0);
+	CU_ASSERT(tqpair[1].digests_in_flight == 2);
+	tqpair[1].digests_in_flight = 0;
+	TAILQ_REMOVE(&tgroup.digest_batches[1].pdus, &pdu[3], tailq);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -1483,6 +1769,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvmf_tcp_create);
 	CU_ADD_TEST(suite, test_nvmf_tcp_destroy);
 	CU_ADD_TEST(suite, test_nvmf_tcp_poll_group_create);
+	CU_ADD_TEST(suite, test_nvmf_tcp_get_optimal_poll_group);
 	CU_ADD_TEST(suite, test_nvmf_tcp_send_c2h_data);
 	CU_ADD_TEST(suite, test_nvmf_tcp_h2c_data_hdr_handle);
 	CU_ADD_TEST(suite, test_nvmf_tcp_in_capsule_data_handle);
@@ -1497,6 +1784,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvmf_tcp_tls_generate_psk_id);
 	CU_ADD_TEST(suite, test_nvmf_tcp_tls_generate_retained_psk);
 	CU_ADD_TEST(suite, test_nvmf_tcp_tls_generate_tls_psk);
+	CU_ADD_TEST(suite, test_nvmf_tcp_flush_digests);
+	CU_ADD_TEST(suite, test_nvmf_tcp_purge_digests);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
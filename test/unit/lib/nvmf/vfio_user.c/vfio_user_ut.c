@@ -248,6 +248,49 @@ test_nvmf_vfio_user_create_destroy(void)
 	CU_ASSERT(done == 1);
 }
 
+static void
+test_nvmf_vfio_user_sq_update_polling(void)
+{
+	struct nvmf_vfio_user_shadow_doorbells sdbl = {};
+	struct nvmf_vfio_user_ctrlr ctrlr = {};
+	struct nvmf_vfio_user_sq sq = {};
+	int i;
+
+	sq.ctrlr = &ctrlr;
+	sq.qid = 1;
+
+	/* Without shadow doorbells every submission is a BAR0 write, never poll */
+	vfio_user_sq_update_polling(&sq, NVMF_VFIO_USER_SQ_POLLING_THRESHOLD);
+	CU_ASSERT(sq.polling == false);
+
+	ctrlr.sdbl = &sdbl;
+
+	/* A few commands per wakeup are fine with interrupts */
+	vfio_user_sq_update_polling(&sq, NVMF_VFIO_USER_SQ_POLLING_THRESHOLD - 1);
+	CU_ASSERT(sq.polling == false);
+
+	/* A busy SQ is switched to polling */
+	vfio_user_sq_update_polling(&sq, NVMF_VFIO_USER_SQ_POLLING_THRESHOLD);
+	CU_ASSERT(sq.polling == true);
+	CU_ASSERT(sq.stats.to_polling == 1);
+
+	/* It keeps polling as long as it is not idle for too long */
+	for (i = 0; i < NVMF_VFIO_USER_SQ_POLLING_IDLE_MAX - 1; i++) {
+		vfio_user_sq_update_polling(&sq, 0);
+	}
+	CU_ASSERT(sq.polling == true);
+	vfio_user_sq_update_polling(&sq, 1);
+	CU_ASSERT(sq.idle_polls == 0);
+
+	/* An idle SQ goes back to interrupts and has to be re-armed */
+	for (i = 0; i < NVMF_VFIO_USER_SQ_POLLING_IDLE_MAX; i++) {
+		vfio_user_sq_update_polling(&sq, 0);
+	}
+	CU_ASSERT(sq.polling == false);
+	CU_ASSERT(sq.need_rearm == true);
+	CU_ASSERT(sq.stats.to_intr == 1);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -262,6 +305,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_cmd_map_prps);
 	CU_ADD_TEST(suite, test_nvme_cmd_map_sgls);
 	CU_ADD_TEST(suite, test_nvmf_vfio_user_create_destroy);
+	CU_ADD_TEST(suite, test_nvmf_vfio_user_sq_update_polling);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
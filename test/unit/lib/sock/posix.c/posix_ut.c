@@ -135,6 +135,58 @@ flush(void)
 	free(req2);
 }
 
+static void
+recv_pipe(void)
+{
+	struct spdk_posix_sock psock = {};
+	struct spdk_sock *sock = &psock.base;
+	uint8_t wbuf[4096], rbuf[4096];
+	struct iovec iov[2];
+	int fds[2], i, rc;
+	ssize_t bytes;
+
+	rc = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	psock.fd = fds[0];
+	rc = fcntl(psock.fd, F_SETFL, O_NONBLOCK);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+
+	rc = posix_sock_alloc_pipe(&psock, 2048);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+
+	for (i = 0; i < (int)sizeof(wbuf); i++) {
+		wbuf[i] = i % 251;
+	}
+	bytes = write(fds[1], wbuf, sizeof(wbuf));
+	SPDK_CU_ASSERT_FATAL(bytes == sizeof(wbuf));
+
+	/* A small read goes through the pipe, which reads ahead */
+	bytes = posix_sock_recv(sock, rbuf, 8);
+	CU_ASSERT(bytes == 8);
+	CU_ASSERT(psock.pipe_has_data);
+	CU_ASSERT(spdk_pipe_reader_bytes_available(psock.recv_pipe) == 2048 - 8);
+
+	/* A large read drains the pipe and receives the rest straight from the socket */
+	iov[0].iov_base = rbuf + 8;
+	iov[0].iov_len = 3000;
+	iov[1].iov_base = rbuf + 3008;
+	iov[1].iov_len = sizeof(rbuf) - 3008;
+	bytes = posix_sock_readv(sock, iov, 2);
+	CU_ASSERT(bytes == sizeof(rbuf) - 8);
+	CU_ASSERT(!psock.pipe_has_data);
+	CU_ASSERT(memcmp(wbuf, rbuf, sizeof(wbuf)) == 0);
+
+	/* Nothing is left */
+	bytes = posix_sock_recv(sock, rbuf, 8);
+	CU_ASSERT(bytes == -1);
+	CU_ASSERT(errno == EAGAIN || errno == EWOULDBLOCK);
+
+	spdk_pipe_destroy(psock.recv_pipe);
+	free(psock.recv_buf);
+	close(fds[0]);
+	close(fds[1]);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -147,6 +199,7 @@ main(int argc, char **argv)
 	suite = CU_add_suite("posix", NULL, NULL);
 
 	CU_ADD_TEST(suite, flush);
+	CU_ADD_TEST(suite, recv_pipe);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 
@@ -615,6 +615,342 @@ iobuf_cache(void)
 	free_cores();
 }
 
+static void
+iobuf_classes(void)
+{
+	struct spdk_iobuf_opts opts = {
+		.small_pool_count = 4,
+		.large_pool_count = 4,
+		.small_bufsize = SMALL_BUFSIZE,
+		.large_bufsize = 4 * LARGE_BUFSIZE,
+		.medium_class_count = 1,
+		.medium_classes = {
+			{ .bufsize = LARGE_BUFSIZE, .pool_count = 4 },
+		},
+	};
+	struct spdk_iobuf_opts invalid_opts, orig_opts;
+	struct spdk_iobuf_class_stats stats;
+	struct spdk_iobuf_channel iobuf_ch[2];
+	struct ut_iobuf_entry entries[5] = {};
+	int rc, finish = 0;
+	uint32_t i;
+	void *buf;
+
+	allocate_cores(2);
+	allocate_threads(2);
+
+	/* Medium classes need to be ordered between the small and the large one */
+	spdk_iobuf_get_opts(&orig_opts);
+	invalid_opts = opts;
+	invalid_opts.small_pool_count = 8192;
+	invalid_opts.large_pool_count = 1024;
+	invalid_opts.medium_classes[0].pool_count = 1024;
+	rc = spdk_iobuf_set_opts(&invalid_opts);
+	CU_ASSERT_EQUAL(rc, 0);
+	invalid_opts.medium_classes[0].bufsize = SMALL_BUFSIZE;
+	rc = spdk_iobuf_set_opts(&invalid_opts);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	invalid_opts.medium_classes[0].bufsize = 4 * LARGE_BUFSIZE;
+	rc = spdk_iobuf_set_opts(&invalid_opts);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	invalid_opts.medium_classes[0].bufsize = LARGE_BUFSIZE;
+	invalid_opts.medium_class_count = SPDK_IOBUF_MAX_MEDIUM_CLASSES + 1;
+	rc = spdk_iobuf_set_opts(&invalid_opts);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	g_iobuf.opts = orig_opts;
+
+	/* Pretend the cores are on two different sockets */
+	g_iobuf.opts = opts;
+	g_iobuf.sockets[0] = 0;
+	g_iobuf.sockets[1] = 1;
+	g_iobuf.num_sockets = 2;
+	set_thread(0);
+	rc = _iobuf_initialize();
+	CU_ASSERT_EQUAL(rc, 0);
+
+	rc = spdk_iobuf_register_module("ut_module");
+	CU_ASSERT_EQUAL(rc, 0);
+
+	for (i = 0; i < 2; i++) {
+		set_thread(i);
+		spdk_thread_set_socket_id(spdk_get_thread(), i);
+		rc = spdk_iobuf_channel_init(&iobuf_ch[i], "ut_module", 0, 0);
+		CU_ASSERT_EQUAL(rc, 0);
+		CU_ASSERT_EQUAL(iobuf_ch[i].medium_count, 1);
+	}
+
+	for (i = 0; spdk_iobuf_get_class_stats(i, &stats) == 0; i++) {
+		CU_ASSERT_EQUAL(stats.num_nodes, 2);
+		CU_ASSERT_EQUAL(stats.nodes[0].socket_id, 0);
+		CU_ASSERT_EQUAL(stats.nodes[0].count, 2);
+		CU_ASSERT_EQUAL(stats.nodes[1].socket_id, 1);
+		CU_ASSERT_EQUAL(stats.nodes[1].count, 2);
+	}
+	CU_ASSERT_EQUAL(i, 3);
+
+	/* Each request is served by the smallest class able to hold it */
+	set_thread(0);
+	buf = spdk_iobuf_get(&iobuf_ch[0], SMALL_BUFSIZE + 1, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL(buf);
+	spdk_iobuf_get_class_stats(0, &stats);
+	CU_ASSERT_EQUAL(stats.bufsize, SMALL_BUFSIZE);
+	CU_ASSERT_EQUAL(stats.nodes[0].available, 2);
+	spdk_iobuf_get_class_stats(1, &stats);
+	CU_ASSERT_EQUAL(stats.bufsize, LARGE_BUFSIZE);
+	CU_ASSERT_EQUAL(stats.nodes[0].available, 1);
+	CU_ASSERT_EQUAL(stats.nodes[1].available, 2);
+	spdk_iobuf_put(&iobuf_ch[0], buf, SMALL_BUFSIZE + 1);
+
+	buf = spdk_iobuf_get(&iobuf_ch[0], LARGE_BUFSIZE + 1, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL(buf);
+	spdk_iobuf_get_class_stats(2, &stats);
+	CU_ASSERT_EQUAL(stats.bufsize, 4 * LARGE_BUFSIZE);
+	CU_ASSERT_EQUAL(stats.nodes[0].available, 1);
+	spdk_iobuf_put(&iobuf_ch[0], buf, LARGE_BUFSIZE + 1);
+
+	/* Buffers are taken from the local node first, then from the remote one */
+	for (i = 0; i < 4; i++) {
+		entries[i].buf = spdk_iobuf_get(&iobuf_ch[0], LARGE_BUFSIZE, &entries[i].iobuf,
+						ut_iobuf_get_buf_cb);
+		CU_ASSERT_PTR_NOT_NULL(entries[i].buf);
+		spdk_iobuf_get_class_stats(1, &stats);
+		CU_ASSERT_EQUAL(stats.nodes[0].available, i < 2 ? 1 - i : 0);
+		CU_ASSERT_EQUAL(stats.nodes[1].available, i < 2 ? 2 : 3 - i);
+	}
+
+	entries[4].buf = spdk_iobuf_get(&iobuf_ch[0], LARGE_BUFSIZE, &entries[4].iobuf,
+					ut_iobuf_get_buf_cb);
+	CU_ASSERT_PTR_NULL(entries[4].buf);
+
+	/* A waiting request is served first, regardless of where the buffer comes from */
+	spdk_iobuf_put(&iobuf_ch[0], entries[3].buf, LARGE_BUFSIZE);
+	CU_ASSERT_PTR_EQUAL(entries[4].buf, entries[3].buf);
+	spdk_iobuf_get_class_stats(1, &stats);
+	CU_ASSERT_EQUAL(stats.nodes[1].available, 0);
+
+	/* Remote buffers go back to the node they were allocated on */
+	spdk_iobuf_put(&iobuf_ch[0], entries[4].buf, LARGE_BUFSIZE);
+	spdk_iobuf_put(&iobuf_ch[0], entries[2].buf, LARGE_BUFSIZE);
+	spdk_iobuf_get_class_stats(1, &stats);
+	CU_ASSERT_EQUAL(stats.nodes[0].available, 0);
+	CU_ASSERT_EQUAL(stats.nodes[1].available, 2);
+
+	/* The other thread takes the buffers from its own node */
+	set_thread(1);
+	buf = spdk_iobuf_get(&iobuf_ch[1], LARGE_BUFSIZE, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL(buf);
+	spdk_iobuf_get_class_stats(1, &stats);
+	CU_ASSERT_EQUAL(stats.nodes[1].available, 1);
+	spdk_iobuf_put(&iobuf_ch[1], buf, LARGE_BUFSIZE);
+
+	set_thread(0);
+	spdk_iobuf_put(&iobuf_ch[0], entries[0].buf, LARGE_BUFSIZE);
+	spdk_iobuf_put(&iobuf_ch[0], entries[1].buf, LARGE_BUFSIZE);
+	spdk_iobuf_get_class_stats(1, &stats);
+	CU_ASSERT_EQUAL(stats.nodes[0].available, 2);
+	CU_ASSERT_EQUAL(stats.nodes[1].available, 2);
+
+	for (i = 0; i < 2; i++) {
+		set_thread(i);
+		spdk_iobuf_channel_fini(&iobuf_ch[i]);
+		spdk_thread_set_socket_id(spdk_get_thread(), SPDK_ENV_SOCKET_ID_ANY);
+	}
+	poll_threads();
+
+	spdk_iobuf_finish(ut_iobuf_finish_cb, &finish);
+	poll_threads();
+
+	CU_ASSERT_EQUAL(finish, 1);
+	g_iobuf.opts = orig_opts;
+
+	free_threads();
+	free_cores();
+}
+
+static void
+iobuf_module_quotas(void)
+{
+	struct spdk_iobuf_opts opts = {
+		.small_pool_count = 4,
+		.large_pool_count = 10,
+		.small_bufsize = SMALL_BUFSIZE,
+		.large_bufsize = LARGE_BUFSIZE,
+	};
+	struct spdk_iobuf_module_opts mod_opts;
+	struct spdk_iobuf_module_stats stats;
+	struct spdk_iobuf_opts orig_opts;
+	struct spdk_iobuf_channel iobuf_ch[3];
+	struct ut_iobuf_entry mod0_entries[6] = {}, mod1_entries[5] = {}, mod2_entries[3] = {};
+	const char *names[] = { "ut_module0", "ut_module1", "ut_module2" };
+	int rc, finish = 0;
+	uint32_t i;
+
+	allocate_cores(1);
+	allocate_threads(1);
+	set_thread(0);
+
+	/* mod0 can hold at most half of the pool, mod1 has 30% of it reserved and twice the
+	 * weight of the others */
+	mod_opts = (struct spdk_iobuf_module_opts) { .max_percent = 50, .weight = 1 };
+	rc = spdk_iobuf_set_module_opts("ut_module0", &mod_opts);
+	CU_ASSERT_EQUAL(rc, 0);
+	mod_opts = (struct spdk_iobuf_module_opts) { .reserved_percent = 30, .weight = 2 };
+	rc = spdk_iobuf_set_module_opts("ut_module1", &mod_opts);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	/* Check the invalid options */
+	mod_opts = (struct spdk_iobuf_module_opts) { .reserved_percent = 80, .weight = 1 };
+	rc = spdk_iobuf_set_module_opts("ut_module2", &mod_opts);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	mod_opts = (struct spdk_iobuf_module_opts) { .reserved_percent = 20, .max_percent = 10, .weight = 1 };
+	rc = spdk_iobuf_set_module_opts("ut_module2", &mod_opts);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	mod_opts = (struct spdk_iobuf_module_opts) { .weight = 0 };
+	rc = spdk_iobuf_set_module_opts("ut_module2", &mod_opts);
+	CU_ASSERT_EQUAL(rc, -EINVAL);
+	spdk_iobuf_get_module_opts("ut_module2", &mod_opts);
+	CU_ASSERT_EQUAL(mod_opts.reserved_percent, 0);
+	CU_ASSERT_EQUAL(mod_opts.max_percent, 0);
+	CU_ASSERT_EQUAL(mod_opts.weight, 1);
+	spdk_iobuf_get_module_opts("ut_module1", &mod_opts);
+	CU_ASSERT_EQUAL(mod_opts.reserved_percent, 30);
+	CU_ASSERT_EQUAL(mod_opts.weight, 2);
+
+	spdk_iobuf_get_opts(&orig_opts);
+	g_iobuf.opts = opts;
+	rc = spdk_iobuf_initialize();
+	CU_ASSERT_EQUAL(rc, 0);
+
+	/* The options can't change once the pools are allocated */
+	mod_opts = (struct spdk_iobuf_module_opts) { .weight = 1 };
+	rc = spdk_iobuf_set_module_opts("ut_module2", &mod_opts);
+	CU_ASSERT_EQUAL(rc, -EBUSY);
+
+	for (i = 0; i < SPDK_COUNTOF(names); i++) {
+		rc = spdk_iobuf_register_module(names[i]);
+		CU_ASSERT_EQUAL(rc, 0);
+		rc = spdk_iobuf_channel_init(&iobuf_ch[i], names[i], 0, 0);
+		CU_ASSERT_EQUAL(rc, 0);
+	}
+	rc = spdk_iobuf_register_module("ut_module1");
+	CU_ASSERT_EQUAL(rc, -EEXIST);
+
+	/* mod0 stops at its limit, even though the pool isn't empty */
+	for (i = 0; i < 6; i++) {
+		mod0_entries[i].buf = spdk_iobuf_get(&iobuf_ch[0], LARGE_BUFSIZE, &mod0_entries[i].iobuf,
+						     ut_iobuf_get_buf_cb);
+		CU_ASSERT(i < 5 ? mod0_entries[i].buf != NULL : mod0_entries[i].buf == NULL);
+	}
+
+	/* mod2 can't take the buffers reserved for mod1 */
+	for (i = 0; i < 3; i++) {
+		mod2_entries[i].buf = spdk_iobuf_get(&iobuf_ch[2], LARGE_BUFSIZE, &mod2_entries[i].iobuf,
+						     ut_iobuf_get_buf_cb);
+		CU_ASSERT(i < 2 ? mod2_entries[i].buf != NULL : mod2_entries[i].buf == NULL);
+	}
+
+	/* Which mod1 can still get */
+	for (i = 0; i < 4; i++) {
+		mod1_entries[i].buf = spdk_iobuf_get(&iobuf_ch[1], LARGE_BUFSIZE, &mod1_entries[i].iobuf,
+						     ut_iobuf_get_buf_cb);
+		CU_ASSERT(i < 3 ? mod1_entries[i].buf != NULL : mod1_entries[i].buf == NULL);
+	}
+
+	spdk_delay_us(10);
+
+	/* mod1 has twice the weight, so its request comes first even though it was queued last.
+	 * mod0 is at its limit, so it isn't considered at all. */
+	spdk_iobuf_put(&iobuf_ch[2], mod2_entries[0].buf, LARGE_BUFSIZE);
+	CU_ASSERT_PTR_EQUAL(mod1_entries[3].buf, mod2_entries[0].buf);
+	CU_ASSERT_PTR_NULL(mod2_entries[2].buf);
+	CU_ASSERT_PTR_NULL(mod0_entries[5].buf);
+
+	/* mod1's next request gets the same tag as the one of mod2 queued before it */
+	mod1_entries[4].buf = spdk_iobuf_get(&iobuf_ch[1], LARGE_BUFSIZE, &mod1_entries[4].iobuf,
+					     ut_iobuf_get_buf_cb);
+	CU_ASSERT_PTR_NULL(mod1_entries[4].buf);
+	spdk_iobuf_put(&iobuf_ch[2], mod2_entries[1].buf, LARGE_BUFSIZE);
+	CU_ASSERT_PTR_EQUAL(mod2_entries[2].buf, mod2_entries[1].buf);
+	CU_ASSERT_PTR_NULL(mod1_entries[4].buf);
+	spdk_iobuf_put(&iobuf_ch[1], mod1_entries[0].buf, LARGE_BUFSIZE);
+	CU_ASSERT_PTR_EQUAL(mod1_entries[4].buf, mod1_entries[0].buf);
+	CU_ASSERT_PTR_NULL(mod0_entries[5].buf);
+
+	/* Once mod0 releases a buffer, it's below its limit again */
+	spdk_iobuf_put(&iobuf_ch[0], mod0_entries[0].buf, LARGE_BUFSIZE);
+	CU_ASSERT_PTR_EQUAL(mod0_entries[5].buf, mod0_entries[0].buf);
+
+	rc = spdk_iobuf_get_module_stats(0, &stats);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_STRING_EQUAL(stats.name, "ut_module0");
+	CU_ASSERT_EQUAL(stats.in_use[0], 0);
+	CU_ASSERT_EQUAL(stats.in_use[1], 5);
+	CU_ASSERT_EQUAL(stats.wait_count, 1);
+	CU_ASSERT_EQUAL(stats.wait_ticks, 10);
+	CU_ASSERT_EQUAL(stats.max_wait_ticks, 10);
+	rc = spdk_iobuf_get_module_stats(1, &stats);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_STRING_EQUAL(stats.name, "ut_module1");
+	CU_ASSERT_EQUAL(stats.in_use[1], 4);
+	CU_ASSERT_EQUAL(stats.wait_count, 2);
+	CU_ASSERT_EQUAL(stats.wait_ticks, 10);
+	CU_ASSERT_EQUAL(stats.max_wait_ticks, 10);
+	rc = spdk_iobuf_get_module_stats(2, &stats);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_STRING_EQUAL(stats.name, "ut_module2");
+	CU_ASSERT_EQUAL(stats.in_use[1], 1);
+	CU_ASSERT_EQUAL(stats.wait_count, 1);
+	rc = spdk_iobuf_get_module_stats(3, &stats);
+	CU_ASSERT_EQUAL(rc, -ENOENT);
+
+	/* Clean up */
+	for (i = 1; i < 6; i++) {
+		spdk_iobuf_put(&iobuf_ch[0], mod0_entries[i].buf, LARGE_BUFSIZE);
+	}
+	for (i = 1; i < 5; i++) {
+		spdk_iobuf_put(&iobuf_ch[1], mod1_entries[i].buf, LARGE_BUFSIZE);
+	}
+	spdk_iobuf_put(&iobuf_ch[2], mod2_entries[2].buf, LARGE_BUFSIZE);
+
+	for (i = 0; i < SPDK_COUNTOF(names); i++) {
+		rc = spdk_iobuf_get_module_stats(i, &stats);
+		CU_ASSERT_EQUAL(rc, 0);
+		CU_ASSERT_EQUAL(stats.in_use[1], 0);
+		spdk_iobuf_channel_fini(&iobuf_ch[i]);
+	}
+	poll_threads();
+
+	spdk_iobuf_finish(ut_iobuf_finish_cb, &finish);
+	poll_threads();
+
+	CU_ASSERT_EQUAL(finish, 1);
+
+	/* Without any reservation or limit, the buffers held aren't counted */
+	rc = spdk_iobuf_initialize();
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = spdk_iobuf_register_module(names[0]);
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = spdk_iobuf_channel_init(&iobuf_ch[0], names[0], 0, 0);
+	CU_ASSERT_EQUAL(rc, 0);
+	mod0_entries[0].buf = spdk_iobuf_get(&iobuf_ch[0], LARGE_BUFSIZE, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL(mod0_entries[0].buf);
+	rc = spdk_iobuf_get_module_stats(0, &stats);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(stats.in_use[1], 0);
+	spdk_iobuf_put(&iobuf_ch[0], mod0_entries[0].buf, LARGE_BUFSIZE);
+	spdk_iobuf_channel_fini(&iobuf_ch[0]);
+	poll_threads();
+
+	finish = 0;
+	spdk_iobuf_finish(ut_iobuf_finish_cb, &finish);
+	poll_threads();
+	CU_ASSERT_EQUAL(finish, 1);
+	g_iobuf.opts = orig_opts;
+
+	free_threads();
+	free_cores();
+}
+
 int
 main(int argc, char **argv)
 {
@@ -627,6 +963,8 @@ main(int argc, char **argv)
 	suite = CU_add_suite("io_channel", NULL, NULL);
 	CU_ADD_TEST(suite, iobuf);
 	CU_ADD_TEST(suite, iobuf_cache);
+	CU_ADD_TEST(suite, iobuf_classes);
+	CU_ADD_TEST(suite, iobuf_module_quotas);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
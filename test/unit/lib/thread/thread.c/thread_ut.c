@@ -156,6 +156,124 @@ poller_run_done(void *ctx)
 	return -1;
 }
 
+static uint32_t g_lane_msg_count;
+static bool g_lane_msg_in_order;
+
+static void
+lane_msg_cb(void *ctx)
+{
+	if ((uintptr_t)ctx != g_lane_msg_count) {
+		g_lane_msg_in_order = false;
+	}
+	g_lane_msg_count++;
+}
+
+static void
+thread_send_msg_lanes(void)
+{
+	struct spdk_thread *thread0, *thread1, *sender;
+	struct spdk_msg_lane *lane;
+	void *ctx[SPDK_MSG_BATCH_SIZE];
+	uint32_t i, count;
+
+	allocate_threads(2);
+	set_thread(0);
+	thread0 = spdk_get_thread();
+	set_thread(1);
+	thread1 = spdk_get_thread();
+
+	/* Send more messages than the lane can hold, so the rest go to overflow. */
+	g_lane_msg_count = 0;
+	g_lane_msg_in_order = true;
+	count = SPDK_MSG_LANE_SIZE + 2 * SPDK_MSG_BATCH_SIZE;
+	for (i = 0; i < count - SPDK_MSG_BATCH_SIZE; i++) {
+		CU_ASSERT(spdk_thread_send_msg(thread0, lane_msg_cb, (void *)(uintptr_t)i) == 0);
+	}
+	for (; i < count; i++) {
+		ctx[i % SPDK_MSG_BATCH_SIZE] = (void *)(uintptr_t)i;
+	}
+	CU_ASSERT(spdk_thread_send_msg_batch(thread0, lane_msg_cb, ctx, SPDK_MSG_BATCH_SIZE) ==
+		  SPDK_MSG_BATCH_SIZE);
+
+	lane = thread0->msg_lanes;
+	SPDK_CU_ASSERT_FATAL(lane != NULL);
+	CU_ASSERT(lane->next == NULL);
+	CU_ASSERT(thread1->msg_last_lane == lane);
+	CU_ASSERT(TAILQ_FIRST(&thread1->msg_overflow_lanes) == lane);
+	CU_ASSERT(!spdk_thread_is_idle(thread0));
+	CU_ASSERT(!spdk_thread_is_idle(thread1));
+
+	/* Overflow is moved into the lane as the receiver drains it, in order. */
+	poll_threads();
+	CU_ASSERT(g_lane_msg_count == count);
+	CU_ASSERT(g_lane_msg_in_order);
+	CU_ASSERT(TAILQ_EMPTY(&thread1->msg_overflow_lanes));
+	CU_ASSERT(!lane->overflow_pending);
+	CU_ASSERT(lane->refs == 2);
+
+	/* A thread can send messages to itself. */
+	g_lane_msg_count = 0;
+	CU_ASSERT(spdk_thread_send_msg(thread1, lane_msg_cb, (void *)0) == 0);
+	poll_threads();
+	CU_ASSERT(g_lane_msg_count == 1);
+	CU_ASSERT(thread1->msg_lanes != NULL);
+
+	/* The lanes of a destroyed sender are unlinked once they are drained. */
+	sender = spdk_thread_create(NULL, NULL);
+	SPDK_CU_ASSERT_FATAL(sender != NULL);
+	spdk_set_thread(sender);
+	g_lane_msg_count = 0;
+	CU_ASSERT(spdk_thread_send_msg(thread0, lane_msg_cb, (void *)0) == 0);
+	CU_ASSERT(thread0->msg_lanes != lane);
+	spdk_thread_exit(sender);
+	while (!spdk_thread_is_exited(sender)) {
+		spdk_thread_poll(sender, 0, 0);
+	}
+	spdk_thread_destroy(sender);
+	set_thread(0);
+	CU_ASSERT(thread0->msg_lanes_reap);
+	poll_threads();
+	CU_ASSERT(g_lane_msg_count == 1);
+	CU_ASSERT(!thread0->msg_lanes_reap);
+	CU_ASSERT(thread0->msg_lanes == lane);
+	CU_ASSERT(lane->next == NULL);
+
+	/* Only the lanes which rang the doorbell are looked at by the receiver. */
+	set_thread(1);
+	g_lane_msg_count = 0;
+	CU_ASSERT(spdk_thread_send_msg(thread0, lane_msg_cb, (void *)0) == 0);
+	CU_ASSERT(thread0->msg_lanes_pending == lane);
+	CU_ASSERT(lane->notified);
+	CU_ASSERT(!spdk_thread_is_idle(thread0));
+	poll_thread(0);
+	CU_ASSERT(g_lane_msg_count == 1);
+	CU_ASSERT(thread0->msg_lanes_pending == NULL);
+	CU_ASSERT(TAILQ_EMPTY(&thread0->msg_active_lanes));
+	CU_ASSERT(!lane->notified);
+	CU_ASSERT(spdk_thread_is_idle(thread0));
+
+	/* Lanes which stay idle are released by their senders and freed by the receivers. */
+	spdk_delay_us(SPDK_MSG_LANE_IDLE_SEC * SPDK_SEC_TO_USEC);
+	poll_threads();
+	CU_ASSERT(thread0->msg_lanes == lane);
+	spdk_delay_us(SPDK_MSG_LANE_IDLE_SEC * SPDK_SEC_TO_USEC);
+	poll_threads();
+	CU_ASSERT(RB_EMPTY(&thread1->msg_send_lanes));
+	CU_ASSERT(thread1->msg_last_lane == NULL);
+	poll_threads();
+	CU_ASSERT(thread0->msg_lanes == NULL);
+	CU_ASSERT(thread1->msg_lanes == NULL);
+
+	/* A new lane is created once the sender needs it again. */
+	g_lane_msg_count = 0;
+	CU_ASSERT(spdk_thread_send_msg(thread0, lane_msg_cb, (void *)0) == 0);
+	CU_ASSERT(thread0->msg_lanes != NULL);
+	poll_threads();
+	CU_ASSERT(g_lane_msg_count == 1);
+
+	free_threads();
+}
+
 static void
 thread_poller(void)
 {
@@ -661,6 +779,95 @@ for_each_channel_unreg(void)
 	free_threads();
 }
 
+struct parallel_ctx {
+	struct spdk_io_channel_iter	*iters[3];
+	int				msg_count;
+	int				cpl_count;
+	int				status;
+};
+
+static void
+parallel_ch_msg(struct spdk_io_channel_iter *i)
+{
+	struct parallel_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_thread *thread = spdk_get_thread();
+	int t;
+
+	CU_ASSERT(spdk_io_channel_get_thread(spdk_io_channel_iter_get_channel(i)) == thread);
+	for (t = 0; t < 3; t++) {
+		if (g_ut_threads[t].thread == thread) {
+			ctx->iters[t] = i;
+		}
+	}
+	ctx->msg_count++;
+}
+
+static void
+parallel_cpl(struct spdk_io_channel_iter *i, int status)
+{
+	struct parallel_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	CU_ASSERT(spdk_io_channel_iter_get_channel(i) == NULL);
+	ctx->status = status;
+	ctx->cpl_count++;
+}
+
+static void
+for_each_channel_parallel(void)
+{
+	struct spdk_io_channel *ch0, *ch1, *ch2;
+	struct parallel_ctx ctx = {};
+	int ch_count = 0;
+
+	allocate_threads(3);
+	set_thread(0);
+	spdk_io_device_register(&ch_count, channel_create, channel_destroy, sizeof(int), NULL);
+	ch0 = spdk_get_io_channel(&ch_count);
+	set_thread(1);
+	ch1 = spdk_get_io_channel(&ch_count);
+	set_thread(2);
+	ch2 = spdk_get_io_channel(&ch_count);
+	CU_ASSERT(ch_count == 3);
+
+	/* All channels are visited before any of them continues */
+	set_thread(0);
+	spdk_for_each_channel_parallel(&ch_count, parallel_ch_msg, &ctx, parallel_cpl);
+	CU_ASSERT(ctx.msg_count == 0);
+	poll_threads();
+	CU_ASSERT(ctx.msg_count == 3);
+	CU_ASSERT(ctx.cpl_count == 0);
+	SPDK_CU_ASSERT_FATAL(ctx.iters[0] != NULL && ctx.iters[1] != NULL && ctx.iters[2] != NULL);
+
+	/* A failure doesn't stop the other channels, and is reported once all are done */
+	set_thread(2);
+	spdk_for_each_channel_continue(ctx.iters[2], 0);
+	set_thread(1);
+	spdk_for_each_channel_continue(ctx.iters[1], -EIO);
+	poll_threads();
+	CU_ASSERT(ctx.cpl_count == 0);
+
+	/* Unregistering the device waits for the iteration to complete */
+	set_thread(0);
+	spdk_put_io_channel(ch0);
+	set_thread(1);
+	spdk_put_io_channel(ch1);
+	set_thread(2);
+	spdk_put_io_channel(ch2);
+	set_thread(0);
+	spdk_io_device_unregister(&ch_count, NULL);
+	poll_threads();
+	CU_ASSERT(!RB_EMPTY(&g_io_devices));
+
+	set_thread(0);
+	spdk_for_each_channel_continue(ctx.iters[0], 0);
+	poll_threads();
+	CU_ASSERT(ctx.cpl_count == 1);
+	CU_ASSERT(ctx.status == -EIO);
+	CU_ASSERT(RB_EMPTY(&g_io_devices));
+
+	free_threads();
+}
+
 static void
 thread_name(void)
 {
@@ -1102,6 +1309,487 @@ thread_update_stats_test(void)
 	free_threads();
 }
 
+static uint64_t
+poller_histogram_count(const struct spdk_histogram_data *histogram, uint64_t ticks)
+{
+	struct spdk_histogram_data *h = (struct spdk_histogram_data *)histogram;
+	uint32_t range, index;
+
+	range = __spdk_histogram_data_get_bucket_range(h, ticks);
+	index = __spdk_histogram_data_get_bucket_index(h, ticks, range);
+
+	return __spdk_histogram_get_count(h, range, index);
+}
+
+static void
+poller_run_time_test(void)
+{
+	struct spdk_poller	*active, *timed;
+	struct spdk_poller_stats stats;
+	const struct spdk_histogram_data *histogram;
+
+	allocate_threads(1);
+	set_thread(0);
+	MOCK_SET(spdk_get_ticks, 0);
+
+	active = spdk_poller_register(poller_run_idle, (void *)100, 0);
+	SPDK_CU_ASSERT_FATAL(active != NULL);
+	timed = spdk_poller_register(poller_run_idle, (void *)500, 1000);
+	SPDK_CU_ASSERT_FATAL(timed != NULL);
+
+	/* Nothing is measured by default. */
+	CU_ASSERT(!spdk_poller_histograms_enabled());
+	CU_ASSERT(spdk_poller_get_slow_threshold() == 0);
+	poll_threads();
+	CU_ASSERT(spdk_poller_get_histogram(active) == NULL);
+	spdk_poller_get_stats(active, &stats);
+	CU_ASSERT(stats.run_count == 1);
+	CU_ASSERT(stats.slow_count == 0);
+
+	/* Each run is tallied once histograms are enabled. */
+	spdk_poller_enable_histograms(true);
+	CU_ASSERT(spdk_poller_histograms_enabled());
+	poll_threads();
+	histogram = spdk_poller_get_histogram(active);
+	SPDK_CU_ASSERT_FATAL(histogram != NULL);
+	CU_ASSERT(poller_histogram_count(histogram, 100) == 1);
+	CU_ASSERT(spdk_poller_get_histogram(timed) == NULL);
+
+	spdk_delay_us(1000);
+	poll_threads();
+	CU_ASSERT(poller_histogram_count(spdk_poller_get_histogram(active), 100) == 2);
+	histogram = spdk_poller_get_histogram(timed);
+	SPDK_CU_ASSERT_FATAL(histogram != NULL);
+	CU_ASSERT(poller_histogram_count(histogram, 500) == 1);
+
+	/* Only the runs longer than the threshold are slow. */
+	spdk_poller_set_slow_threshold(200);
+	CU_ASSERT(spdk_poller_get_slow_threshold() == 200);
+	spdk_delay_us(1000);
+	poll_threads();
+	spdk_poller_get_stats(active, &stats);
+	CU_ASSERT(stats.slow_count == 0);
+	spdk_poller_get_stats(timed, &stats);
+	CU_ASSERT(stats.slow_count == 1);
+
+	/* Disabling histograms keeps the collected data. */
+	spdk_poller_enable_histograms(false);
+	spdk_poller_set_slow_threshold(0);
+	spdk_delay_us(1000);
+	poll_threads();
+	CU_ASSERT(poller_histogram_count(spdk_poller_get_histogram(timed), 500) == 2);
+	spdk_poller_get_stats(timed, &stats);
+	CU_ASSERT(stats.run_count == 3);
+	CU_ASSERT(stats.slow_count == 1);
+
+	spdk_poller_unregister(&active);
+	spdk_poller_unregister(&timed);
+	poll_threads();
+
+	free_threads();
+}
+
+static void
+thread_stats_shm_test(void)
+{
+	const struct spdk_thread_stats_shm *shm;
+	struct spdk_thread_stats_shm_entry entry;
+	struct spdk_poller *active, *timed;
+	struct spdk_io_channel *ch;
+	struct spdk_thread *thread0, *thread1, *thread2;
+	const char *shm_name;
+	char name[64];
+	char long_name[SPDK_THREAD_STATS_SHM_NAME_LEN];
+	int rc;
+
+	snprintf(name, sizeof(name), "/thread_ut_stats.pid%d", (int)getpid());
+	allocate_threads(2);
+	set_thread(1);
+	thread1 = spdk_get_thread();
+	set_thread(0);
+	thread0 = spdk_get_thread();
+
+	CU_ASSERT(spdk_thread_stats_shm_get(&shm_name) == NULL);
+	CU_ASSERT(shm_name == NULL);
+	CU_ASSERT(spdk_thread_stats_shm_init(name, 0) == -EINVAL);
+
+	/* Room for a single thread only. */
+	rc = spdk_thread_stats_shm_init(name, 1);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(spdk_thread_stats_shm_init(name, 1) == -EEXIST);
+	shm = spdk_thread_stats_shm_get(&shm_name);
+	SPDK_CU_ASSERT_FATAL(shm != NULL);
+	CU_ASSERT(strcmp(shm_name, name) == 0);
+	CU_ASSERT(shm->version == SPDK_THREAD_STATS_SHM_VERSION);
+	CU_ASSERT(shm->max_threads == 1);
+	CU_ASSERT(shm->tsc_rate == spdk_get_ticks_hz());
+	CU_ASSERT(!spdk_thread_stats_shm_read(shm, 0, &entry));
+
+	active = spdk_poller_register(poller_run_idle, (void *)0, 0);
+	SPDK_CU_ASSERT_FATAL(active != NULL);
+	timed = spdk_poller_register(poller_run_idle, (void *)0, 1000);
+	SPDK_CU_ASSERT_FATAL(timed != NULL);
+	spdk_io_device_register(&g_device1, create_cb_1, destroy_cb_1, sizeof(g_ctx1), NULL);
+	ch = spdk_get_io_channel(&g_device1);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	/* Threads publish once per period, the first one to do it gets the entry. */
+	spdk_delay_us(SPDK_THREAD_STATS_SHM_PERIOD_US);
+	poll_thread_times(0, 1);
+	poll_thread_times(1, 1);
+	SPDK_CU_ASSERT_FATAL(spdk_thread_stats_shm_read(shm, 0, &entry));
+	CU_ASSERT(entry.id == spdk_thread_get_id(thread0));
+	CU_ASSERT(strcmp(entry.name, spdk_thread_get_name(thread0)) == 0);
+	CU_ASSERT(entry.seq % 2 == 0);
+	CU_ASSERT(entry.tsc == spdk_thread_get_last_tsc(thread0));
+	CU_ASSERT(entry.active_pollers_count == 1);
+	CU_ASSERT(entry.timed_pollers_count == 1);
+	CU_ASSERT(entry.paused_pollers_count == 0);
+	CU_ASSERT(entry.poller_run_count == 2);
+	CU_ASSERT(entry.io_channel_count == 1);
+	CU_ASSERT(entry.msg_queue_depth == 0);
+	CU_ASSERT(thread1->stats_entry == NULL);
+
+	/* Nothing is published until the period elapses again. */
+	spdk_delay_us(1000);
+	poll_thread_times(0, 1);
+	SPDK_CU_ASSERT_FATAL(spdk_thread_stats_shm_read(shm, 0, &entry));
+	CU_ASSERT(entry.poller_run_count == 2);
+
+	spdk_poller_pause(timed);
+	spdk_delay_us(SPDK_THREAD_STATS_SHM_PERIOD_US);
+	poll_thread_times(0, 1);
+	SPDK_CU_ASSERT_FATAL(spdk_thread_stats_shm_read(shm, 0, &entry));
+	CU_ASSERT(entry.active_pollers_count == 1);
+	CU_ASSERT(entry.timed_pollers_count == 0);
+	CU_ASSERT(entry.paused_pollers_count == 1);
+	CU_ASSERT(entry.poller_run_count == 5);
+
+	spdk_thread_stats_shm_cleanup();
+	CU_ASSERT(spdk_thread_stats_shm_get(NULL) == NULL);
+	CU_ASSERT(thread0->stats_entry == NULL);
+
+	/* Both threads fit in a bigger region. */
+	rc = spdk_thread_stats_shm_init(name, 4);
+	CU_ASSERT(rc == 0);
+	shm = spdk_thread_stats_shm_get(NULL);
+	SPDK_CU_ASSERT_FATAL(shm != NULL);
+	spdk_delay_us(SPDK_THREAD_STATS_SHM_PERIOD_US);
+	poll_threads();
+	SPDK_CU_ASSERT_FATAL(spdk_thread_stats_shm_read(shm, 0, &entry));
+	CU_ASSERT(entry.id == spdk_thread_get_id(thread0));
+	SPDK_CU_ASSERT_FATAL(spdk_thread_stats_shm_read(shm, 1, &entry));
+	CU_ASSERT(entry.id == spdk_thread_get_id(thread1));
+	CU_ASSERT(entry.active_pollers_count == 0);
+	CU_ASSERT(entry.io_channel_count == 0);
+	CU_ASSERT(entry.in_interrupt == 0);
+	CU_ASSERT(!spdk_thread_stats_shm_read(shm, 2, &entry));
+
+	/* The current statistics match the published ones. */
+	set_thread(0);
+	CU_ASSERT(spdk_thread_get_stats_entry(&entry) == 0);
+	CU_ASSERT(entry.id == spdk_thread_get_id(thread0));
+	CU_ASSERT(strcmp(entry.name, spdk_thread_get_name(thread0)) == 0);
+	CU_ASSERT(entry.active_pollers_count == 1);
+	CU_ASSERT(entry.paused_pollers_count == 1);
+	CU_ASSERT(entry.io_channel_count == 1);
+
+	/* New threads are listed before they are polled for the first time, with their whole name. */
+	memset(long_name, 'a', sizeof(long_name) - 1);
+	long_name[sizeof(long_name) - 1] = '\0';
+	thread2 = spdk_thread_create(long_name, NULL);
+	SPDK_CU_ASSERT_FATAL(thread2 != NULL);
+	SPDK_CU_ASSERT_FATAL(spdk_thread_stats_shm_read(shm, 2, &entry));
+	CU_ASSERT(entry.id == spdk_thread_get_id(thread2));
+	CU_ASSERT(strcmp(entry.name, long_name) == 0);
+	spdk_set_thread(thread2);
+	spdk_thread_exit(thread2);
+	spdk_thread_poll(thread2, 0, 0);
+	CU_ASSERT(spdk_thread_is_exited(thread2));
+	spdk_thread_destroy(thread2);
+	CU_ASSERT(!spdk_thread_stats_shm_read(shm, 2, &entry));
+	set_thread(0);
+
+	spdk_poller_unregister(&active);
+	spdk_poller_unregister(&timed);
+	spdk_put_io_channel(ch);
+	spdk_io_device_unregister(&g_device1, NULL);
+	poll_threads();
+
+	/* Entries are released with their threads. */
+	free_threads();
+	CU_ASSERT(!spdk_thread_stats_shm_read(shm, 0, &entry));
+	CU_ASSERT(!spdk_thread_stats_shm_read(shm, 1, &entry));
+
+	spdk_thread_stats_shm_cleanup();
+}
+
+struct ut_work_ctx {
+	struct spdk_thread	*threads[8];
+	struct spdk_work_task	*task;
+	bool			async;
+	int			fail_index;
+	int			status;
+	bool			done;
+};
+
+static void
+ut_work_fn(void *ctx, uint64_t index, struct spdk_work_task *task)
+{
+	struct ut_work_ctx *work = ctx;
+
+	SPDK_CU_ASSERT_FATAL(index < SPDK_COUNTOF(work->threads));
+	CU_ASSERT(work->threads[index] == NULL);
+	work->threads[index] = spdk_get_thread();
+
+	if (work->async) {
+		CU_ASSERT(work->task == NULL);
+		work->task = task;
+		return;
+	}
+
+	spdk_work_task_done(task, (int)index == work->fail_index ? -EIO : 0);
+}
+
+static void
+ut_work_cpl(void *ctx, int status)
+{
+	struct ut_work_ctx *work = ctx;
+
+	CU_ASSERT(!work->done);
+	work->status = status;
+	work->done = true;
+}
+
+static void
+ut_work_task_done(struct ut_work_ctx *work, int status)
+{
+	struct spdk_work_task *task = work->task;
+
+	work->task = NULL;
+	spdk_work_task_done(task, status);
+}
+
+static void
+work_queue(void)
+{
+	struct spdk_work_job_opts opts = { .count = 8, .chunk = 2 };
+	struct spdk_work_opts work_opts, saved_opts;
+	struct ut_work_ctx work = { .fail_index = -1 };
+	int i;
+
+	allocate_threads(2);
+	set_thread(0);
+
+	CU_ASSERT(spdk_work_submit(&opts, NULL, &work, ut_work_cpl, &work) == -EINVAL);
+	CU_ASSERT(spdk_work_submit(&opts, ut_work_fn, &work, NULL, &work) == -EINVAL);
+
+	/* The submitting thread processes its own jobs. */
+	CU_ASSERT(spdk_work_submit(&opts, ut_work_fn, &work, ut_work_cpl, &work) == 0);
+	poll_thread(0);
+	CU_ASSERT(work.done);
+	CU_ASSERT(work.status == 0);
+	for (i = 0; i < 8; i++) {
+		CU_ASSERT(work.threads[i] == g_ut_threads[0].thread);
+	}
+
+	/* Idle threads steal the tasks, the completion runs on the submitting thread. */
+	memset(&work, 0, sizeof(work));
+	work.fail_index = -1;
+	CU_ASSERT(spdk_work_submit(&opts, ut_work_fn, &work, ut_work_cpl, &work) == 0);
+	poll_thread(1);
+	CU_ASSERT(!work.done);
+	for (i = 0; i < 8; i++) {
+		CU_ASSERT(work.threads[i] == g_ut_threads[1].thread);
+	}
+	poll_thread(0);
+	CU_ASSERT(work.done);
+	CU_ASSERT(work.status == 0);
+
+	/* An empty job completes right away. */
+	memset(&work, 0, sizeof(work));
+	opts.count = 0;
+	CU_ASSERT(spdk_work_submit(&opts, ut_work_fn, &work, ut_work_cpl, &work) == 0);
+	poll_threads();
+	CU_ASSERT(work.done);
+	CU_ASSERT(work.status == 0);
+
+	/* The indices left are skipped once the job fails. */
+	memset(&work, 0, sizeof(work));
+	work.fail_index = 1;
+	opts.count = 8;
+	CU_ASSERT(spdk_work_submit(&opts, ut_work_fn, &work, ut_work_cpl, &work) == 0);
+	poll_threads();
+	CU_ASSERT(work.done);
+	CU_ASSERT(work.status == -EIO);
+	CU_ASSERT(work.threads[1] != NULL);
+	for (i = 2; i < 8; i++) {
+		CU_ASSERT(work.threads[i] == NULL);
+	}
+
+	/* No more tasks of a job than its limit are processed at once. */
+	memset(&work, 0, sizeof(work));
+	work.async = true;
+	opts.count = 3;
+	opts.chunk = 1;
+	opts.max_tasks = 1;
+	CU_ASSERT(spdk_work_submit(&opts, ut_work_fn, &work, ut_work_cpl, &work) == 0);
+	poll_thread(1);
+	poll_thread(0);
+	CU_ASSERT(work.threads[0] == g_ut_threads[1].thread);
+	CU_ASSERT(work.threads[1] == NULL);
+
+	set_thread(1);
+	ut_work_task_done(&work, 0);
+	poll_thread(1);
+	CU_ASSERT(work.threads[1] == g_ut_threads[1].thread);
+	CU_ASSERT(work.threads[2] == NULL);
+	CU_ASSERT(!work.done);
+
+	/* The thread processing a task cannot exit before it is done. */
+	spdk_thread_exit(g_ut_threads[1].thread);
+	poll_thread(1);
+	CU_ASSERT(!spdk_thread_is_exited(g_ut_threads[1].thread));
+
+	/* A failure from an asynchronous completion fails the job. */
+	ut_work_task_done(&work, -ENOMEM);
+	poll_threads();
+	CU_ASSERT(work.threads[2] == NULL);
+	CU_ASSERT(work.done);
+	CU_ASSERT(work.status == -ENOMEM);
+	CU_ASSERT(spdk_thread_is_exited(g_ut_threads[1].thread));
+
+	/* The global limit applies to all jobs. */
+	spdk_work_get_opts(&saved_opts);
+	work_opts.max_tasks = 0;
+	work_opts.budget_us = 10;
+	CU_ASSERT(spdk_work_set_opts(&work_opts) == -EINVAL);
+	work_opts.max_tasks = 1;
+	CU_ASSERT(spdk_work_set_opts(&work_opts) == 0);
+	spdk_work_get_opts(&work_opts);
+	CU_ASSERT(work_opts.max_tasks == 1);
+	CU_ASSERT(work_opts.budget_us == 10);
+
+	memset(&work, 0, sizeof(work));
+	work.async = true;
+	opts.count = 2;
+	opts.max_tasks = 0;
+	set_thread(0);
+	CU_ASSERT(spdk_work_submit(&opts, ut_work_fn, &work, ut_work_cpl, &work) == 0);
+	poll_thread(0);
+	CU_ASSERT(work.threads[0] != NULL);
+	CU_ASSERT(work.threads[1] == NULL);
+	ut_work_task_done(&work, 0);
+	poll_thread(0);
+	CU_ASSERT(work.threads[1] != NULL);
+	ut_work_task_done(&work, 0);
+	poll_thread(0);
+	CU_ASSERT(work.done);
+	CU_ASSERT(work.status == 0);
+
+	/* A task yields to the thread between indices once the budget is used up. */
+	work_opts.budget_us = 0;
+	CU_ASSERT(spdk_work_set_opts(&work_opts) == 0);
+	memset(&work, 0, sizeof(work));
+	work.fail_index = -1;
+	opts.count = 4;
+	opts.chunk = 4;
+	CU_ASSERT(spdk_work_submit(&opts, ut_work_fn, &work, ut_work_cpl, &work) == 0);
+	for (i = 0; i < 4; i++) {
+		poll_thread_times(0, 1);
+		CU_ASSERT(work.threads[i] != NULL);
+		if (i < 3) {
+			CU_ASSERT(work.threads[i + 1] == NULL);
+		}
+	}
+	poll_thread(0);
+	CU_ASSERT(work.done);
+	CU_ASSERT(work.status == 0);
+	CU_ASSERT(g_work_running == 0);
+
+	CU_ASSERT(spdk_work_set_opts(&saved_opts) == 0);
+
+	free_threads();
+}
+
+static struct spdk_thread *
+ut_work_create_thread(void)
+{
+	struct spdk_thread *thread;
+
+	thread = spdk_thread_create(NULL, NULL);
+	SPDK_CU_ASSERT_FATAL(thread != NULL);
+	spdk_set_thread(thread);
+
+	return thread;
+}
+
+static void
+ut_work_force_exit(struct spdk_thread *thread)
+{
+	spdk_set_thread(thread);
+	spdk_thread_exit(thread);
+	spdk_thread_poll(thread, 0, 0);
+	CU_ASSERT(!spdk_thread_is_exited(thread));
+	spdk_delay_us(SPDK_THREAD_EXIT_TIMEOUT_SEC * SPDK_SEC_TO_USEC);
+	spdk_thread_poll(thread, 0, 0);
+	CU_ASSERT(spdk_thread_is_exited(thread));
+	spdk_thread_destroy(thread);
+}
+
+static void
+work_queue_force_exit(void)
+{
+	struct spdk_work_job_opts opts = { .count = 1, .chunk = 1 };
+	struct ut_work_ctx work = { .fail_index = -1, .async = true };
+	struct spdk_thread *thread;
+
+	allocate_threads(1);
+
+	/* The job of a thread forced to exit is released by the task still processing it. */
+	thread = ut_work_create_thread();
+	CU_ASSERT(spdk_work_submit(&opts, ut_work_fn, &work, ut_work_cpl, &work) == 0);
+	poll_thread(0);
+	CU_ASSERT(work.threads[0] == g_ut_threads[0].thread);
+	ut_work_force_exit(thread);
+	set_thread(0);
+	ut_work_task_done(&work, 0);
+	poll_threads();
+	CU_ASSERT(!work.done);
+	CU_ASSERT(g_work_running == 0);
+	CU_ASSERT(g_work_queued == 0);
+
+	/* The task of a thread forced to exit fails its job. */
+	memset(&work, 0, sizeof(work));
+	work.async = true;
+	set_thread(0);
+	CU_ASSERT(spdk_work_submit(&opts, ut_work_fn, &work, ut_work_cpl, &work) == 0);
+	thread = ut_work_create_thread();
+	spdk_thread_poll(thread, 0, 0);
+	CU_ASSERT(work.threads[0] == thread);
+	ut_work_force_exit(thread);
+	poll_threads();
+	CU_ASSERT(work.done);
+	CU_ASSERT(work.status == -ECANCELED);
+	CU_ASSERT(g_work_running == 0);
+
+	/* The indices nobody took yet are dropped along with the thread. */
+	memset(&work, 0, sizeof(work));
+	work.async = true;
+	opts.count = 2;
+	opts.max_tasks = 1;
+	thread = ut_work_create_thread();
+	CU_ASSERT(spdk_work_submit(&opts, ut_work_fn, &work, ut_work_cpl, &work) == 0);
+	ut_work_force_exit(thread);
+	CU_ASSERT(work.threads[0] == thread);
+	CU_ASSERT(work.threads[1] == NULL);
+	CU_ASSERT(!work.done);
+	CU_ASSERT(g_work_running == 0);
+	CU_ASSERT(g_work_queued == 0);
+
+	free_threads();
+}
+
 struct ut_nested_ch {
 	struct spdk_io_channel *child;
 	struct spdk_poller *poller;
@@ -1408,13 +2096,13 @@ cache_closest_timed_poller(void)
 	 * have the closest timed poller.
 	 */
 	CU_ASSERT(thread->first_timed_poller == poller1);
-	CU_ASSERT(RB_MIN(timed_pollers_tree, &thread->timed_pollers) == poller1);
+	CU_ASSERT(timer_wheel_min(&thread->timed_pollers) == poller1);
 
 	spdk_delay_us(1000);
 	poll_threads();
 
 	CU_ASSERT(thread->first_timed_poller == poller2);
-	CU_ASSERT(RB_MIN(timed_pollers_tree, &thread->timed_pollers) == poller2);
+	CU_ASSERT(timer_wheel_min(&thread->timed_pollers) == poller2);
 
 	/* If we unregister a timed poller by spdk_poller_unregister()
 	 * when it is waiting, it is marked as being unregistered and
@@ -1432,13 +2120,13 @@ cache_closest_timed_poller(void)
 	poll_threads();
 
 	CU_ASSERT(thread->first_timed_poller == tmp);
-	CU_ASSERT(RB_MIN(timed_pollers_tree, &thread->timed_pollers) == tmp);
+	CU_ASSERT(timer_wheel_min(&thread->timed_pollers) == tmp);
 
 	spdk_delay_us(1);
 	poll_threads();
 
 	CU_ASSERT(thread->first_timed_poller == poller3);
-	CU_ASSERT(RB_MIN(timed_pollers_tree, &thread->timed_pollers) == poller3);
+	CU_ASSERT(timer_wheel_min(&thread->timed_pollers) == poller3);
 
 	/* If we pause a timed poller by spdk_poller_pause() when it is waiting,
 	 * it is marked as being paused and is actually paused when it is expired.
@@ -1452,13 +2140,13 @@ cache_closest_timed_poller(void)
 	poll_threads();
 
 	CU_ASSERT(thread->first_timed_poller == poller3);
-	CU_ASSERT(RB_MIN(timed_pollers_tree, &thread->timed_pollers) == poller3);
+	CU_ASSERT(timer_wheel_min(&thread->timed_pollers) == poller3);
 
 	spdk_delay_us(1);
 	poll_threads();
 
 	CU_ASSERT(thread->first_timed_poller == poller1);
-	CU_ASSERT(RB_MIN(timed_pollers_tree, &thread->timed_pollers) == poller1);
+	CU_ASSERT(timer_wheel_min(&thread->timed_pollers) == poller1);
 
 	/* After unregistering all timed pollers, the cache should
 	 * be NULL.
@@ -1470,7 +2158,7 @@ cache_closest_timed_poller(void)
 	poll_threads();
 
 	CU_ASSERT(thread->first_timed_poller == NULL);
-	CU_ASSERT(RB_EMPTY(&thread->timed_pollers));
+	CU_ASSERT(timer_wheel_empty(&thread->timed_pollers));
 
 	free_threads();
 }
@@ -1566,7 +2254,7 @@ multi_timed_pollers_have_same_expiration(void)
 	poll_threads();
 
 	CU_ASSERT(thread->first_timed_poller == NULL);
-	CU_ASSERT(RB_EMPTY(&thread->timed_pollers));
+	CU_ASSERT(timer_wheel_empty(&thread->timed_pollers));
 
 	/*
 	 * case 2: unregister timed pollers while multiple timed pollers are registered.
@@ -1633,11 +2321,96 @@ multi_timed_pollers_have_same_expiration(void)
 	poll_threads();
 
 	CU_ASSERT(thread->first_timed_poller == NULL);
-	CU_ASSERT(RB_EMPTY(&thread->timed_pollers));
+	CU_ASSERT(timer_wheel_empty(&thread->timed_pollers));
 
 	free_threads();
 }
 
+static void
+timer_wheel_expire_order(void)
+{
+	struct timer_wheel *wheel;
+	struct spdk_poller *pollers, *poller, *min, *prev;
+	uint64_t base, now, seed = 1;
+	int i, num_expired = 0, num_inserted = 0;
+	const int count = 512;
+
+	wheel = calloc(1, sizeof(*wheel));
+	pollers = calloc(count, sizeof(*pollers));
+	SPDK_CU_ASSERT_FATAL(wheel != NULL && pollers != NULL);
+
+	/* Start just below a boundary of the upper levels so that cascading
+	 * crosses it.
+	 */
+	base = (1ULL << 36) - 1000;
+	timer_wheel_init(wheel, base);
+
+	for (i = 0; i < count; i++) {
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		/* Mix short and long expirations and make some of them collide. */
+		pollers[i].next_run_tick = base + ((seed >> 33) % (1ULL << (i % 40)));
+		pollers[i].id = i;
+		timer_wheel_insert(wheel, &pollers[i]);
+	}
+
+	/* Removing a poller does not disturb the others. */
+	for (i = 0; i < count; i += 7) {
+		timer_wheel_remove(wheel, &pollers[i]);
+		pollers[i].state = SPDK_POLLER_STATE_UNREGISTERED;
+	}
+	num_inserted = count - SPDK_CEIL_DIV(count, 7);
+
+	now = base;
+	prev = NULL;
+	while (!timer_wheel_empty(wheel)) {
+		/* The closest poller is the earliest inserted one with the smallest tick. */
+		min = NULL;
+		for (i = 0; i < count; i++) {
+			if (pollers[i].state != SPDK_POLLER_STATE_UNREGISTERED &&
+			    (min == NULL || pollers[i].next_run_tick < min->next_run_tick)) {
+				min = &pollers[i];
+			}
+		}
+		CU_ASSERT(timer_wheel_min(wheel) == min);
+
+		now += (now - base) / 2 + 1;
+		while ((poller = timer_wheel_expire(wheel, now)) != NULL) {
+			CU_ASSERT(poller->next_run_tick <= now);
+			CU_ASSERT(poller->state != SPDK_POLLER_STATE_UNREGISTERED);
+			if (prev != NULL) {
+				CU_ASSERT(prev->next_run_tick < poller->next_run_tick ||
+					  (prev->next_run_tick == poller->next_run_tick &&
+					   prev->id < poller->id));
+			}
+			poller->state = SPDK_POLLER_STATE_UNREGISTERED;
+			prev = poller;
+			num_expired++;
+		}
+
+		min = timer_wheel_min(wheel);
+		CU_ASSERT(min == NULL || min->next_run_tick > now);
+	}
+
+	CU_ASSERT(num_expired == num_inserted);
+	CU_ASSERT(timer_wheel_first(wheel) == NULL);
+
+	/* A poller due before the base still expires in time if the clock goes
+	 * backwards.
+	 */
+	pollers[0].next_run_tick = base + 100;
+	timer_wheel_insert(wheel, &pollers[0]);
+	pollers[1].next_run_tick = now + 100;
+	timer_wheel_insert(wheel, &pollers[1]);
+	CU_ASSERT(timer_wheel_expire(wheel, base + 99) == NULL);
+	CU_ASSERT(timer_wheel_expire(wheel, base + 100) == &pollers[0]);
+	CU_ASSERT(timer_wheel_expire(wheel, base + 100) == NULL);
+	CU_ASSERT(timer_wheel_expire(wheel, now + 100) == &pollers[1]);
+	CU_ASSERT(timer_wheel_empty(wheel));
+
+	free(pollers);
+	free(wheel);
+}
+
 static int
 dummy_create_cb(void *io_device, void *ctx_buf)
 {
@@ -1926,20 +2699,27 @@ main(int argc, char **argv)
 
 	CU_ADD_TEST(suite, thread_alloc);
 	CU_ADD_TEST(suite, thread_send_msg);
+	CU_ADD_TEST(suite, thread_send_msg_lanes);
 	CU_ADD_TEST(suite, thread_poller);
 	CU_ADD_TEST(suite, poller_pause);
 	CU_ADD_TEST(suite, thread_for_each);
 	CU_ADD_TEST(suite, for_each_channel_remove);
 	CU_ADD_TEST(suite, for_each_channel_unreg);
+	CU_ADD_TEST(suite, for_each_channel_parallel);
 	CU_ADD_TEST(suite, thread_name);
 	CU_ADD_TEST(suite, channel);
 	CU_ADD_TEST(suite, channel_destroy_races);
 	CU_ADD_TEST(suite, thread_exit_test);
 	CU_ADD_TEST(suite, thread_update_stats_test);
+	CU_ADD_TEST(suite, poller_run_time_test);
+	CU_ADD_TEST(suite, thread_stats_shm_test);
+	CU_ADD_TEST(suite, work_queue);
+	CU_ADD_TEST(suite, work_queue_force_exit);
 	CU_ADD_TEST(suite, nested_channel);
 	CU_ADD_TEST(suite, device_unregister_and_thread_exit_race);
 	CU_ADD_TEST(suite, cache_closest_timed_poller);
 	CU_ADD_TEST(suite, multi_timed_pollers_have_same_expiration);
+	CU_ADD_TEST(suite, timer_wheel_expire_order);
 	CU_ADD_TEST(suite, io_device_lookup);
 	CU_ADD_TEST(suite, spdk_spin);
 